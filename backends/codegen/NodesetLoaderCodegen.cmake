@@ -0,0 +1,36 @@
+include(CMakeParseArguments)
+
+# nodesetloader_generate_c(NAME <name> FILES <nodeset>... [OUTPUT_DIR <dir>])
+#
+# Runs nodesetCodegen at build time and adds the static library <name> with
+# the tables of the nodesets, the files are loaded in the given order. <name>.h
+# declares the NodesetLoader_GeneratedNodeset <name>, which is passed to
+# NodesetLoader_loadGenerated. When cross compiling, set
+# NODESETLOADER_CODEGEN_EXECUTABLE to a nodesetCodegen built for the host.
+function(nodesetloader_generate_c)
+    cmake_parse_arguments(GEN "" "NAME;OUTPUT_DIR" "FILES" ${ARGN})
+    if(NOT GEN_NAME OR NOT GEN_FILES)
+        message(FATAL_ERROR "nodesetloader_generate_c: NAME and FILES are required")
+    endif()
+    if(NOT GEN_OUTPUT_DIR)
+        set(GEN_OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/${GEN_NAME})
+    endif()
+    if(NODESETLOADER_CODEGEN_EXECUTABLE)
+        set(GEN_EXECUTABLE ${NODESETLOADER_CODEGEN_EXECUTABLE})
+    else()
+        set(GEN_EXECUTABLE nodesetCodegen)
+    endif()
+    file(MAKE_DIRECTORY ${GEN_OUTPUT_DIR})
+    set(GEN_SOURCE ${GEN_OUTPUT_DIR}/${GEN_NAME}.c)
+    set(GEN_HEADER ${GEN_OUTPUT_DIR}/${GEN_NAME}.h)
+
+    add_custom_command(OUTPUT ${GEN_SOURCE} ${GEN_HEADER}
+                       COMMAND ${GEN_EXECUTABLE} ${GEN_NAME} ${GEN_SOURCE}
+                               ${GEN_HEADER} ${GEN_FILES}
+                       DEPENDS ${GEN_EXECUTABLE} ${GEN_FILES}
+                       COMMENT "Generating nodeset tables ${GEN_NAME}"
+                       VERBATIM)
+    add_library(${GEN_NAME} STATIC ${GEN_SOURCE} ${GEN_HEADER})
+    target_include_directories(${GEN_NAME} PUBLIC ${GEN_OUTPUT_DIR})
+    target_link_libraries(${GEN_NAME} PUBLIC NodesetLoaderGenerated)
+endfunction()
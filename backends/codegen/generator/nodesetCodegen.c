@@ -0,0 +1,840 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Translates nodesets into C tables which NodesetLoader_loadGenerated inserts
+// into a server without parsing:
+// nodesetCodegen name out.c out.h nodeset.xml...
+// The files are loaded into a scratch server by the open62541 backend, which
+// decodes the values and imports the data types, and are parsed a second time
+// for the sorted nodes. The nodes are emitted in the order the backend adds
+// them, the values in their binary encoding.
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "NodesetLoader/NodesetLoader.h"
+#include "NodesetLoader/backendOpen62541.h"
+#include "NodesetLoader/dataTypes.h"
+#include "conversion.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct NodeList
+{
+    NL_Node **nodes;
+    size_t size;
+    size_t capacity;
+};
+
+struct Generator
+{
+    UA_Server *server;
+    NodesetLoader *loader;
+    const char *name;
+    FILE *out;
+    struct NodeList nodes;
+    UA_String *namespaces;
+    size_t namespacesSize;
+};
+
+static unsigned short addNamespace(void *userContext, const char *uri)
+{
+    // the indices of the scratch server, which are used by its values
+    return UA_Server_addNamespace((UA_Server *)userContext, uri);
+}
+
+static void addToList(struct NodeList *list, NL_Node *node)
+{
+    if (list->size == list->capacity)
+    {
+        size_t capacity = list->capacity ? 2 * list->capacity : 256;
+        NL_Node **nodes =
+            (NL_Node **)realloc(list->nodes, capacity * sizeof(NL_Node *));
+        if (!nodes)
+        {
+            return;
+        }
+        list->nodes = nodes;
+        list->capacity = capacity;
+    }
+    list->nodes[list->size++] = node;
+}
+
+static bool isIdentifier(const char *s)
+{
+    if (!*s || isdigit((unsigned char)*s))
+    {
+        return false;
+    }
+    for (; *s; s++)
+    {
+        if (!isalnum((unsigned char)*s) && *s != '_')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printBytes(FILE *out, const UA_Byte *data, size_t length)
+{
+    fputc('"', out);
+    for (size_t i = 0; i < length; i++)
+    {
+        UA_Byte c = data[i];
+        // octal escapes have a fixed length, '?' would start a trigraph
+        if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\' || c == '?')
+        {
+            fprintf(out, "\\%03o", c);
+        }
+        else
+        {
+            fputc(c, out);
+        }
+        if (i % 64 == 63 && i + 1 < length)
+        {
+            fputs("\"\n    \"", out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void printString(FILE *out, const char *s)
+{
+    if (!s)
+    {
+        fputs("NULL", out);
+        return;
+    }
+    printBytes(out, (const UA_Byte *)s, strlen(s));
+}
+
+static void printByteString(FILE *out, const UA_ByteString *bs)
+{
+    if (!bs->length)
+    {
+        fputs("{0, NULL}", out);
+        return;
+    }
+    fprintf(out, "{%zu, (UA_Byte *)", bs->length);
+    printBytes(out, bs->data, bs->length);
+    fputc('}', out);
+}
+
+static void printNodeId(FILE *out, const UA_NodeId *id)
+{
+    switch (id->identifierType)
+    {
+    case UA_NODEIDTYPE_STRING:
+        fprintf(out, "{%u, UA_NODEIDTYPE_STRING, {.string = ",
+                id->namespaceIndex);
+        printByteString(out, &id->identifier.string);
+        fputs("}}", out);
+        break;
+    case UA_NODEIDTYPE_BYTESTRING:
+        fprintf(out, "{%u, UA_NODEIDTYPE_BYTESTRING, {.byteString = ",
+                id->namespaceIndex);
+        printByteString(out, &id->identifier.byteString);
+        fputs("}}", out);
+        break;
+    case UA_NODEIDTYPE_GUID:
+    {
+        const UA_Guid *g = &id->identifier.guid;
+        fprintf(out,
+                "{%u, UA_NODEIDTYPE_GUID, {.guid = {%uu, %u, %u, {%u, %u, %u, "
+                "%u, %u, %u, %u, %u}}}}",
+                id->namespaceIndex, (unsigned)g->data1, g->data2, g->data3,
+                g->data4[0], g->data4[1], g->data4[2], g->data4[3],
+                g->data4[4], g->data4[5], g->data4[6], g->data4[7]);
+        break;
+    }
+    case UA_NODEIDTYPE_NUMERIC:
+    default:
+        fprintf(out, "{%u, UA_NODEIDTYPE_NUMERIC, {.numeric = %uu}}",
+                id->namespaceIndex, (unsigned)id->identifier.numeric);
+        break;
+    }
+}
+
+static NL_Reference *getHierachicalInverseReference(const NL_Node *node)
+{
+    for (NL_Reference *ref = node->hierachicalRefs; ref; ref = ref->next)
+    {
+        if (!ref->isForward)
+        {
+            return ref;
+        }
+    }
+    return NULL;
+}
+
+// the same parent as the open62541 backend
+static UA_NodeId getParentId(const NL_Node *node, UA_NodeId *parentRefId)
+{
+    UA_NodeId parentId = UA_NODEID_NULL;
+    if (NodesetLoader_isInstanceNode(node))
+    {
+        parentId = ((const NL_InstanceNode *)node)->parentNodeId;
+    }
+    NL_Reference *ref = getHierachicalInverseReference(node);
+    *parentRefId = ref ? ref->refType : UA_NODEID_NULL;
+    if (UA_NodeId_equal(&parentId, &UA_NODEID_NULL) && ref)
+    {
+        parentId = ref->target;
+    }
+    return parentId;
+}
+
+// true if the reference is added by addNode_begin of the source or the
+// target node
+static bool isParentReference(NodesetLoader *loader, const NL_Node *node,
+                              const NL_Reference *ref)
+{
+    UA_NodeId parentRefId = UA_NODEID_NULL;
+    UA_NodeId parentId = UA_NODEID_NULL;
+    if (!ref->isForward)
+    {
+        parentId = getParentId(node, &parentRefId);
+        return UA_NodeId_equal(&parentId, &ref->target) &&
+               UA_NodeId_equal(&parentRefId, &ref->refType);
+    }
+    const NL_Node *child = NodesetLoader_getNode(loader, &ref->target);
+    if (!child)
+    {
+        return false;
+    }
+    parentId = getParentId(child, &parentRefId);
+    return UA_NodeId_equal(&parentId, &node->id) &&
+           UA_NodeId_equal(&parentRefId, &ref->refType);
+}
+
+static bool isKnownParent(const UA_NodeId typeId)
+{
+    if (typeId.namespaceIndex == 0 &&
+        typeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
+        typeId.identifier.numeric <= 29)
+    {
+        return true;
+    }
+    UA_NodeId optionSetId = UA_NODEID_NUMERIC(0, UA_NS0ID_OPTIONSET);
+    return UA_NodeId_equal(&typeId, &optionSetId);
+}
+
+// the supertype of namespace 0 the DataTypeImporter of the backend was
+// called with, the known parents are numeric
+static UA_NodeId getParentType(UA_Server *server, const UA_NodeId dataTypeId)
+{
+    UA_NodeId current;
+    UA_NodeId_copy(&dataTypeId, &current);
+    while (!isKnownParent(current))
+    {
+        UA_BrowseDescription bd;
+        UA_BrowseDescription_init(&bd);
+        bd.nodeId = current;
+        bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+        bd.nodeClassMask = UA_NODECLASS_DATATYPE;
+        UA_BrowseResult br = UA_Server_browse(server, 10, &bd);
+        UA_NodeId_clear(&current);
+        if (br.statusCode != UA_STATUSCODE_GOOD || br.referencesSize != 1)
+        {
+            UA_BrowseResult_clear(&br);
+            return UA_NODEID_NULL;
+        }
+        UA_NodeId_copy(&br.references[0].nodeId.nodeId, &current);
+        UA_BrowseResult_clear(&br);
+    }
+    return current;
+}
+
+static size_t getArrayDimensions(const char *s, UA_UInt32 *dims, size_t max)
+{
+    size_t size = 0;
+    while (s && *s && size < max)
+    {
+        dims[size++] = (UA_UInt32)atoi(s);
+        s = strchr(s, ',');
+        if (s)
+        {
+            s++;
+        }
+    }
+    return size;
+}
+
+static void emitNamespaces(struct Generator *gen)
+{
+    FILE *out = gen->out;
+    fprintf(out, "static const char *const %s_namespaces[%zu] = {\n",
+            gen->name, gen->namespacesSize);
+    for (size_t i = 0; i < gen->namespacesSize; i++)
+    {
+        // every server has these namespaces
+        if (i < 2)
+        {
+            fputs("    NULL,\n", out);
+            continue;
+        }
+        fputs("    ", out);
+        printBytes(out, gen->namespaces[i].data, gen->namespaces[i].length);
+        fputs(",\n", out);
+    }
+    fputs("};\n\n", out);
+}
+
+static size_t emitDataTypes(struct Generator *gen)
+{
+    FILE *out = gen->out;
+    size_t cnt = 0;
+    for (size_t i = 0; i < gen->nodes.size; i++)
+    {
+        const NL_DataTypeNode *node =
+            (const NL_DataTypeNode *)gen->nodes.nodes[i];
+        if (node->nodeClass != NODECLASS_DATATYPE || !node->definition ||
+            !node->definition->fieldCnt)
+        {
+            continue;
+        }
+        fprintf(out, "static const NodesetLoader_GeneratedField %s_fields%zu[] = {\n",
+                gen->name, i);
+        for (size_t j = 0; j < node->definition->fieldCnt; j++)
+        {
+            const NL_DataTypeDefinitionField *f = &node->definition->fields[j];
+            fputs("    {", out);
+            printString(out, f->name);
+            fputs(", ", out);
+            printNodeId(out, &f->dataType);
+            fprintf(out, ", %d, %d, %s},\n", f->valueRank, f->value,
+                    f->isOptional ? "true" : "false");
+        }
+        fputs("};\n", out);
+    }
+
+    for (size_t i = 0; i < gen->nodes.size; i++)
+    {
+        const NL_DataTypeNode *node =
+            (const NL_DataTypeNode *)gen->nodes.nodes[i];
+        if (node->nodeClass != NODECLASS_DATATYPE)
+        {
+            continue;
+        }
+        if (!cnt)
+        {
+            fprintf(out,
+                    "\nstatic const NodesetLoader_GeneratedDataType "
+                    "%s_dataTypes[] = {\n",
+                    gen->name);
+        }
+        cnt++;
+        const NL_Reference *supertype =
+            getHierachicalInverseReference((const NL_Node *)node);
+        const UA_DataType *type =
+            NodesetLoader_getCustomDataType(gen->server, &node->id);
+        const UA_NodeId parent = getParentType(gen->server, node->id);
+        fputs("    {.id = ", out);
+        printNodeId(out, &node->id);
+        fputs(",\n     .name = ", out);
+        printString(out, node->browseName.name);
+        fputs(",\n     .supertype = ", out);
+        printNodeId(out, supertype ? &supertype->target : &UA_NODEID_NULL);
+        fputs(",\n     .parent = ", out);
+        printNodeId(out, &parent);
+        fputs(",\n     .binaryEncodingId = ", out);
+        printNodeId(out, type ? &type->binaryEncodingId : &UA_NODEID_NULL);
+        if (node->definition)
+        {
+            const NL_DataTypeDefinition *def = node->definition;
+            if (def->fieldCnt)
+            {
+                fprintf(out, ",\n     .fields = %s_fields%zu,\n     .fieldsSize = %zu",
+                        gen->name, i, def->fieldCnt);
+            }
+            fprintf(out,
+                    ",\n     .hasDefinition = true, .isEnum = %s, .isUnion = "
+                    "%s, .isOptionSet = %s",
+                    def->isEnum ? "true" : "false",
+                    def->isUnion ? "true" : "false",
+                    def->isOptionSet ? "true" : "false");
+        }
+        fputs("},\n", out);
+    }
+    if (cnt)
+    {
+        fputs("};\n\n", out);
+    }
+    return cnt;
+}
+
+// returns false if the node has no value, sets the array length for the
+// array dimensions
+static bool emitValue(struct Generator *gen, size_t index, const NL_Node *node,
+                      size_t *arrayLength)
+{
+    FILE *out = gen->out;
+    UA_Variant var;
+    UA_Variant_init(&var);
+    if (UA_Server_readValue(gen->server, node->id, &var) != UA_STATUSCODE_GOOD ||
+        UA_Variant_isEmpty(&var))
+    {
+        UA_Variant_clear(&var);
+        return false;
+    }
+    const bool isArray = !UA_Variant_isScalar(&var);
+    const size_t size = isArray ? var.arrayLength : 1;
+    *arrayLength = isArray ? var.arrayLength : 0;
+    if (size)
+    {
+        fprintf(out, "static const UA_ByteString %s_value%zu[] = {\n",
+                gen->name, index);
+        for (size_t i = 0; i < size; i++)
+        {
+            UA_ByteString encoded = UA_BYTESTRING_NULL;
+            UA_encodeBinary((const char *)var.data + i * var.type->memSize,
+                            var.type, &encoded);
+            fputs("    ", out);
+            printByteString(out, &encoded);
+            fputs(",\n", out);
+            UA_ByteString_clear(&encoded);
+        }
+        fputs("};\n", out);
+    }
+    fprintf(out, "static const NodesetLoader_GeneratedValue %s_valueInfo%zu = {",
+            gen->name, index);
+    printNodeId(out, &var.type->typeId);
+    if (size)
+    {
+        fprintf(out, ", %s, %s_value%zu, %zu};\n", isArray ? "true" : "false",
+                gen->name, index, size);
+    }
+    else
+    {
+        fprintf(out, ", %s, NULL, 0};\n", isArray ? "true" : "false");
+    }
+    UA_Variant_clear(&var);
+    return true;
+}
+
+static void emitArrayDimensions(struct Generator *gen, size_t index,
+                                const UA_UInt32 *dims, size_t size)
+{
+    fprintf(gen->out, "static const UA_UInt32 %s_dims%zu[] = {", gen->name,
+            index);
+    for (size_t i = 0; i < size; i++)
+    {
+        fprintf(gen->out, "%s%uu", i ? ", " : "", (unsigned)dims[i]);
+    }
+    fputs("};\n", gen->out);
+}
+
+static void printField(FILE *out, const char *name, const char *s)
+{
+    fprintf(out, ",\n     .%s = ", name);
+    printString(out, s);
+}
+
+static void printIdField(FILE *out, const char *name, const UA_NodeId *id)
+{
+    fprintf(out, ",\n     .%s = ", name);
+    printNodeId(out, id);
+}
+
+// The values and array dimensions are emitted in front of the node table,
+// the flags tell the node which ones it has. The array dimensions are
+// completed like the open62541 backend does it.
+enum
+{
+    HAS_VALUE = 1,
+    HAS_DIMS = 2
+};
+
+static unsigned emitNodeData(struct Generator *gen, size_t index,
+                             const NL_Node *node)
+{
+    unsigned flags = 0;
+    UA_UInt32 dims[32];
+    size_t dimsSize = 0;
+    if (node->nodeClass == NODECLASS_VARIABLE)
+    {
+        const NL_VariableNode *var = (const NL_VariableNode *)node;
+        size_t arrayLength = 0;
+        if (emitValue(gen, index, node, &arrayLength))
+        {
+            flags |= HAS_VALUE;
+        }
+        dimsSize = getArrayDimensions(var->arrayDimensions, dims, 32);
+        if (!dimsSize && atoi(var->valueRank) == 1)
+        {
+            dims[dimsSize++] = 0;
+        }
+        if (!dimsSize && arrayLength)
+        {
+            dims[dimsSize++] = (UA_UInt32)arrayLength;
+        }
+    }
+    else if (node->nodeClass == NODECLASS_VARIABLETYPE)
+    {
+        const NL_VariableTypeNode *type = (const NL_VariableTypeNode *)node;
+        if (atoi(type->valueRank) >= 0 && !strcmp(type->arrayDimensions, ""))
+        {
+            dims[dimsSize++] = 0;
+        }
+    }
+    if (dimsSize)
+    {
+        emitArrayDimensions(gen, index, dims, dimsSize);
+        flags |= HAS_DIMS;
+    }
+    return flags;
+}
+
+static const char *NODECLASS_ENUM[NL_NODECLASS_COUNT] = {
+    "UA_NODECLASS_OBJECT",        "UA_NODECLASS_OBJECTTYPE",
+    "UA_NODECLASS_VARIABLE",      "UA_NODECLASS_DATATYPE",
+    "UA_NODECLASS_METHOD",        "UA_NODECLASS_REFERENCETYPE",
+    "UA_NODECLASS_VARIABLETYPE",  "UA_NODECLASS_VIEW"};
+
+static void emitNode(struct Generator *gen, size_t index, const NL_Node *node,
+                     unsigned flags)
+{
+    FILE *out = gen->out;
+    UA_NodeId parentRefId = UA_NODEID_NULL;
+    const UA_NodeId parentId = getParentId(node, &parentRefId);
+    fprintf(out, "    {.nodeClass = %s", NODECLASS_ENUM[node->nodeClass]);
+    printIdField(out, "id", &node->id);
+    printIdField(out, "parentId", &parentId);
+    printIdField(out, "parentReferenceType", &parentRefId);
+    fprintf(out, ",\n     .browseNameNs = %u", node->browseName.nsIdx);
+    printField(out, "browseName", node->browseName.name);
+    printField(out, "displayNameLocale", node->displayName.locale);
+    printField(out, "displayName", node->displayName.text);
+    printField(out, "descriptionLocale", node->description.locale);
+    printField(out, "description", node->description.text);
+
+    switch (node->nodeClass)
+    {
+    case NODECLASS_OBJECT:
+    {
+        const NL_ObjectNode *obj = (const NL_ObjectNode *)node;
+        if (obj->refToTypeDef)
+        {
+            printIdField(out, "typeDefinition", &obj->refToTypeDef->target);
+        }
+        fprintf(out, ",\n     .eventNotifier = %d",
+                (UA_Byte)atoi(obj->eventNotifier));
+        break;
+    }
+    case NODECLASS_OBJECTTYPE:
+        fprintf(out, ",\n     .isAbstract = %s",
+                isValTrue(((const NL_ObjectTypeNode *)node)->isAbstract)
+                    ? "true"
+                    : "false");
+        break;
+    case NODECLASS_VARIABLE:
+    {
+        const NL_VariableNode *var = (const NL_VariableNode *)node;
+        if (var->refToTypeDef)
+        {
+            printIdField(out, "typeDefinition", &var->refToTypeDef->target);
+        }
+        printIdField(out, "dataType", &var->datatype);
+        fprintf(out,
+                ",\n     .valueRank = %d, .accessLevel = %d, "
+                ".userAccessLevel = %d, .historizing = %s",
+                atoi(var->valueRank), (UA_Byte)atoi(var->accessLevel),
+                (UA_Byte)atoi(var->userAccessLevel),
+                isValTrue(var->historizing) ? "true" : "false");
+        fprintf(out, ",\n     .minimumSamplingInterval = %.17g",
+                atof(var->minimumSamplingInterval));
+        break;
+    }
+    case NODECLASS_VARIABLETYPE:
+    {
+        const NL_VariableTypeNode *type = (const NL_VariableTypeNode *)node;
+        printIdField(out, "dataType", &type->datatype);
+        fprintf(out, ",\n     .valueRank = %d, .isAbstract = %s",
+                atoi(type->valueRank),
+                isValTrue(type->isAbstract) ? "true" : "false");
+        break;
+    }
+    case NODECLASS_DATATYPE:
+        fprintf(out, ",\n     .isAbstract = %s",
+                isValTrue(((const NL_DataTypeNode *)node)->isAbstract)
+                    ? "true"
+                    : "false");
+        break;
+    case NODECLASS_METHOD:
+    {
+        const NL_MethodNode *method = (const NL_MethodNode *)node;
+        fprintf(out, ",\n     .executable = %s, .userExecutable = %s",
+                isValTrue(method->executable) ? "true" : "false",
+                isValTrue(method->userExecutable) ? "true" : "false");
+        break;
+    }
+    case NODECLASS_REFERENCETYPE:
+    {
+        const NL_ReferenceTypeNode *ref = (const NL_ReferenceTypeNode *)node;
+        fprintf(out, ",\n     .symmetric = %s",
+                isValTrue(ref->symmetric) ? "true" : "false");
+        printField(out, "inverseNameLocale", ref->inverseName.locale);
+        printField(out, "inverseName", ref->inverseName.text);
+        break;
+    }
+    case NODECLASS_VIEW:
+    {
+        const NL_ViewNode *view = (const NL_ViewNode *)node;
+        fprintf(out, ",\n     .eventNotifier = %d, .containsNoLoops = %s",
+                (UA_Byte)atoi(view->eventNotifier),
+                isValTrue(view->containsNoLoops) ? "true" : "false");
+        break;
+    }
+    }
+    if (flags & HAS_DIMS)
+    {
+        fprintf(out,
+                ",\n     .arrayDimensions = %s_dims%zu,\n"
+                "     .arrayDimensionsSize = sizeof(%s_dims%zu) / "
+                "sizeof(UA_UInt32)",
+                gen->name, index, gen->name, index);
+    }
+    if (flags & HAS_VALUE)
+    {
+        fprintf(out, ",\n     .value = &%s_valueInfo%zu", gen->name, index);
+    }
+    fputs("},\n", out);
+}
+
+static size_t emitReferences(struct Generator *gen)
+{
+    FILE *out = gen->out;
+    size_t cnt = 0;
+    for (size_t i = 0; i < gen->nodes.size; i++)
+    {
+        const NL_Node *node = gen->nodes.nodes[i];
+        NL_Reference *lists[2] = {node->nonHierachicalRefs,
+                                  node->hierachicalRefs};
+        for (size_t l = 0; l < 2; l++)
+        {
+            for (const NL_Reference *ref = lists[l]; ref; ref = ref->next)
+            {
+                if (l == 1 && isParentReference(gen->loader, node, ref))
+                {
+                    continue;
+                }
+                if (!cnt)
+                {
+                    fprintf(out,
+                            "static const NodesetLoader_GeneratedReference "
+                            "%s_references[] = {\n",
+                            gen->name);
+                }
+                cnt++;
+                fprintf(out, "    {%zu, ", i);
+                printNodeId(out, &ref->refType);
+                fputs(", ", out);
+                printNodeId(out, &ref->target);
+                fprintf(out, ", %s},\n", ref->isForward ? "true" : "false");
+            }
+        }
+    }
+    if (cnt)
+    {
+        fputs("};\n\n", out);
+    }
+    return cnt;
+}
+
+static void emitSource(struct Generator *gen, const char *header)
+{
+    FILE *out = gen->out;
+    const char *base = strrchr(header, '/');
+    fputs("/* generated by nodesetCodegen, do not edit */\n\n", out);
+    fprintf(out, "#include \"%s\"\n\n", base ? base + 1 : header);
+    emitNamespaces(gen);
+    size_t dataTypesSize = emitDataTypes(gen);
+
+    unsigned *flags = (unsigned *)calloc(gen->nodes.size + 1, sizeof(unsigned));
+    for (size_t i = 0; i < gen->nodes.size; i++)
+    {
+        flags[i] = emitNodeData(gen, i, gen->nodes.nodes[i]);
+    }
+    if (gen->nodes.size)
+    {
+        fprintf(out, "\nstatic const NodesetLoader_GeneratedNode %s_nodes[] = {\n",
+                gen->name);
+        for (size_t i = 0; i < gen->nodes.size; i++)
+        {
+            emitNode(gen, i, gen->nodes.nodes[i], flags[i]);
+        }
+        fputs("};\n\n", out);
+    }
+    free(flags);
+    size_t referencesSize = emitReferences(gen);
+
+    fprintf(out, "const NodesetLoader_GeneratedNodeset %s = {\n", gen->name);
+    fprintf(out, "    %s_namespaces, %zu,\n", gen->name, gen->namespacesSize);
+    if (dataTypesSize)
+    {
+        fprintf(out, "    %s_dataTypes, %zu,\n", gen->name, dataTypesSize);
+    }
+    else
+    {
+        fputs("    NULL, 0,\n", out);
+    }
+    if (gen->nodes.size)
+    {
+        fprintf(out, "    %s_nodes, %zu,\n", gen->name, gen->nodes.size);
+    }
+    else
+    {
+        fputs("    NULL, 0,\n", out);
+    }
+    if (referencesSize)
+    {
+        fprintf(out, "    %s_references, %zu};\n", gen->name, referencesSize);
+    }
+    else
+    {
+        fputs("    NULL, 0};\n", out);
+    }
+}
+
+static void emitHeader(FILE *out, const char *name)
+{
+    fputs("/* generated by nodesetCodegen, do not edit */\n\n", out);
+    fprintf(out, "#ifndef %s_GENERATED_H\n#define %s_GENERATED_H\n\n", name,
+            name);
+    fputs("#include <NodesetLoader/generated.h>\n\n", out);
+    fputs("#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n", out);
+    fprintf(out, "extern const NodesetLoader_GeneratedNodeset %s;\n\n", name);
+    fputs("#ifdef __cplusplus\n}\n#endif\n#endif\n", out);
+}
+
+static bool readNamespaces(struct Generator *gen)
+{
+    UA_Variant var;
+    UA_Variant_init(&var);
+    if (UA_Server_readValue(gen->server,
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY),
+                            &var) != UA_STATUSCODE_GOOD ||
+        !UA_Variant_hasArrayType(&var, &UA_TYPES[UA_TYPES_STRING]))
+    {
+        UA_Variant_clear(&var);
+        return false;
+    }
+    gen->namespaces = (UA_String *)var.data;
+    gen->namespacesSize = var.arrayLength;
+    // the array is owned by the generator now
+    UA_Variant_init(&var);
+    return true;
+}
+
+static bool parse(struct Generator *gen, int fileCnt, char **files)
+{
+    for (int i = 0; i < fileCnt; i++)
+    {
+        if (!NodesetLoader_loadFile(gen->server, files[i], NULL))
+        {
+            fprintf(stderr, "nodesetCodegen: could not load %s\n", files[i]);
+            return false;
+        }
+    }
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.userContext = gen->server;
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(NL_ImportOptions));
+    // the values are read from the scratch server
+    options.skipAttributes = NL_ATTRIBUTE_VALUE | NL_ATTRIBUTE_EXTENSIONS;
+    gen->loader = NodesetLoader_new(NULL, NULL);
+    for (int i = 0; i < fileCnt; i++)
+    {
+        handler.file = files[i];
+        if (!NodesetLoader_importFileWithOptions(gen->loader, &handler,
+                                                 &options))
+        {
+            fprintf(stderr, "nodesetCodegen: could not parse %s\n", files[i]);
+            return false;
+        }
+    }
+    if (!NodesetLoader_sort(gen->loader))
+    {
+        fprintf(stderr, "nodesetCodegen: could not sort the nodes\n");
+        return false;
+    }
+    // the order of NodesetLoader_loadFile
+    const NL_NodeClass order[NL_NODECLASS_COUNT] = {
+        NODECLASS_REFERENCETYPE, NODECLASS_DATATYPE, NODECLASS_OBJECTTYPE,
+        NODECLASS_VARIABLETYPE,  NODECLASS_OBJECT,   NODECLASS_METHOD,
+        NODECLASS_VARIABLE,      NODECLASS_VIEW};
+    for (size_t i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        NodesetLoader_forEachNode(gen->loader, order[i], &gen->nodes,
+                                  (NodesetLoader_forEachNode_Func)addToList);
+    }
+    return readNamespaces(gen);
+}
+
+static bool writeFile(const char *path, struct Generator *gen,
+                      const char *header)
+{
+    gen->out = fopen(path, "w");
+    if (!gen->out)
+    {
+        fprintf(stderr, "nodesetCodegen: could not open %s\n", path);
+        return false;
+    }
+    if (header)
+    {
+        emitSource(gen, header);
+    }
+    else
+    {
+        emitHeader(gen->out, gen->name);
+    }
+    bool success = !ferror(gen->out);
+    success = !fclose(gen->out) && success;
+    gen->out = NULL;
+    return success;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 5)
+    {
+        fprintf(stderr,
+                "usage: nodesetCodegen name out.c out.h nodeset.xml...\n");
+        return 1;
+    }
+    struct Generator gen;
+    memset(&gen, 0, sizeof(struct Generator));
+    gen.name = argv[1];
+    if (!isIdentifier(gen.name))
+    {
+        fprintf(stderr, "nodesetCodegen: %s is no C identifier\n", gen.name);
+        return 1;
+    }
+    gen.server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(gen.server));
+
+    bool success = parse(&gen, argc - 4, argv + 4) &&
+                   writeFile(argv[3], &gen, NULL) &&
+                   writeFile(argv[2], &gen, argv[3]);
+
+    NodesetLoader_delete(gen.loader);
+    free(gen.nodes.nodes);
+    UA_Array_delete(gen.namespaces, gen.namespacesSize,
+                    &UA_TYPES[UA_TYPES_STRING]);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(gen.server)->customDataTypes;
+#endif
+    UA_Server_delete(gen.server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+    return success ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __NODESETLOADER_GENERATED_H__
+#define __NODESETLOADER_GENERATED_H__
+
+#include <open62541/server.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+#ifdef __GNUC__
+#define LOADER_EXPORT __attribute__((dllexport))
+#else
+#define LOADER_EXPORT __declspec(dllexport)
+#endif
+#else /* non win32 */
+#if __GNUC__ || __clang__
+#define LOADER_EXPORT __attribute__((visibility("default")))
+#endif
+#endif
+#ifndef LOADER_EXPORT
+#define LOADER_EXPORT /* fallback to default */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tables emitted by nodesetCodegen, see nodesetloader_generate_c in
+// NodesetLoaderCodegen.cmake. All NodeIds, browse names and the NodeIds and
+// QualifiedNames inside the values use the namespace indices of the
+// generator, index i refers to namespaces[i]. Indices 0 and 1 are the
+// namespaces every server has, their uris are NULL.
+
+typedef struct
+{
+    const char *name;
+    UA_NodeId dataType;
+    UA_Int32 valueRank;
+    UA_Int32 value;
+    UA_Boolean isOptional;
+} NodesetLoader_GeneratedField;
+
+// definition of a custom data type, the UA_DataType is built by the runtime
+// for the memory layout of the target
+typedef struct
+{
+    UA_NodeId id;
+    const char *name;
+    UA_NodeId supertype;
+    // supertype of namespace 0 which decides on the kind of the type
+    UA_NodeId parent;
+    UA_NodeId binaryEncodingId;
+    const NodesetLoader_GeneratedField *fields;
+    size_t fieldsSize;
+    UA_Boolean hasDefinition;
+    UA_Boolean isEnum;
+    UA_Boolean isUnion;
+    UA_Boolean isOptionSet;
+} NodesetLoader_GeneratedDataType;
+
+// the binary encoding of every element, one element for scalars
+typedef struct
+{
+    UA_NodeId typeId;
+    UA_Boolean isArray;
+    const UA_ByteString *elements;
+    size_t elementsSize;
+} NodesetLoader_GeneratedValue;
+
+// the attributes which don't apply to the node class are zero
+typedef struct
+{
+    UA_NodeClass nodeClass;
+    UA_NodeId id;
+    UA_NodeId parentId;
+    UA_NodeId parentReferenceType;
+    UA_NodeId typeDefinition;
+    UA_UInt16 browseNameNs;
+    const char *browseName;
+    const char *displayNameLocale;
+    const char *displayName;
+    const char *descriptionLocale;
+    const char *description;
+    UA_NodeId dataType;
+    UA_Int32 valueRank;
+    const UA_UInt32 *arrayDimensions;
+    size_t arrayDimensionsSize;
+    UA_Byte accessLevel;
+    UA_Byte userAccessLevel;
+    UA_Byte eventNotifier;
+    UA_Boolean isAbstract;
+    UA_Boolean symmetric;
+    UA_Boolean historizing;
+    UA_Boolean executable;
+    UA_Boolean userExecutable;
+    UA_Boolean containsNoLoops;
+    UA_Double minimumSamplingInterval;
+    const char *inverseNameLocale;
+    const char *inverseName;
+    // NULL if the node has no value
+    const NodesetLoader_GeneratedValue *value;
+} NodesetLoader_GeneratedNode;
+
+// references which are not added with the parent of a node
+typedef struct
+{
+    // index into the nodes
+    size_t source;
+    UA_NodeId refType;
+    UA_NodeId target;
+    UA_Boolean isForward;
+} NodesetLoader_GeneratedReference;
+
+typedef struct
+{
+    const char *const *namespaces;
+    size_t namespacesSize;
+    const NodesetLoader_GeneratedDataType *dataTypes;
+    size_t dataTypesSize;
+    // in the order they are inserted
+    const NodesetLoader_GeneratedNode *nodes;
+    size_t nodesSize;
+    const NodesetLoader_GeneratedReference *references;
+    size_t referencesSize;
+} NodesetLoader_GeneratedNodeset;
+
+// Adds the namespaces, registers the data types in the custom data types of
+// the server config and inserts the nodes and references, like
+// NodesetLoader_loadFileWithOptions in bulk insert mode. The custom data types
+// are released like the ones of the loader, see
+// NodesetLoader_cleanupCustomDataTypes. Returns false if one of the nodes
+// couldn't be added.
+LOADER_EXPORT bool
+NodesetLoader_loadGenerated(UA_Server *server,
+                            const NodesetLoader_GeneratedNodeset *nodeset);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
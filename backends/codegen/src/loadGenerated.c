@@ -0,0 +1,535 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/types.h>
+
+#include "DataTypeImporter.h"
+#include "NodesetLoader/dataTypes.h"
+#include "NodesetLoader/generated.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct LoadCtx
+{
+    UA_Server *server;
+    // namespace index of the server for every namespace index of the
+    // generator
+    UA_UInt16 *namespaces;
+    size_t namespacesSize;
+};
+typedef struct LoadCtx LoadCtx;
+
+static UA_UInt16 translateIdx(const LoadCtx *ctx, UA_UInt16 idx)
+{
+    if (idx < ctx->namespacesSize)
+    {
+        return ctx->namespaces[idx];
+    }
+    return idx;
+}
+
+// the identifier is not copied
+static UA_NodeId translate(const LoadCtx *ctx, UA_NodeId id)
+{
+    id.namespaceIndex = translateIdx(ctx, id.namespaceIndex);
+    return id;
+}
+
+static bool addNamespaces(LoadCtx *ctx,
+                          const NodesetLoader_GeneratedNodeset *nodeset)
+{
+    ctx->namespacesSize = nodeset->namespacesSize;
+    ctx->namespaces =
+        (UA_UInt16 *)calloc(nodeset->namespacesSize + 1, sizeof(UA_UInt16));
+    if (!ctx->namespaces)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < nodeset->namespacesSize; i++)
+    {
+        ctx->namespaces[i] =
+            nodeset->namespaces[i]
+                ? UA_Server_addNamespace(ctx->server, nodeset->namespaces[i])
+                : (UA_UInt16)i;
+    }
+    return true;
+}
+
+// Feeds the definitions to the DataTypeImporter, which computes the memory
+// layout of the types like for a parsed nodeset. The nodes only live until
+// the members are initialized.
+static bool importDataTypes(const LoadCtx *ctx,
+                            const NodesetLoader_GeneratedNodeset *nodeset)
+{
+    if (nodeset->dataTypesSize == 0)
+    {
+        return true;
+    }
+    const size_t size = nodeset->dataTypesSize;
+    NL_DataTypeNode *nodes =
+        (NL_DataTypeNode *)calloc(size, sizeof(NL_DataTypeNode));
+    NL_DataTypeDefinition *definitions =
+        (NL_DataTypeDefinition *)calloc(size, sizeof(NL_DataTypeDefinition));
+    // the supertype and the binary encoding of every type
+    NL_Reference *refs = (NL_Reference *)calloc(2 * size, sizeof(NL_Reference));
+    DataTypeImporter *importer = DataTypeImporter_new(ctx->server);
+    bool success = nodes && definitions && refs && importer;
+    for (size_t i = 0; success && i < size; i++)
+    {
+        const NodesetLoader_GeneratedDataType *type = &nodeset->dataTypes[i];
+        NL_DataTypeNode *node = &nodes[i];
+        node->nodeClass = NODECLASS_DATATYPE;
+        node->id = translate(ctx, type->id);
+        node->browseName.name = (char *)(uintptr_t)type->name;
+
+        NL_Reference *supertype = &refs[2 * i];
+        supertype->isForward = false;
+        supertype->refType = UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE);
+        supertype->target = translate(ctx, type->supertype);
+        node->hierachicalRefs = supertype;
+
+        if (!UA_NodeId_isNull(&type->binaryEncodingId))
+        {
+            NL_Reference *encoding = &refs[2 * i + 1];
+            encoding->isForward = true;
+            encoding->refType = UA_NODEID_NUMERIC(0, UA_NS0ID_HASENCODING);
+            encoding->target = translate(ctx, type->binaryEncodingId);
+            node->nonHierachicalRefs = encoding;
+        }
+
+        if (type->hasDefinition)
+        {
+            NL_DataTypeDefinition *def = &definitions[i];
+            def->isEnum = type->isEnum;
+            def->isUnion = type->isUnion;
+            def->isOptionSet = type->isOptionSet;
+            def->fieldCnt = type->fieldsSize;
+            def->fields = (NL_DataTypeDefinitionField *)calloc(
+                type->fieldsSize + 1, sizeof(NL_DataTypeDefinitionField));
+            if (!def->fields)
+            {
+                success = false;
+                break;
+            }
+            for (size_t j = 0; j < type->fieldsSize; j++)
+            {
+                const NodesetLoader_GeneratedField *field = &type->fields[j];
+                def->fields[j].name = (char *)(uintptr_t)field->name;
+                def->fields[j].dataType = translate(ctx, field->dataType);
+                def->fields[j].valueRank = field->valueRank;
+                def->fields[j].value = field->value;
+                def->fields[j].isOptional = field->isOptional;
+            }
+            node->definition = def;
+        }
+        DataTypeImporter_addCustomDataType(importer, node,
+                                           translate(ctx, type->parent));
+    }
+    if (success)
+    {
+        DataTypeImporter_initMembers(importer);
+    }
+    DataTypeImporter_delete(importer);
+    for (size_t i = 0; definitions && i < size; i++)
+    {
+        free(definitions[i].fields);
+    }
+    free(definitions);
+    free(refs);
+    free(nodes);
+    return success;
+}
+
+static void translateValue(const LoadCtx *ctx, void *p, const UA_DataType *type);
+
+static void translateArray(const LoadCtx *ctx, void *p, size_t size,
+                           const UA_DataType *type)
+{
+    if (!p || p == UA_EMPTY_ARRAY_SENTINEL)
+    {
+        return;
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        translateValue(ctx, (char *)p + i * type->memSize, type);
+    }
+}
+
+static void translateMembers(const LoadCtx *ctx, void *p,
+                             const UA_DataType *type)
+{
+    uintptr_t adr = (uintptr_t)p;
+    for (size_t i = 0; i < type->membersSize; i++)
+    {
+        const UA_DataTypeMember *m = &type->members[i];
+        adr += m->padding;
+        if (m->isArray)
+        {
+            translateArray(ctx, *(void **)(adr + sizeof(size_t)),
+                           *(size_t *)adr, m->memberType);
+            adr += sizeof(size_t) + sizeof(void *);
+        }
+        else if (m->isOptional)
+        {
+            translateArray(ctx, *(void **)adr, 1, m->memberType);
+            adr += sizeof(void *);
+        }
+        else
+        {
+            translateValue(ctx, (void *)adr, m->memberType);
+            adr += m->memberType->memSize;
+        }
+    }
+}
+
+// the values are encoded with the namespace indices of the generator
+static void translateValue(const LoadCtx *ctx, void *p, const UA_DataType *type)
+{
+    switch (type->typeKind)
+    {
+    case UA_DATATYPEKIND_NODEID:
+        ((UA_NodeId *)p)->namespaceIndex =
+            translateIdx(ctx, ((UA_NodeId *)p)->namespaceIndex);
+        break;
+    case UA_DATATYPEKIND_EXPANDEDNODEID:
+        ((UA_ExpandedNodeId *)p)->nodeId.namespaceIndex =
+            translateIdx(ctx, ((UA_ExpandedNodeId *)p)->nodeId.namespaceIndex);
+        break;
+    case UA_DATATYPEKIND_QUALIFIEDNAME:
+        ((UA_QualifiedName *)p)->namespaceIndex =
+            translateIdx(ctx, ((UA_QualifiedName *)p)->namespaceIndex);
+        break;
+    case UA_DATATYPEKIND_VARIANT:
+    {
+        UA_Variant *var = (UA_Variant *)p;
+        if (var->type)
+        {
+            translateArray(ctx, var->data,
+                           UA_Variant_isScalar(var) ? 1 : var->arrayLength,
+                           var->type);
+        }
+        break;
+    }
+    case UA_DATATYPEKIND_EXTENSIONOBJECT:
+    {
+        UA_ExtensionObject *eo = (UA_ExtensionObject *)p;
+        if (eo->encoding >= UA_EXTENSIONOBJECT_DECODED && eo->content.decoded.type)
+        {
+            translateValue(ctx, eo->content.decoded.data,
+                           eo->content.decoded.type);
+        }
+        else
+        {
+            eo->content.encoded.typeId.namespaceIndex = translateIdx(
+                ctx, eo->content.encoded.typeId.namespaceIndex);
+        }
+        break;
+    }
+    case UA_DATATYPEKIND_STRUCTURE:
+    case UA_DATATYPEKIND_OPTSTRUCT:
+        translateMembers(ctx, p, type);
+        break;
+    default:
+        break;
+    }
+}
+
+static const UA_DataType *findType(const LoadCtx *ctx, const UA_NodeId *typeId)
+{
+    const UA_DataType *type = UA_findDataType(typeId);
+    if (!type)
+    {
+        type = NodesetLoader_getCustomDataType(ctx->server, typeId);
+    }
+    return type;
+}
+
+static bool decodeValue(const LoadCtx *ctx,
+                        const NodesetLoader_GeneratedValue *value,
+                        UA_Variant *out)
+{
+    const UA_NodeId typeId = translate(ctx, value->typeId);
+    const UA_DataType *type = findType(ctx, &typeId);
+    if (!type)
+    {
+        return false;
+    }
+    void *data = UA_Array_new(value->elementsSize, type);
+    if (!data)
+    {
+        return false;
+    }
+    UA_DecodeBinaryOptions options;
+    memset(&options, 0, sizeof(UA_DecodeBinaryOptions));
+    options.customTypes = UA_Server_getConfig(ctx->server)->customDataTypes;
+    for (size_t i = 0; i < value->elementsSize; i++)
+    {
+        void *element = (char *)data + i * type->memSize;
+        if (UA_decodeBinary(&value->elements[i], element, type, &options) !=
+            UA_STATUSCODE_GOOD)
+        {
+            UA_Array_delete(data, value->elementsSize, type);
+            return false;
+        }
+        translateValue(ctx, element, type);
+    }
+    if (value->isArray)
+    {
+        UA_Variant_setArray(out, data, value->elementsSize, type);
+    }
+    else
+    {
+        UA_Variant_setScalar(out, data, type);
+    }
+    return true;
+}
+
+static UA_StatusCode addVariableNode(const LoadCtx *ctx,
+                                     const NodesetLoader_GeneratedNode *node,
+                                     const UA_NodeId *id,
+                                     const UA_NodeId *parentId,
+                                     const UA_NodeId *parentReferenceId,
+                                     const UA_QualifiedName *qn,
+                                     const UA_LocalizedText *lt,
+                                     const UA_LocalizedText *description)
+{
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = *lt;
+    attr.description = *description;
+    attr.dataType = translate(ctx, node->dataType);
+    attr.valueRank = node->valueRank;
+    attr.arrayDimensionsSize = node->arrayDimensionsSize;
+    attr.arrayDimensions = (UA_UInt32 *)(uintptr_t)node->arrayDimensions;
+    attr.accessLevel = node->accessLevel;
+    attr.userAccessLevel = node->userAccessLevel;
+    attr.historizing = node->historizing;
+    attr.minimumSamplingInterval = node->minimumSamplingInterval;
+    if (node->value && !decodeValue(ctx, node->value, &attr.value))
+    {
+        UA_Variant_init(&attr.value);
+    }
+    // value is copied by open62541
+    UA_StatusCode status = UA_Server_addNode_begin(
+        ctx->server, UA_NODECLASS_VARIABLE, *id, *parentId, *parentReferenceId,
+        *qn, translate(ctx, node->typeDefinition), &attr,
+        &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES], NULL, NULL);
+    UA_Variant_clear(&attr.value);
+    return status;
+}
+
+// the same calls as the open62541 backend in bulk insert mode
+static UA_StatusCode addNode(const LoadCtx *ctx,
+                             const NodesetLoader_GeneratedNode *node)
+{
+    const UA_NodeId id = translate(ctx, node->id);
+    const UA_NodeId parentId = translate(ctx, node->parentId);
+    const UA_NodeId parentReferenceId =
+        translate(ctx, node->parentReferenceType);
+    const UA_QualifiedName qn =
+        UA_QUALIFIEDNAME(translateIdx(ctx, node->browseNameNs),
+                         (char *)(uintptr_t)node->browseName);
+    const UA_LocalizedText lt =
+        UA_LOCALIZEDTEXT((char *)(uintptr_t)node->displayNameLocale,
+                         (char *)(uintptr_t)node->displayName);
+    const UA_LocalizedText description =
+        UA_LOCALIZEDTEXT((char *)(uintptr_t)node->descriptionLocale,
+                         (char *)(uintptr_t)node->description);
+
+    switch (node->nodeClass)
+    {
+    case UA_NODECLASS_OBJECT:
+    {
+        UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+        attr.displayName = lt;
+        attr.description = description;
+        attr.eventNotifier = node->eventNotifier;
+        return UA_Server_addNode_begin(
+            ctx->server, UA_NODECLASS_OBJECT, id, parentId, parentReferenceId,
+            qn, translate(ctx, node->typeDefinition), &attr,
+            &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES], NULL, NULL);
+    }
+    case UA_NODECLASS_OBJECTTYPE:
+    {
+        UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+        attr.displayName = lt;
+        attr.description = description;
+        attr.isAbstract = node->isAbstract;
+        return UA_Server_addNode_begin(
+            ctx->server, UA_NODECLASS_OBJECTTYPE, id, parentId,
+            parentReferenceId, qn, UA_NODEID_NULL, &attr,
+            &UA_TYPES[UA_TYPES_OBJECTTYPEATTRIBUTES], NULL, NULL);
+    }
+    case UA_NODECLASS_VARIABLE:
+        return addVariableNode(ctx, node, &id, &parentId, &parentReferenceId,
+                               &qn, &lt, &description);
+    case UA_NODECLASS_VARIABLETYPE:
+    {
+        UA_VariableTypeAttributes attr = UA_VariableTypeAttributes_default;
+        attr.displayName = lt;
+        attr.description = description;
+        attr.dataType = translate(ctx, node->dataType);
+        attr.valueRank = node->valueRank;
+        attr.isAbstract = node->isAbstract;
+        attr.arrayDimensionsSize = node->arrayDimensionsSize;
+        attr.arrayDimensions = (UA_UInt32 *)(uintptr_t)node->arrayDimensions;
+        return UA_Server_addNode_begin(
+            ctx->server, UA_NODECLASS_VARIABLETYPE, id, parentId,
+            parentReferenceId, qn, UA_NODEID_NULL, &attr,
+            &UA_TYPES[UA_TYPES_VARIABLETYPEATTRIBUTES], NULL, NULL);
+    }
+    case UA_NODECLASS_METHOD:
+    {
+        UA_MethodAttributes attr = UA_MethodAttributes_default;
+        attr.displayName = lt;
+        attr.description = description;
+        attr.executable = node->executable;
+        attr.userExecutable = node->userExecutable;
+        return UA_Server_addMethodNode(ctx->server, id, parentId,
+                                       parentReferenceId, qn, attr, NULL, 0,
+                                       NULL, 0, NULL, NULL, NULL);
+    }
+    case UA_NODECLASS_REFERENCETYPE:
+    {
+        UA_ReferenceTypeAttributes attr = UA_ReferenceTypeAttributes_default;
+        attr.displayName = lt;
+        attr.description = description;
+        attr.symmetric = node->symmetric;
+        attr.inverseName =
+            UA_LOCALIZEDTEXT((char *)(uintptr_t)node->inverseNameLocale,
+                             (char *)(uintptr_t)node->inverseName);
+        return UA_Server_addReferenceTypeNode(ctx->server, id, parentId,
+                                              parentReferenceId, qn, attr,
+                                              NULL, NULL);
+    }
+    case UA_NODECLASS_DATATYPE:
+    {
+        UA_DataTypeAttributes attr = UA_DataTypeAttributes_default;
+        attr.displayName = lt;
+        attr.description = description;
+        attr.isAbstract = node->isAbstract;
+        return UA_Server_addNode_begin(
+            ctx->server, UA_NODECLASS_DATATYPE, id, parentId,
+            parentReferenceId, qn, UA_NODEID_NULL, &attr,
+            &UA_TYPES[UA_TYPES_DATATYPEATTRIBUTES], NULL, NULL);
+    }
+    case UA_NODECLASS_VIEW:
+    {
+        UA_ViewAttributes attr = UA_ViewAttributes_default;
+        attr.displayName = lt;
+        attr.description = description;
+        attr.eventNotifier = node->eventNotifier;
+        attr.containsNoLoops = node->containsNoLoops;
+        return UA_Server_addNode_begin(
+            ctx->server, UA_NODECLASS_VIEW, id, parentId, parentReferenceId,
+            qn, UA_NODEID_NULL, &attr, &UA_TYPES[UA_TYPES_VIEWATTRIBUTES],
+            NULL, NULL);
+    }
+    default:
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    }
+}
+
+// Adds the nodes in table order. The nodes which fail are tried again a few
+// times, like the second chance of the open62541 backend, so a child which
+// precedes its parent in the table is added as well. Returns the number of
+// nodes which couldn't be added.
+static size_t addNodes(const LoadCtx *ctx,
+                       const NodesetLoader_GeneratedNodeset *nodeset)
+{
+    const size_t attemptsNum = 10;
+    size_t *failed = (size_t *)calloc(nodeset->nodesSize + 1, sizeof(size_t));
+    if (!failed)
+    {
+        return nodeset->nodesSize;
+    }
+    size_t failedSize = 0;
+    for (size_t i = 0; i < nodeset->nodesSize; i++)
+    {
+        if (UA_StatusCode_isBad(addNode(ctx, &nodeset->nodes[i])))
+        {
+            failed[failedSize++] = i;
+        }
+    }
+    for (size_t attempt = 1; attempt < attemptsNum && failedSize > 0; attempt++)
+    {
+        size_t stillFailed = 0;
+        for (size_t i = 0; i < failedSize; i++)
+        {
+            if (UA_StatusCode_isBad(addNode(ctx, &nodeset->nodes[failed[i]])))
+            {
+                failed[stillFailed++] = failed[i];
+            }
+        }
+        if (stillFailed == failedSize)
+        {
+            break;
+        }
+        failedSize = stillFailed;
+    }
+    free(failed);
+    return failedSize;
+}
+
+static void addReferences(const LoadCtx *ctx,
+                          const NodesetLoader_GeneratedNodeset *nodeset)
+{
+    for (size_t i = 0; i < nodeset->referencesSize; i++)
+    {
+        const NodesetLoader_GeneratedReference *ref = &nodeset->references[i];
+        if (ref->source >= nodeset->nodesSize)
+        {
+            continue;
+        }
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
+        target.nodeId = translate(ctx, ref->target);
+        UA_Server_addReference(ctx->server,
+                               translate(ctx, nodeset->nodes[ref->source].id),
+                               translate(ctx, ref->refType), target,
+                               ref->isForward);
+    }
+}
+
+// runs the constructors of the nodes which were only inserted
+static void finishNodes(const LoadCtx *ctx,
+                        const NodesetLoader_GeneratedNodeset *nodeset)
+{
+    for (size_t i = 0; i < nodeset->nodesSize; i++)
+    {
+        const NodesetLoader_GeneratedNode *node = &nodeset->nodes[i];
+        if (node->nodeClass == UA_NODECLASS_OBJECTTYPE ||
+            node->nodeClass == UA_NODECLASS_DATATYPE ||
+            node->nodeClass == UA_NODECLASS_VIEW)
+        {
+            UA_Server_addNode_finish(ctx->server, translate(ctx, node->id));
+        }
+    }
+}
+
+bool NodesetLoader_loadGenerated(UA_Server *server,
+                                 const NodesetLoader_GeneratedNodeset *nodeset)
+{
+    if (!server || !nodeset)
+    {
+        return false;
+    }
+    LoadCtx ctx;
+    memset(&ctx, 0, sizeof(LoadCtx));
+    ctx.server = server;
+    if (!addNamespaces(&ctx, nodeset))
+    {
+        return false;
+    }
+    // the types are needed to decode the values
+    bool success = importDataTypes(&ctx, nodeset);
+    if (success)
+    {
+        success = addNodes(&ctx, nodeset) == 0;
+        addReferences(&ctx, nodeset);
+        finishNodes(&ctx, nodeset);
+    }
+    free(ctx.namespaces);
+    return success;
+}
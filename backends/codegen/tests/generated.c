@@ -0,0 +1,120 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include "check.h"
+
+#include <NodesetLoader/dataTypes.h>
+#include "customTypesGenerated.h"
+
+UA_Server *server;
+
+static void setup(void)
+{
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+}
+
+static void teardown(void)
+{
+    UA_Server_run_shutdown(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(server)->customDataTypes;
+#endif
+    UA_Server_delete(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+}
+
+struct Point
+{
+    UA_Int32 x;
+    UA_Int32 y;
+};
+
+struct PointWithOffset
+{
+    struct Point offset;
+    UA_Int32 x;
+    UA_Int32 y;
+};
+
+START_TEST(Server_LoadGenerated)
+{
+    ck_assert(NodesetLoader_loadGenerated(server, &customTypesGenerated));
+
+    size_t idx = 0;
+    ck_assert_uint_eq(UA_Server_getNamespaceByName(
+                          server,
+                          UA_STRING("http://yourorganisation.org/structWithValues/"),
+                          &idx),
+                      UA_STATUSCODE_GOOD);
+    const UA_NodeId pointId = UA_NODEID_NUMERIC((UA_UInt16)idx, 3002);
+    ck_assert(NodesetLoader_getCustomDataType(server, &pointId) != NULL);
+
+    UA_Variant var;
+    UA_Variant_init(&var);
+    // Point
+    UA_StatusCode retval = UA_Server_readValue(
+        server, UA_NODEID_NUMERIC((UA_UInt16)idx, 6019), &var);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    struct Point *p = (struct Point *)var.data;
+    ck_assert(p->x == 20);
+    ck_assert(p->y == 30);
+
+    UA_Variant_clear(&var);
+}
+END_TEST
+
+START_TEST(Server_ReadPointWithOffset)
+{
+    size_t idx = 0;
+    UA_Server_getNamespaceByName(
+        server, UA_STRING("http://yourorganisation.org/structWithValues/"),
+        &idx);
+
+    UA_Variant var;
+    UA_Variant_init(&var);
+    UA_StatusCode retval = UA_Server_readValue(
+        server, UA_NODEID_NUMERIC((UA_UInt16)idx, 6018), &var);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    struct PointWithOffset *p = (struct PointWithOffset *)var.data;
+    ck_assert(p->x == 20);
+    ck_assert(p->y == 30);
+    ck_assert(p->offset.x == 1);
+    ck_assert(p->offset.y == 2);
+
+    UA_Variant_clear(&var);
+}
+END_TEST
+
+static Suite *testSuite_Client(void)
+{
+    Suite *s = suite_create("generated nodeset");
+    TCase *tc_server = tcase_create("generated nodeset");
+    tcase_add_unchecked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, Server_LoadGenerated);
+    tcase_add_test(tc_server, Server_ReadPointWithOffset);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(void)
+{
+    Suite *s = testSuite_Client();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -33,9 +33,173 @@
 extern "C" {
 #endif
 
+struct NL_ImportFilter;
+struct NL_Progress;
+
 LOADER_EXPORT bool NodesetLoader_loadFile(struct UA_Server *, const char *path,
                             NodesetLoader_ExtensionInterface *extensionHandling);
 
+// Keeps the values of variable nodes in a compact parsed form and decodes
+// them on the first read of the node. The nodes get a UA_DataSource which
+// serves the decoded value, concurrent reads decode the value only once. Only
+// used for variable nodes without extension, because the store occupies the
+// nodeContext.
+// The store must be deleted after UA_Server_delete.
+struct NodesetLoader_LazyValueStore;
+typedef struct NodesetLoader_LazyValueStore NodesetLoader_LazyValueStore;
+
+LOADER_EXPORT NodesetLoader_LazyValueStore *NodesetLoader_LazyValueStore_new(void);
+LOADER_EXPORT void
+NodesetLoader_LazyValueStore_delete(NodesetLoader_LazyValueStore *store);
+
+// zero initialize the options, unset members keep the default behaviour
+struct NodesetLoader_LoadOptions
+{
+    // optional, values are decoded eagerly if NULL
+    NodesetLoader_LazyValueStore *lazyValues;
+    // number of worker threads which decode the values of variable nodes
+    // while the other node classes are added, 0 decodes them on insertion
+    size_t valueDecodingThreads;
+    // limit of the memory used by the parsed nodeset in bytes, 0 means
+    // unlimited, see NodesetLoader_newWithBudget
+    size_t memoryBudget;
+    // frees the parse and sort structures and compacts the nodes before they
+    // are added, see NodesetLoader_compact. Ignored with a warning if an
+    // extension interface is passed, the extensions refer to the strings of
+    // the nodeset.
+    bool compact;
+    // optional, only the nodes which pass the filter are added, see
+    // NL_ImportFilter
+    const struct NL_ImportFilter *filter;
+    // NL_AttributeMask of the attributes which are not parsed and left at
+    // their defaults, e.g. the values of the variables
+    unsigned int skipAttributes;
+    // Deferred finish mode: object types, data types and views are only
+    // inserted by addNode_begin while the nodes are added, their constructors
+    // are run by one final addNode_finish pass after all nodes and references
+    // are added. References which were added with the parent of a node are
+    // not added a second time. Nodes are still added one by one, this does
+    // not batch the locking or the constructors of the server.
+    bool deferFinish;
+    // values of variables with a data type of namespace 0 are decoded while
+    // the file is parsed, without the intermediate NL_Data tree, see
+    // NL_ImportOptions.decodeValues. These values are never decoded lazily.
+    bool decodeValues;
+    // optional, an NL_ProgressCallback, see NL_ImportOptions.progress. Reports
+    // the parsing and sorting of each file and NL_PROGRESS_INSERT for every
+    // node class while the nodes are added. Cancelling the insertion keeps
+    // the nodes added so far and finishes the nodes which were only inserted,
+    // the remaining nodes and the references are not added. With
+    // NodesetLoader_loadFiles it is called from the parsing thread as well.
+    bool (*progress)(void *context, const struct NL_Progress *progress);
+    void *progressContext;
+    unsigned int progressInterval;
+    // NodesetLoader_loadFilesAsync: nodes, or the references of nodes, which
+    // are added per iteration of the server, 0 means 1000
+    size_t asyncBatchSize;
+};
+typedef struct NodesetLoader_LoadOptions NodesetLoader_LoadOptions;
+
+// options may be NULL, which is equal to NodesetLoader_loadFile
+LOADER_EXPORT bool
+NodesetLoader_loadFileWithOptions(struct UA_Server *, const char *path,
+                                  NodesetLoader_ExtensionInterface *extensionHandling,
+                                  const NodesetLoader_LoadOptions *options);
+
+// Loads the files in the given order, like calling
+// NodesetLoader_loadFileWithOptions for each of them. The next file is parsed
+// on a background thread while the nodes of the current file are added.
+// The background thread logs to the logger of the server config, which
+// must be thread-safe. Returns false if one of the files couldn't be loaded.
+LOADER_EXPORT bool
+NodesetLoader_loadFiles(struct UA_Server *, const char **paths, size_t pathsSize,
+                        NodesetLoader_ExtensionInterface *extensionHandling,
+                        const NodesetLoader_LoadOptions *options);
+
+// Keeps the reference type hierarchy of the server, the custom datatype
+// import and the resolved value types alive across files, so the server is
+// browsed once per session instead of once per file. The structures are
+// updated with the reference types and datatypes of every loaded file.
+// Reference types which are added to the server by other means after
+// NodesetLoader_Session_new are not known to the session. The options are
+// copied, the store and the filter they point to must outlive the session.
+// The session must be deleted before the server.
+struct NodesetLoader_Session;
+typedef struct NodesetLoader_Session NodesetLoader_Session;
+
+// options may be NULL for the default behaviour
+LOADER_EXPORT NodesetLoader_Session *
+NodesetLoader_Session_new(struct UA_Server *,
+                          const NodesetLoader_LoadOptions *options);
+LOADER_EXPORT void NodesetLoader_Session_delete(NodesetLoader_Session *session);
+// like NodesetLoader_loadFileWithOptions with the options of the session
+LOADER_EXPORT bool
+NodesetLoader_Session_loadFile(NodesetLoader_Session *session, const char *path,
+                               NodesetLoader_ExtensionInterface *extensionHandling);
+// like NodesetLoader_loadFiles with the options of the session
+LOADER_EXPORT bool
+NodesetLoader_Session_loadFiles(NodesetLoader_Session *session, const char **paths,
+                                size_t pathsSize,
+                                NodesetLoader_ExtensionInterface *extensionHandling);
+
+// Loads the files while the server is running. The files are parsed and
+// sorted on a background thread, the nodes are added in batches of
+// asyncBatchSize by a repeated callback of the server, so the server keeps
+// serving requests. The node classes are added in the order of the synchronous
+// import: reference types, data types, object types and variable types are
+// visible before the instances, the references are added after all nodes of
+// a file. The server has to be started before, UA_Server_run_startup or
+// UA_Server_run. The paths and options are copied. The background thread
+// logs to the logger of the server config, which must be thread-safe.
+struct NodesetLoader_AsyncImport;
+typedef struct NodesetLoader_AsyncImport NodesetLoader_AsyncImport;
+
+typedef enum
+{
+    NODESETLOADER_ASYNC_PARSING,
+    NODESETLOADER_ASYNC_INSERTING,
+    NODESETLOADER_ASYNC_DONE,
+    NODESETLOADER_ASYNC_FAILED
+} NodesetLoader_AsyncImportState;
+
+struct NodesetLoader_AsyncImportStatus
+{
+    NodesetLoader_AsyncImportState state;
+    // files which were added to the server, or failed
+    size_t filesDone;
+    size_t filesSize;
+    // while inserting: the NL_NodeClass being added, its nodes added so far
+    // and in total
+    unsigned int nodeClass;
+    size_t nodesInserted;
+    size_t nodesOfClass;
+};
+typedef struct NodesetLoader_AsyncImportStatus NodesetLoader_AsyncImportStatus;
+
+// called once from the server's main loop after the last file, status is
+// false if one of the files couldn't be loaded
+typedef void (*NodesetLoader_AsyncImport_doneCallback)(struct UA_Server *server,
+                                                       void *context,
+                                                       bool status);
+
+// options and done may be NULL, returns NULL if the import couldn't be started
+LOADER_EXPORT NodesetLoader_AsyncImport *
+NodesetLoader_loadFilesAsync(struct UA_Server *, const char **paths,
+                             size_t pathsSize,
+                             NodesetLoader_ExtensionInterface *extensionHandling,
+                             const NodesetLoader_LoadOptions *options,
+                             NodesetLoader_AsyncImport_doneCallback done,
+                             void *doneContext);
+// has to be called from the thread which runs the server
+LOADER_EXPORT void
+NodesetLoader_AsyncImport_getStatus(const NodesetLoader_AsyncImport *import,
+                                    NodesetLoader_AsyncImportStatus *status);
+// Stops an import in progress, the nodes added so far are kept and finished
+// like after a cancellation, waits for the file which is being parsed. Has to
+// be called from the thread which runs the server, before UA_Server_delete.
+LOADER_EXPORT void
+NodesetLoader_AsyncImport_delete(NodesetLoader_AsyncImport *import);
+
 #ifdef __cplusplus
 }
 #endif
@@ -698,6 +698,17 @@ DataTypeImporter *DataTypeImporter_new(struct UA_Server *server)
     return importer;
 }
 
+void DataTypeImporter_startFile(DataTypeImporter *importer)
+{
+    free((void *)importer->nodes);
+    importer->nodes = NULL;
+    importer->nodesSize = 0;
+    if (importer->types)
+    {
+        importer->firstNewDataType = importer->types->typesSize;
+    }
+}
+
 void DataTypeImporter_delete(DataTypeImporter *importer)
 {
     free((void *)importer->nodes);
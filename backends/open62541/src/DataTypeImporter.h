@@ -20,6 +20,10 @@ void DataTypeImporter_addCustomDataType(DataTypeImporter *importer,
                                         const NL_DataTypeNode *node, const UA_NodeId parentId);
 // has to be called after all dependent types where added
 void DataTypeImporter_initMembers(DataTypeImporter *importer);
+// Forgets the nodes of the previous file, the types which are added from now
+// on are initialized by the next DataTypeImporter_initMembers. Allows to reuse
+// the importer for several files.
+void DataTypeImporter_startFile(DataTypeImporter *importer);
 void DataTypeImporter_delete(DataTypeImporter *importer);
 
 #endif
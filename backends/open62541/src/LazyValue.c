@@ -0,0 +1,407 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+
+#include "LazyValue.h"
+#include "ServerContext.h"
+#include "Value.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NODESETLOADER_HAS_PTHREAD
+#include <pthread.h>
+#endif
+
+struct LazyValue
+{
+    // compact parsed value, released once it is decoded or overwritten
+    NL_Value *value;
+    // served by the data source once the value is decoded
+    UA_Variant decoded;
+    bool isDecoded;
+    const UA_DataType *type;
+    const ServerContext *serverContext;
+#ifdef NODESETLOADER_HAS_PTHREAD
+    // reads and writes of the node may run on different threads
+    pthread_mutex_t lock;
+#endif
+};
+
+// entries are used as nodeContext, so they must not be moved
+#define LAZYVALUE_BLOCKSIZE 1024
+struct LazyValueBlock
+{
+    LazyValue entries[LAZYVALUE_BLOCKSIZE];
+    size_t size;
+    struct LazyValueBlock *next;
+};
+
+struct NodesetLoader_LazyValueStore
+{
+    struct LazyValueBlock *blocks;
+    ServerContext **serverContexts;
+    size_t serverContextsSize;
+};
+
+struct CompactBuffer
+{
+    NL_Data *nodes;
+    NL_Data **members;
+    char *chars;
+};
+typedef struct CompactBuffer CompactBuffer;
+
+static size_t stringSize(const char *s)
+{
+    return s ? strlen(s) + 1 : 0;
+}
+
+static void measureData(const NL_Data *data, size_t *nodes, size_t *members,
+                        size_t *chars)
+{
+    (*nodes)++;
+    *chars += stringSize(data->name);
+    if (data->type == DATATYPE_PRIMITIVE)
+    {
+        *chars += stringSize(data->val.primitiveData.value);
+        return;
+    }
+    *members += data->val.complexData.membersSize;
+    for (size_t i = 0; i < data->val.complexData.membersSize; i++)
+    {
+        measureData(data->val.complexData.members[i], nodes, members, chars);
+    }
+}
+
+static const char *copyString(CompactBuffer *buf, const char *s)
+{
+    if (!s)
+    {
+        return NULL;
+    }
+    size_t size = strlen(s) + 1;
+    char *copy = buf->chars;
+    memcpy(copy, s, size);
+    buf->chars += size;
+    return copy;
+}
+
+static NL_Data *copyData(CompactBuffer *buf, const NL_Data *src,
+                         NL_Data *parent)
+{
+    NL_Data *data = buf->nodes++;
+    data->type = src->type;
+    data->name = copyString(buf, src->name);
+    data->parent = parent;
+    if (src->type == DATATYPE_PRIMITIVE)
+    {
+        data->val.primitiveData.value =
+            copyString(buf, src->val.primitiveData.value);
+        return data;
+    }
+    size_t membersSize = src->val.complexData.membersSize;
+    data->val.complexData.membersSize = membersSize;
+    data->val.complexData.members = membersSize ? buf->members : NULL;
+    buf->members += membersSize;
+    for (size_t i = 0; i < membersSize; i++)
+    {
+        data->val.complexData.members[i] =
+            copyData(buf, src->val.complexData.members[i], data);
+    }
+    return data;
+}
+
+// copies the value with all of its data and strings into one allocation,
+// layout: NL_Value | NL_Data[] | NL_Data*[] | chars
+static NL_Value *compactValue(const NL_Value *value)
+{
+    size_t nodes = 0;
+    size_t members = 0;
+    size_t chars = stringSize(value->type);
+    measureData(value->data, &nodes, &members, &chars);
+
+    size_t size = sizeof(NL_Value) + nodes * sizeof(NL_Data) +
+                  members * sizeof(NL_Data *) + chars;
+    char *mem = (char *)malloc(size);
+    if (!mem)
+    {
+        return NULL;
+    }
+    NL_Value *copy = (NL_Value *)mem;
+    CompactBuffer buf;
+    buf.nodes = (NL_Data *)(mem + sizeof(NL_Value));
+    buf.members = (NL_Data **)(buf.nodes + nodes);
+    buf.chars = (char *)(buf.members + members);
+
+    copy->ctx = NULL;
+    copy->isArray = value->isArray;
+    copy->isExtensionObject = value->isExtensionObject;
+    copy->typeId = UA_NODEID_NULL;
+    copy->type = copyString(&buf, value->type);
+    copy->data = copyData(&buf, value->data, NULL);
+    return copy;
+}
+
+static LazyValue *newEntry(NodesetLoader_LazyValueStore *store)
+{
+    if (!store->blocks || store->blocks->size == LAZYVALUE_BLOCKSIZE)
+    {
+        struct LazyValueBlock *block =
+            (struct LazyValueBlock *)calloc(1, sizeof(struct LazyValueBlock));
+        if (!block)
+        {
+            return NULL;
+        }
+        block->next = store->blocks;
+        store->blocks = block;
+    }
+    LazyValue *entry = &store->blocks->entries[store->blocks->size++];
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_init(&entry->lock, NULL);
+#endif
+    return entry;
+}
+
+static void lock(LazyValue *lazyValue)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_lock(&lazyValue->lock);
+#else
+    (void)lazyValue;
+#endif
+}
+
+static void unlock(LazyValue *lazyValue)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_unlock(&lazyValue->lock);
+#else
+    (void)lazyValue;
+#endif
+}
+
+LazyValue *LazyValueStore_add(NodesetLoader_LazyValueStore *store,
+                              const NL_Value *value, const UA_DataType *type,
+                              const ServerContext *serverContext)
+{
+    if (!value->data || !type)
+    {
+        return NULL;
+    }
+    LazyValue *entry = newEntry(store);
+    if (!entry)
+    {
+        return NULL;
+    }
+    entry->value = compactValue(value);
+    if (!entry->value)
+    {
+        // the slot stays unused until the store is deleted
+        return NULL;
+    }
+    entry->type = type;
+    entry->serverContext = serverContext;
+    return entry;
+}
+
+static void releaseSpan(LazyValue *lazyValue)
+{
+    free(lazyValue->value);
+    lazyValue->value = NULL;
+}
+
+void LazyValue_release(LazyValue *lazyValue)
+{
+    if (!lazyValue)
+    {
+        return;
+    }
+    lock(lazyValue);
+    releaseSpan(lazyValue);
+    UA_Variant_clear(&lazyValue->decoded);
+    lazyValue->isDecoded = false;
+    unlock(lazyValue);
+}
+
+void LazyValueStore_adoptServerContext(NodesetLoader_LazyValueStore *store,
+                                       ServerContext *serverContext)
+{
+    ServerContext **contexts = (ServerContext **)realloc(
+        store->serverContexts,
+        (store->serverContextsSize + 1) * sizeof(ServerContext *));
+    if (!contexts)
+    {
+        ServerContext_delete(serverContext);
+        return;
+    }
+    store->serverContexts = contexts;
+    store->serverContexts[store->serverContextsSize++] = serverContext;
+}
+
+// must be called with the lock held, the span is kept if the value can't be
+// decoded, so the next read tries again
+static UA_StatusCode decode(UA_Server *server, const UA_NodeId *nodeId,
+                            LazyValue *lazyValue)
+{
+    if (lazyValue->isDecoded)
+    {
+        return UA_STATUSCODE_GOOD;
+    }
+    if (!lazyValue->value)
+    {
+        // released without being written, the node has no value
+        UA_Variant_init(&lazyValue->decoded);
+        lazyValue->isDecoded = true;
+        return UA_STATUSCODE_GOOD;
+    }
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(server)->customDataTypes;
+    if (!Value_toVariant(&lazyValue->decoded, lazyValue->value,
+                         lazyValue->type,
+                         customTypes ? customTypes->types : NULL,
+                         lazyValue->serverContext))
+    {
+        UA_Variant_init(&lazyValue->decoded);
+        UA_String id;
+        UA_String_init(&id);
+        UA_NodeId_print(nodeId, &id);
+        UA_LOG_WARNING(UA_Server_getConfig(server)->logging,
+                       UA_LOGCATEGORY_USERLAND,
+                       "NodesetLoader: value of node %.*s could not be "
+                       "decoded, retrying on the next read",
+                       (int)id.length, (const char *)id.data);
+        UA_String_clear(&id);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+    releaseSpan(lazyValue);
+    lazyValue->isDecoded = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode readValue(UA_Server *server, const UA_NodeId *sessionId,
+                               void *sessionContext, const UA_NodeId *nodeId,
+                               void *nodeContext,
+                               UA_Boolean includeSourceTimeStamp,
+                               const UA_NumericRange *range,
+                               UA_DataValue *value)
+{
+    LazyValue *lazyValue = (LazyValue *)nodeContext;
+    lock(lazyValue);
+    UA_StatusCode status = decode(server, nodeId, lazyValue);
+    if (status == UA_STATUSCODE_GOOD)
+    {
+        status = range ? UA_Variant_copyRange(&lazyValue->decoded,
+                                              &value->value, *range)
+                       : UA_Variant_copy(&lazyValue->decoded, &value->value);
+    }
+    unlock(lazyValue);
+    if (status != UA_STATUSCODE_GOOD)
+    {
+        return status;
+    }
+    value->hasValue = true;
+    if (includeSourceTimeStamp)
+    {
+        value->sourceTimestamp = UA_DateTime_now();
+        value->hasSourceTimestamp = true;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode writeValue(UA_Server *server, const UA_NodeId *sessionId,
+                                void *sessionContext, const UA_NodeId *nodeId,
+                                void *nodeContext, const UA_NumericRange *range,
+                                const UA_DataValue *data)
+{
+    LazyValue *lazyValue = (LazyValue *)nodeContext;
+    if (!data->hasValue)
+    {
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    }
+    lock(lazyValue);
+    UA_StatusCode status = UA_STATUSCODE_GOOD;
+    if (range)
+    {
+        // only a part is written, the rest of the retained value is needed
+        status = decode(server, nodeId, lazyValue);
+        if (status == UA_STATUSCODE_GOOD)
+        {
+            status = UA_Variant_setRangeCopy(&lazyValue->decoded,
+                                             data->value.data,
+                                             data->value.arrayLength, *range);
+        }
+    }
+    else
+    {
+        // value was written before it was read, the retained one is outdated
+        UA_Variant copy;
+        status = UA_Variant_copy(&data->value, &copy);
+        if (status == UA_STATUSCODE_GOOD)
+        {
+            releaseSpan(lazyValue);
+            UA_Variant_clear(&lazyValue->decoded);
+            lazyValue->decoded = copy;
+            lazyValue->isDecoded = true;
+        }
+    }
+    unlock(lazyValue);
+    return status;
+}
+
+UA_StatusCode LazyValue_install(UA_Server *server, const UA_NodeId id,
+                                LazyValue *lazyValue)
+{
+    UA_DataSource dataSource;
+    dataSource.read = readValue;
+    dataSource.write = writeValue;
+    UA_StatusCode status =
+        UA_Server_setVariableNode_dataSource(server, id, dataSource);
+    if (status != UA_STATUSCODE_GOOD)
+    {
+        // without data source the value would never be decoded, the node
+        // isn't reachable by other threads yet
+        if (decode(server, &id, lazyValue) == UA_STATUSCODE_GOOD)
+        {
+            UA_Server_writeValue(server, id, lazyValue->decoded);
+        }
+        LazyValue_release(lazyValue);
+    }
+    return status;
+}
+
+NodesetLoader_LazyValueStore *NodesetLoader_LazyValueStore_new(void)
+{
+    return (NodesetLoader_LazyValueStore *)calloc(
+        1, sizeof(NodesetLoader_LazyValueStore));
+}
+
+void NodesetLoader_LazyValueStore_delete(NodesetLoader_LazyValueStore *store)
+{
+    if (!store)
+    {
+        return;
+    }
+    struct LazyValueBlock *block = store->blocks;
+    while (block)
+    {
+        struct LazyValueBlock *next = block->next;
+        for (size_t i = 0; i < block->size; i++)
+        {
+            LazyValue_release(&block->entries[i]);
+#ifdef NODESETLOADER_HAS_PTHREAD
+            pthread_mutex_destroy(&block->entries[i].lock);
+#endif
+        }
+        free(block);
+        block = next;
+    }
+    for (size_t i = 0; i < store->serverContextsSize; i++)
+    {
+        ServerContext_delete(store->serverContexts[i]);
+    }
+    free(store->serverContexts);
+    free(store);
+}
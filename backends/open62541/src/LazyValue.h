@@ -0,0 +1,38 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef LAZYVALUE_H
+#define LAZYVALUE_H
+
+#include <open62541/server.h>
+
+#include <NodesetLoader/backendOpen62541.h>
+#include "NodesetLoader/NodesetLoader.h"
+
+struct ServerContext;
+
+struct LazyValue;
+typedef struct LazyValue LazyValue;
+
+// Keeps a compact copy of the value (one allocation for the whole NL_Data
+// tree). The returned entry is owned by the store and is used as nodeContext
+// of the variable node.
+LazyValue *LazyValueStore_add(NodesetLoader_LazyValueStore *store,
+                              const NL_Value *value, const UA_DataType *type,
+                              const struct ServerContext *serverContext);
+// Releases the retained and the decoded value, e.g. if the node couldn't be
+// added
+void LazyValue_release(LazyValue *lazyValue);
+// The store takes ownership of the serverContext, the namespace mapping is
+// needed when values are decoded after the import has finished
+void LazyValueStore_adoptServerContext(NodesetLoader_LazyValueStore *store,
+                                       struct ServerContext *serverContext);
+// Installs the data source which decodes the value once on the first read and
+// serves the decoded value afterwards. Writes replace the retained value. The
+// value is decoded immediately and written to the node if the data source
+// can't be installed.
+UA_StatusCode LazyValue_install(UA_Server *server, const UA_NodeId id,
+                                LazyValue *lazyValue);
+
+#endif
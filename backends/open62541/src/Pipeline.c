@@ -0,0 +1,224 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Pipeline.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef NODESETLOADER_HAS_PTHREAD
+#include <pthread.h>
+
+struct Pipeline
+{
+    size_t count;
+    void *context;
+    Pipeline_produce produce;
+    void *item;
+    bool full;
+    // set by Pipeline_delete, the producer stops after its current item
+    bool stopped;
+    // items taken by Pipeline_tryTake
+    size_t taken;
+    pthread_t producer;
+    bool running;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+static void *produceAll(void *context)
+{
+    Pipeline *pipeline = (Pipeline *)context;
+    for (size_t i = 0; i < pipeline->count; i++)
+    {
+        // wait until the previous item is taken, this limits the memory to
+        // one item in advance
+        pthread_mutex_lock(&pipeline->lock);
+        while (pipeline->full && !pipeline->stopped)
+        {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        bool stopped = pipeline->stopped;
+        pthread_mutex_unlock(&pipeline->lock);
+        if (stopped)
+        {
+            break;
+        }
+
+        void *item = pipeline->produce(pipeline->context, i);
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->item = item;
+        pipeline->full = true;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+    return NULL;
+}
+
+static void *take(Pipeline *pipeline)
+{
+    pthread_mutex_lock(&pipeline->lock);
+    while (!pipeline->full)
+    {
+        pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+    }
+    void *item = pipeline->item;
+    pipeline->item = NULL;
+    pipeline->full = false;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    return item;
+}
+
+void Pipeline_run(size_t count, void *context, Pipeline_produce produce,
+                  Pipeline_consume consume)
+{
+    Pipeline pipeline;
+    pipeline.count = count;
+    pipeline.context = context;
+    pipeline.produce = produce;
+    pipeline.item = NULL;
+    pipeline.full = false;
+    pipeline.stopped = false;
+    pipeline.taken = 0;
+    pipeline.running = false;
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.changed, NULL);
+
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, produceAll, &pipeline))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            consume(context, i, produce(context, i));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            consume(context, i, take(&pipeline));
+        }
+        pthread_join(producer, NULL);
+    }
+    pthread_mutex_destroy(&pipeline.lock);
+    pthread_cond_destroy(&pipeline.changed);
+}
+
+Pipeline *Pipeline_start(size_t count, void *context, Pipeline_produce produce)
+{
+    Pipeline *pipeline = (Pipeline *)calloc(1, sizeof(Pipeline));
+    if (!pipeline)
+    {
+        return NULL;
+    }
+    pipeline->count = count;
+    pipeline->context = context;
+    pipeline->produce = produce;
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->changed, NULL);
+    // the items are produced by Pipeline_tryTake if there is no thread
+    pipeline->running =
+        pthread_create(&pipeline->producer, NULL, produceAll, pipeline) == 0;
+    return pipeline;
+}
+
+bool Pipeline_tryTake(Pipeline *pipeline, void **item)
+{
+    if (pipeline->taken == pipeline->count)
+    {
+        return false;
+    }
+    if (!pipeline->running)
+    {
+        *item = pipeline->produce(pipeline->context, pipeline->taken++);
+        return true;
+    }
+    pthread_mutex_lock(&pipeline->lock);
+    bool full = pipeline->full;
+    if (full)
+    {
+        *item = pipeline->item;
+        pipeline->item = NULL;
+        pipeline->full = false;
+        pipeline->taken++;
+        pthread_cond_broadcast(&pipeline->changed);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return full;
+}
+
+void Pipeline_delete(Pipeline *pipeline, Pipeline_consume discard)
+{
+    if (!pipeline)
+    {
+        return;
+    }
+    if (pipeline->running)
+    {
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->stopped = true;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+        pthread_join(pipeline->producer, NULL);
+    }
+    if (pipeline->full)
+    {
+        discard(pipeline->context, pipeline->taken, pipeline->item);
+    }
+    pthread_mutex_destroy(&pipeline->lock);
+    pthread_cond_destroy(&pipeline->changed);
+    free(pipeline);
+}
+
+#else
+
+struct Pipeline
+{
+    size_t count;
+    void *context;
+    Pipeline_produce produce;
+    size_t taken;
+};
+
+void Pipeline_run(size_t count, void *context, Pipeline_produce produce,
+                  Pipeline_consume consume)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        consume(context, i, produce(context, i));
+    }
+}
+
+Pipeline *Pipeline_start(size_t count, void *context, Pipeline_produce produce)
+{
+    Pipeline *pipeline = (Pipeline *)calloc(1, sizeof(Pipeline));
+    if (!pipeline)
+    {
+        return NULL;
+    }
+    pipeline->count = count;
+    pipeline->context = context;
+    pipeline->produce = produce;
+    return pipeline;
+}
+
+bool Pipeline_tryTake(Pipeline *pipeline, void **item)
+{
+    if (pipeline->taken == pipeline->count)
+    {
+        return false;
+    }
+    *item = pipeline->produce(pipeline->context, pipeline->taken++);
+    return true;
+}
+
+void Pipeline_delete(Pipeline *pipeline, Pipeline_consume discard)
+{
+    (void)discard;
+    free(pipeline);
+}
+
+#endif
@@ -0,0 +1,36 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// runs on the background thread, the returned item is handed to consume
+typedef void *(*Pipeline_produce)(void *context, size_t index);
+// runs on the calling thread, items are consumed in order
+typedef void (*Pipeline_consume)(void *context, size_t index, void *item);
+
+// Produces item index + 1 on a background thread while item index is
+// consumed. At most one item is produced in advance. Without thread support
+// the items are produced and consumed one after the other.
+void Pipeline_run(size_t count, void *context, Pipeline_produce produce,
+                  Pipeline_consume consume);
+
+// A pipeline whose items are taken without waiting, e.g. from a callback of
+// the server. The items are produced in order on a background thread, at most
+// one in advance. Without thread support the item is produced by
+// Pipeline_tryTake.
+struct Pipeline;
+typedef struct Pipeline Pipeline;
+
+Pipeline *Pipeline_start(size_t count, void *context, Pipeline_produce produce);
+// returns false if the next item isn't produced yet
+bool Pipeline_tryTake(Pipeline *pipeline, void **item);
+// The producer stops after its current item and is joined, an item which was
+// produced but not taken is handed to discard.
+void Pipeline_delete(Pipeline *pipeline, Pipeline_consume discard);
+
+#endif
@@ -13,6 +13,10 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#ifdef NODESETLOADER_HAS_PTHREAD
+#include <pthread.h>
+#endif
+
 struct RefContainer
 {
     size_t size;
@@ -25,6 +29,11 @@ struct RefServiceImpl
     RefContainer hierachicalRefs;
     RefContainer nonHierachicalRefs;
     RefContainer hasTypeDefRefs;
+#ifdef NODESETLOADER_HAS_PTHREAD
+    // with NodesetLoader_loadFiles and the async import the next file is
+    // parsed, and adds its reference types, while the current one is inserted
+    pthread_mutex_t lock;
+#endif
 };
 
 static void
@@ -37,6 +46,24 @@ RefContainer_clear(RefContainer *c) {
 
 typedef struct RefServiceImpl RefServiceImpl;
 
+static void lock(RefServiceImpl *impl)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_lock(&impl->lock);
+#else
+    (void)impl;
+#endif
+}
+
+static void unlock(RefServiceImpl *impl)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_unlock(&impl->lock);
+#else
+    (void)impl;
+#endif
+}
+
 typedef void (*browseFnc)(RefServiceImpl *impl, const UA_NodeId id);
 
 static void iterate(UA_Server *server, const UA_NodeId *startId, browseFnc fnc,
@@ -104,25 +131,35 @@ isInContainer(const RefContainer c, const NL_Reference *ref) {
     return false;
 }
 
-static bool isNonHierachicalRef(const RefServiceImpl *service,
+static bool isNonHierachicalRef(RefServiceImpl *service,
                                 const NL_Reference *ref)
 {
-    return isInContainer(service->nonHierachicalRefs, ref);
+    lock(service);
+    bool result = isInContainer(service->nonHierachicalRefs, ref);
+    unlock(service);
+    return result;
 }
 
-static bool isHierachicalRef(const RefServiceImpl *service,
+static bool isHierachicalRef(RefServiceImpl *service,
                                    const NL_Reference *ref)
 {
-    return isInContainer(service->hierachicalRefs, ref);
+    lock(service);
+    bool result = isInContainer(service->hierachicalRefs, ref);
+    unlock(service);
+    return result;
 }
 
-static bool isTypeDefRef(const RefServiceImpl *service, const NL_Reference *ref)
+static bool isTypeDefRef(RefServiceImpl *service, const NL_Reference *ref)
 {
-    return isInContainer(service->hasTypeDefRefs, ref);
+    lock(service);
+    bool result = isInContainer(service->hasTypeDefRefs, ref);
+    unlock(service);
+    return result;
 }
 
 static void addnewRefType(RefServiceImpl *service, NL_ReferenceTypeNode *node)
 {
+    lock(service);
     NL_Reference *ref = node->hierachicalRefs;
     bool isHierachical = false;
     while (ref) {
@@ -142,6 +179,7 @@ static void addnewRefType(RefServiceImpl *service, NL_ReferenceTypeNode *node)
     }
     if (!isHierachical)
         addToRefs(&service->nonHierachicalRefs, node->id);
+    unlock(service);
 }
 
 NL_ReferenceService *RefServiceImpl_new(struct UA_Server *server)
@@ -172,6 +210,9 @@ NL_ReferenceService *RefServiceImpl_new(struct UA_Server *server)
         free(impl);
         return NULL;
     }
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_init(&impl->lock, NULL);
+#endif
     refService->context = impl;
     refService->addNewReferenceType =
         (RefService_addNewReferenceType)addnewRefType;
@@ -189,6 +230,9 @@ void RefServiceImpl_delete(NL_ReferenceService *service)
     RefContainer_clear(&impl->hierachicalRefs);
     RefContainer_clear(&impl->nonHierachicalRefs);
     RefContainer_clear(&impl->hasTypeDefRefs);
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_destroy(&impl->lock);
+#endif
     free(impl);
     free(service);
 }
@@ -463,3 +463,31 @@ void Value_getData(RawData *outData, const NL_Value *value, const UA_DataType *t
         setScalar(value->data, type, outData, customTypes, serverContext);
     }
 }
+
+bool Value_toVariant(UA_Variant *out, const NL_Value *value, const UA_DataType *type,
+                     const UA_DataType *customTypes, const ServerContext *serverContext)
+{
+    UA_Variant_init(out);
+    if (!type || !value->data)
+    {
+        return false;
+    }
+    RawData *data = RawData_new(NULL);
+    if (!data)
+    {
+        return false;
+    }
+    Value_getData(data, value, type, customTypes, serverContext);
+    if (value->isArray)
+    {
+        UA_Variant_setArray(out, data->mem,
+                            value->data->val.complexData.membersSize, type);
+    }
+    else
+    {
+        UA_Variant_setScalar(out, data->mem, type);
+    }
+    // the memory of the nested arrays is owned by the variant now
+    RawData_delete(data);
+    return true;
+}
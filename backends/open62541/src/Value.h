@@ -26,5 +26,8 @@ RawData *RawData_new(RawData *old);
 void RawData_delete(RawData *data);
 
 void Value_getData(RawData *outData, const NL_Value *value, const UA_DataType* type, const UA_DataType* customTypes, const struct ServerContext *serverContext);
+// decodes the value into the variant, the variant owns the decoded memory afterwards
+bool Value_toVariant(UA_Variant *out, const NL_Value *value, const UA_DataType *type,
+                     const UA_DataType *customTypes, const struct ServerContext *serverContext);
 
 #endif
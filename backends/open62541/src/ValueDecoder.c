@@ -0,0 +1,356 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+
+#include "ValueDecoder.h"
+#include "ServerContext.h"
+#include "Value.h"
+
+#include <stdlib.h>
+
+#ifdef NODESETLOADER_HAS_PTHREAD
+#include <pthread.h>
+
+// number of jobs a worker claims at once
+#define VALUEDECODER_CHUNKSIZE 16
+
+enum DecodeJobState
+{
+    DECODEJOB_PENDING,
+    DECODEJOB_CLAIMED,
+    DECODEJOB_DONE,
+    DECODEJOB_TAKEN
+};
+
+struct DecodeJob
+{
+    const NL_VariableNode *node;
+    const UA_DataType *type;
+    UA_Variant value;
+    // the value is empty if the decoding failed
+    bool decoded;
+    enum DecodeJobState state;
+};
+typedef struct DecodeJob DecodeJob;
+
+struct ValueDecoder
+{
+    const ServerContext *serverContext;
+    const UA_DataType *customTypes;
+    size_t threadCount;
+    // in insertion order, workers claim the jobs from the front
+    DecodeJob *jobs;
+    size_t jobsSize;
+    size_t jobsCapacity;
+    // sorted by node for the lookup
+    DecodeJob **index;
+    size_t nextJob;
+    pthread_t *threads;
+    size_t threadsSize;
+    pthread_mutex_t lock;
+    pthread_cond_t jobDone;
+};
+
+struct CollectCtx
+{
+    ValueDecoder *decoder;
+    void *resolveContext;
+    bool skipWithoutExtension;
+    ValueDecoder_resolveType resolveType;
+};
+
+ValueDecoder *ValueDecoder_new(const ServerContext *serverContext,
+                               size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        return NULL;
+    }
+    ValueDecoder *decoder = (ValueDecoder *)calloc(1, sizeof(ValueDecoder));
+    if (!decoder)
+    {
+        return NULL;
+    }
+    decoder->serverContext = serverContext;
+    decoder->threadCount = threadCount;
+    pthread_mutex_init(&decoder->lock, NULL);
+    pthread_cond_init(&decoder->jobDone, NULL);
+    return decoder;
+}
+
+static void collectJob(struct CollectCtx *ctx, NL_Node *node)
+{
+    const NL_VariableNode *variable = (const NL_VariableNode *)node;
+    if (!variable->value || !variable->value->data)
+    {
+        return;
+    }
+    if (ctx->skipWithoutExtension && !variable->extension)
+    {
+        return;
+    }
+    ValueDecoder *decoder = ctx->decoder;
+    if (decoder->jobsSize == decoder->jobsCapacity)
+    {
+        size_t capacity = decoder->jobsCapacity ? decoder->jobsCapacity * 2 : 256;
+        DecodeJob *jobs =
+            (DecodeJob *)realloc(decoder->jobs, capacity * sizeof(DecodeJob));
+        if (!jobs)
+        {
+            // value is decoded by the insertion thread
+            return;
+        }
+        decoder->jobs = jobs;
+        decoder->jobsCapacity = capacity;
+    }
+    DecodeJob *job = &decoder->jobs[decoder->jobsSize++];
+    job->node = variable;
+    job->type = ctx->resolveType(ctx->resolveContext, variable->datatype);
+    UA_Variant_init(&job->value);
+    job->decoded = false;
+    job->state = DECODEJOB_PENDING;
+}
+
+static int compareJobs(const void *a, const void *b)
+{
+    uintptr_t nodeA = (uintptr_t)(*(DecodeJob *const *)a)->node;
+    uintptr_t nodeB = (uintptr_t)(*(DecodeJob *const *)b)->node;
+    if (nodeA < nodeB)
+    {
+        return -1;
+    }
+    return nodeA > nodeB ? 1 : 0;
+}
+
+static void decode(const ValueDecoder *decoder, DecodeJob *job)
+{
+    job->decoded =
+        Value_toVariant(&job->value, job->node->value, job->type,
+                        decoder->customTypes, decoder->serverContext);
+    if (!job->decoded)
+    {
+        UA_Variant_clear(&job->value);
+    }
+}
+
+// has to be called with the lock held
+static size_t claimJobs(ValueDecoder *decoder, DecodeJob **claimed)
+{
+    size_t cnt = 0;
+    while (decoder->nextJob < decoder->jobsSize && cnt < VALUEDECODER_CHUNKSIZE)
+    {
+        DecodeJob *job = &decoder->jobs[decoder->nextJob++];
+        if (job->state == DECODEJOB_PENDING)
+        {
+            job->state = DECODEJOB_CLAIMED;
+            claimed[cnt++] = job;
+        }
+    }
+    return cnt;
+}
+
+static void *work(void *context)
+{
+    ValueDecoder *decoder = (ValueDecoder *)context;
+    DecodeJob *claimed[VALUEDECODER_CHUNKSIZE];
+    for (;;)
+    {
+        pthread_mutex_lock(&decoder->lock);
+        size_t cnt = claimJobs(decoder, claimed);
+        pthread_mutex_unlock(&decoder->lock);
+        if (cnt == 0)
+        {
+            break;
+        }
+        for (size_t i = 0; i < cnt; i++)
+        {
+            decode(decoder, claimed[i]);
+            pthread_mutex_lock(&decoder->lock);
+            claimed[i]->state = DECODEJOB_DONE;
+            pthread_cond_broadcast(&decoder->jobDone);
+            pthread_mutex_unlock(&decoder->lock);
+        }
+    }
+    return NULL;
+}
+
+void ValueDecoder_start(ValueDecoder *decoder, NodesetLoader *loader,
+                        void *resolveContext,
+                        ValueDecoder_resolveType resolveType,
+                        bool skipWithoutExtension)
+{
+    if (!decoder)
+    {
+        return;
+    }
+    UA_Server *server = ServerContext_getServerObject(decoder->serverContext);
+    // the custom types are complete after the datatype import
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(server)->customDataTypes;
+    decoder->customTypes = customTypes ? customTypes->types : NULL;
+
+    // the type lookup browses the server, therefore it's done here
+    struct CollectCtx ctx;
+    ctx.decoder = decoder;
+    ctx.resolveContext = resolveContext;
+    ctx.skipWithoutExtension = skipWithoutExtension;
+    ctx.resolveType = resolveType;
+    NodesetLoader_forEachNode(loader, NODECLASS_VARIABLE, &ctx,
+                              (NodesetLoader_forEachNode_Func)collectJob);
+    if (decoder->jobsSize == 0)
+    {
+        return;
+    }
+
+    decoder->index =
+        (DecodeJob **)malloc(decoder->jobsSize * sizeof(DecodeJob *));
+    if (!decoder->index)
+    {
+        decoder->jobsSize = 0;
+        return;
+    }
+    for (size_t i = 0; i < decoder->jobsSize; i++)
+    {
+        decoder->index[i] = &decoder->jobs[i];
+    }
+    qsort(decoder->index, decoder->jobsSize, sizeof(DecodeJob *), compareJobs);
+
+    decoder->threads =
+        (pthread_t *)calloc(decoder->threadCount, sizeof(pthread_t));
+    if (!decoder->threads)
+    {
+        // the insertion thread decodes all values on demand
+        return;
+    }
+    for (size_t i = 0; i < decoder->threadCount; i++)
+    {
+        if (pthread_create(&decoder->threads[i], NULL, work, decoder))
+        {
+            break;
+        }
+        decoder->threadsSize++;
+    }
+}
+
+static DecodeJob *findJob(const ValueDecoder *decoder,
+                          const NL_VariableNode *node)
+{
+    if (!decoder->index)
+    {
+        return NULL;
+    }
+    DecodeJob key;
+    key.node = node;
+    const DecodeJob *keyPtr = &key;
+    DecodeJob **job = (DecodeJob **)bsearch(&keyPtr, decoder->index,
+                                            decoder->jobsSize,
+                                            sizeof(DecodeJob *), compareJobs);
+    return job ? *job : NULL;
+}
+
+bool ValueDecoder_take(ValueDecoder *decoder, const NL_VariableNode *node,
+                       UA_Variant *out)
+{
+    if (!decoder)
+    {
+        return false;
+    }
+    DecodeJob *job = findJob(decoder, node);
+    if (!job)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&decoder->lock);
+    if (job->state == DECODEJOB_PENDING)
+    {
+        // the workers are behind, steal the job instead of waiting
+        job->state = DECODEJOB_CLAIMED;
+        pthread_mutex_unlock(&decoder->lock);
+        decode(decoder, job);
+        pthread_mutex_lock(&decoder->lock);
+        job->state = DECODEJOB_DONE;
+    }
+    while (job->state == DECODEJOB_CLAIMED)
+    {
+        pthread_cond_wait(&decoder->jobDone, &decoder->lock);
+    }
+    // a failed value is decoded again by the caller, which reports the error
+    bool taken = job->state == DECODEJOB_DONE && job->decoded;
+    if (taken)
+    {
+        *out = job->value;
+        UA_Variant_init(&job->value);
+    }
+    if (job->state == DECODEJOB_DONE)
+    {
+        job->state = DECODEJOB_TAKEN;
+    }
+    pthread_mutex_unlock(&decoder->lock);
+    return taken;
+}
+
+void ValueDecoder_cancel(ValueDecoder *decoder)
+{
+    if (!decoder)
+    {
+        return;
+    }
+    pthread_mutex_lock(&decoder->lock);
+    decoder->nextJob = decoder->jobsSize;
+    pthread_mutex_unlock(&decoder->lock);
+}
+
+void ValueDecoder_delete(ValueDecoder *decoder)
+{
+    if (!decoder)
+    {
+        return;
+    }
+    for (size_t i = 0; i < decoder->threadsSize; i++)
+    {
+        pthread_join(decoder->threads[i], NULL);
+    }
+    for (size_t i = 0; i < decoder->jobsSize; i++)
+    {
+        UA_Variant_clear(&decoder->jobs[i].value);
+    }
+    pthread_mutex_destroy(&decoder->lock);
+    pthread_cond_destroy(&decoder->jobDone);
+    free(decoder->threads);
+    free(decoder->index);
+    free(decoder->jobs);
+    free(decoder);
+}
+
+#else
+
+ValueDecoder *ValueDecoder_new(const ServerContext *serverContext,
+                               size_t threadCount)
+{
+    return NULL;
+}
+
+void ValueDecoder_start(ValueDecoder *decoder, NodesetLoader *loader,
+                        void *resolveContext,
+                        ValueDecoder_resolveType resolveType,
+                        bool skipWithoutExtension)
+{
+}
+
+bool ValueDecoder_take(ValueDecoder *decoder, const NL_VariableNode *node,
+                       UA_Variant *out)
+{
+    return false;
+}
+
+void ValueDecoder_cancel(ValueDecoder *decoder)
+{
+}
+
+void ValueDecoder_delete(ValueDecoder *decoder)
+{
+}
+
+#endif
@@ -0,0 +1,47 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VALUEDECODER_H
+#define VALUEDECODER_H
+
+#include <open62541/server.h>
+
+#include "NodesetLoader/NodesetLoader.h"
+
+#include <stdbool.h>
+
+struct ServerContext;
+
+// Decodes the values of all variable nodes on a pool of worker threads,
+// while the insertion thread adds the other node classes to the server.
+struct ValueDecoder;
+typedef struct ValueDecoder ValueDecoder;
+
+typedef const UA_DataType *(*ValueDecoder_resolveType)(void *context,
+                                                       const UA_NodeId dataTypeId);
+
+// returns NULL if threads are not supported or threadCount is 0, values are
+// decoded on the insertion thread in this case
+ValueDecoder *ValueDecoder_new(const struct ServerContext *serverContext,
+                               size_t threadCount);
+// Resolves the datatypes on the calling thread and starts the workers. Has to
+// be called after the datatypes were imported. Nodes without extension are
+// skipped if skipWithoutExtension is set, their values are handled lazily.
+void ValueDecoder_start(ValueDecoder *decoder, NodesetLoader *loader,
+                        void *resolveContext,
+                        ValueDecoder_resolveType resolveType,
+                        bool skipWithoutExtension);
+// Moves the decoded value of the node into out, waits for the workers if the
+// value is in progress. Returns false if there is no decoded value for the
+// node (e.g. it was already taken or the decoding failed), out is unchanged
+// then and the caller decodes the value itself.
+bool ValueDecoder_take(ValueDecoder *decoder, const NL_VariableNode *node,
+                       UA_Variant *out);
+// the workers stop after their current jobs, the remaining values are not
+// decoded
+void ValueDecoder_cancel(ValueDecoder *decoder);
+// joins the workers and frees all values which were not taken
+void ValueDecoder_delete(ValueDecoder *decoder);
+
+#endif
@@ -11,14 +11,20 @@
 #include <NodesetLoader/dataTypes.h>
 
 #include "DataTypeImporter.h"
+#include "LazyValue.h"
+#include "Pipeline.h"
 #include "Value.h"
+#include "ValueDecoder.h"
 #include "ServerContext.h"
 #include "conversion.h"
 #include "NodesetLoader/NodesetLoader.h"
 #include "RefServiceImpl.h"
 #include "nodes/NodeContainer.h"
+#include "NodeIndex.h"
+#include "Progress.h"
 
 #include <assert.h>
+#include <stdint.h>
 
 unsigned short NodesetLoader_BackendOpen62541_addNamespace(void *userContext, const char *namespaceUri);
 
@@ -66,6 +72,59 @@ static UA_NodeId getParentType(UA_Server *server, const UA_NodeId dataTypeId)
     return current;
 }
 
+static const UA_DataType *getValueDataType(UA_Server *server,
+                                           const UA_NodeId dataTypeId)
+{
+    const UA_DataType *dataType = UA_findDataType(&dataTypeId);
+    if (!dataType)
+    {
+        // try it with custom types
+        dataType = NodesetLoader_getCustomDataType(server, &dataTypeId);
+        // try it with parent
+        if (!dataType)
+        {
+            const UA_NodeId parent = getParentType(server, dataTypeId);
+            dataType = UA_findDataType(&parent);
+        }
+    }
+    return dataType;
+}
+
+// The value types of the variables, resolved once per data type instead of
+// browsing the supertypes for every variable. Only valid after the datatypes
+// were imported.
+struct DataTypeCache
+{
+    UA_Server *server;
+    // created on the first lookup
+    NodeIdMap *types;
+};
+typedef struct DataTypeCache DataTypeCache;
+
+static const UA_DataType *DataTypeCache_resolve(DataTypeCache *cache,
+                                                const UA_NodeId dataTypeId)
+{
+    const void *cached = NULL;
+    if (NodeIdMap_get(cache->types, &dataTypeId, &cached))
+    {
+        return (const UA_DataType *)cached;
+    }
+    const UA_DataType *type = getValueDataType(cache->server, dataTypeId);
+    if (!cache->types)
+    {
+        cache->types = NodeIdMap_new(64);
+    }
+    // without memory or for the null NodeId the type isn't cached
+    NodeIdMap_add(cache->types, &dataTypeId, type);
+    return type;
+}
+
+static void DataTypeCache_clear(DataTypeCache *cache)
+{
+    NodeIdMap_delete(cache->types);
+    cache->types = NULL;
+}
+
 static UA_NodeId getReferenceTypeId(const NL_Reference *ref)
 {
     if (!ref)
@@ -145,13 +204,20 @@ static UA_StatusCode
 handleViewNode(const NL_ViewNode *node, UA_NodeId *id, const UA_NodeId *parentId,
                const UA_NodeId *parentReferenceId, const UA_LocalizedText *lt,
                const UA_QualifiedName *qn, const UA_LocalizedText *description,
-               UA_Server *server)
+               UA_Server *server, bool deferFinish)
 {
     UA_ViewAttributes attr = UA_ViewAttributes_default;
     attr.displayName = *lt;
     attr.description = *description;
     attr.eventNotifier = (UA_Byte)atoi(node->eventNotifier);
     attr.containsNoLoops = isValTrue(node->containsNoLoops);
+    if (deferFinish)
+    {
+        return UA_Server_addNode_begin(server, UA_NODECLASS_VIEW, *id, *parentId,
+                                       *parentReferenceId, *qn, UA_NODEID_NULL,
+                                       &attr, &UA_TYPES[UA_TYPES_VIEWATTRIBUTES],
+                                       node->extension, NULL);
+    }
     return UA_Server_addViewNode(server, *id, *parentId, *parentReferenceId, *qn, attr,
                           node->extension, NULL);
 }
@@ -205,7 +271,10 @@ static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *
                                const UA_LocalizedText *lt,
                                const UA_QualifiedName *qn,
                                const UA_LocalizedText *description,
-                               const ServerContext *serverContext)
+                               const ServerContext *serverContext,
+                               NodesetLoader_LazyValueStore *lazyValues,
+                               ValueDecoder *decoder,
+                               DataTypeCache *dataTypes)
 {
     UA_VariableAttributes attr = UA_VariableAttributes_default;
     attr.displayName = *lt;
@@ -234,42 +303,60 @@ static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *
     {
         attr.arrayDimensions = UA_UInt32_new();
         *attr.arrayDimensions =
-            (UA_UInt32)node->value->data->val.complexData.membersSize;
+            node->value->variant
+                ? (UA_UInt32)node->value->variant->arrayLength
+                : (UA_UInt32)node->value->data->val.complexData.membersSize;
         attr.arrayDimensionsSize = 1;
     }
     RawData *data = NULL;
-    if (node->value && node->value->data != NULL)
+    LazyValue *lazyValue = NULL;
+    void *nodeContext = node->extension;
+    // the value may be decoded by the parser or in advance by the workers
+    bool decoded = false;
+    if (node->value && node->value->variant)
     {
-        const UA_DataType *dataType = UA_findDataType(&attr.dataType);
-        if (!dataType)
+        // moved, the node keeps an empty variant
+        attr.value = *node->value->variant;
+        UA_Variant_init(node->value->variant);
+        decoded = true;
+    }
+    if (!decoded)
+    {
+        decoded = node->value && node->value->data != NULL &&
+                  ValueDecoder_take(decoder, node, &attr.value);
+    }
+    if (!decoded && node->value && node->value->data != NULL)
+    {
+        const UA_DataType *dataType =
+            DataTypeCache_resolve(dataTypes, attr.dataType);
+
+        // the lazy value needs the nodeContext, extensions are decoded eagerly
+        if (lazyValues && !node->extension)
         {
-            // try it with custom types
-            dataType = NodesetLoader_getCustomDataType(ServerContext_getServerObject(serverContext), &attr.dataType);
-            // try it with parent
-            if (!dataType)
-            {
-                const UA_NodeId parent = getParentType(ServerContext_getServerObject(serverContext), attr.dataType);
-                dataType = UA_findDataType(&parent);
-            }
+            lazyValue = LazyValueStore_add(lazyValues, node->value, dataType,
+                                           serverContext);
+            nodeContext = lazyValue;
         }
+        if (!lazyValue)
+        {
+            UA_ServerConfig *config = UA_Server_getConfig(ServerContext_getServerObject(serverContext));
+            const UA_DataTypeArray *types = config->customDataTypes;
 
-        UA_ServerConfig *config = UA_Server_getConfig(ServerContext_getServerObject(serverContext));
-        const UA_DataTypeArray *types = config->customDataTypes;
-
-        data = RawData_new(data);
-        Value_getData(data, node->value, dataType, types->types, serverContext);
+            data = RawData_new(data);
+            Value_getData(data, node->value, dataType, types->types, serverContext);
 
-        if (data)
-        {
-            if (node->value->isArray)
+            if (data)
             {
-                UA_Variant_setArray(
-                    &attr.value, data->mem,
-                    node->value->data->val.complexData.membersSize, dataType);
-            }
-            else
-            {
-                UA_Variant_setScalar(&attr.value, data->mem, dataType);
+                if (node->value->isArray)
+                {
+                    UA_Variant_setArray(
+                        &attr.value, data->mem,
+                        node->value->data->val.complexData.membersSize, dataType);
+                }
+                else
+                {
+                    UA_Variant_setScalar(&attr.value, data->mem, dataType);
+                }
             }
         }
     }
@@ -283,7 +370,19 @@ static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *
     UA_StatusCode Status = UA_Server_addNode_begin(ServerContext_getServerObject(serverContext), UA_NODECLASS_VARIABLE, *id, *parentId,
                             *parentReferenceId, *qn, typeDefId, &attr,
                             &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES],
-                            node->extension, NULL);
+                            nodeContext, NULL);
+    if (lazyValue)
+    {
+        if (UA_StatusCode_isBad(Status))
+        {
+            LazyValue_release(lazyValue);
+        }
+        else
+        {
+            LazyValue_install(ServerContext_getServerObject(serverContext), *id,
+                              lazyValue);
+        }
+    }
     //cannot call addNode finish, otherwise the nodes for e.g. range will be instantiated twice
     //UA_Server_addNode_finish(server, *id);
     UA_Variant_clear(&attr.value);
@@ -299,13 +398,21 @@ static UA_StatusCode handleObjectTypeNode(const NL_ObjectTypeNode *node, UA_Node
                                  const UA_LocalizedText *lt,
                                  const UA_QualifiedName *qn,
                                  const UA_LocalizedText *description,
-                                 UA_Server *server)
+                                 UA_Server *server, bool deferFinish)
 {
     UA_ObjectTypeAttributes oAttr = UA_ObjectTypeAttributes_default;
     oAttr.displayName = *lt;
     oAttr.isAbstract = isValTrue(node->isAbstract);
     oAttr.description = *description;
 
+    if (deferFinish)
+    {
+        return UA_Server_addNode_begin(
+            server, UA_NODECLASS_OBJECTTYPE, *id, *parentId, *parentReferenceId,
+            *qn, UA_NODEID_NULL, &oAttr,
+            &UA_TYPES[UA_TYPES_OBJECTTYPEATTRIBUTES], node->extension, NULL);
+    }
+
     return UA_Server_addObjectTypeNode(server, *id, *parentId, *parentReferenceId, *qn,
                                 oAttr, node->extension, NULL);
 }
@@ -366,13 +473,21 @@ static UA_StatusCode handleDataTypeNode(const NL_DataTypeNode *node, UA_NodeId *
                                const UA_LocalizedText *lt,
                                const UA_QualifiedName *qn,
                                const UA_LocalizedText *description,
-                               UA_Server *server)
+                               UA_Server *server, bool deferFinish)
 {
     UA_DataTypeAttributes attr = UA_DataTypeAttributes_default;
     attr.displayName = *lt;
     attr.description = *description;
     attr.isAbstract = isValTrue(node->isAbstract);
 
+    if (deferFinish)
+    {
+        return UA_Server_addNode_begin(
+            server, UA_NODECLASS_DATATYPE, *id, *parentId, *parentReferenceId,
+            *qn, UA_NODEID_NULL, &attr, &UA_TYPES[UA_TYPES_DATATYPEATTRIBUTES],
+            node->extension, NULL);
+    }
+
     return UA_Server_addDataTypeNode(server, *id, *parentId, *parentReferenceId, *qn,
                               attr, node->extension, NULL);
 }
@@ -381,12 +496,31 @@ struct AddNodeContext
 {
     ServerContext* serverContext;
     NodeContainer* problemNodes;
+    NodesetLoader_LazyValueStore *lazyValues;
+    ValueDecoder *decoder;
+    DataTypeCache *dataTypes;
+    // deferred finish: nodes which are finished after all nodes were added,
+    // NULL otherwise
+    NodeContainer *unfinished;
+    // the remaining nodes are skipped once the import is cancelled
+    Progress *progress;
 };
 
 typedef struct AddNodeContext AddNodeContext;
 
+// node classes which are only inserted by addNode_begin in deferred finish mode
+static bool isFinishedLater(NL_NodeClass nodeClass)
+{
+    return nodeClass == NODECLASS_OBJECTTYPE || nodeClass == NODECLASS_DATATYPE ||
+           nodeClass == NODECLASS_VIEW;
+}
+
 static void addNodeImpl(AddNodeContext *context, NL_Node *node)
 {
+    if (context->progress->cancelled)
+    {
+        return;
+    }
     UA_NodeId id = node->id;
     UA_NodeId parentReferenceId = UA_NODEID_NULL;
     UA_NodeId parentId = getParentId(node, &parentReferenceId);
@@ -413,7 +547,8 @@ static void addNodeImpl(AddNodeContext *context, NL_Node *node)
     case NODECLASS_OBJECTTYPE:
         addedNodeStatus = handleObjectTypeNode((const NL_ObjectTypeNode *)node, &id, &parentId,
                                                &parentReferenceId, &lt, &qn, &description,
-                                               ServerContext_getServerObject(context->serverContext));
+                                               ServerContext_getServerObject(context->serverContext),
+                                               context->unfinished != NULL);
         break;
 
     case NODECLASS_REFERENCETYPE:
@@ -430,23 +565,39 @@ static void addNodeImpl(AddNodeContext *context, NL_Node *node)
 
     case NODECLASS_VARIABLE:
         addedNodeStatus = handleVariableNode((const NL_VariableNode *)node, &id, &parentId,
-                                             &parentReferenceId, &lt, &qn, &description, context->serverContext);
+                                             &parentReferenceId, &lt, &qn, &description, context->serverContext,
+                                             context->lazyValues, context->decoder, context->dataTypes);
         break;
     case NODECLASS_DATATYPE:
         addedNodeStatus = handleDataTypeNode((const NL_DataTypeNode *)node, &id, &parentId,
-                                             &parentReferenceId, &lt, &qn, &description, ServerContext_getServerObject(context->serverContext));
+                                             &parentReferenceId, &lt, &qn, &description, ServerContext_getServerObject(context->serverContext),
+                                             context->unfinished != NULL);
         break;
     case NODECLASS_VIEW:
         addedNodeStatus = handleViewNode((const NL_ViewNode *)node, &id, &parentId,
-                                         &parentReferenceId, &lt, &qn, &description, ServerContext_getServerObject(context->serverContext));
+                                         &parentReferenceId, &lt, &qn, &description, ServerContext_getServerObject(context->serverContext),
+                                         context->unfinished != NULL);
         break;
     }
+    if (context->unfinished != NULL && !UA_StatusCode_isBad(addedNodeStatus) &&
+        isFinishedLater(node->nodeClass))
+    {
+        NodeContainer_add(context->unfinished, node);
+    }
     // If a node was not added to the server due to an error, we add such a node
     // to a special node container. We can then try to add such nodes later.
     if(context->problemNodes != NULL && UA_StatusCode_isBad(addedNodeStatus))
     {
         NodeContainer_add(context->problemNodes, node);
     }
+    context->progress->state.nodesInserted++;
+    Progress_update(context->progress);
+}
+
+static void countNode(size_t *cnt, NL_Node *node)
+{
+    (void)node;
+    (*cnt)++;
 }
 
 unsigned short
@@ -484,6 +635,18 @@ static void logToOpen(void *context, enum NodesetLoader_LogLevel level,
     va_end(vl);
 }
 
+// state which is kept across the files of a session
+struct NodesetLoader_Session
+{
+    UA_Server *server;
+    NodesetLoader_LoadOptions options;
+    NodesetLoader_Logger *logger;
+    // knows the reference types of the server and of all loaded files
+    NL_ReferenceService *refService;
+    DataTypeImporter *dataTypeImporter;
+    DataTypeCache dataTypes;
+};
+
 struct DataTypeImportCtx
 {
     DataTypeImporter *importer;
@@ -516,25 +679,57 @@ static void addDataType(struct DataTypeImportCtx *ctx, NL_Node *node)
                                        parent);
 }
 
-static void importDataTypes(NodesetLoader *loader, UA_Server *server)
+static void importDataTypes(NodesetLoader *loader, NodesetLoader_Session *session)
 {
     // add datatypes
     const NL_BiDirectionalReference *hasEncodingRef =
         NodesetLoader_getBidirectionalRefs(loader);
-    DataTypeImporter *importer = DataTypeImporter_new(server);
+    DataTypeImporter *importer = session->dataTypeImporter;
+    DataTypeImporter_startFile(importer);
     struct DataTypeImportCtx ctx;
     ctx.hasEncodingRef = hasEncodingRef;
-    ctx.server = server;
+    ctx.server = session->server;
     ctx.importer = importer;
     NodesetLoader_forEachNode(loader, NODECLASS_DATATYPE, &ctx,
                               (NodesetLoader_forEachNode_Func)addDataType);
 
     DataTypeImporter_initMembers(importer);
-    DataTypeImporter_delete(importer);
 }
 
-static void addNonHierachicalRefs(UA_Server *server, NL_Node *node)
+struct AddRefsCtx
+{
+    UA_Server *server;
+    // only set in deferred finish mode, to skip the references which were added
+    // with the parent of a node
+    NodesetLoader *loader;
+};
+
+// true if the reference was added by addNode_begin of the source or the
+// target node
+static bool isParentReference(NodesetLoader *loader, const NL_Node *node,
+                              const NL_Reference *ref)
+{
+    UA_NodeId parentRefId = UA_NODEID_NULL;
+    UA_NodeId parentId = UA_NODEID_NULL;
+    if (!ref->isForward)
+    {
+        parentId = getParentId(node, &parentRefId);
+        return UA_NodeId_equal(&parentId, &ref->target) &&
+               UA_NodeId_equal(&parentRefId, &ref->refType);
+    }
+    const NL_Node *child = NodesetLoader_getNode(loader, &ref->target);
+    if (!child)
+    {
+        return false;
+    }
+    parentId = getParentId(child, &parentRefId);
+    return UA_NodeId_equal(&parentId, &node->id) &&
+           UA_NodeId_equal(&parentRefId, &ref->refType);
+}
+
+static void addNonHierachicalRefs(struct AddRefsCtx *ctx, NL_Node *node)
 {
+    UA_Server *server = ctx->server;
     NL_Reference *ref = node->nonHierachicalRefs;
     while (ref)
     {
@@ -550,6 +745,11 @@ static void addNonHierachicalRefs(UA_Server *server, NL_Node *node)
     ref = node->hierachicalRefs;
     while (ref)
     {
+        if (ctx->loader && isParentReference(ctx->loader, node, ref))
+        {
+            ref = ref->next;
+            continue;
+        }
         UA_NodeId src = node->id;
         UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
         target.nodeId = ref->target;
@@ -559,7 +759,7 @@ static void addNonHierachicalRefs(UA_Server *server, NL_Node *node)
     }
 }
 
-static size_t secondChanceAddNodes(ServerContext *serverContext,
+static size_t secondChanceAddNodes(const AddNodeContext *addNodeContext,
                                    NodeContainer **badStatusNodes,
                                    const NodesetLoader_Logger *logger)
 {
@@ -576,9 +776,8 @@ static size_t secondChanceAddNodes(ServerContext *serverContext,
     {
         NodeContainer *local_badStatusNodes =
             NodeContainer_new((*badStatusNodes)->size, false);
-        AddNodeContext context;
+        AddNodeContext context = *addNodeContext;
         context.problemNodes = local_badStatusNodes;
-        context.serverContext = serverContext;
         for (size_t counter = 0; counter < (*badStatusNodes)->size; counter++)
         {
             // Import to server again
@@ -597,115 +796,941 @@ static size_t secondChanceAddNodes(ServerContext *serverContext,
     return numberOfAllAddedNodes;
 }
 
-static void addNodes(NodesetLoader *loader, ServerContext *serverContext,
-                     NodesetLoader_Logger *logger)
+// Runs the constructors of the nodes which were only inserted, in the order
+// they were added. A node which fails is removed by open62541.
+static void finishNodes(UA_Server *server, const NodeContainer *unfinished,
+                        const NodesetLoader_Logger *logger)
 {
-    const NL_NodeClass order[NL_NODECLASS_COUNT] = {
-        NODECLASS_REFERENCETYPE, NODECLASS_DATATYPE, NODECLASS_OBJECTTYPE,
-        NODECLASS_VARIABLETYPE,  NODECLASS_OBJECT,   NODECLASS_METHOD,
-        NODECLASS_VARIABLE,      NODECLASS_VIEW};
-    const size_t containerInitialSize = 100;
+    size_t failed = 0;
+    for (size_t i = 0; i < unfinished->size; i++)
+    {
+        if (UA_StatusCode_isBad(
+                UA_Server_addNode_finish(server, unfinished->nodes[i]->id)))
+        {
+            failed++;
+        }
+    }
+    logger->log(logger->context,
+                failed ? NODESETLOADER_LOGLEVEL_WARNING
+                       : NODESETLOADER_LOGLEVEL_DEBUG,
+                "finished nodes: %zu, failed: %zu", unfinished->size - failed,
+                failed);
+}
+
+enum InsertionStage
+{
+    INSERT_NODES,
+    INSERT_SECOND_CHANCE,
+    INSERT_REFERENCES,
+    INSERT_FINISH,
+    INSERT_DONE
+};
 
+static const NL_NodeClass insertionOrder[NL_NODECLASS_COUNT] = {
+    NODECLASS_REFERENCETYPE, NODECLASS_DATATYPE, NODECLASS_OBJECTTYPE,
+    NODECLASS_VARIABLETYPE,  NODECLASS_OBJECT,   NODECLASS_METHOD,
+    NODECLASS_VARIABLE,      NODECLASS_VIEW};
+
+// Adds the nodes of a sorted loader to the server in steps of a bounded
+// number of nodes, so the insertion can be interleaved with the main loop of
+// the server. The node classes are added in insertionOrder, the types are
+// visible before the instances. The references are added after all nodes.
+struct Insertion
+{
+    NodesetLoader_Session *session;
+    NodesetLoader *loader;
+    AddNodeContext context;
+    Progress progress;
+    struct AddRefsCtx refsCtx;
+    enum InsertionStage stage;
+    // index into insertionOrder
+    size_t classIndex;
+    // the nodes of the current class, NULL if not collected yet
+    NodeContainer *nodes;
+    size_t nextNode;
     // If we have a problem adding nodes to the server, let's add references
     // to these nodes to the container.
-    NodeContainer* badStatusNodes = NodeContainer_new(containerInitialSize, false);
+    NodeContainer *badStatusNodes;
     // Since every cycle we add one node class we need to save
     // counter of previous badStatusNodes because badStatusNodes
     // will always be adding new bad nodes to one list, and we have to calculate
     // the real number of bad status nodes on every single cycle.
-    size_t previous_loop_badStatusNodes_size = 0;
+    size_t previousBadStatusSize;
+};
+typedef struct Insertion Insertion;
 
-    AddNodeContext context;
-    context.problemNodes = badStatusNodes;
-    context.serverContext = serverContext;
-    for (size_t i = 0; i < NL_NODECLASS_COUNT; i++)
-    {
-        const NL_NodeClass classToImport = order[i];
-        size_t cnt =
-            NodesetLoader_forEachNode(loader, classToImport, &context,
-                                      (NodesetLoader_forEachNode_Func)addNodeImpl);
-        if (classToImport == NODECLASS_DATATYPE)
-        {
-            importDataTypes(loader, ServerContext_getServerObject(serverContext));
-        }
+static void Insertion_init(Insertion *ins, NodesetLoader_Session *session,
+                           NodesetLoader *loader, ServerContext *serverContext)
+{
+    const NodesetLoader_LoadOptions *options = &session->options;
+    const size_t containerInitialSize = 100;
+    memset(ins, 0, sizeof(Insertion));
+    ins->session = session;
+    ins->loader = loader;
+    ins->stage = INSERT_NODES;
+    ins->badStatusNodes = NodeContainer_new(containerInitialSize, false);
+
+    AddNodeContext *context = &ins->context;
+    context->problemNodes = ins->badStatusNodes;
+    context->serverContext = serverContext;
+    context->lazyValues = options->lazyValues;
+    context->decoder =
+        ValueDecoder_new(serverContext, options->valueDecodingThreads);
+    context->dataTypes = &session->dataTypes;
+    context->unfinished = options->deferFinish
+                              ? NodeContainer_new(containerInitialSize, false)
+                              : NULL;
+    Progress_setCallback(&ins->progress, options->progress,
+                         options->progressContext, options->progressInterval);
+    Progress_startStage(&ins->progress, NL_PROGRESS_INSERT);
+    context->progress = &ins->progress;
+
+    ins->refsCtx.server = ServerContext_getServerObject(serverContext);
+    ins->refsCtx.loader = options->deferFinish ? loader : NULL;
+}
 
-        // Now we can see the nodes that could not be added and can calculate
-        // and show the actual nodes added.
-        logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
-                    "imported %ss: %zu", NL_NODECLASS_NAME[classToImport],
-                    cnt - (badStatusNodes->size - previous_loop_badStatusNodes_size));
-        previous_loop_badStatusNodes_size = badStatusNodes->size;
+static void collectNodes(Insertion *ins)
+{
+    const NL_NodeClass nodeClass = insertionOrder[ins->classIndex];
+    ins->nodes = NodeContainer_new(100, false);
+    NodesetLoader_forEachNode(ins->loader, nodeClass, ins->nodes,
+                              (NodesetLoader_forEachNode_Func)NodeContainer_add);
+    ins->nextNode = 0;
+}
+
+static void nextClass(Insertion *ins, enum InsertionStage nextStage)
+{
+    NodeContainer_delete(ins->nodes);
+    ins->nodes = NULL;
+    ins->classIndex++;
+    if (ins->classIndex == NL_NODECLASS_COUNT || ins->progress.cancelled)
+    {
+        ins->classIndex = 0;
+        ins->stage = nextStage;
     }
+}
 
+// returns the number of nodes added
+static size_t insertNodes(Insertion *ins, size_t budget)
+{
+    NodesetLoader_Logger *logger = ins->session->logger;
+    const NL_NodeClass classToImport = insertionOrder[ins->classIndex];
+    if (!ins->nodes)
+    {
+        collectNodes(ins);
+        ins->progress.state.nodeClass = classToImport;
+        ins->progress.state.nodesInserted = 0;
+        ins->progress.state.nodesOfClass = ins->nodes->size;
+    }
+    size_t cnt = 0;
+    while (ins->nextNode < ins->nodes->size && cnt < budget &&
+           !ins->progress.cancelled)
+    {
+        addNodeImpl(&ins->context, ins->nodes->nodes[ins->nextNode++]);
+        cnt++;
+    }
+    if (ins->nextNode < ins->nodes->size && !ins->progress.cancelled)
+    {
+        return cnt;
+    }
+    if (classToImport == NODECLASS_DATATYPE)
+    {
+        importDataTypes(ins->loader, ins->session);
+        // values are decoded while the remaining node classes are added
+        ValueDecoder_start(ins->context.decoder, ins->loader,
+                           &ins->session->dataTypes,
+                           (ValueDecoder_resolveType)DataTypeCache_resolve,
+                           ins->context.lazyValues != NULL);
+    }
+
+    // Now we can see the nodes that could not be added and can calculate
+    // and show the actual nodes added.
+    logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
+                "imported %ss: %zu", NL_NODECLASS_NAME[classToImport],
+                ins->nextNode -
+                    (ins->badStatusNodes->size - ins->previousBadStatusSize));
+    ins->previousBadStatusSize = ins->badStatusNodes->size;
+    // the end of every node class is reported
+    Progress_report(&ins->progress);
+    nextClass(ins, INSERT_SECOND_CHANCE);
+    return cnt;
+}
+
+static void insertSecondChance(Insertion *ins)
+{
+    NodesetLoader_Logger *logger = ins->session->logger;
     // second chance algorithm
-    if (badStatusNodes->size != 0)
+    if (ins->badStatusNodes->size != 0 && !ins->progress.cancelled)
     {
         logger->log(logger->context, NODESETLOADER_LOGLEVEL_WARNING,
                     "Couldn't import: %zu. Let's try adding non-imported "
-                    "nodes a few more times.", badStatusNodes->size);
+                    "nodes a few more times.", ins->badStatusNodes->size);
         size_t numberOfAllAddedNodes =
-            secondChanceAddNodes(serverContext, &badStatusNodes, logger);
+            secondChanceAddNodes(&ins->context, &ins->badStatusNodes, logger);
         logger->log(logger->context, NODESETLOADER_LOGLEVEL_WARNING,
                     "imported after attempts: %zu", numberOfAllAddedNodes);
     }
 
     // Delete only reference and container. Not NL_Nodes objects.
-    NodeContainer_delete(badStatusNodes);
+    NodeContainer_delete(ins->badStatusNodes);
+    ins->badStatusNodes = NULL;
+    if (ins->progress.cancelled)
+    {
+        ValueDecoder_cancel(ins->context.decoder);
+        logger->log(logger->context, NODESETLOADER_LOGLEVEL_WARNING,
+                    "import cancelled, the nodes added so far are kept");
+    }
+    ValueDecoder_delete(ins->context.decoder);
+    ins->context.decoder = NULL;
+    ins->stage = ins->progress.cancelled ? INSERT_FINISH : INSERT_REFERENCES;
+}
+
+// returns the number of nodes whose references were added
+static size_t insertReferences(Insertion *ins, size_t budget)
+{
+    if (!ins->nodes)
+    {
+        collectNodes(ins);
+    }
+    size_t cnt = 0;
+    while (ins->nextNode < ins->nodes->size && cnt < budget &&
+           !ins->progress.cancelled)
+    {
+        addNonHierachicalRefs(&ins->refsCtx, ins->nodes->nodes[ins->nextNode++]);
+        cnt++;
+    }
+    if (ins->nextNode == ins->nodes->size || ins->progress.cancelled)
+    {
+        nextClass(ins, INSERT_FINISH);
+    }
+    return cnt;
+}
 
-    for (size_t i = 0; i < NL_NODECLASS_COUNT; i++)
+static void insertFinish(Insertion *ins)
+{
+    // also after a cancellation, the inserted nodes would be incomplete
+    if (ins->context.unfinished)
     {
-        const NL_NodeClass classToImport = order[i];
-        NodesetLoader_forEachNode(
-            loader, classToImport, ServerContext_getServerObject(serverContext),
-            (NodesetLoader_forEachNode_Func)addNonHierachicalRefs);
+        finishNodes(ins->refsCtx.server, ins->context.unfinished,
+                    ins->session->logger);
+        NodeContainer_delete(ins->context.unfinished);
+        ins->context.unfinished = NULL;
     }
+    ins->stage = INSERT_DONE;
 }
 
-bool NodesetLoader_loadFile(struct UA_Server *server, const char *path,
-                            NodesetLoader_ExtensionInterface *extensionHandling)
+// Adds at most budget nodes, or the references of at most budget nodes. The
+// second chance and the final pass are a step of their own. Returns true once
+// the insertion is done, the resources of the insertion are released then.
+static bool Insertion_step(Insertion *ins, size_t budget)
 {
-    if (!server)
+    while (ins->stage != INSERT_DONE && budget)
     {
-        return false;
+        switch (ins->stage)
+        {
+        case INSERT_NODES:
+            budget -= insertNodes(ins, budget);
+            break;
+        case INSERT_SECOND_CHANCE:
+            insertSecondChance(ins);
+            budget = 0;
+            break;
+        case INSERT_REFERENCES:
+            budget -= insertReferences(ins, budget);
+            break;
+        case INSERT_FINISH:
+            insertFinish(ins);
+            budget = 0;
+            break;
+        case INSERT_DONE:
+            break;
+        }
     }
-    if (!path)
+    return ins->stage == INSERT_DONE;
+}
+
+// returns false if the import was cancelled
+static bool addNodes(NodesetLoader_Session *session, NodesetLoader *loader,
+                     ServerContext *serverContext)
+{
+    Insertion ins;
+    Insertion_init(&ins, session, loader, serverContext);
+    while (!Insertion_step(&ins, SIZE_MAX))
     {
+    }
+    return !ins.progress.cancelled;
+}
+
+static NodesetLoader_Logger *newLogger(UA_Server *server)
+{
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    NodesetLoader_Logger *logger =
+        (NodesetLoader_Logger *)calloc(1, sizeof(NodesetLoader_Logger));
+    if (!logger)
+    {
+        return NULL;
+    }
+    logger->context = (void*)(uintptr_t)config->logging;
+    logger->log = &logToOpen;
+    return logger;
+}
+
+static void releaseServerContext(const NodesetLoader_LoadOptions *options,
+                                 ServerContext *serverContext)
+{
+    if (options->lazyValues)
+    {
+        // the namespace mapping is needed to decode the values later on
+        LazyValueStore_adoptServerContext(options->lazyValues, serverContext);
+    }
+    else
+    {
+        ServerContext_delete(serverContext);
+    }
+}
+
+static void initImportOptions(NL_ImportOptions *importOptions,
+                              const NodesetLoader_LoadOptions *options)
+{
+    memset(importOptions, 0, sizeof(NL_ImportOptions));
+    importOptions->filter = options->filter;
+    importOptions->skipAttributes = options->skipAttributes;
+    importOptions->decodeValues = options->decodeValues;
+    importOptions->progress = options->progress;
+    importOptions->progressContext = options->progressContext;
+    importOptions->progressInterval = options->progressInterval;
+}
+
+// The strings an extension interface receives live in the char arena, which
+// the compaction releases, while the extensions are passed to the server as
+// node contexts. Hence nodesets with an extension interface aren't compacted.
+static bool autoCompact(NodesetLoader_Logger *logger,
+                        const NodesetLoader_LoadOptions *options,
+                        const NodesetLoader_ExtensionInterface *extensionHandling)
+{
+    if (options->compact && extensionHandling)
+    {
+        logger->log(logger->context, NODESETLOADER_LOGLEVEL_WARNING,
+                    "compaction is skipped, an extension interface is set");
         return false;
     }
+    return options->compact;
+}
+
+NodesetLoader_Session *
+NodesetLoader_Session_new(struct UA_Server *server,
+                          const NodesetLoader_LoadOptions *options)
+{
+    if (!server)
+    {
+        return NULL;
+    }
+    NodesetLoader_Session *session =
+        (NodesetLoader_Session *)calloc(1, sizeof(NodesetLoader_Session));
+    if (!session)
+    {
+        return NULL;
+    }
+    session->server = server;
+    if (options)
+    {
+        session->options = *options;
+    }
+    session->dataTypes.server = server;
+    session->logger = newLogger(server);
+    // browses the reference type hierarchy of the server
+    session->refService = RefServiceImpl_new(server);
+    session->dataTypeImporter = DataTypeImporter_new(server);
+    if (!session->logger || !session->refService || !session->dataTypeImporter)
+    {
+        NodesetLoader_Session_delete(session);
+        return NULL;
+    }
+    return session;
+}
 
-    ServerContext *serverContext = ServerContext_new(server);
+void NodesetLoader_Session_delete(NodesetLoader_Session *session)
+{
+    if (!session)
+    {
+        return;
+    }
+    if (session->refService)
+    {
+        RefServiceImpl_delete(session->refService);
+    }
+    if (session->dataTypeImporter)
+    {
+        DataTypeImporter_delete(session->dataTypeImporter);
+    }
+    DataTypeCache_clear(&session->dataTypes);
+    free(session->logger);
+    free(session);
+}
+
+bool NodesetLoader_Session_loadFile(
+    NodesetLoader_Session *session, const char *path,
+    NodesetLoader_ExtensionInterface *extensionHandling)
+{
+    if (!session || !path)
+    {
+        return false;
+    }
+    const NodesetLoader_LoadOptions *options = &session->options;
+    NodesetLoader_Logger *logger = session->logger;
+    ServerContext *serverContext = ServerContext_new(session->server);
 
     NL_FileContext handler;
     handler.addNamespace = NodesetLoader_BackendOpen62541_addNamespace;
     handler.userContext = serverContext;
     handler.file = path;
     handler.extensionHandling = extensionHandling;
+    NL_ImportOptions importOptions;
+    initImportOptions(&importOptions, options);
 
-    UA_ServerConfig *config = UA_Server_getConfig(server);
-    NodesetLoader_Logger *logger =
-        (NodesetLoader_Logger *)calloc(1, sizeof(NodesetLoader_Logger));
-    logger->context = (void*)(uintptr_t)config->logging;
-    logger->log = &logToOpen;
-    NL_ReferenceService *refService = RefServiceImpl_new(server);
-
-    NodesetLoader *loader = NodesetLoader_new(logger, refService);
+    NodesetLoader *loader = NodesetLoader_newWithBudget(
+        logger, session->refService, options->memoryBudget);
+    NodesetLoader_setAutoCompact(
+        loader, autoCompact(logger, options, extensionHandling));
     logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
                 "Start import nodeset: %s", path);
-    bool importStatus = NodesetLoader_importFile(loader, &handler);
-    bool sortStatus = NodesetLoader_sort(loader);
+    bool importStatus =
+        NodesetLoader_importFileWithOptions(loader, &handler, &importOptions);
+    // an aborted import (e.g. memory budget) leaves an incomplete nodeset
+    bool sortStatus = importStatus && NodesetLoader_sort(loader);
     bool retStatus = importStatus && sortStatus;
     if (retStatus && sortStatus)
     {
-        addNodes(loader, serverContext, logger);
+        retStatus = addNodes(session, loader, serverContext);
     }
     else
     {
         logger->log(logger->context, NODESETLOADER_LOGLEVEL_ERROR,
                     "importing the nodeset failed, nodes were not added");
     }
-    RefServiceImpl_delete(refService);
     NodesetLoader_delete(loader);
-    ServerContext_delete(serverContext);
-    free(logger);
+    releaseServerContext(options, serverContext);
     return retStatus;
 }
+
+bool NodesetLoader_loadFile(struct UA_Server *server, const char *path,
+                            NodesetLoader_ExtensionInterface *extensionHandling)
+{
+    return NodesetLoader_loadFileWithOptions(server, path, extensionHandling,
+                                             NULL);
+}
+
+bool NodesetLoader_loadFileWithOptions(
+    struct UA_Server *server, const char *path,
+    NodesetLoader_ExtensionInterface *extensionHandling,
+    const NodesetLoader_LoadOptions *options)
+{
+    if (!server)
+    {
+        return false;
+    }
+    if (!path)
+    {
+        return false;
+    }
+    NodesetLoader_Session *session = NodesetLoader_Session_new(server, options);
+    if (!session)
+    {
+        return false;
+    }
+    bool status =
+        NodesetLoader_Session_loadFile(session, path, extensionHandling);
+    NodesetLoader_Session_delete(session);
+    return status;
+}
+
+// Files are parsed and sorted on a background thread, while the previous file
+// is added to the server. The parsing thread must not access the server,
+// therefore it works on a copy of the server's namespace array. Namespaces
+// which are new to the server are registered right before the nodes of the
+// file are added, in the same order and therefore with the same index.
+struct LoadFilesCtx
+{
+    UA_Server *server;
+    const char **paths;
+    NodesetLoader_ExtensionInterface *extensionHandling;
+    // the reference service is shared by the loaders, reference types of a
+    // file are known to the next
+    NodesetLoader_Session *session;
+    const NodesetLoader_LoadOptions *options;
+    NodesetLoader_Logger *logger;
+    // only accessed by the parsing thread
+    char **namespaces;
+    size_t namespacesSize;
+    bool status;
+};
+typedef struct LoadFilesCtx LoadFilesCtx;
+
+struct ParsedFile
+{
+    LoadFilesCtx *ctx;
+    NodesetLoader *loader;
+    ServerContext *serverContext;
+    // namespaces of this file which are new to the server, in order of the
+    // predicted index starting with newNamespacesBegin
+    const char **newNamespaces;
+    size_t newNamespacesSize;
+    size_t newNamespacesBegin;
+    bool status;
+};
+typedef struct ParsedFile ParsedFile;
+
+static bool readServerNamespaces(LoadFilesCtx *ctx)
+{
+    UA_Variant namespaceArray;
+    UA_Variant_init(&namespaceArray);
+    UA_StatusCode status = UA_Server_readValue(
+        ctx->server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY),
+        &namespaceArray);
+    if (status != UA_STATUSCODE_GOOD ||
+        namespaceArray.type != &UA_TYPES[UA_TYPES_STRING])
+    {
+        UA_Variant_clear(&namespaceArray);
+        return false;
+    }
+    const UA_String *uris = (const UA_String *)namespaceArray.data;
+    ctx->namespaces =
+        (char **)calloc(namespaceArray.arrayLength, sizeof(char *));
+    for (size_t i = 0; ctx->namespaces && i < namespaceArray.arrayLength; i++)
+    {
+        char *uri = (char *)calloc(uris[i].length + 1, sizeof(char));
+        if (!uri)
+        {
+            break;
+        }
+        memcpy(uri, uris[i].data, uris[i].length);
+        ctx->namespaces[ctx->namespacesSize++] = uri;
+    }
+    bool complete = ctx->namespaces &&
+                    ctx->namespacesSize == namespaceArray.arrayLength;
+    UA_Variant_clear(&namespaceArray);
+    return complete;
+}
+
+static unsigned short addNamespaceDeferred(void *userContext,
+                                           const char *namespaceUri)
+{
+    ParsedFile *file = (ParsedFile *)userContext;
+    LoadFilesCtx *ctx = file->ctx;
+    size_t idx = 0;
+    while (idx < ctx->namespacesSize && strcmp(ctx->namespaces[idx], namespaceUri))
+    {
+        idx++;
+    }
+    if (idx == ctx->namespacesSize)
+    {
+        char **namespaces = (char **)realloc(
+            ctx->namespaces, (ctx->namespacesSize + 1) * sizeof(char *));
+        const char **newNamespaces = (const char **)realloc(
+            file->newNamespaces, (file->newNamespacesSize + 1) * sizeof(char *));
+        char *uri = (char *)malloc(strlen(namespaceUri) + 1);
+        if (namespaces)
+        {
+            ctx->namespaces = namespaces;
+        }
+        if (newNamespaces)
+        {
+            file->newNamespaces = newNamespaces;
+        }
+        if (!namespaces || !newNamespaces || !uri)
+        {
+            free(uri);
+            file->status = false;
+            return 0;
+        }
+        strcpy(uri, namespaceUri);
+        if (file->newNamespacesSize == 0)
+        {
+            file->newNamespacesBegin = idx;
+        }
+        ctx->namespaces[ctx->namespacesSize++] = uri;
+        file->newNamespaces[file->newNamespacesSize++] = uri;
+    }
+    ServerContext_addNamespaceIdx(file->serverContext, (UA_UInt16)idx);
+    return (unsigned short)idx;
+}
+
+static void *parseFile(LoadFilesCtx *ctx, size_t index)
+{
+    ParsedFile *file = (ParsedFile *)calloc(1, sizeof(ParsedFile));
+    if (!file)
+    {
+        return NULL;
+    }
+    file->ctx = ctx;
+    file->status = true;
+    file->serverContext = ServerContext_new(ctx->server);
+
+    NL_FileContext handler;
+    handler.addNamespace = addNamespaceDeferred;
+    handler.userContext = file;
+    handler.file = ctx->paths[index];
+    handler.extensionHandling = ctx->extensionHandling;
+    NL_ImportOptions importOptions;
+    initImportOptions(&importOptions, ctx->options);
+
+    file->loader = NodesetLoader_newWithBudget(
+        ctx->logger, ctx->session->refService, ctx->options->memoryBudget);
+    NodesetLoader_setAutoCompact(
+        file->loader,
+        autoCompact(ctx->logger, ctx->options, ctx->extensionHandling));
+    ctx->logger->log(ctx->logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
+                     "Start import nodeset: %s", handler.file);
+    bool importStatus = NodesetLoader_importFileWithOptions(
+        file->loader, &handler, &importOptions);
+    bool sortStatus = importStatus && NodesetLoader_sort(file->loader);
+    file->status = file->status && importStatus && sortStatus;
+    return file;
+}
+
+// Registers the namespaces of the file at the server, returns false if the
+// file can't be added.
+static bool registerNamespaces(LoadFilesCtx *ctx, size_t index,
+                               ParsedFile *file)
+{
+    // registered even if the file failed, the indices of the following files
+    // rely on it
+    for (size_t i = 0; i < file->newNamespacesSize; i++)
+    {
+        UA_UInt16 idx = UA_Server_addNamespace(ctx->server, file->newNamespaces[i]);
+        if (idx != file->newNamespacesBegin + i)
+        {
+            ctx->logger->log(ctx->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                             "namespace %s was added concurrently, indices differ",
+                             file->newNamespaces[i]);
+            file->status = false;
+        }
+    }
+    if (!file->status)
+    {
+        ctx->logger->log(ctx->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                         "importing the nodeset %s failed, nodes were not added",
+                         ctx->paths[index]);
+        ctx->status = false;
+    }
+    return file->status;
+}
+
+static void deleteParsedFile(LoadFilesCtx *ctx, size_t index, ParsedFile *file)
+{
+    (void)index;
+    if (!file)
+    {
+        return;
+    }
+    NodesetLoader_delete(file->loader);
+    releaseServerContext(ctx->options, file->serverContext);
+    free(file->newNamespaces);
+    free(file);
+}
+
+static void insertFile(LoadFilesCtx *ctx, size_t index, ParsedFile *file)
+{
+    if (!file)
+    {
+        ctx->status = false;
+        return;
+    }
+    if (registerNamespaces(ctx, index, file))
+    {
+        ctx->status = addNodes(ctx->session, file->loader, file->serverContext) &&
+                      ctx->status;
+    }
+    deleteParsedFile(ctx, index, file);
+}
+
+static void freeNamespaces(LoadFilesCtx *ctx)
+{
+    for (size_t i = 0; i < ctx->namespacesSize; i++)
+    {
+        free(ctx->namespaces[i]);
+    }
+    free(ctx->namespaces);
+}
+
+bool NodesetLoader_Session_loadFiles(
+    NodesetLoader_Session *session, const char **paths, size_t pathsSize,
+    NodesetLoader_ExtensionInterface *extensionHandling)
+{
+    if (!session || !paths)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < pathsSize; i++)
+    {
+        if (!paths[i])
+        {
+            return false;
+        }
+    }
+
+    LoadFilesCtx ctx;
+    memset(&ctx, 0, sizeof(LoadFilesCtx));
+    ctx.server = session->server;
+    ctx.paths = paths;
+    ctx.extensionHandling = extensionHandling;
+    ctx.session = session;
+    ctx.options = &session->options;
+    ctx.logger = session->logger;
+    ctx.status = true;
+
+    if (readServerNamespaces(&ctx))
+    {
+        Pipeline_run(pathsSize, &ctx, (Pipeline_produce)parseFile,
+                     (Pipeline_consume)insertFile);
+    }
+    else
+    {
+        ctx.status = false;
+    }
+
+    freeNamespaces(&ctx);
+    return ctx.status;
+}
+
+bool NodesetLoader_loadFiles(struct UA_Server *server, const char **paths,
+                             size_t pathsSize,
+                             NodesetLoader_ExtensionInterface *extensionHandling,
+                             const NodesetLoader_LoadOptions *options)
+{
+    if (!server || !paths)
+    {
+        return false;
+    }
+    NodesetLoader_Session *session = NodesetLoader_Session_new(server, options);
+    if (!session)
+    {
+        return false;
+    }
+    bool status = NodesetLoader_Session_loadFiles(session, paths, pathsSize,
+                                                  extensionHandling);
+    NodesetLoader_Session_delete(session);
+    return status;
+}
+
+// the server's main loop adds a batch of nodes at this interval
+static const UA_Double asyncImportInterval = 10.0;
+static const size_t asyncImportDefaultBatchSize = 1000;
+
+struct NodesetLoader_AsyncImport
+{
+    UA_Server *server;
+    NodesetLoader_Session *session;
+    LoadFilesCtx ctx;
+    const char **paths;
+    size_t pathsSize;
+    Pipeline *pipeline;
+    UA_UInt64 callbackId;
+    bool callbackAdded;
+    // the file which is being added, NULL while the next one is parsed
+    ParsedFile *file;
+    Insertion insertion;
+    size_t filesDone;
+    bool done;
+    NodesetLoader_AsyncImport_doneCallback doneCallback;
+    void *doneContext;
+};
+
+static void finishAsyncFile(NodesetLoader_AsyncImport *import)
+{
+    deleteParsedFile(&import->ctx, import->filesDone, import->file);
+    import->file = NULL;
+    import->filesDone++;
+}
+
+// returns false if there is no file to add yet
+static bool beginAsyncFile(NodesetLoader_AsyncImport *import)
+{
+    void *item = NULL;
+    if (!Pipeline_tryTake(import->pipeline, &item))
+    {
+        return false;
+    }
+    import->file = (ParsedFile *)item;
+    if (!import->file)
+    {
+        import->ctx.status = false;
+        import->filesDone++;
+        return true;
+    }
+    if (!registerNamespaces(&import->ctx, import->filesDone, import->file))
+    {
+        finishAsyncFile(import);
+        return true;
+    }
+    Insertion_init(&import->insertion, import->session, import->file->loader,
+                   import->file->serverContext);
+    return true;
+}
+
+static void asyncImportCallback(UA_Server *server, void *data)
+{
+    NodesetLoader_AsyncImport *import = (NodesetLoader_AsyncImport *)data;
+    if (import->done)
+    {
+        return;
+    }
+    // files which failed to parse don't count as a batch
+    while (!import->file && import->filesDone < import->pathsSize)
+    {
+        if (!beginAsyncFile(import))
+        {
+            return;
+        }
+    }
+    if (import->file)
+    {
+        size_t batchSize = import->session->options.asyncBatchSize;
+        if (!Insertion_step(&import->insertion,
+                            batchSize ? batchSize : asyncImportDefaultBatchSize))
+        {
+            return;
+        }
+        import->ctx.status =
+            !import->insertion.progress.cancelled && import->ctx.status;
+        finishAsyncFile(import);
+    }
+    if (import->filesDone == import->pathsSize)
+    {
+        import->done = true;
+        // removing the running callback is allowed by the server
+        UA_Server_removeRepeatedCallback(server, import->callbackId);
+        import->callbackAdded = false;
+        if (import->doneCallback)
+        {
+            import->doneCallback(server, import->doneContext, import->ctx.status);
+        }
+    }
+}
+
+NodesetLoader_AsyncImport *
+NodesetLoader_loadFilesAsync(struct UA_Server *server, const char **paths,
+                             size_t pathsSize,
+                             NodesetLoader_ExtensionInterface *extensionHandling,
+                             const NodesetLoader_LoadOptions *options,
+                             NodesetLoader_AsyncImport_doneCallback done,
+                             void *doneContext)
+{
+    if (!server || !paths)
+    {
+        return NULL;
+    }
+    for (size_t i = 0; i < pathsSize; i++)
+    {
+        if (!paths[i])
+        {
+            return NULL;
+        }
+    }
+    NodesetLoader_AsyncImport *import = (NodesetLoader_AsyncImport *)calloc(
+        1, sizeof(NodesetLoader_AsyncImport));
+    if (!import)
+    {
+        return NULL;
+    }
+    import->server = server;
+    import->doneCallback = done;
+    import->doneContext = doneContext;
+    import->session = NodesetLoader_Session_new(server, options);
+    // the paths are read by the parsing thread
+    import->paths = (const char **)calloc(pathsSize + 1, sizeof(char *));
+    if (!import->session || !import->paths)
+    {
+        NodesetLoader_AsyncImport_delete(import);
+        return NULL;
+    }
+    for (; import->pathsSize < pathsSize; import->pathsSize++)
+    {
+        char *path = (char *)malloc(strlen(paths[import->pathsSize]) + 1);
+        if (!path)
+        {
+            NodesetLoader_AsyncImport_delete(import);
+            return NULL;
+        }
+        strcpy(path, paths[import->pathsSize]);
+        import->paths[import->pathsSize] = path;
+    }
+
+    LoadFilesCtx *ctx = &import->ctx;
+    ctx->server = server;
+    ctx->paths = import->paths;
+    ctx->extensionHandling = extensionHandling;
+    ctx->session = import->session;
+    ctx->options = &import->session->options;
+    ctx->logger = import->session->logger;
+    ctx->status = true;
+    if (!readServerNamespaces(ctx))
+    {
+        NodesetLoader_AsyncImport_delete(import);
+        return NULL;
+    }
+    import->pipeline = Pipeline_start(pathsSize, ctx, (Pipeline_produce)parseFile);
+    if (!import->pipeline ||
+        UA_Server_addRepeatedCallback(server, asyncImportCallback, import,
+                                      asyncImportInterval,
+                                      &import->callbackId) != UA_STATUSCODE_GOOD)
+    {
+        NodesetLoader_AsyncImport_delete(import);
+        return NULL;
+    }
+    import->callbackAdded = true;
+    return import;
+}
+
+void NodesetLoader_AsyncImport_getStatus(const NodesetLoader_AsyncImport *import,
+                                         NodesetLoader_AsyncImportStatus *status)
+{
+    memset(status, 0, sizeof(NodesetLoader_AsyncImportStatus));
+    status->filesDone = import->filesDone;
+    status->filesSize = import->pathsSize;
+    if (import->done)
+    {
+        status->state = import->ctx.status ? NODESETLOADER_ASYNC_DONE
+                                           : NODESETLOADER_ASYNC_FAILED;
+        return;
+    }
+    if (!import->file)
+    {
+        status->state = NODESETLOADER_ASYNC_PARSING;
+        return;
+    }
+    status->state = NODESETLOADER_ASYNC_INSERTING;
+    status->nodeClass = (unsigned int)import->insertion.progress.state.nodeClass;
+    status->nodesInserted = import->insertion.progress.state.nodesInserted;
+    status->nodesOfClass = import->insertion.progress.state.nodesOfClass;
+}
+
+void NodesetLoader_AsyncImport_delete(NodesetLoader_AsyncImport *import)
+{
+    if (!import)
+    {
+        return;
+    }
+    if (import->callbackAdded)
+    {
+        UA_Server_removeRepeatedCallback(import->server, import->callbackId);
+    }
+    if (import->file)
+    {
+        // the nodes which were only inserted are finished
+        import->insertion.progress.cancelled = true;
+        while (!Insertion_step(&import->insertion, SIZE_MAX))
+        {
+        }
+        finishAsyncFile(import);
+    }
+    Pipeline_delete(import->pipeline, (Pipeline_consume)deleteParsedFile);
+    freeNamespaces(&import->ctx);
+    for (size_t i = 0; i < import->pathsSize; i++)
+    {
+        free((void *)(uintptr_t)import->paths[i]);
+    }
+    free(import->paths);
+    NodesetLoader_Session_delete(import->session);
+    free(import);
+}
@@ -0,0 +1,169 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include "check.h"
+
+#include "testHelper.h"
+#include <NodesetLoader/backendOpen62541.h>
+#include <NodesetLoader/dataTypes.h>
+
+UA_Server *server;
+char *nodesetPath = NULL;
+
+struct DoneContext
+{
+    size_t calls;
+    bool status;
+};
+
+static void setup(void)
+{
+    printf("path to testnodesets %s\n", nodesetPath);
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    UA_Server_run_startup(server);
+}
+
+static void teardown(void)
+{
+    UA_Server_run_shutdown(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(server)->customDataTypes;
+#endif
+    UA_Server_delete(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+}
+
+static void onDone(UA_Server *s, void *context, bool status)
+{
+    ck_assert(s == server);
+    struct DoneContext *done = (struct DoneContext *)context;
+    done->calls++;
+    done->status = status;
+}
+
+START_TEST(asyncImport_done)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    // several iterations per node class
+    options.asyncBatchSize = 2;
+    struct DoneContext done = {0, false};
+    const char *paths[] = {nodesetPath};
+    NodesetLoader_AsyncImport *import = NodesetLoader_loadFilesAsync(
+        server, paths, 1, NULL, &options, onDone, &done);
+    ck_assert(import);
+
+    NodesetLoader_AsyncImportStatus status;
+    bool inserting = false;
+    while (!done.calls)
+    {
+        UA_Server_run_iterate(server, true);
+        NodesetLoader_AsyncImport_getStatus(import, &status);
+        ck_assert(status.filesSize == 1);
+        if (status.state == NODESETLOADER_ASYNC_INSERTING)
+        {
+            inserting = true;
+            ck_assert(status.nodesInserted <= status.nodesOfClass);
+        }
+    }
+    ck_assert(inserting);
+    ck_assert(done.status);
+    NodesetLoader_AsyncImport_getStatus(import, &status);
+    ck_assert(status.state == NODESETLOADER_ASYNC_DONE);
+    ck_assert(status.filesDone == 1);
+
+    // the callback is called once
+    UA_Server_run_iterate(server, true);
+    ck_assert(done.calls == 1);
+    NodesetLoader_AsyncImport_delete(import);
+
+    ck_assert(getNodeClass(server, UA_NODEID_NUMERIC(2, 6002)) ==
+              UA_NODECLASS_OBJECT);
+    ck_assert(hasReference(server, UA_NODEID_NUMERIC(2, 6002),
+                           UA_NODEID_NUMERIC(2, 6003),
+                           UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                           UA_BROWSEDIRECTION_FORWARD));
+}
+END_TEST
+
+START_TEST(asyncImport_deleteEarly)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.asyncBatchSize = 1;
+    struct DoneContext done = {0, false};
+    const char *paths[] = {nodesetPath, nodesetPath};
+    NodesetLoader_AsyncImport *import = NodesetLoader_loadFilesAsync(
+        server, paths, 2, NULL, &options, onDone, &done);
+    ck_assert(import);
+
+    NodesetLoader_AsyncImportStatus status;
+    NodesetLoader_AsyncImport_getStatus(import, &status);
+    while (status.state != NODESETLOADER_ASYNC_INSERTING && !done.calls)
+    {
+        UA_Server_run_iterate(server, true);
+        NodesetLoader_AsyncImport_getStatus(import, &status);
+    }
+    NodesetLoader_AsyncImport_delete(import);
+    ck_assert(done.calls == 0);
+    // the server keeps running without the import
+    UA_Server_run_iterate(server, true);
+    ck_assert(done.calls == 0);
+}
+END_TEST
+
+START_TEST(asyncImport_missingFile)
+{
+    struct DoneContext done = {0, true};
+    const char *paths[] = {"notExisting.xml"};
+    NodesetLoader_AsyncImport *import = NodesetLoader_loadFilesAsync(
+        server, paths, 1, NULL, NULL, onDone, &done);
+    ck_assert(import);
+    while (!done.calls)
+    {
+        UA_Server_run_iterate(server, true);
+    }
+    ck_assert(!done.status);
+    NodesetLoader_AsyncImportStatus status;
+    NodesetLoader_AsyncImport_getStatus(import, &status);
+    ck_assert(status.state == NODESETLOADER_ASYNC_FAILED);
+    NodesetLoader_AsyncImport_delete(import);
+}
+END_TEST
+
+static Suite *testSuite_Client(void)
+{
+    Suite *s = suite_create("asyncImport");
+    TCase *tc_server = tcase_create("asyncImport");
+    tcase_add_checked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, asyncImport_done);
+    tcase_add_test(tc_server, asyncImport_deleteEarly);
+    tcase_add_test(tc_server, asyncImport_missingFile);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("%s", argv[0]);
+    if (!(argc > 1))
+        return 1;
+    nodesetPath = argv[1];
+    Suite *s = testSuite_Client();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
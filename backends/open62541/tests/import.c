@@ -11,6 +11,7 @@
 #include "testHelper.h"
 #include <NodesetLoader/backendOpen62541.h>
 #include <NodesetLoader/dataTypes.h>
+#include <NodesetLoader/NodesetLoader.h>
 
 UA_Server *server;
 char* nodesetPath=NULL;
@@ -53,6 +54,68 @@ START_TEST(Server_EmptyHandler) {
 }
 END_TEST
 
+struct ProgressLog
+{
+    size_t calls[3];
+    NL_Progress last;
+    bool cancelInsert;
+};
+
+static bool onProgress(void *context, const NL_Progress *progress)
+{
+    struct ProgressLog *log = (struct ProgressLog *)context;
+    log->calls[progress->stage]++;
+    log->last = *progress;
+    return !(log->cancelInsert && progress->stage == NL_PROGRESS_INSERT);
+}
+
+static bool loadWithProgress(struct ProgressLog *log)
+{
+    UA_Server *localServer = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(localServer));
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.progress = onProgress;
+    options.progressContext = log;
+    bool status =
+        NodesetLoader_loadFileWithOptions(localServer, nodesetPath, NULL, &options);
+    UA_Server_run_shutdown(localServer);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(localServer)->customDataTypes;
+#endif
+    UA_Server_delete(localServer);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+    return status;
+}
+
+START_TEST(Server_ImportProgress) {
+    struct ProgressLog log;
+    memset(&log, 0, sizeof(log));
+    ck_assert(loadWithProgress(&log));
+    ck_assert_uint_gt(log.calls[NL_PROGRESS_PARSE], 0);
+    ck_assert_uint_gt(log.calls[NL_PROGRESS_SORT], 0);
+    ck_assert_uint_gt(log.calls[NL_PROGRESS_INSERT], 0);
+    // the end of the last node class
+    ck_assert_int_eq(log.last.stage, NL_PROGRESS_INSERT);
+    ck_assert_int_eq(log.last.nodeClass, NODECLASS_VIEW);
+    ck_assert_uint_eq(log.last.nodesInserted, log.last.nodesOfClass);
+}
+END_TEST
+
+START_TEST(Server_CancelInsert) {
+    struct ProgressLog log;
+    memset(&log, 0, sizeof(log));
+    log.cancelInsert = true;
+    ck_assert(!loadWithProgress(&log));
+    // cancelled by the first update, no further nodes are added
+    ck_assert_uint_eq(log.calls[NL_PROGRESS_INSERT], 1);
+    ck_assert_uint_le(log.last.nodesInserted, 1);
+}
+END_TEST
+
 static Suite *testSuite_Client(void) {
     Suite *s = suite_create("server nodeset import");
     TCase *tc_server = tcase_create("server nodeset import");
@@ -60,6 +123,8 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_server, Server_ImportNodeset);
     tcase_add_test(tc_server, Server_ImportNoFile);
     tcase_add_test(tc_server, Server_EmptyHandler);
+    tcase_add_test(tc_server, Server_ImportProgress);
+    tcase_add_test(tc_server, Server_CancelInsert);
     suite_add_tcase(s, tc_server);
     return s;
 }
@@ -0,0 +1,503 @@
+#include "address_space_compare.h"
+
+#include <open62541/types_generated.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+
+struct TNodeIdLess
+{
+    bool operator()(const UA_NodeId &Lhs, const UA_NodeId &Rhs) const
+    {
+        return UA_NodeId_order(&Lhs, &Rhs) == UA_ORDER_LESS;
+    }
+};
+
+// owns the node ids
+typedef set<UA_NodeId, TNodeIdLess> TNodeIdSet;
+
+// an attribute or a reference of a node as read from one server
+typedef struct
+{
+    TDifferenceKind Kind;
+    string Aspect;
+    // binary encoding of the value, compared between the servers
+    string Key;
+    string Text;
+} TEntry;
+
+typedef vector<TEntry> TNodeSnapshot;
+
+typedef struct
+{
+    UA_AttributeId Id;
+    const char *pName;
+} TAttribute;
+
+// Value and DataTypeDefinition are handled separately, the user attributes
+// are the same as the attributes for the admin session
+const TAttribute Attributes[] = {
+    {UA_ATTRIBUTEID_NODECLASS, "NodeClass"},
+    {UA_ATTRIBUTEID_BROWSENAME, "BrowseName"},
+    {UA_ATTRIBUTEID_DISPLAYNAME, "DisplayName"},
+    {UA_ATTRIBUTEID_DESCRIPTION, "Description"},
+    {UA_ATTRIBUTEID_WRITEMASK, "WriteMask"},
+    {UA_ATTRIBUTEID_ISABSTRACT, "IsAbstract"},
+    {UA_ATTRIBUTEID_SYMMETRIC, "Symmetric"},
+    {UA_ATTRIBUTEID_INVERSENAME, "InverseName"},
+    {UA_ATTRIBUTEID_CONTAINSNOLOOPS, "ContainsNoLoops"},
+    {UA_ATTRIBUTEID_EVENTNOTIFIER, "EventNotifier"},
+    {UA_ATTRIBUTEID_DATATYPE, "DataType"},
+    {UA_ATTRIBUTEID_VALUERANK, "ValueRank"},
+    {UA_ATTRIBUTEID_ARRAYDIMENSIONS, "ArrayDimensions"},
+    {UA_ATTRIBUTEID_ACCESSLEVEL, "AccessLevel"},
+    {UA_ATTRIBUTEID_MINIMUMSAMPLINGINTERVAL, "MinimumSamplingInterval"},
+    {UA_ATTRIBUTEID_HISTORIZING, "Historizing"},
+    {UA_ATTRIBUTEID_EXECUTABLE, "Executable"}};
+
+string ToString(const UA_String &Str)
+{
+    return string((const char *)Str.data, Str.length);
+}
+
+string PrintNodeId(const UA_NodeId &Id)
+{
+    UA_String str = UA_STRING_NULL;
+    string ret = "error";
+    if (UA_NodeId_print(&Id, &str) == UA_STATUSCODE_GOOD)
+    {
+        ret = ToString(str);
+    }
+    UA_String_clear(&str);
+    return ret;
+}
+
+string PrintVariant(const UA_Variant &Value, const string &Key)
+{
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    (void)Key;
+    UA_String str = UA_STRING_NULL;
+    string ret = "error";
+    if (UA_print(&Value, &UA_TYPES[UA_TYPES_VARIANT], &str) ==
+        UA_STATUSCODE_GOOD)
+    {
+        ret = ToString(str);
+    }
+    UA_String_clear(&str);
+    return ret;
+#else
+    // without type descriptions the binary encoding is printed
+    (void)Value;
+    string ret;
+    char Buffer[3] = {0};
+    for (unsigned char c : Key)
+    {
+        snprintf(Buffer, sizeof(Buffer), "%02x", c);
+        ret += Buffer;
+    }
+    return ret;
+#endif
+}
+
+// The status is part of the key, reading an attribute which the node class
+// doesn't have fails equally on both servers.
+void AddDataValue(TNodeSnapshot &Snapshot, TDifferenceKind Kind,
+                  const char *pAspect, const UA_DataValue &Value)
+{
+    TEntry Entry;
+    Entry.Kind = Kind;
+    Entry.Aspect = pAspect;
+    if (!Value.hasValue)
+    {
+        Entry.Key = UA_StatusCode_name(Value.status);
+        Entry.Text = Entry.Key;
+        Snapshot.push_back(Entry);
+        return;
+    }
+    UA_ByteString encoded = UA_BYTESTRING_NULL;
+    if (UA_encodeBinary(&Value.value, &UA_TYPES[UA_TYPES_VARIANT], &encoded) ==
+        UA_STATUSCODE_GOOD)
+    {
+        Entry.Key = ToString(encoded);
+    }
+    else
+    {
+        Entry.Key = "encoding failed";
+    }
+    UA_ByteString_clear(&encoded);
+    Entry.Text = PrintVariant(Value.value, Entry.Key);
+    Snapshot.push_back(Entry);
+}
+
+void ReadAttribute(UA_Server *pServer, const UA_NodeId &Id,
+                   UA_AttributeId AttributeId, TDifferenceKind Kind,
+                   const char *pAspect, TNodeSnapshot &Snapshot)
+{
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = Id;
+    rvi.attributeId = AttributeId;
+    UA_DataValue Value =
+        UA_Server_read(pServer, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    AddDataValue(Snapshot, Kind, pAspect, Value);
+    UA_DataValue_clear(&Value);
+}
+
+void ReadReferences(UA_Server *pServer, const UA_NodeId &Id,
+                    TNodeSnapshot &Snapshot)
+{
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = Id;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_REFERENCES);
+    bd.includeSubtypes = UA_TRUE;
+    bd.resultMask = UA_BROWSERESULTMASK_REFERENCETYPEID;
+    // no continuation point, all references are returned at once
+    UA_BrowseResult br = UA_Server_browse(pServer, 0, &bd);
+    size_t first = Snapshot.size();
+    if (br.statusCode != UA_STATUSCODE_GOOD)
+    {
+        TEntry Entry = {TDifferenceKind::Reference, "",
+                        UA_StatusCode_name(br.statusCode),
+                        UA_StatusCode_name(br.statusCode)};
+        Snapshot.push_back(Entry);
+    }
+    for (size_t i = 0; i < br.referencesSize; i++)
+    {
+        const UA_ReferenceDescription &ref = br.references[i];
+        string Text = PrintNodeId(ref.referenceTypeId) + " -> " +
+                      PrintNodeId(ref.nodeId.nodeId);
+        TEntry Entry = {TDifferenceKind::Reference, "", Text, Text};
+        Snapshot.push_back(Entry);
+    }
+    UA_BrowseResult_clear(&br);
+    // compared as a set
+    sort(Snapshot.begin() + (ptrdiff_t)first, Snapshot.end(),
+         [](const TEntry &Lhs, const TEntry &Rhs) { return Lhs.Key < Rhs.Key; });
+}
+
+void ReadNode(UA_Server *pServer, const UA_NodeId &Id,
+              const TCompareOptions &Options, TNodeSnapshot &Snapshot)
+{
+    for (const TAttribute &Attribute : Attributes)
+    {
+        ReadAttribute(pServer, Id, Attribute.Id, TDifferenceKind::Attribute,
+                      Attribute.pName, Snapshot);
+    }
+    if (Options.CompareValues)
+    {
+        ReadAttribute(pServer, Id, UA_ATTRIBUTEID_VALUE, TDifferenceKind::Value,
+                      "Value", Snapshot);
+    }
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    if (Options.CompareDataTypeDefinitions)
+    {
+        ReadAttribute(pServer, Id, UA_ATTRIBUTEID_DATATYPEDEFINITION,
+                      TDifferenceKind::DataTypeDefinition,
+                      "DataTypeDefinition", Snapshot);
+    }
+#endif
+    ReadReferences(pServer, Id, Snapshot);
+}
+
+// Collects the nodes which are reachable by forward hierarchical references,
+// like the browse of a client.
+UA_Boolean CollectNodes(UA_Server *pServer, const UA_NodeId &StartId,
+                        TNodeIdSet &oNodes)
+{
+    vector<UA_NodeId> Queue;
+    UA_NodeId Start;
+    if (UA_NodeId_copy(&StartId, &Start) != UA_STATUSCODE_GOOD)
+    {
+        return UA_FALSE;
+    }
+    oNodes.insert(Start);
+    Queue.push_back(Start);
+    UA_Boolean ret = UA_TRUE;
+    while (!Queue.empty() && ret)
+    {
+        UA_NodeId Id = Queue.back();
+        Queue.pop_back();
+
+        UA_BrowseDescription bd;
+        UA_BrowseDescription_init(&bd);
+        bd.nodeId = Id;
+        bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+        bd.referenceTypeId =
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+        bd.includeSubtypes = UA_TRUE;
+        bd.resultMask = UA_BROWSERESULTMASK_NONE;
+        UA_BrowseResult br = UA_Server_browse(pServer, 0, &bd);
+        if (br.statusCode != UA_STATUSCODE_GOOD)
+        {
+            ret = UA_FALSE;
+        }
+        for (size_t i = 0; ret && i < br.referencesSize; i++)
+        {
+            const UA_ExpandedNodeId &Target = br.references[i].nodeId;
+            // only local nodes
+            if (Target.serverIndex != 0 || Target.namespaceUri.length > 0 ||
+                oNodes.count(Target.nodeId))
+            {
+                continue;
+            }
+            UA_NodeId Copy;
+            if (UA_NodeId_copy(&Target.nodeId, &Copy) != UA_STATUSCODE_GOOD)
+            {
+                ret = UA_FALSE;
+                break;
+            }
+            oNodes.insert(Copy);
+            Queue.push_back(Copy);
+        }
+        UA_BrowseResult_clear(&br);
+    }
+    return ret;
+}
+
+void ClearNodes(TNodeIdSet &Nodes)
+{
+    for (const UA_NodeId &Id : Nodes)
+    {
+        UA_NodeId_clear(const_cast<UA_NodeId *>(&Id));
+    }
+    Nodes.clear();
+}
+
+size_t RangeCount(size_t Size, size_t Threads)
+{
+    return max<size_t>(1, min(Threads, Size));
+}
+
+// Runs Fn(Range, Begin, End) for RangeCount(Size, Threads) consecutive ranges
+// of [0, Size) in parallel.
+template <typename TFunction>
+void ForEachRange(size_t Size, size_t Threads, TFunction Fn)
+{
+    size_t Ranges = RangeCount(Size, Threads);
+    vector<thread> Workers;
+    size_t Begin = 0;
+    for (size_t i = 0; i < Ranges; i++)
+    {
+        size_t End = Begin + (Size - Begin) / (Ranges - i);
+        if (i + 1 == Ranges)
+        {
+            Fn(i, Begin, End);
+        }
+        else
+        {
+            Workers.emplace_back(Fn, i, Begin, End);
+        }
+        Begin = End;
+    }
+    for (thread &Worker : Workers)
+    {
+        Worker.join();
+    }
+}
+
+void ReadNodes(UA_Server *pServer, const vector<UA_NodeId> &Nodes,
+               const TCompareOptions &Options, size_t Threads,
+               vector<TNodeSnapshot> &oSnapshots)
+{
+    oSnapshots.resize(Nodes.size());
+    ForEachRange(Nodes.size(), Threads,
+                 [&](size_t Range, size_t Begin, size_t End) {
+        (void)Range;
+        for (size_t i = Begin; i < End; i++)
+        {
+            ReadNode(pServer, Nodes[i], Options, oSnapshots[i]);
+        }
+    });
+}
+
+void CompareNode(const string &NodeId, const TNodeSnapshot &Reference,
+                 const TNodeSnapshot &Test, TDifferenceVec &oDifferences)
+{
+    // the attributes are in the same order, the references are sorted
+    size_t r = 0;
+    size_t t = 0;
+    while (r < Reference.size() || t < Test.size())
+    {
+        const TEntry *pRef = r < Reference.size() ? &Reference[r] : nullptr;
+        const TEntry *pTest = t < Test.size() ? &Test[t] : nullptr;
+        if (pRef && pTest && pRef->Kind != TDifferenceKind::Reference &&
+            pRef->Kind == pTest->Kind && pRef->Aspect == pTest->Aspect)
+        {
+            if (pRef->Key != pTest->Key)
+            {
+                oDifferences.push_back(
+                    {pRef->Kind, NodeId, pRef->Aspect, pRef->Text, pTest->Text});
+            }
+            r++;
+            t++;
+            continue;
+        }
+        if (pRef && pTest && pRef->Key == pTest->Key)
+        {
+            r++;
+            t++;
+            continue;
+        }
+        if (pRef && (!pTest || pRef->Key < pTest->Key))
+        {
+            oDifferences.push_back(
+                {pRef->Kind, NodeId, pRef->Aspect, pRef->Text, ""});
+            r++;
+        }
+        else
+        {
+            oDifferences.push_back(
+                {pTest->Kind, NodeId, pTest->Aspect, "", pTest->Text});
+            t++;
+        }
+    }
+}
+
+} // namespace
+
+TCompareOptions DefaultCompareOptions()
+{
+    TCompareOptions Options;
+    Options.StartId = UA_NODEID_NUMERIC(0, UA_NS0ID_ROOTFOLDER);
+    Options.Threads = 0;
+    Options.CompareValues = UA_TRUE;
+    Options.CompareDataTypeDefinitions = UA_TRUE;
+    return Options;
+}
+
+UA_Boolean CompareAddressSpaces(UA_Server *pReference, UA_Server *pTest,
+                                const TCompareOptions &Options,
+                                TDifferenceVec &oDifferences)
+{
+    oDifferences.clear();
+    size_t Threads = Options.Threads;
+    if (Threads == 0)
+    {
+        Threads = max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    TNodeIdSet ReferenceNodes;
+    TNodeIdSet TestNodes;
+    UA_Boolean ret = UA_TRUE;
+    UA_Boolean TestRet = UA_TRUE;
+    // one thread per server
+    thread TestCollector(
+        [&]() { TestRet = CollectNodes(pTest, Options.StartId, TestNodes); });
+    ret = CollectNodes(pReference, Options.StartId, ReferenceNodes);
+    TestCollector.join();
+    if (!ret || !TestRet)
+    {
+        ClearNodes(ReferenceNodes);
+        ClearNodes(TestNodes);
+        return UA_FALSE;
+    }
+
+    // the node sets are ordered by node id
+    vector<UA_NodeId> Common;
+    TNodeIdSet::const_iterator itRef = ReferenceNodes.begin();
+    TNodeIdSet::const_iterator itTest = TestNodes.begin();
+    TNodeIdLess Less;
+    while (itRef != ReferenceNodes.end() || itTest != TestNodes.end())
+    {
+        if (itTest == TestNodes.end() ||
+            (itRef != ReferenceNodes.end() && Less(*itRef, *itTest)))
+        {
+            oDifferences.push_back({TDifferenceKind::MissingNode,
+                                    PrintNodeId(*itRef), "", "", ""});
+            ++itRef;
+        }
+        else if (itRef == ReferenceNodes.end() || Less(*itTest, *itRef))
+        {
+            oDifferences.push_back({TDifferenceKind::AdditionalNode,
+                                    PrintNodeId(*itTest), "", "", ""});
+            ++itTest;
+        }
+        else
+        {
+            Common.push_back(*itRef);
+            ++itRef;
+            ++itTest;
+        }
+    }
+
+    // a server is only read by one thread at a time, unless the server
+    // serializes the calls itself
+    size_t ReadThreads = 1;
+#if UA_MULTITHREADING >= 100
+    ReadThreads = max<size_t>(1, Threads / 2);
+#endif
+    vector<TNodeSnapshot> ReferenceSnapshots;
+    vector<TNodeSnapshot> TestSnapshots;
+    thread TestReader([&]() {
+        ReadNodes(pTest, Common, Options, ReadThreads, TestSnapshots);
+    });
+    ReadNodes(pReference, Common, Options, ReadThreads, ReferenceSnapshots);
+    TestReader.join();
+
+    vector<TDifferenceVec> RangeDifferences(RangeCount(Common.size(), Threads));
+    ForEachRange(Common.size(), Threads,
+                 [&](size_t Range, size_t Begin, size_t End) {
+        for (size_t i = Begin; i < End; i++)
+        {
+            CompareNode(PrintNodeId(Common[i]), ReferenceSnapshots[i],
+                        TestSnapshots[i], RangeDifferences[Range]);
+        }
+    });
+    for (const TDifferenceVec &Differences : RangeDifferences)
+    {
+        oDifferences.insert(oDifferences.end(), Differences.begin(),
+                            Differences.end());
+    }
+
+    ClearNodes(ReferenceNodes);
+    ClearNodes(TestNodes);
+    return UA_TRUE;
+}
+
+const char *DifferenceKindName(TDifferenceKind Kind)
+{
+    switch (Kind)
+    {
+    case TDifferenceKind::MissingNode:
+        return "MissingNode";
+    case TDifferenceKind::AdditionalNode:
+        return "AdditionalNode";
+    case TDifferenceKind::Attribute:
+        return "Attribute";
+    case TDifferenceKind::Value:
+        return "Value";
+    case TDifferenceKind::Reference:
+        return "Reference";
+    case TDifferenceKind::DataTypeDefinition:
+        return "DataTypeDefinition";
+    }
+    return "Unknown";
+}
+
+void PrintDifferences(const TDifferenceVec &Differences, ostream &out)
+{
+    for (const TDifference &Difference : Differences)
+    {
+        out << DifferenceKindName(Difference.Kind) << " " << Difference.NodeId;
+        if (!Difference.Aspect.empty())
+        {
+            out << " " << Difference.Aspect;
+        }
+        if (Difference.Kind != TDifferenceKind::MissingNode &&
+            Difference.Kind != TDifferenceKind::AdditionalNode)
+        {
+            out << ": reference = '" << Difference.Reference << "', test = '"
+                << Difference.Test << "'";
+        }
+        out << "\n";
+    }
+}
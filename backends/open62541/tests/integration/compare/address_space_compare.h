@@ -0,0 +1,68 @@
+#ifndef _ADDRESS_SPACE_COMPARE_H
+#define _ADDRESS_SPACE_COMPARE_H
+
+#include <open62541/server.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Compares the address spaces of two servers in the same process through the
+// server API, without a client and network connection. The nodes which are
+// reachable by forward hierarchical references from the start node are
+// compared by their attributes, values, forward references and
+// DataTypeDefinitions. Values are compared by their binary encoding, so
+// structures of generated and imported custom types are equal if they
+// encode equally.
+
+enum class TDifferenceKind
+{
+    MissingNode,    // only on the reference server
+    AdditionalNode, // only on the test server
+    Attribute,
+    Value,
+    Reference,
+    DataTypeDefinition
+};
+
+typedef struct
+{
+    TDifferenceKind Kind;
+    std::string NodeId;
+    // name of the attribute, empty for nodes and references
+    std::string Aspect;
+    // printed on the reference and the test server, empty if not present
+    std::string Reference;
+    std::string Test;
+} TDifference;
+
+typedef std::vector<TDifference> TDifferenceVec;
+
+typedef struct
+{
+    UA_NodeId StartId;
+    // threads which compare the nodes, 0 uses one per hardware thread. The
+    // servers are read by one thread each, unless open62541 is built with
+    // multithreading, their nodestores are not safe for concurrent reads
+    // otherwise.
+    size_t Threads;
+    UA_Boolean CompareValues;
+    UA_Boolean CompareDataTypeDefinitions;
+} TCompareOptions;
+
+// compares from the root folder with all aspects on all hardware threads
+TCompareOptions DefaultCompareOptions();
+
+// The servers must not be running or changed during the comparison. The
+// differences are ordered by node id. Returns false if a server couldn't be
+// browsed.
+UA_Boolean CompareAddressSpaces(UA_Server *pReference, UA_Server *pTest,
+                                const TCompareOptions &Options,
+                                TDifferenceVec &oDifferences);
+
+const char *DifferenceKindName(TDifferenceKind Kind);
+
+// one line per difference
+void PrintDifferences(const TDifferenceVec &Differences, std::ostream &out);
+
+#endif // _ADDRESS_SPACE_COMPARE_H
@@ -0,0 +1,122 @@
+#include "address_space_compare.h"
+#include "reference_server.h"
+#include "test_server.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void PrintUsage()
+{
+    cout << "command help = compareServers [--threads N] [--start-id NodeId] "
+            "[--no-values] [--no-definitions] [--output File] Nodeset..."
+         << endl;
+    cout << "The reference server is compiled with the generated nodesets, "
+            "the test server loads the given nodesets."
+         << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    TCompareOptions Options = DefaultCompareOptions();
+    string OutputPath;
+    vector<const char *> Nodesets;
+    for (int i = 1; i < argc; i++)
+    {
+        const bool HasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--threads") && HasValue)
+        {
+            Options.Threads = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--start-id") && HasValue)
+        {
+            UA_NodeId_init(&Options.StartId);
+            if (UA_NodeId_parse(&Options.StartId, UA_STRING(argv[++i])) !=
+                UA_STATUSCODE_GOOD)
+            {
+                cout << "Argument [--start-id] syntax is invalid" << endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--no-values"))
+        {
+            Options.CompareValues = UA_FALSE;
+        }
+        else if (!strcmp(argv[i], "--no-definitions"))
+        {
+            Options.CompareDataTypeDefinitions = UA_FALSE;
+        }
+        else if (!strcmp(argv[i], "--output") && HasValue)
+        {
+            OutputPath = argv[++i];
+        }
+        else if (!strncmp(argv[i], "--", 2))
+        {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+        else
+        {
+            Nodesets.push_back(argv[i]);
+        }
+    }
+
+    UA_Server *pReference = CreateReferenceServer();
+    if (!pReference)
+    {
+        cout << "Error: creating the reference server failed" << endl;
+        UA_NodeId_clear(&Options.StartId);
+        return EXIT_FAILURE;
+    }
+    UA_Server *pTest = CreateTestServer(4841, Nodesets.data(), Nodesets.size());
+    if (!pTest)
+    {
+        cout << "Error: creating the test server failed" << endl;
+        DeleteReferenceServer(pReference);
+        UA_NodeId_clear(&Options.StartId);
+        return EXIT_FAILURE;
+    }
+
+    int ret = EXIT_SUCCESS;
+    TDifferenceVec Differences;
+    if (CompareAddressSpaces(pReference, pTest, Options, Differences) ==
+        UA_FALSE)
+    {
+        cout << "Error: browsing the address spaces failed" << endl;
+        ret = EXIT_FAILURE;
+    }
+    else if (!Differences.empty())
+    {
+        cout << "Error: The addressspaces of the servers do not match, "
+             << Differences.size() << " difference(s)" << endl;
+        ret = EXIT_FAILURE;
+    }
+
+    if (!OutputPath.empty())
+    {
+        ofstream oFileStream(OutputPath, ios::binary | ios::trunc);
+        if (!oFileStream.good())
+        {
+            cout << "Error: Could not open file. Path = '" << OutputPath << "'"
+                 << endl;
+            ret = EXIT_FAILURE;
+        }
+        PrintDifferences(Differences, oFileStream);
+    }
+    else
+    {
+        PrintDifferences(Differences, cout);
+    }
+
+    DeleteTestServer(pTest);
+    DeleteReferenceServer(pReference);
+    UA_NodeId_clear(&Options.StartId);
+    cout << "Test finished: " << ((ret == EXIT_SUCCESS) ? "success" : "failure")
+         << endl;
+    return ret;
+}
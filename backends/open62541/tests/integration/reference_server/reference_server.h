@@ -0,0 +1,13 @@
+#ifndef _REFERENCE_SERVER_H
+#define _REFERENCE_SERVER_H
+
+#include <open62541/server.h>
+
+// Creates a server with the nodesets which were generated by the nodeset
+// compiler, selected by the USE_* definitions. Returns nullptr on error.
+UA_Server *CreateReferenceServer();
+
+// also frees the custom datatypes
+void DeleteReferenceServer(UA_Server *pServer);
+
+#endif // _REFERENCE_SERVER_H
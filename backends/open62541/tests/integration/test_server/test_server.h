@@ -0,0 +1,14 @@
+#ifndef _TEST_SERVER_H
+#define _TEST_SERVER_H
+
+#include <open62541/server.h>
+
+// Creates a server which loads the nodesets with the NodesetLoader. Returns
+// nullptr if a nodeset couldn't be loaded.
+UA_Server *CreateTestServer(UA_UInt16 Port, const char *const *ppNodesets,
+                            size_t NodesetsSize);
+
+// also cleans up the imported custom datatypes
+void DeleteTestServer(UA_Server *pServer);
+
+#endif // _TEST_SERVER_H
@@ -0,0 +1,199 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include <math.h>
+#include <pthread.h>
+
+#include "check.h"
+
+#include "testHelper.h"
+#include <NodesetLoader/backendOpen62541.h>
+#include <NodesetLoader/dataTypes.h>
+
+UA_Server *server;
+NodesetLoader_LazyValueStore *lazyValues;
+char* nodesetPath=NULL;
+
+static void setup(void) {
+    printf("path to testnodesets %s\n", nodesetPath);
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    lazyValues = NodesetLoader_LazyValueStore_new();
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(server)->customDataTypes;
+#endif
+    UA_Server_delete(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+    NodesetLoader_LazyValueStore_delete(lazyValues);
+}
+
+static UA_UInt16 getNamespaceIndex(const char* uri)
+{
+    UA_Variant namespaceArray;
+    UA_Variant_init(&namespaceArray);
+    UA_Server_readValue(server, UA_NODEID_NUMERIC(0, 2255), &namespaceArray);
+    UA_UInt16 nsidx = 0;
+    for(size_t cnt = 0; cnt < namespaceArray.arrayLength; cnt++) {
+        if(!strncmp((char*)((UA_String*)namespaceArray.data)[cnt].data, uri, ((UA_String*)namespaceArray.data)[cnt].length))
+        {
+            nsidx =(UA_UInt16)cnt;
+            break;
+        }
+    }
+    UA_Variant_clear(&namespaceArray);
+    return nsidx;
+}
+
+static UA_UInt16 loadLazyValues(void)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.lazyValues = lazyValues;
+    ck_assert(NodesetLoader_loadFileWithOptions(server, nodesetPath, NULL, &options));
+    UA_UInt16 nsIdx =
+        getNamespaceIndex("http://open62541.com/nodesetimport/tests/namespaceZeroValues");
+    ck_assert_uint_gt(nsIdx, 0);
+    return nsIdx;
+}
+
+START_TEST(Server_LoadLazyValues) {
+    UA_UInt16 nsIdx = loadLazyValues();
+    UA_Variant var;
+    UA_Variant_init(&var);
+    //scalar double, read twice to hit the decoded value
+    for (int i = 0; i < 2; i++)
+    {
+        UA_StatusCode retval = UA_Server_readValue(server, UA_NODEID_NUMERIC(nsIdx, 1003), &var);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert(var.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+        ck_assert(fabs(*(UA_Double *)var.data - 3.14) < 0.01);
+        UA_Variant_clear(&var);
+    }
+    //array of Uint32
+    UA_StatusCode retval = UA_Server_readValue(server, UA_NODEID_NUMERIC(nsIdx, 1004), &var);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(var.type == &UA_TYPES[UA_TYPES_UINT32]);
+    ck_assert_uint_eq(((UA_UInt32 *)var.data)[2], 140);
+    UA_Variant_clear(&var);
+    //extension object with nested struct
+    retval = UA_Server_readValue(server, UA_NODEID_NUMERIC(nsIdx, 1005), &var);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(var.type == &UA_TYPES[UA_TYPES_SERVERSTATUSDATATYPE]);
+    ck_assert_int_eq(((UA_ServerStatusDataType *)var.data)->state, 5);
+    UA_Variant_clear(&var);
+}
+END_TEST
+
+START_TEST(WriteBeforeRead)
+{
+    // a fresh server, the value of 1003 has never been read
+    UA_UInt16 nsIdx = loadLazyValues();
+    // written value must not be overwritten by the retained one
+    UA_Variant var;
+    UA_Double val = 42.0;
+    UA_Variant_setScalar(&var, &val, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert_uint_eq(UA_Server_writeValue(server, UA_NODEID_NUMERIC(nsIdx, 1003), var),
+                      UA_STATUSCODE_GOOD);
+    UA_Variant_init(&var);
+    UA_StatusCode retval = UA_Server_readValue(server, UA_NODEID_NUMERIC(nsIdx, 1003), &var);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(var.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert(fabs(*(UA_Double *)var.data - 42.0) < 0.01);
+    UA_Variant_clear(&var);
+}
+END_TEST
+
+struct ReadContext
+{
+    UA_NodeId id;
+    bool ok;
+};
+
+static void *readDouble(void *arg)
+{
+    struct ReadContext *ctx = (struct ReadContext *)arg;
+    UA_Variant var;
+    UA_Variant_init(&var);
+    ctx->ok = UA_Server_readValue(server, ctx->id, &var) == UA_STATUSCODE_GOOD &&
+              var.type == &UA_TYPES[UA_TYPES_DOUBLE] &&
+              fabs(*(UA_Double *)var.data - 3.14) < 0.01;
+    UA_Variant_clear(&var);
+    return NULL;
+}
+
+START_TEST(ConcurrentFirstRead)
+{
+    // every thread may be the first one to decode the value
+    UA_UInt16 nsIdx = loadLazyValues();
+    enum { THREADS = 8 };
+    pthread_t threads[THREADS];
+    struct ReadContext ctx[THREADS];
+    for (size_t i = 0; i < THREADS; i++)
+    {
+        ctx[i].id = UA_NODEID_NUMERIC(nsIdx, 1003);
+        ctx[i].ok = false;
+        ck_assert_int_eq(pthread_create(&threads[i], NULL, readDouble, &ctx[i]), 0);
+    }
+    for (size_t i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        ck_assert(ctx[i].ok);
+    }
+}
+END_TEST
+
+START_TEST(ReadIndexRange)
+{
+    UA_UInt16 nsIdx = loadLazyValues();
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_NUMERIC(nsIdx, 1004);
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    rvi.indexRange = UA_STRING("2");
+    UA_DataValue dv = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    ck_assert_uint_eq(dv.status, UA_STATUSCODE_GOOD);
+    ck_assert(dv.hasValue);
+    ck_assert_uint_eq(dv.value.arrayLength, 1);
+    ck_assert_uint_eq(((UA_UInt32 *)dv.value.data)[0], 140);
+    UA_DataValue_clear(&dv);
+}
+END_TEST
+
+static Suite *testSuite_Client(void) {
+    Suite *s = suite_create("server nodeset import");
+    TCase *tc_server = tcase_create("server nodeset import");
+    tcase_add_checked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, Server_LoadLazyValues);
+    tcase_add_test(tc_server, WriteBeforeRead);
+    tcase_add_test(tc_server, ConcurrentFirstRead);
+    tcase_add_test(tc_server, ReadIndexRange);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(int argc, char*argv[]) {
+    printf("%s", argv[0]);
+    if (!(argc > 1))
+        return 1;
+    nodesetPath = argv[1];
+    Suite *s = testSuite_Client();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
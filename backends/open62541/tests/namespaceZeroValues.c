@@ -51,9 +51,8 @@ static UA_UInt16 getNamespaceIndex(const char* uri)
     return nsidx;
 }
 
-START_TEST(Server_LoadNS0Values) {
-
-    ck_assert(NodesetLoader_loadFile(server, nodesetPath, NULL));
+static void checkNS0Values(void)
+{
     UA_UInt16 nsIdx =
         getNamespaceIndex("http://open62541.com/nodesetimport/tests/namespaceZeroValues");
     ck_assert_uint_gt(nsIdx, 0);
@@ -129,6 +128,54 @@ START_TEST(Server_LoadNS0Values) {
     ck_assert(UA_Guid_equal(&guid, (UA_Guid *)var.data));
     UA_Variant_clear(&var);
 }
+
+START_TEST(Server_LoadNS0Values) {
+
+    ck_assert(NodesetLoader_loadFile(server, nodesetPath, NULL));
+    checkNS0Values();
+}
+END_TEST
+
+static void loadWithOptions(const NodesetLoader_LoadOptions *options)
+{
+    ck_assert(NodesetLoader_loadFileWithOptions(server, nodesetPath, NULL, options));
+    checkNS0Values();
+}
+
+START_TEST(Server_LoadNS0Values_valueDecodingThreads)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.valueDecodingThreads = 4;
+    loadWithOptions(&options);
+}
+END_TEST
+
+START_TEST(Server_LoadNS0Values_compact)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.compact = true;
+    loadWithOptions(&options);
+}
+END_TEST
+
+START_TEST(Server_LoadNS0Values_deferFinish)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.deferFinish = true;
+    loadWithOptions(&options);
+}
+END_TEST
+
+START_TEST(Server_LoadNS0Values_decodeValues)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.decodeValues = true;
+    loadWithOptions(&options);
+}
 END_TEST
 
 START_TEST(EnumValues)
@@ -170,6 +217,27 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_server, EnumValues);
     //tcase_add_test(tc_server, NumericRange);
     suite_add_tcase(s, tc_server);
+    // every load option on a server of its own
+    TCase *tc_threads = tcase_create("valueDecodingThreads");
+    tcase_add_unchecked_fixture(tc_threads, setup, teardown);
+    tcase_add_test(tc_threads, Server_LoadNS0Values_valueDecodingThreads);
+    tcase_add_test(tc_threads, EnumValues);
+    suite_add_tcase(s, tc_threads);
+    TCase *tc_compact = tcase_create("compact");
+    tcase_add_unchecked_fixture(tc_compact, setup, teardown);
+    tcase_add_test(tc_compact, Server_LoadNS0Values_compact);
+    tcase_add_test(tc_compact, EnumValues);
+    suite_add_tcase(s, tc_compact);
+    TCase *tc_deferred = tcase_create("deferFinish");
+    tcase_add_unchecked_fixture(tc_deferred, setup, teardown);
+    tcase_add_test(tc_deferred, Server_LoadNS0Values_deferFinish);
+    tcase_add_test(tc_deferred, EnumValues);
+    suite_add_tcase(s, tc_deferred);
+    TCase *tc_decode = tcase_create("decodeValues");
+    tcase_add_unchecked_fixture(tc_decode, setup, teardown);
+    tcase_add_test(tc_decode, Server_LoadNS0Values_decodeValues);
+    tcase_add_test(tc_decode, EnumValues);
+    suite_add_tcase(s, tc_decode);
     return s;
 }
 
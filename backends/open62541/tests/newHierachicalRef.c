@@ -23,6 +23,12 @@ static void setup(void)
     UA_ServerConfig_setDefault(config);
 }
 
+static void setupRunning(void)
+{
+    setup();
+    UA_Server_run_startup(server);
+}
+
 static void teardown(void)
 {
     UA_Server_run_shutdown(server);
@@ -43,6 +49,32 @@ START_TEST(loadNodeset)
 }
 END_TEST
 
+static void onDone(UA_Server *s, void *context, bool status)
+{
+    *(int *)context = status ? 1 : -1;
+}
+
+// the second file is parsed, using the reference type of the first one, while
+// the first file is added by the running server
+START_TEST(loadNodesetAsync)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.asyncBatchSize = 1;
+    int done = 0;
+    const char *paths[] = {nodesetPath1, nodesetPath2};
+    NodesetLoader_AsyncImport *import = NodesetLoader_loadFilesAsync(
+        server, paths, 2, NULL, &options, onDone, &done);
+    ck_assert(import);
+    while (!done)
+    {
+        UA_Server_run_iterate(server, true);
+    }
+    ck_assert_int_eq(done, 1);
+    NodesetLoader_AsyncImport_delete(import);
+}
+END_TEST
+
 START_TEST(newHierachicalRef)
 {
     ck_assert(UA_NODECLASS_REFERENCETYPE ==
@@ -88,6 +120,14 @@ static Suite *testSuite_Client(void)
     tcase_add_test(tc_server, noHierachicalRef);
     tcase_add_test(tc_server, otherNamespace);
     suite_add_tcase(s, tc_server);
+
+    TCase *tc_async = tcase_create("async");
+    tcase_add_unchecked_fixture(tc_async, setupRunning, teardown);
+    tcase_add_test(tc_async, loadNodesetAsync);
+    tcase_add_test(tc_async, newHierachicalRef);
+    tcase_add_test(tc_async, noHierachicalRef);
+    tcase_add_test(tc_async, otherNamespace);
+    suite_add_tcase(s, tc_async);
     return s;
 }
 
@@ -36,10 +36,8 @@ static void teardown(void)
 #endif
 }
 
-START_TEST(references_typeDefinitionId)
+static void checkTypeDefinitionIds(void)
 {
-    ck_assert(NodesetLoader_loadFile(server, nodesetPath, NULL));
-
     UA_NodeId baseDataVariableTypeId =
         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
     UA_NodeId typeId = getTypeDefinitionId(server, UA_NODEID_NUMERIC(2, 6012));
@@ -49,6 +47,22 @@ START_TEST(references_typeDefinitionId)
     typeId = getTypeDefinitionId(server, UA_NODEID_NUMERIC(2, 5002));
     ck_assert(UA_NodeId_equal(&folderTypeId, &typeId));
 }
+
+START_TEST(references_typeDefinitionId)
+{
+    ck_assert(NodesetLoader_loadFile(server, nodesetPath, NULL));
+    checkTypeDefinitionIds();
+}
+END_TEST
+
+START_TEST(references_typeDefinitionId_deferFinish)
+{
+    NodesetLoader_LoadOptions options;
+    memset(&options, 0, sizeof(options));
+    options.deferFinish = true;
+    ck_assert(NodesetLoader_loadFileWithOptions(server, nodesetPath, NULL, &options));
+    checkTypeDefinitionIds();
+}
 END_TEST
 
 START_TEST(forwardReferences)
@@ -112,6 +126,15 @@ static Suite *testSuite_Client(void)
     tcase_add_test(tc_server, forwardReferences_EURange);
     tcase_add_test(tc_server, forwardReferences_EURange_newTypeDefRef);
     suite_add_tcase(s, tc_server);
+    // the same references, loaded in bulk insert mode
+    TCase *tc_deferred = tcase_create("deferFinish");
+    tcase_add_unchecked_fixture(tc_deferred, setup, teardown);
+    tcase_add_test(tc_deferred, references_typeDefinitionId_deferFinish);
+    tcase_add_test(tc_deferred, forwardReferences);
+    tcase_add_test(tc_deferred, forwardReferences_otherWayRound);
+    tcase_add_test(tc_deferred, forwardReferences_EURange);
+    tcase_add_test(tc_deferred, forwardReferences_EURange_newTypeDefRef);
+    suite_add_tcase(s, tc_deferred);
     return s;
 }
 
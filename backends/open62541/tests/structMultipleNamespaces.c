@@ -75,6 +75,48 @@ START_TEST(Server_ReadPointWithOffset)
 }
 END_TEST
 
+START_TEST(Server_ReadPointWithOffset_LoadFiles)
+{
+    const char *paths[2] = {nodesetPath1, nodesetPath2};
+    ck_assert(NodesetLoader_loadFiles(server, paths, 2, NULL, NULL));
+
+    UA_Variant var;
+    UA_Variant_init(&var);
+    UA_StatusCode retval =
+        UA_Server_readValue(server, UA_NODEID_NUMERIC(3, 6015), &var);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    struct PointWithOffset *p = (struct PointWithOffset *)var.data;
+    ck_assert(p->x == 10);
+    ck_assert(p->offset.z == -3);
+
+    UA_Variant_clear(&var);
+}
+END_TEST
+
+START_TEST(Server_ReadPointWithOffset_Session)
+{
+    NodesetLoader_Session *session = NodesetLoader_Session_new(server, NULL);
+    ck_assert_ptr_ne(session, NULL);
+    // the struct of the second file refers to the type of the first
+    ck_assert(NodesetLoader_Session_loadFile(session, nodesetPath1, NULL));
+    ck_assert(NodesetLoader_Session_loadFile(session, nodesetPath2, NULL));
+    NodesetLoader_Session_delete(session);
+
+    UA_Variant var;
+    UA_Variant_init(&var);
+    UA_StatusCode retval =
+        UA_Server_readValue(server, UA_NODEID_NUMERIC(3, 6015), &var);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    struct PointWithOffset *p = (struct PointWithOffset *)var.data;
+    ck_assert(p->x == 10);
+    ck_assert(p->offset.z == -3);
+
+    UA_Variant_clear(&var);
+}
+END_TEST
+
 static Suite *testSuite_Client(void)
 {
     Suite *s = suite_create("server nodeset import");
@@ -82,6 +124,14 @@ static Suite *testSuite_Client(void)
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, Server_ReadPointWithOffset);
     suite_add_tcase(s, tc_server);
+    TCase *tc_loadFiles = tcase_create("load files pipelined");
+    tcase_add_unchecked_fixture(tc_loadFiles, setup, teardown);
+    tcase_add_test(tc_loadFiles, Server_ReadPointWithOffset_LoadFiles);
+    suite_add_tcase(s, tc_loadFiles);
+    TCase *tc_session = tcase_create("load files in a session");
+    tcase_add_unchecked_fixture(tc_session, setup, teardown);
+    tcase_add_test(tc_session, Server_ReadPointWithOffset_Session);
+    suite_add_tcase(s, tc_session);
     return s;
 }
 
@@ -0,0 +1,604 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Exports nodesets as two tables, <prefix>nodes and <prefix>references, in
+// NDJSON (one JSON object per line) or CSV with a header line:
+// nodes: nodeClass,nodeId,browseNameNs,browseName,displayName,description,
+//        parentNodeId,typeDefinition,dataType
+// references: source,refType,target,isForward,kind
+// The nodes are written in sort order. They are formatted in spans on worker
+// threads and the spans are written in order, so the output doesn't depend on
+// the number of threads.
+
+#include "NodesetLoader/NodesetLoader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef NODESETLOADER_HAS_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define SPAN_SIZE 4096
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+struct Output
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+    bool outOfMemory;
+};
+
+struct Job
+{
+    NL_NodeSpan span;
+    struct Output nodes;
+    struct Output refs;
+    bool done;
+};
+
+struct Export
+{
+    bool csv;
+    bool outOfMemory;
+    struct Job *jobs;
+    size_t size;
+    size_t capacity;
+    size_t next;
+    // jobs before written are written and freed
+    size_t written;
+    // formatted jobs which are not written yet are limited to window
+    size_t window;
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+#endif
+};
+
+static const char *REFERENCEKIND_NAME[] = {"hierarchical", "nonHierarchical",
+                                           "typeDefinition"};
+
+static bool reserve(struct Output *out, size_t len)
+{
+    if (out->size + len <= out->capacity)
+    {
+        return true;
+    }
+    size_t capacity = out->capacity ? out->capacity * 2 : 65536;
+    while (capacity < out->size + len)
+    {
+        capacity *= 2;
+    }
+    char *data = (char *)realloc(out->data, capacity);
+    if (!data)
+    {
+        out->outOfMemory = true;
+        return false;
+    }
+    out->data = data;
+    out->capacity = capacity;
+    return true;
+}
+
+static void append(struct Output *out, const char *s, size_t len)
+{
+    if (!reserve(out, len))
+    {
+        return;
+    }
+    memcpy(out->data + out->size, s, len);
+    out->size += len;
+}
+
+static void appendString(struct Output *out, const char *s)
+{
+    append(out, s, strlen(s));
+}
+
+static void appendUInt(struct Output *out, UA_UInt32 value)
+{
+    char digits[10];
+    size_t len = 0;
+    do
+    {
+        digits[sizeof(digits) - ++len] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    append(out, digits + sizeof(digits) - len, len);
+}
+
+// characters which are copied as they are, in runs
+static bool jsonPlain(unsigned char c)
+{
+    return c >= 0x20 && c != '"' && c != '\\';
+}
+
+static void appendJson(struct Output *out, const char *s, size_t len)
+{
+    append(out, "\"", 1);
+    size_t i = 0;
+    while (i < len)
+    {
+        size_t run = i;
+        while (run < len && jsonPlain((unsigned char)s[run]))
+        {
+            run++;
+        }
+        append(out, s + i, run - i);
+        if (run == len)
+        {
+            break;
+        }
+        char c = s[run];
+        if (c == '"' || c == '\\')
+        {
+            char escaped[2] = {'\\', c};
+            append(out, escaped, 2);
+        }
+        else
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+            append(out, escaped, 6);
+        }
+        i = run + 1;
+    }
+    append(out, "\"", 1);
+}
+
+// fields are quoted only if they contain a separator, quote or line break
+static void appendCsv(struct Output *out, const char *s, size_t len)
+{
+    size_t plain = 0;
+    while (plain < len && s[plain] != ',' && s[plain] != '"' &&
+           s[plain] != '\n' && s[plain] != '\r')
+    {
+        plain++;
+    }
+    if (plain == len)
+    {
+        append(out, s, len);
+        return;
+    }
+    append(out, "\"", 1);
+    size_t i = 0;
+    const char *quote;
+    while ((quote = (const char *)memchr(s + i, '"', len - i)) != NULL)
+    {
+        size_t run = (size_t)(quote - s) + 1;
+        append(out, s + i, run - i);
+        append(out, "\"", 1);
+        i = run;
+    }
+    append(out, s + i, len - i);
+    append(out, "\"", 1);
+}
+
+static void appendText(struct Export *exp, struct Output *out, const char *s)
+{
+    if (!s)
+    {
+        append(out, exp->csv ? "" : "null", exp->csv ? 0 : 4);
+        return;
+    }
+    if (exp->csv)
+    {
+        appendCsv(out, s, strlen(s));
+    }
+    else
+    {
+        appendJson(out, s, strlen(s));
+    }
+}
+
+static void appendNodeId(struct Export *exp, struct Output *out,
+                         const UA_NodeId *id)
+{
+    if (!id || UA_NodeId_isNull(id))
+    {
+        append(out, exp->csv ? "" : "null", exp->csv ? 0 : 4);
+        return;
+    }
+    // numeric ids are formatted here, they need neither escaping nor an
+    // allocation
+    if (id->identifierType == UA_NODEIDTYPE_NUMERIC)
+    {
+        if (!exp->csv)
+        {
+            append(out, "\"", 1);
+        }
+        if (id->namespaceIndex)
+        {
+            append(out, "ns=", 3);
+            appendUInt(out, id->namespaceIndex);
+            append(out, ";", 1);
+        }
+        append(out, "i=", 2);
+        appendUInt(out, id->identifier.numeric);
+        if (!exp->csv)
+        {
+            append(out, "\"", 1);
+        }
+        return;
+    }
+    UA_String s = {0, NULL};
+    if (UA_NodeId_print(id, &s) != UA_STATUSCODE_GOOD)
+    {
+        append(out, exp->csv ? "" : "null", exp->csv ? 0 : 4);
+        return;
+    }
+    if (exp->csv)
+    {
+        appendCsv(out, (const char *)s.data, s.length);
+    }
+    else
+    {
+        appendJson(out, (const char *)s.data, s.length);
+    }
+    UA_String_clear(&s);
+}
+
+// starts a field, name is only used for NDJSON
+static void field(struct Export *exp, struct Output *out, const char *name,
+                  bool first)
+{
+    if (exp->csv)
+    {
+        if (!first)
+        {
+            append(out, ",", 1);
+        }
+        return;
+    }
+    append(out, first ? "{\"" : ",\"", 2);
+    appendString(out, name);
+    append(out, "\":", 2);
+}
+
+static void endRecord(struct Export *exp, struct Output *out)
+{
+    append(out, exp->csv ? "\n" : "}\n", exp->csv ? 1 : 2);
+}
+
+static void formatSpan(struct Export *exp, struct Job *job)
+{
+    const NL_NodeSpan *span = &job->span;
+    for (size_t i = 0; i < span->size; i++)
+    {
+        const NL_Node *node = span->nodes[i];
+        struct Output *out = &job->nodes;
+        field(exp, out, "nodeClass", true);
+        appendText(exp, out, NL_NODECLASS_NAME[span->nodeClass]);
+        field(exp, out, "nodeId", false);
+        appendNodeId(exp, out, &span->ids[i]);
+        field(exp, out, "browseNameNs", false);
+        appendUInt(out, span->browseNames[i].nsIdx);
+        field(exp, out, "browseName", false);
+        appendText(exp, out, span->browseNames[i].name);
+        field(exp, out, "displayName", false);
+        appendText(exp, out, node->displayName.text);
+        field(exp, out, "description", false);
+        appendText(exp, out, node->description.text);
+        field(exp, out, "parentNodeId", false);
+        appendNodeId(exp, out,
+                     span->parentNodeIds ? &span->parentNodeIds[i] : NULL);
+        field(exp, out, "typeDefinition", false);
+        appendNodeId(exp, out,
+                     span->typeDefinitions ? &span->typeDefinitions[i] : NULL);
+        field(exp, out, "dataType", false);
+        appendNodeId(exp, out, span->dataTypes ? &span->dataTypes[i] : NULL);
+        endRecord(exp, out);
+
+        out = &job->refs;
+        for (size_t r = span->refsBegin[i]; r < span->refsBegin[i + 1]; r++)
+        {
+            const NL_ReferenceEntry *ref = &span->refs[r];
+            field(exp, out, "source", true);
+            appendNodeId(exp, out, &span->ids[i]);
+            field(exp, out, "refType", false);
+            appendNodeId(exp, out, &ref->refType);
+            field(exp, out, "target", false);
+            appendNodeId(exp, out, &ref->target);
+            field(exp, out, "isForward", false);
+            appendString(out, ref->isForward ? "true" : "false");
+            field(exp, out, "kind", false);
+            appendText(exp, out, REFERENCEKIND_NAME[ref->kind]);
+            endRecord(exp, out);
+        }
+    }
+}
+
+static void collectSpan(void *context, const NL_NodeSpan *span)
+{
+    struct Export *exp = (struct Export *)context;
+    if (exp->size == exp->capacity)
+    {
+        size_t capacity = exp->capacity ? exp->capacity * 2 : 64;
+        struct Job *jobs =
+            (struct Job *)realloc(exp->jobs, capacity * sizeof(struct Job));
+        if (!jobs)
+        {
+            exp->outOfMemory = true;
+            return;
+        }
+        exp->jobs = jobs;
+        exp->capacity = capacity;
+    }
+    struct Job *job = &exp->jobs[exp->size++];
+    memset(job, 0, sizeof(struct Job));
+    job->span = *span;
+}
+
+#ifdef NODESETLOADER_HAS_PTHREAD
+static struct Job *nextJob(struct Export *exp)
+{
+    struct Job *job = NULL;
+    pthread_mutex_lock(&exp->lock);
+    while (exp->next < exp->size && exp->next >= exp->written + exp->window)
+    {
+        pthread_cond_wait(&exp->changed, &exp->lock);
+    }
+    if (exp->next < exp->size)
+    {
+        job = &exp->jobs[exp->next++];
+    }
+    pthread_mutex_unlock(&exp->lock);
+    return job;
+}
+
+static void finishJob(struct Export *exp, struct Job *job)
+{
+    pthread_mutex_lock(&exp->lock);
+    job->done = true;
+    pthread_cond_broadcast(&exp->changed);
+    pthread_mutex_unlock(&exp->lock);
+}
+
+static void *work(void *context)
+{
+    struct Export *exp = (struct Export *)context;
+    struct Job *job;
+    while ((job = nextJob(exp)) != NULL)
+    {
+        formatSpan(exp, job);
+        finishJob(exp, job);
+    }
+    return NULL;
+}
+#endif
+
+static void waitForJob(struct Export *exp, struct Job *job)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_lock(&exp->lock);
+    while (!job->done)
+    {
+        pthread_cond_wait(&exp->changed, &exp->lock);
+    }
+    pthread_mutex_unlock(&exp->lock);
+#else
+    if (!job->done)
+    {
+        formatSpan(exp, job);
+        job->done = true;
+    }
+#endif
+}
+
+static void writtenJob(struct Export *exp)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_lock(&exp->lock);
+    exp->written++;
+    pthread_cond_broadcast(&exp->changed);
+    pthread_mutex_unlock(&exp->lock);
+#else
+    exp->written++;
+#endif
+}
+
+// the calling thread writes the spans in order while the workers format them
+static bool run(struct Export *exp, size_t threads, FILE *nodes, FILE *refs)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_t *workers = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    size_t started = 0;
+    while (workers && started < threads &&
+           !pthread_create(&workers[started], NULL, work, exp))
+    {
+        started++;
+    }
+    if (!started)
+    {
+        // no worker, the spans are formatted before they are written
+        exp->window = exp->size;
+        work(exp);
+    }
+#else
+    (void)threads;
+#endif
+    bool ok = true;
+    for (size_t i = 0; i < exp->size; i++)
+    {
+        struct Job *job = &exp->jobs[i];
+        waitForJob(exp, job);
+        if (job->nodes.outOfMemory || job->refs.outOfMemory ||
+            fwrite(job->nodes.data, 1, job->nodes.size, nodes) !=
+                job->nodes.size ||
+            fwrite(job->refs.data, 1, job->refs.size, refs) != job->refs.size)
+        {
+            ok = false;
+        }
+        free(job->nodes.data);
+        free(job->refs.data);
+        memset(&job->nodes, 0, sizeof(struct Output));
+        memset(&job->refs, 0, sizeof(struct Output));
+        writtenJob(exp);
+    }
+#ifdef NODESETLOADER_HAS_PTHREAD
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+#endif
+    return ok;
+}
+
+static size_t defaultThreads(void)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (size_t)cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+static unsigned short namespaces = 0;
+static unsigned short addNamespace(void *userContext, const char *uri)
+{
+    (void)userContext;
+    if (uri && !strcmp(uri, "http://opcfoundation.org/UA/"))
+    {
+        return 0;
+    }
+    return ++namespaces;
+}
+
+static FILE *openTable(const char *prefix, const char *table, bool csv)
+{
+    size_t len = strlen(prefix) + strlen(table) + 8;
+    char *path = (char *)malloc(len);
+    if (!path)
+    {
+        return NULL;
+    }
+    snprintf(path, len, "%s%s.%s", prefix, table, csv ? "csv" : "ndjson");
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s\n", path);
+    }
+    else
+    {
+        setvbuf(f, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+    }
+    free(path);
+    return f;
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: nodesetExport [-j threads] [-f ndjson|csv] "
+                    "outputPrefix nodeset.xml...\n");
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t threads = defaultThreads();
+    bool csv = false;
+    int first = 1;
+    while (first + 1 < argc && argv[first][0] == '-')
+    {
+        if (!strcmp(argv[first], "-j"))
+        {
+            threads = (size_t)strtoul(argv[first + 1], NULL, 10);
+        }
+        else if (!strcmp(argv[first], "-f") &&
+                 (!strcmp(argv[first + 1], "csv") ||
+                  !strcmp(argv[first + 1], "ndjson")))
+        {
+            csv = !strcmp(argv[first + 1], "csv");
+        }
+        else
+        {
+            return usage();
+        }
+        first += 2;
+    }
+    if (first + 1 >= argc || !threads)
+    {
+        return usage();
+    }
+    const char *prefix = argv[first];
+
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.addNamespace = addNamespace;
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(options));
+    // values and extensions are not exported
+    options.skipAttributes = NL_ATTRIBUTE_VALUE | NL_ATTRIBUTE_EXTENSIONS;
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    if (!loader)
+    {
+        return 1;
+    }
+    for (int i = first + 1; i < argc; i++)
+    {
+        handler.file = argv[i];
+        if (!NodesetLoader_importFileWithOptions(loader, &handler, &options))
+        {
+            fprintf(stderr, "nodeset %s could not be loaded\n", argv[i]);
+            NodesetLoader_delete(loader);
+            return 1;
+        }
+    }
+    NodesetLoader_sort(loader);
+
+    struct Export exp;
+    memset(&exp, 0, sizeof(exp));
+    exp.csv = csv;
+    exp.window = 4 * threads;
+    size_t nodeCnt = 0;
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        nodeCnt += NodesetLoader_forEachSpan(loader, (NL_NodeClass)i, SPAN_SIZE,
+                                             &exp, collectSpan);
+    }
+
+    FILE *nodes = openTable(prefix, "nodes", csv);
+    FILE *refs = openTable(prefix, "references", csv);
+    bool ok = nodes && refs && !exp.outOfMemory;
+    if (ok)
+    {
+        if (csv)
+        {
+            fputs("nodeClass,nodeId,browseNameNs,browseName,displayName,"
+                  "description,parentNodeId,typeDefinition,dataType\n",
+                  nodes);
+            fputs("source,refType,target,isForward,kind\n", refs);
+        }
+#ifdef NODESETLOADER_HAS_PTHREAD
+        pthread_mutex_init(&exp.lock, NULL);
+        pthread_cond_init(&exp.changed, NULL);
+#endif
+        // the main thread writes, the workers format
+        ok = run(&exp, threads, nodes, refs);
+#ifdef NODESETLOADER_HAS_PTHREAD
+        pthread_cond_destroy(&exp.changed);
+        pthread_mutex_destroy(&exp.lock);
+#endif
+    }
+    if (nodes && fclose(nodes))
+    {
+        ok = false;
+    }
+    if (refs && fclose(refs))
+    {
+        ok = false;
+    }
+    free(exp.jobs);
+    NodesetLoader_delete(loader);
+    if (!ok)
+    {
+        fprintf(stderr, "export failed\n");
+        return 1;
+    }
+    fprintf(stderr, "%zu node(s) exported\n", nodeCnt);
+    return 0;
+}
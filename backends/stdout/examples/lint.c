@@ -0,0 +1,292 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Validates nodesets and prints all findings as one JSON object per line:
+// {"file":"...","check":"dangling-reference","nodeId":"ns=1;i=5","message":"..."}
+// Every file is validated on its own, the files are spread over worker
+// threads. Exits with 1 if there are findings.
+
+#include "NodesetLoader/NodesetLoader.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef NODESETLOADER_HAS_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// findings of one file, printed in the order of the arguments
+struct Output
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+};
+
+struct Job
+{
+    const char *file;
+    struct Output out;
+    size_t findings;
+    unsigned short namespaces;
+    // the last error logged by the loader
+    char error[256];
+};
+
+struct Jobs
+{
+    struct Job *jobs;
+    size_t size;
+    size_t next;
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_t lock;
+#endif
+};
+
+static void append(struct Output *out, const char *s, size_t len)
+{
+    if (out->size + len + 1 > out->capacity)
+    {
+        size_t capacity = out->capacity ? out->capacity * 2 : 4096;
+        while (capacity < out->size + len + 1)
+        {
+            capacity *= 2;
+        }
+        char *data = (char *)realloc(out->data, capacity);
+        if (!data)
+        {
+            return;
+        }
+        out->data = data;
+        out->capacity = capacity;
+    }
+    memcpy(out->data + out->size, s, len);
+    out->size += len;
+    out->data[out->size] = '\0';
+}
+
+static void appendString(struct Output *out, const char *s)
+{
+    append(out, s, strlen(s));
+}
+
+static void appendJson(struct Output *out, const char *s, size_t len)
+{
+    append(out, "\"", 1);
+    for (size_t i = 0; i < len; i++)
+    {
+        char c = s[i];
+        if (c == '"' || c == '\\')
+        {
+            char escaped[2] = {'\\', c};
+            append(out, escaped, 2);
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+            append(out, escaped, 6);
+        }
+        else
+        {
+            append(out, &c, 1);
+        }
+    }
+    append(out, "\"", 1);
+}
+
+static void appendFinding(struct Job *job, const char *check,
+                          const UA_NodeId *nodeId, const char *message)
+{
+    struct Output *out = &job->out;
+    appendString(out, "{\"file\":");
+    appendJson(out, job->file, strlen(job->file));
+    appendString(out, ",\"check\":");
+    appendJson(out, check, strlen(check));
+    appendString(out, ",\"nodeId\":");
+    UA_String id = {0, NULL};
+    if (nodeId && !UA_NodeId_isNull(nodeId) &&
+        UA_NodeId_print(nodeId, &id) == UA_STATUSCODE_GOOD)
+    {
+        appendJson(out, (const char *)id.data, id.length);
+    }
+    else
+    {
+        appendString(out, "null");
+    }
+    UA_String_clear(&id);
+    appendString(out, ",\"message\":");
+    appendJson(out, message, strlen(message));
+    appendString(out, "}\n");
+    job->findings++;
+}
+
+static void onFinding(void *context, const NL_Finding *finding)
+{
+    appendFinding((struct Job *)context, NL_CHECK_NAME[finding->check],
+                  &finding->nodeId, finding->message);
+}
+
+static void logError(void *context, enum NodesetLoader_LogLevel level,
+                     const char *message, ...)
+{
+    if (level != NODESETLOADER_LOGLEVEL_ERROR)
+    {
+        return;
+    }
+    struct Job *job = (struct Job *)context;
+    va_list args;
+    va_start(args, message);
+    vsnprintf(job->error, sizeof(job->error), message, args);
+    va_end(args);
+}
+
+static unsigned short addNamespace(void *userContext, const char *uri)
+{
+    struct Job *job = (struct Job *)userContext;
+    if (uri && !strcmp(uri, "http://opcfoundation.org/UA/"))
+    {
+        return 0;
+    }
+    return ++job->namespaces;
+}
+
+static void validate(struct Job *job)
+{
+    NodesetLoader_Logger logger = {job, logError};
+    NodesetLoader *loader = NodesetLoader_new(&logger, NULL);
+    if (!loader)
+    {
+        appendFinding(job, "import", NULL, "out of memory");
+        return;
+    }
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.file = job->file;
+    handler.addNamespace = addNamespace;
+    handler.userContext = job;
+    // the findings of a partial import are reported as well
+    if (!NodesetLoader_importFile(loader, &handler))
+    {
+        appendFinding(job, "import", NULL,
+                      job->error[0] ? job->error : "import failed");
+    }
+    NodesetLoader_validate(loader, job, onFinding);
+    NodesetLoader_delete(loader);
+}
+
+static struct Job *nextJob(struct Jobs *jobs)
+{
+    struct Job *job = NULL;
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_lock(&jobs->lock);
+#endif
+    if (jobs->next < jobs->size)
+    {
+        job = &jobs->jobs[jobs->next++];
+    }
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_unlock(&jobs->lock);
+#endif
+    return job;
+}
+
+static void *work(void *context)
+{
+    struct Job *job;
+    while ((job = nextJob((struct Jobs *)context)) != NULL)
+    {
+        validate(job);
+    }
+    return NULL;
+}
+
+static void run(struct Jobs *jobs, size_t threads)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_t *workers = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    size_t started = 0;
+    while (workers && started < threads &&
+           !pthread_create(&workers[started], NULL, work, jobs))
+    {
+        started++;
+    }
+    // whatever is left is done on this thread
+    work(jobs);
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+#else
+    (void)threads;
+    work(jobs);
+#endif
+}
+
+static size_t defaultThreads(void)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (size_t)cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    size_t threads = defaultThreads();
+    int first = 1;
+    if (argc > 2 && !strcmp(argv[1], "-j"))
+    {
+        threads = (size_t)strtoul(argv[2], NULL, 10);
+        first = 3;
+    }
+    if (first >= argc || !threads)
+    {
+        fprintf(stderr, "usage: nodesetLint [-j threads] nodeset.xml...\n");
+        return 2;
+    }
+
+    struct Jobs jobs;
+    memset(&jobs, 0, sizeof(jobs));
+    jobs.size = (size_t)(argc - first);
+    jobs.jobs = (struct Job *)calloc(jobs.size, sizeof(struct Job));
+    if (!jobs.jobs)
+    {
+        return 2;
+    }
+    for (size_t i = 0; i < jobs.size; i++)
+    {
+        jobs.jobs[i].file = argv[first + (int)i];
+    }
+    if (threads > jobs.size)
+    {
+        threads = jobs.size;
+    }
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_init(&jobs.lock, NULL);
+#endif
+    // the main thread is one of the workers
+    run(&jobs, threads - 1);
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_destroy(&jobs.lock);
+#endif
+
+    size_t findings = 0;
+    for (size_t i = 0; i < jobs.size; i++)
+    {
+        if (jobs.jobs[i].out.data)
+        {
+            fputs(jobs.jobs[i].out.data, stdout);
+        }
+        findings += jobs.jobs[i].findings;
+        free(jobs.jobs[i].out.data);
+    }
+    free(jobs.jobs);
+    fprintf(stderr, "%zu finding(s) in %zu file(s)\n", findings, jobs.size);
+    return findings ? 1 : 0;
+}
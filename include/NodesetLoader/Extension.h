@@ -1,6 +1,8 @@
 #ifndef NODESETLOADER_EXTENSION_H
 #define NODESETLOADER_EXTENSION_H
 
+#include <stddef.h>
+
 typedef void *(*NodesetLoader_newExtensionCb)(void);
 typedef void (*NodesetLoader_startExtensionCb)(void *extensionData,
                                                const char *name,
@@ -20,4 +22,58 @@ typedef struct
     NodesetLoader_finishExtensionCb finish;
 } NodesetLoader_ExtensionInterface;
 
+// Version 2 of the extension interface. Text is passed as spans which point
+// into the buffer of the xml parser, the spans are not NUL-terminated and are
+// only valid for the duration of the callback.
+typedef struct
+{
+    const char *data;
+    size_t length;
+} NL_TextSpan;
+
+typedef struct
+{
+    NL_TextSpan name;
+    NL_TextSpan value;
+} NL_ExtensionAttribute;
+
+// Allocates from an arena owned by the loader, the memory is released by
+// NodesetLoader_delete. The returned memory is suitably aligned for any type
+// and is not initialized.
+typedef void *(*NodesetLoader_allocExtensionCb)(void *allocatorContext,
+                                                size_t size);
+typedef struct
+{
+    void *context;
+    NodesetLoader_allocExtensionCb alloc;
+} NodesetLoader_ExtensionAllocator;
+
+// the allocator stays valid until NodesetLoader_delete
+typedef void *(*NodesetLoader_newExtensionV2Cb)(
+    void *userContext, const NodesetLoader_ExtensionAllocator *allocator);
+typedef void (*NodesetLoader_startExtensionV2Cb)(
+    void *userContext, void *extensionData, NL_TextSpan name,
+    size_t attributesSize, const NL_ExtensionAttribute *attributes);
+// Called for the character data inside of the extension, also for the
+// whitespace between elements. The text of one element may be delivered in
+// several chunks.
+typedef void (*NodesetLoader_textExtensionV2Cb)(void *userContext,
+                                                void *extensionData,
+                                                NL_TextSpan text);
+typedef void (*NodesetLoader_endExtensionV2Cb)(void *userContext,
+                                               void *extensionData,
+                                               NL_TextSpan name);
+typedef void (*NodesetLoader_finishExtensionV2Cb)(void *userContext,
+                                                  void *extensionData);
+
+typedef struct
+{
+    void *userContext;
+    NodesetLoader_newExtensionV2Cb newExtension;
+    NodesetLoader_startExtensionV2Cb start;
+    NodesetLoader_textExtensionV2Cb text;
+    NodesetLoader_endExtensionV2Cb end;
+    NodesetLoader_finishExtensionV2Cb finish;
+} NodesetLoader_ExtensionInterfaceV2;
+
 #endif
@@ -172,6 +172,9 @@ struct NL_Value
     const char *type;
     UA_NodeId typeId;
     NL_Data *data;
+    // set instead of data and type if the value was decoded while parsing,
+    // see NL_ImportOptions.decodeValues
+    UA_Variant *variant;
 };
 typedef struct NL_Value NL_Value;
 struct NL_VariableNode
@@ -244,6 +247,85 @@ typedef struct NL_ViewNode NL_ViewNode;
 
 typedef unsigned short (*NL_addNamespaceCallback)(void *userContext, const char *);
 
+#define NL_NODECLASS_MASK(nodeClass) (1u << (nodeClass))
+
+// called with the userContext of the NL_FileContext, id is translated to the
+// namespace indices of the backend
+typedef bool (*NL_ImportFilter_Func)(void *userContext, NL_NodeClass nodeClass,
+                                     const UA_NodeId *id);
+
+// Decides on the attributes of a node element, before anything of the node is
+// allocated, if it is imported. A node is imported if it passes all filters
+// which are set, zero initialize the unused members.
+// The NodeIds of the skipped nodes are remembered: an instance node whose
+// ParentNodeId refers to a node which was skipped before is skipped as well,
+// and references to skipped nodes or of skipped reference types are removed
+// before the sort and the validation.
+struct NL_ImportFilter
+{
+    // NL_NODECLASS_MASK of the imported node classes, 0 imports all
+    unsigned int nodeClasses;
+    // uris of the imported namespaces, nodes of namespace 0 have the uri
+    // "http://opcfoundation.org/UA/"
+    const char *const *namespaceUris;
+    size_t namespaceUrisSize;
+    // range of numeric identifiers, NodeIds of the other identifier types
+    // pass, numericMax 0 means unlimited
+    UA_UInt32 numericMin;
+    UA_UInt32 numericMax;
+    // Instance nodes are imported if they are the root or their ParentNodeId
+    // refers to the root or to an instance imported as part of the subtree
+    // before, the type nodes are not affected. Hence the parents have to
+    // precede their children in the file.
+    const UA_NodeId *subtreeRoot;
+    NL_ImportFilter_Func accept;
+};
+typedef struct NL_ImportFilter NL_ImportFilter;
+
+// Parts of the nodes which aren't needed by every backend, set in
+// NL_ImportOptions.skipAttributes they are skipped while parsing and left
+// empty, as if they were missing in the file.
+typedef enum
+{
+    NL_ATTRIBUTE_VALUE = 1 << 0,
+    NL_ATTRIBUTE_DESCRIPTION = 1 << 1,
+    NL_ATTRIBUTE_DISPLAYNAME_LOCALE = 1 << 2,
+    NL_ATTRIBUTE_INVERSENAME = 1 << 3,
+    NL_ATTRIBUTE_EXTENSIONS = 1 << 4,
+    NL_ATTRIBUTE_DATATYPE_DEFINITION = 1 << 5
+} NL_AttributeMask;
+
+typedef enum
+{
+    NL_PROGRESS_PARSE = 0,
+    NL_PROGRESS_SORT = 1,
+    // reported by backends while the nodes are added
+    NL_PROGRESS_INSERT = 2
+} NL_ProgressStage;
+
+// the fields of the later stages are 0 during the earlier ones
+struct NL_Progress
+{
+    NL_ProgressStage stage;
+    // of the file being parsed
+    size_t bytesParsed;
+    size_t bytesTotal;
+    // nodes created by all files of the loader so far
+    size_t nodesCreated;
+    size_t nodesSorted;
+    size_t nodesToSort;
+    // the node class being inserted, its nodes inserted so far and in total
+    NL_NodeClass nodeClass;
+    size_t nodesInserted;
+    size_t nodesOfClass;
+};
+typedef struct NL_Progress NL_Progress;
+
+// Returning false cancels the import at the next node. NodesetLoader_importFile
+// and NodesetLoader_sort return false then and the loader has to be deleted,
+// which releases the memory of the partial nodeset.
+typedef bool (*NL_ProgressCallback)(void *context, const NL_Progress *progress);
+
 struct NL_FileContext
 {
     void *userContext;
@@ -253,22 +335,280 @@ struct NL_FileContext
 };
 typedef struct NL_FileContext NL_FileContext;
 
+// Optional settings of NodesetLoader_importFileWithOptions, zero initialize
+// the unused members. NodesetLoader_importFile imports with all of them unset.
+struct NL_ImportOptions
+{
+    // takes precedence over NL_FileContext.extensionHandling if set
+    NodesetLoader_ExtensionInterfaceV2 *extensionHandlingV2;
+    // optional, all nodes are imported if NULL
+    const NL_ImportFilter *filter;
+    // NL_AttributeMask of the skipped attributes, 0 parses all of them
+    unsigned int skipAttributes;
+    // Values of variables whose data type is a builtin, enumeration or
+    // structure type of namespace 0 are decoded into NL_Value.variant while
+    // parsing, without building the NL_Data tree. The other values are
+    // parsed as before.
+    bool decodeValues;
+    // optional, called at most once per progressInterval milliseconds while
+    // the file is parsed and, with the callback of the last imported file,
+    // while the nodes are sorted. The first update and the end of each stage
+    // are always reported.
+    NL_ProgressCallback progress;
+    void *progressContext;
+    unsigned int progressInterval;
+};
+typedef struct NL_ImportOptions NL_ImportOptions;
+
 struct NodesetLoader;
 typedef struct NodesetLoader NodesetLoader;
 
 LOADER_EXPORT NodesetLoader *NodesetLoader_new(NodesetLoader_Logger *logger,
                                                struct NL_ReferenceService *refService);
+// memoryBudget limits the memory of the loaded nodesets in bytes, 0 means
+// unlimited. An import which exceeds the budget is aborted and
+// NodesetLoader_importFile returns false, the loader has to be deleted then.
+LOADER_EXPORT NodesetLoader *
+NodesetLoader_newWithBudget(NodesetLoader_Logger *logger,
+                            struct NL_ReferenceService *refService,
+                            size_t memoryBudget);
 LOADER_EXPORT bool NodesetLoader_importFile(NodesetLoader *loader,
                                             const NL_FileContext *fileContext);
+// options may be NULL, which is the same as NodesetLoader_importFile
+LOADER_EXPORT bool
+NodesetLoader_importFileWithOptions(NodesetLoader *loader,
+                                    const NL_FileContext *fileContext,
+                                    const NL_ImportOptions *options);
 LOADER_EXPORT void NodesetLoader_delete(NodesetLoader *loader);
 LOADER_EXPORT const NL_BiDirectionalReference *
 NodesetLoader_getBidirectionalRefs(const NodesetLoader *loader);
 LOADER_EXPORT bool NodesetLoader_sort(NodesetLoader *loader);
+// Frees the structures which are only needed for parsing and sorting, and
+// moves the nodes, their references and strings into contiguous memory in
+// sort order. Has to be called after NodesetLoader_sort. Pointers to nodes and
+// strings obtained before are invalid afterwards, including the strings passed
+// to an extension interface, and no further files can be imported.
+LOADER_EXPORT bool NodesetLoader_compact(NodesetLoader *loader);
+// compacts the nodeset at the end of every successful NodesetLoader_sort
+LOADER_EXPORT void NodesetLoader_setAutoCompact(NodesetLoader *loader,
+                                                bool autoCompact);
 typedef void (*NodesetLoader_forEachNode_Func)(void *context, NL_Node *node);
 LOADER_EXPORT size_t
 NodesetLoader_forEachNode(NodesetLoader *loader, NL_NodeClass nodeClass,
                           void *context, NodesetLoader_forEachNode_Func fn);
 LOADER_EXPORT bool NodesetLoader_isInstanceNode (const NL_Node *baseNode);
+
+typedef enum
+{
+    NL_REFERENCEKIND_HIERACHICAL = 0,
+    NL_REFERENCEKIND_NONHIERACHICAL = 1,
+    NL_REFERENCEKIND_TYPEDEFINITION = 2,
+    // the reference type is neither known as hierachical nor as non
+    // hierachical
+    NL_REFERENCEKIND_UNKNOWN = 3
+} NL_ReferenceKind;
+
+typedef struct
+{
+    UA_NodeId refType;
+    UA_NodeId target;
+    bool isForward;
+    NL_ReferenceKind kind;
+} NL_ReferenceEntry;
+
+// Consecutive nodes of one node class in sorted order, stored column wise.
+// The entries of node i are at index i of each column, the references of
+// node i are refs[refsBegin[i]] up to refs[refsBegin[i + 1]].
+typedef struct
+{
+    NL_NodeClass nodeClass;
+    size_t size;
+    NL_Node *const *nodes;
+    const UA_NodeId *ids;
+    const NL_BrowseName *browseNames;
+    // instance nodes (object, variable, method, view), NULL otherwise
+    const UA_NodeId *parentNodeIds;
+    // objects and variables, NULL otherwise
+    const UA_NodeId *typeDefinitions;
+    // variables and variable types, NULL otherwise
+    const UA_NodeId *dataTypes;
+    const size_t *refsBegin;
+    const NL_ReferenceEntry *refs;
+} NL_NodeSpan;
+
+typedef void (*NodesetLoader_forEachSpan_Func)(void *context,
+                                               const NL_NodeSpan *span);
+// Iterates the nodes in spans of at most batchSize nodes (0 for one span).
+// The columns are built on the first call for the node class, after
+// NodesetLoader_sort, and are a snapshot of the nodes at this point. NodeIds
+// and names are not copied, they are valid until NodesetLoader_delete.
+LOADER_EXPORT size_t
+NodesetLoader_forEachSpan(NodesetLoader *loader, NL_NodeClass nodeClass,
+                          size_t batchSize, void *context,
+                          NodesetLoader_forEachSpan_Func fn);
+// Returns the node with this id or NULL. Nodes are indexed when they are
+// parsed, the hash index costs one pointer per slot at a load factor between
+// 0.375 and 0.75, i.e. 11 to 22 bytes per node on 64 bit.
+LOADER_EXPORT NL_Node *NodesetLoader_getNode(const NodesetLoader *loader,
+                                             const UA_NodeId *id);
+
+typedef void (*NodesetLoader_forEachReference_Func)(
+    void *context, const NL_ReferenceEntry *ref);
+// Calls fn for each reference of the node, the type definition first, then the
+// hierachical, non hierachical and unknown references. The NodeIds of the
+// entries are valid until NodesetLoader_delete. Returns the number of
+// references.
+LOADER_EXPORT size_t
+NodesetLoader_forEachReference(NodesetLoader *loader, const NL_Node *node,
+                               void *context,
+                               NodesetLoader_forEachReference_Func fn);
+// Lets NodesetLoader_compact store the references as a pair of handles into
+// a table of the distinct NodeIds of the nodeset, 12 bytes per reference
+// instead of an NL_Reference with its own copies of the NodeIds. The reference
+// lists of the nodes are then a view, which is built for a node class on the
+// first NodesetLoader_forEachNode or NodesetLoader_getNode and costs an
+// NL_Reference per reference, the NodeIds are shared with the table.
+// NodesetLoader_forEachReference, NodesetLoader_forEachSpan and
+// NodesetLoader_getInverseReferences read the handles and don't build the
+// view, changes to the lists of the view are not seen by them. Has to be set
+// before the compaction.
+LOADER_EXPORT void
+NodesetLoader_setCompactReferences(NodesetLoader *loader,
+                                   bool compactReferences);
+
+typedef struct
+{
+    NL_Node *source;
+    UA_NodeId refType;
+    bool isForward;
+} NL_InverseReference;
+
+// Returns all references of the loaded nodes that target id, size is set to
+// their number. The index is built on the first call after
+// NodesetLoader_sort and is a snapshot of the references at this point. It
+// costs sizeof(UA_NodeId) + sizeof(NL_InverseReference), 64 bytes on 64 bit,
+// per reference and is freed with the loader. The lookup is a binary search.
+LOADER_EXPORT const NL_InverseReference *
+NodesetLoader_getInverseReferences(NodesetLoader *loader, const UA_NodeId *id,
+                                   size_t *size);
+
+typedef struct
+{
+    NL_Node *const *nodes;
+    size_t size;
+} NL_NodeLevel;
+
+// Returns the sorted nodes grouped into levels, size is set to the number of
+// levels. All dependencies of the nodes of level k, as seen by the sort, lie
+// in the levels below k, so the nodes of one level can be processed in
+// parallel. Within a level the nodes are in sort order. Available after
+// NodesetLoader_sort, the grouping is built on the first call.
+LOADER_EXPORT const NL_NodeLevel *
+NodesetLoader_getLevels(NodesetLoader *loader, size_t *size);
+
+typedef enum
+{
+    NL_CHECK_DANGLING_REFERENCE = 0,
+    NL_CHECK_UNKNOWN_REFERENCETYPE = 1,
+    NL_CHECK_MISSING_TYPEDEFINITION = 2,
+    NL_CHECK_MISSING_DATATYPE = 3,
+    NL_CHECK_ALIAS = 4,
+    NL_CHECK_MALFORMED_NODEID = 5,
+    NL_CHECK_MALFORMED_BROWSENAME = 6,
+    NL_CHECK_DUPLICATE_NODEID = 7,
+    NL_CHECK_REFERENCE_CYCLE = 8,
+    NL_CHECK_VALUE_TYPE = 9
+} NL_Check;
+#define NL_CHECK_COUNT 10
+
+// stable identifiers of the checks, e.g. "dangling-reference"
+LOADER_EXPORT extern const char *NL_CHECK_NAME[NL_CHECK_COUNT];
+
+typedef struct
+{
+    NL_Check check;
+    // the node the finding belongs to, null if the node has no valid id
+    UA_NodeId nodeId;
+    const char *message;
+} NL_Finding;
+
+typedef void (*NodesetLoader_Finding_Func)(void *context,
+                                           const NL_Finding *finding);
+// Checks the imported nodesets and reports all findings instead of stopping
+// at the first one, returns their number. Malformed NodeIds and browse names,
+// alias misuse and duplicate NodeIds are recorded while parsing. The other
+// checks run on the first call, which has to be after the last import, and
+// sort the nodeset if this didn't happen yet. References into namespaces
+// without any imported node are not reported as dangling, their nodes are
+// expected to exist on the server. Findings are valid until
+// NodesetLoader_delete.
+LOADER_EXPORT size_t NodesetLoader_validate(NodesetLoader *loader,
+                                            void *context,
+                                            NodesetLoader_Finding_Func fn);
+
+typedef enum
+{
+    NL_MEMORY_CHARARENA = 0,
+    NL_MEMORY_NODES = 1,
+    NL_MEMORY_REFERENCES = 2,
+    NL_MEMORY_VALUES = 3,
+    NL_MEMORY_SORT = 4,
+    NL_MEMORY_ALIASES = 5,
+    NL_MEMORY_NAMESPACES = 6,
+    // node index, inverse references and columns
+    NL_MEMORY_INDEX = 7,
+    NL_MEMORY_EXTENSIONS = 8
+} NL_MemorySubsystem;
+#define NL_MEMORY_COUNT 9
+
+LOADER_EXPORT extern const char *NL_MEMORY_NAME[NL_MEMORY_COUNT];
+
+typedef struct
+{
+    size_t bytes[NL_MEMORY_COUNT];
+    size_t total;
+    // 0 if unlimited
+    size_t budget;
+} NL_MemoryUsage;
+
+// Bytes allocated by the loader per subsystem. Memory of the logger, the
+// reference service and the extensions (unless allocated from the extension
+// arena) is not included.
+LOADER_EXPORT void NodesetLoader_getMemoryUsage(const NodesetLoader *loader,
+                                                NL_MemoryUsage *usage);
+
+// Arena for the strings of the parsed nodesets. An arena can be used by
+// several loaders one after another, it is reset when the loader is deleted
+// and keeps its regions. Regions grow geometrically and are not zeroed, with
+// hugePages they are rounded up to 2 MiB and mapped with a huge page hint
+// where mmap is available.
+struct CharArenaAllocator;
+typedef struct CharArenaAllocator NodesetLoader_CharArena;
+
+typedef struct
+{
+    size_t regions;
+    size_t mappedRegions;
+    // bytes of all regions
+    size_t capacity;
+    // bytes in use since the last reset
+    size_t used;
+    size_t resets;
+} NL_CharArenaStats;
+
+LOADER_EXPORT NodesetLoader_CharArena *
+NodesetLoader_CharArena_new(size_t initialSize, bool hugePages);
+LOADER_EXPORT void NodesetLoader_CharArena_delete(NodesetLoader_CharArena *arena);
+LOADER_EXPORT void
+NodesetLoader_CharArena_getStats(const NodesetLoader_CharArena *arena,
+                                 NL_CharArenaStats *stats);
+// Has to be called before the first import. The arena has to outlive the
+// loader and must not be used by two loaders at the same time.
+LOADER_EXPORT bool NodesetLoader_useCharArena(NodesetLoader *loader,
+                                              NodesetLoader_CharArena *arena);
+// statistics of the char arena of the loader, false before the first import
+LOADER_EXPORT bool NodesetLoader_getCharArenaStats(const NodesetLoader *loader,
+                                                   NL_CharArenaStats *stats);
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,8 @@ struct AliasList
 {
     Alias *data;
     size_t size;
+    // first alias of the current file
+    size_t fileBegin;
 };
 
 AliasList *AliasList_new(void)
@@ -45,20 +47,48 @@ Alias *AliasList_newAlias(AliasList *list, char *name)
     return &list->data[list->size - 1];
 }
 
+static const Alias *findAlias(const AliasList *list, size_t begin,
+                              const char *name)
+{
+    if (!name)
+        return NULL;
+    // backwards, a redefinition hides the alias of a file before
+    for (size_t i = list->size; i > begin; i--)
+    {
+        if (!strcmp(name, list->data[i - 1].name))
+            return &list->data[i - 1];
+    }
+    return NULL;
+}
+
 const UA_NodeId *
     AliasList_getNodeId(const AliasList *list, const char *name) {
-    if(!name)
-        return NULL;
+    const Alias *alias = findAlias(list, 0, name);
+    return alias ? &alias->id : NULL;
+}
 
-    for(Alias* alias = list->data; alias != list->data + list->size; alias++) {
-        if (!strcmp(name, alias->name))
-            return &alias->id;
+void AliasList_startFile(AliasList *list) { list->fileBegin = list->size; }
+
+bool AliasList_isDefinedInFile(const AliasList *list, const char *name)
+{
+    return findAlias(list, list->fileBegin, name) != NULL;
+}
+
+size_t AliasList_memoryUsage(const AliasList *list)
+{
+    if (!list)
+    {
+        return 0;
     }
-    return NULL;
+    return sizeof(AliasList) + MAX_ALIAS * sizeof(Alias);
 }
 
 void AliasList_delete(AliasList *list)
 {
+    if (!list)
+    {
+        return;
+    }
     free(list->data);
     free(list);
 }
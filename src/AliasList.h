@@ -22,7 +22,12 @@ struct AliasList;
 typedef struct AliasList AliasList;
 AliasList *AliasList_new(void);
 Alias *AliasList_newAlias(AliasList *list, char *name);
+// the latest definition of the alias
 const UA_NodeId *AliasList_getNodeId(const AliasList *list, const char *alias);
+// the aliases are defined per file, a later file may redefine them
+void AliasList_startFile(AliasList *list);
+bool AliasList_isDefinedInFile(const AliasList *list, const char *alias);
+size_t AliasList_memoryUsage(const AliasList *list);
 void AliasList_delete(AliasList *list);
 
 #endif
@@ -6,9 +6,19 @@
  */
 
 #include "CharAllocator.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef NODESETLOADER_HAS_MMAP
+#include <sys/mman.h>
+#endif
+
+// regions grow geometrically up to this size, larger requests get a region
+// of their own size
+#define CHARARENA_MAX_REGIONSIZE (64 * 1024 * 1024)
+#define CHARARENA_HUGEPAGESIZE (2 * 1024 * 1024)
+
 struct Region;
 
 struct Region
@@ -19,22 +29,69 @@ struct Region
     char *mem;
     char *userPtr;
     size_t userSize;
+    bool mapped;
 };
 
 struct CharArenaAllocator
 {
     size_t initialSize;
+    bool hugePages;
+    // regions in order of use, current is the one allocations are taken from,
+    // the ones after current are kept from before the last reset
+    struct Region *first;
     struct Region *current;
+    CharArenaAllocator_Stats stats;
 };
 
-static struct Region *Region_new(size_t capacity)
+static char *allocMem(size_t capacity, bool hugePages, bool *mapped)
+{
+    *mapped = false;
+#ifdef NODESETLOADER_HAS_MMAP
+    if (hugePages && capacity >= CHARARENA_HUGEPAGESIZE)
+    {
+        void *mem = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem != MAP_FAILED)
+        {
+#ifdef MADV_HUGEPAGE
+            madvise(mem, capacity, MADV_HUGEPAGE);
+#endif
+            *mapped = true;
+            return (char *)mem;
+        }
+    }
+#endif
+    // no zero fill, the users terminate their strings
+    return (char *)malloc(capacity);
+}
+
+static void Region_delete(struct Region *region)
 {
+#ifdef NODESETLOADER_HAS_MMAP
+    if (region->mapped)
+    {
+        munmap(region->mem, region->capacity);
+        free(region);
+        return;
+    }
+#endif
+    free(region->mem);
+    free(region);
+}
+
+static struct Region *Region_new(CharArenaAllocator *arena, size_t capacity)
+{
+    if (arena->hugePages)
+    {
+        capacity = (capacity + CHARARENA_HUGEPAGESIZE - 1) &
+                   ~(size_t)(CHARARENA_HUGEPAGESIZE - 1);
+    }
     struct Region *region = (struct Region *)calloc(1, sizeof(struct Region));
     if(!region)
     {
         return NULL;
     }
-    region->mem = (char *)calloc(capacity, sizeof(char));
+    region->mem = allocMem(capacity, arena->hugePages, &region->mapped);
     if(!region->mem)
     {
         free(region);
@@ -42,10 +99,22 @@ static struct Region *Region_new(size_t capacity)
     }
     region->capacity = capacity;
     region->userPtr = region->mem;
+    arena->stats.regions++;
+    arena->stats.capacity += capacity;
+    if (region->mapped)
+    {
+        arena->stats.mappedRegions++;
+    }
     return region;
 }
 
 CharArenaAllocator *CharArenaAllocator_new(size_t initialSize)
+{
+    return CharArenaAllocator_newWithOptions(initialSize, false);
+}
+
+CharArenaAllocator *CharArenaAllocator_newWithOptions(size_t initialSize,
+                                                      bool hugePages)
 {
     CharArenaAllocator *arena =
         (CharArenaAllocator *)calloc(1, sizeof(CharArenaAllocator));
@@ -53,36 +122,65 @@ CharArenaAllocator *CharArenaAllocator_new(size_t initialSize)
     {
         return NULL;
     }
-    arena->initialSize = initialSize;
-    arena->current = Region_new(arena->initialSize);
+    arena->initialSize = initialSize ? initialSize : 1;
+    arena->hugePages = hugePages;
+    arena->first = Region_new(arena, arena->initialSize);
+    if (!arena->first)
+    {
+        free(arena);
+        return NULL;
+    }
+    arena->current = arena->first;
     return arena;
 }
 
-static size_t getRegionSize(size_t requested, size_t initialArenaSize)
+static size_t getRegionSize(const CharArenaAllocator *arena, size_t required)
 {
-    size_t regionSize = initialArenaSize;
-    if (requested > initialArenaSize)
+    size_t regionSize = arena->current->capacity * 2;
+    if (regionSize > CHARARENA_MAX_REGIONSIZE)
+    {
+        regionSize = CHARARENA_MAX_REGIONSIZE;
+    }
+    if (regionSize < arena->initialSize)
     {
-        regionSize = requested * 2;
+        regionSize = arena->initialSize;
     }
-    return regionSize;
+    return required > regionSize ? required : regionSize;
+}
+
+// makes the region after current, which has room for required bytes, the
+// current one. Regions kept from before a reset are used if they are large
+// enough.
+static bool nextRegion(CharArenaAllocator *arena, size_t required)
+{
+    struct Region *next = arena->current->next;
+    if (!next || next->capacity < required)
+    {
+        next = Region_new(arena, getRegionSize(arena, required));
+        if (!next)
+        {
+            return false;
+        }
+        next->next = arena->current->next;
+        arena->current->next = next;
+    }
+    arena->current = next;
+    return true;
 }
 
 char *CharArenaAllocator_malloc(CharArenaAllocator *arena, size_t size)
 {
     if ((arena->current->size + size) > arena->current->capacity)
-    {        
-        struct Region *newRegion = Region_new(getRegionSize(size, arena->initialSize));
-        if (!newRegion)
+    {
+        if (!nextRegion(arena, size))
         {
             return NULL;
         }
-        newRegion->next = arena->current;
-        arena->current = newRegion;
     }
     arena->current->userPtr = arena->current->mem + arena->current->size;
     arena->current->size += size;
     arena->current->userSize = size;
+    arena->stats.used += size;
     return arena->current->userPtr;
 }
 
@@ -90,33 +188,72 @@ char *CharArenaAllocator_realloc(CharArenaAllocator *arena, size_t size)
 {
     if ((arena->current->size + size) > arena->current->capacity)
     {
-        // we also have to consider the size we have to transfer
-        struct Region *newRegion =
-            Region_new(getRegionSize(size + arena->current->userSize*2, arena->initialSize));
-        if (!newRegion)
+        struct Region *old = arena->current;
+        if (!nextRegion(arena, old->userSize + size))
         {
             return NULL;
         }
-        //we have to copy over the old stuff
-        memcpy(newRegion->userPtr, arena->current->userPtr, arena->current->userSize);
-        newRegion->userSize = arena->current->userSize;
-        newRegion->next = arena->current;
-        newRegion->size = newRegion->userSize;
-        arena->current = newRegion;
+        // we have to copy over the old stuff, the geometric growth keeps this
+        // rare for long texts
+        memcpy(arena->current->mem, old->userPtr, old->userSize);
+        old->size -= old->userSize;
+        arena->current->userPtr = arena->current->mem;
+        arena->current->userSize = old->userSize;
+        arena->current->size = old->userSize;
     }
     arena->current->userSize += size;
     arena->current->size += size;
+    arena->stats.used += size;
     return arena->current->userPtr;
 }
 
-void CharArenaAllocator_delete(CharArenaAllocator *arena)
+void CharArenaAllocator_reset(CharArenaAllocator *arena)
+{
+    for (struct Region *r = arena->first; r; r = r->next)
+    {
+        r->size = 0;
+        r->userSize = 0;
+        r->userPtr = r->mem;
+    }
+    arena->current = arena->first;
+    arena->stats.used = 0;
+    arena->stats.resets++;
+}
+
+bool CharArenaAllocator_contains(const CharArenaAllocator *arena,
+                                 const char *ptr)
+{
+    uintptr_t p = (uintptr_t)ptr;
+    for (const struct Region *r = arena->first; r; r = r->next)
+    {
+        uintptr_t mem = (uintptr_t)r->mem;
+        if (p >= mem && p < mem + r->capacity)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CharArenaAllocator_getStats(const CharArenaAllocator *arena,
+                                 CharArenaAllocator_Stats *stats)
+{
+    *stats = arena->stats;
+}
+
+size_t CharArenaAllocator_memoryUsage(const CharArenaAllocator *arena)
+{
+    return sizeof(CharArenaAllocator) +
+           arena->stats.regions * sizeof(struct Region) + arena->stats.capacity;
+}
+
+void CharArenaAllocator_delete(struct CharArenaAllocator *arena)
 {
-    struct Region *r = arena->current;
+    struct Region *r = arena->first;
     while (r)
     {
         struct Region *tmp = r->next;
-        free(r->mem);
-        free(r);
+        Region_delete(r);
         r = tmp;
     }
     free(arena);
@@ -7,14 +7,42 @@
 
 #ifndef CHARALLOCATOR_H
 #define CHARALLOCATOR_H
+#include <stdbool.h>
 #include <stddef.h>
 
 struct CharArenaAllocator;
 typedef struct CharArenaAllocator CharArenaAllocator;
 
+typedef struct
+{
+    size_t regions;
+    // regions backed by mmap, see CharArenaAllocator_newWithOptions
+    size_t mappedRegions;
+    // bytes of all regions
+    size_t capacity;
+    // bytes handed out since the last reset
+    size_t used;
+    size_t resets;
+} CharArenaAllocator_Stats;
+
 CharArenaAllocator *CharArenaAllocator_new(size_t initialSize);
+// With hugePages set, regions are rounded up to 2 MiB and mapped with a huge
+// page hint if mmap is available.
+CharArenaAllocator *CharArenaAllocator_newWithOptions(size_t initialSize,
+                                                      bool hugePages);
+// The memory is not initialized.
 char *CharArenaAllocator_malloc(struct CharArenaAllocator *arena, size_t size);
+// Grows the last allocation by size bytes, it may be moved to a new region.
 char *CharArenaAllocator_realloc(struct CharArenaAllocator *arena, size_t size);
+// Releases all allocations but keeps the regions for the next use.
+void CharArenaAllocator_reset(struct CharArenaAllocator *arena);
+// true if ptr points into one of the regions of the arena
+bool CharArenaAllocator_contains(const struct CharArenaAllocator *arena,
+                                 const char *ptr);
+void CharArenaAllocator_getStats(const struct CharArenaAllocator *arena,
+                                 CharArenaAllocator_Stats *stats);
+// bytes allocated by the arena, including unused capacity of the regions
+size_t CharArenaAllocator_memoryUsage(const struct CharArenaAllocator *arena);
 void CharArenaAllocator_delete(struct CharArenaAllocator *arena);
 
 #endif
@@ -9,18 +9,21 @@
 #include "nodes/NodeContainer.h"
 #include "NodesetLoader/NodesetLoader.h"
 #include <stdlib.h>
+#include <string.h>
 
 struct InternalRefService
 {
     size_t hierachicalRefsSize;
+    size_t hierachicalRefsCapacity;
     NL_ReferenceTypeNode *hierachicalRefs;
     struct NodeContainer *nonHierachicalRefs;
 };
 
 typedef struct InternalRefService InternalRefService;
 
-#define MAX_HIERACHICAL_REFS 50
-NL_ReferenceTypeNode hierachicalRefs[MAX_HIERACHICAL_REFS] = {
+#define INITIAL_HIERACHICAL_REFS 50
+// copied by every service, so loaders on different threads don't share it
+static const NL_ReferenceTypeNode hierachicalRefs[] = {
     {NODECLASS_REFERENCETYPE,
      {0, UA_NODEIDTYPE_NUMERIC, {35}},
      {0, "Organizes"},
@@ -172,6 +175,17 @@ addnewRefTypeImpl(InternalRefService *service, NL_ReferenceTypeNode *node) {
         if (!ref->isForward) {
             for (size_t i = 0; i < service->hierachicalRefsSize; i++) {
                 if (UA_NodeId_equal(&service->hierachicalRefs[i].id, &ref->target)) {
+                    if (service->hierachicalRefsSize ==
+                        service->hierachicalRefsCapacity) {
+                        size_t capacity = service->hierachicalRefsCapacity * 2;
+                        NL_ReferenceTypeNode *refs = (NL_ReferenceTypeNode *)realloc(
+                            service->hierachicalRefs,
+                            capacity * sizeof(NL_ReferenceTypeNode));
+                        if (!refs)
+                            break;
+                        service->hierachicalRefs = refs;
+                        service->hierachicalRefsCapacity = capacity;
+                    }
                     service->hierachicalRefs[service->hierachicalRefsSize++] =
                         *(NL_ReferenceTypeNode *)node;
                     isHierachical = true;
@@ -194,13 +208,23 @@ NL_ReferenceService *InternalRefService_new(void)
     {
         return NULL;
     }
-    service->hierachicalRefs = hierachicalRefs;
-    service->hierachicalRefsSize = 9;
+    service->hierachicalRefs = (NL_ReferenceTypeNode *)malloc(
+        INITIAL_HIERACHICAL_REFS * sizeof(NL_ReferenceTypeNode));
+    if (!service->hierachicalRefs)
+    {
+        free(service);
+        return NULL;
+    }
+    service->hierachicalRefsCapacity = INITIAL_HIERACHICAL_REFS;
+    service->hierachicalRefsSize =
+        sizeof(hierachicalRefs) / sizeof(hierachicalRefs[0]);
+    memcpy(service->hierachicalRefs, hierachicalRefs, sizeof(hierachicalRefs));
     service->nonHierachicalRefs = NodeContainer_new(100, false);
 
     NL_ReferenceService *refService = (NL_ReferenceService *)calloc(1, sizeof(NL_ReferenceService));
     if(!refService)
     {
+        free(service->hierachicalRefs);
         free(service);
         return NULL;
     }
@@ -220,6 +244,7 @@ void InternalRefService_delete(NL_ReferenceService *refService)
     InternalRefService *internalService =
         (InternalRefService *)refService->context;
     NodeContainer_delete(internalService->nonHierachicalRefs);
+    free(internalService->hierachicalRefs);
     free(internalService);
     free(refService);
 }
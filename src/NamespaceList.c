@@ -35,8 +35,21 @@ NamespaceList *NamespaceList_new(NL_addNamespaceCallback cb)
     return list;
 }
 
+size_t NamespaceList_memoryUsage(const NamespaceList *list)
+{
+    if (!list)
+    {
+        return 0;
+    }
+    return sizeof(NamespaceList) + list->size * sizeof(Namespace);
+}
+
 void NamespaceList_delete(NamespaceList *list)
 {
+    if (!list)
+    {
+        return;
+    }
     free(list->data);
     free(list);
 }
@@ -25,6 +25,7 @@ NamespaceList *NamespaceList_new(NL_addNamespaceCallback cb);
 Namespace *NamespaceList_newNamespace(NamespaceList *list, void *userContext,
                                       const char *uri);
 void NamespaceList_setUri(NamespaceList *list, Namespace *ns);
+size_t NamespaceList_memoryUsage(const NamespaceList *list);
 void NamespaceList_delete(NamespaceList *list);
 const Namespace *NamespaceList_getNamespace(const NamespaceList *list,
                                             int relativeIndex);
@@ -0,0 +1,279 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NodeIdTable.h"
+#include "CharAllocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *text;
+    UA_UInt32 hash;
+    // the string identifier of the fast path points into text
+    bool ownsId;
+    UA_NodeId id;
+} NodeIdEntry;
+
+struct NodeIdTable
+{
+    // handle + 1 of the entries, 0 if empty, capacity is a power of 2
+    size_t *slots;
+    size_t capacity;
+    NodeIdEntry *entries;
+    size_t size;
+    size_t entriesCapacity;
+    CharArenaAllocator *texts;
+};
+
+static size_t roundUpToPowerOf2(size_t n)
+{
+    size_t capacity = 16;
+    while (capacity < n)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+NodeIdTable *NodeIdTable_new(size_t initialCapacity)
+{
+    NodeIdTable *table = (NodeIdTable *)calloc(1, sizeof(NodeIdTable));
+    if (!table)
+    {
+        return NULL;
+    }
+    table->capacity = roundUpToPowerOf2(initialCapacity);
+    table->slots = (size_t *)calloc(table->capacity, sizeof(size_t));
+    table->texts = CharArenaAllocator_new(64 * 1024);
+    if (!table->slots || !table->texts)
+    {
+        NodeIdTable_delete(table);
+        return NULL;
+    }
+    return table;
+}
+
+void NodeIdTable_delete(NodeIdTable *table)
+{
+    if (!table)
+    {
+        return;
+    }
+    for (size_t i = 0; i < table->size; i++)
+    {
+        if (table->entries[i].ownsId)
+        {
+            UA_NodeId_clear(&table->entries[i].id);
+        }
+    }
+    free(table->entries);
+    free(table->slots);
+    if (table->texts)
+    {
+        CharArenaAllocator_delete(table->texts);
+    }
+    free(table);
+}
+
+static UA_UInt32 hashText(const char *text)
+{
+    // FNV-1a
+    UA_UInt32 hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+    {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+static size_t *findSlot(const NodeIdTable *table, size_t *slots,
+                        size_t capacity, const char *text, UA_UInt32 hash)
+{
+    size_t mask = capacity - 1;
+    size_t pos = hash & mask;
+    while (slots[pos])
+    {
+        const NodeIdEntry *entry = &table->entries[slots[pos] - 1];
+        if (entry->hash == hash && !strcmp(entry->text, text))
+        {
+            break;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return &slots[pos];
+}
+
+static bool grow(NodeIdTable *table)
+{
+    size_t capacity = table->capacity * 2;
+    size_t *slots = (size_t *)calloc(capacity, sizeof(size_t));
+    if (!slots)
+    {
+        return false;
+    }
+    // the texts are distinct, the first empty slot is taken
+    for (size_t i = 0; i < table->size; i++)
+    {
+        size_t pos = table->entries[i].hash & (capacity - 1);
+        while (slots[pos])
+        {
+            pos = (pos + 1) & (capacity - 1);
+        }
+        slots[pos] = i + 1;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return true;
+}
+
+static bool parseDecimal(const char **s, UA_UInt32 max, UA_UInt32 *out)
+{
+    const char *c = *s;
+    UA_UInt64 value = 0;
+    while (*c >= '0' && *c <= '9')
+    {
+        value = value * 10 + (UA_UInt64)(*c - '0');
+        if (value > max)
+        {
+            return false;
+        }
+        c++;
+    }
+    if (c == *s)
+    {
+        return false;
+    }
+    *out = (UA_UInt32)value;
+    *s = c;
+    return true;
+}
+
+// the forms i=, ns=N;i= and ns=N;s= cover nearly all NodeIds of the nodesets,
+// everything else is left to UA_NodeId_parse
+static bool parseFast(const char *text, UA_NodeId *id)
+{
+    UA_NodeId_init(id);
+    const char *c = text;
+    if (!strncmp(c, "ns=", 3))
+    {
+        c += 3;
+        UA_UInt32 ns = 0;
+        if (!parseDecimal(&c, UA_UINT16_MAX, &ns) || *c != ';')
+        {
+            return false;
+        }
+        id->namespaceIndex = (UA_UInt16)ns;
+        c++;
+    }
+    if (c[0] == 'i' && c[1] == '=')
+    {
+        c += 2;
+        id->identifierType = UA_NODEIDTYPE_NUMERIC;
+        return parseDecimal(&c, UA_UINT32_MAX, &id->identifier.numeric) &&
+               *c == '\0';
+    }
+    if (c[0] == 's' && c[1] == '=' && c[2] != '\0')
+    {
+        id->identifierType = UA_NODEIDTYPE_STRING;
+        id->identifier.string.length = strlen(c + 2);
+        id->identifier.string.data = (UA_Byte *)(uintptr_t)(c + 2);
+        return true;
+    }
+    return false;
+}
+
+static NodeIdEntry *newEntry(NodeIdTable *table)
+{
+    if (table->size == table->entriesCapacity)
+    {
+        size_t capacity =
+            table->entriesCapacity ? table->entriesCapacity * 2 : 64;
+        NodeIdEntry *entries = (NodeIdEntry *)realloc(
+            table->entries, capacity * sizeof(NodeIdEntry));
+        if (!entries)
+        {
+            return NULL;
+        }
+        table->entries = entries;
+        table->entriesCapacity = capacity;
+    }
+    return &table->entries[table->size];
+}
+
+size_t NodeIdTable_intern(NodeIdTable *table, const char *text)
+{
+    UA_UInt32 hash = hashText(text);
+    size_t *slot = findSlot(table, table->slots, table->capacity, text, hash);
+    if (*slot)
+    {
+        return *slot - 1;
+    }
+    NodeIdEntry *entry = newEntry(table);
+    if (!entry)
+    {
+        return NODEIDTABLE_INVALID;
+    }
+    size_t length = strlen(text) + 1;
+    char *copy = CharArenaAllocator_malloc(table->texts, length);
+    if (!copy)
+    {
+        return NODEIDTABLE_INVALID;
+    }
+    memcpy(copy, text, length);
+    entry->text = copy;
+    entry->hash = hash;
+    entry->ownsId = false;
+    if (!parseFast(copy, &entry->id))
+    {
+        if (UA_NodeId_parse(&entry->id, UA_STRING(copy)) != UA_STATUSCODE_GOOD)
+        {
+            // malformed texts are not interned, they are reported on every
+            // occurrence
+            return NODEIDTABLE_INVALID;
+        }
+        entry->ownsId = true;
+    }
+    // keep the load factor below 0.75
+    if ((table->size + 1) * 4 > table->capacity * 3)
+    {
+        if (!grow(table))
+        {
+            if (entry->ownsId)
+            {
+                UA_NodeId_clear(&entry->id);
+            }
+            return NODEIDTABLE_INVALID;
+        }
+        slot = findSlot(table, table->slots, table->capacity, text, hash);
+    }
+    *slot = table->size + 1;
+    return table->size++;
+}
+
+const UA_NodeId *NodeIdTable_get(const NodeIdTable *table, size_t handle)
+{
+    if (handle >= table->size)
+    {
+        return NULL;
+    }
+    return &table->entries[handle].id;
+}
+
+size_t NodeIdTable_size(const NodeIdTable *table)
+{
+    return table ? table->size : 0;
+}
+
+size_t NodeIdTable_memoryUsage(const NodeIdTable *table)
+{
+    if (!table)
+    {
+        return 0;
+    }
+    return sizeof(NodeIdTable) + table->capacity * sizeof(size_t) +
+           table->entriesCapacity * sizeof(NodeIdEntry) +
+           CharArenaAllocator_memoryUsage(table->texts);
+}
@@ -0,0 +1,27 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NODEIDTABLE_H
+#define NODEIDTABLE_H
+
+#include "NodesetLoader/NodesetLoader.h"
+
+// Interns the NodeId strings of the nodesets: every distinct text is parsed
+// once and mapped to a canonical NodeId and a handle. The NodeIds are stored
+// before the namespace translation, so the table is valid for all files.
+struct NodeIdTable;
+typedef struct NodeIdTable NodeIdTable;
+
+#define NODEIDTABLE_INVALID ((size_t)-1)
+
+NodeIdTable *NodeIdTable_new(size_t initialCapacity);
+void NodeIdTable_delete(NodeIdTable *table);
+// returns NODEIDTABLE_INVALID if text is no valid NodeId, the text is copied
+size_t NodeIdTable_intern(NodeIdTable *table, const char *text);
+// the NodeId is owned by the table and valid until the next call of intern
+const UA_NodeId *NodeIdTable_get(const NodeIdTable *table, size_t handle);
+size_t NodeIdTable_size(const NodeIdTable *table);
+size_t NodeIdTable_memoryUsage(const NodeIdTable *table);
+
+#endif
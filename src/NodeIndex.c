@@ -0,0 +1,562 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NodeIndex.h"
+#include "nodes/NodeBlock.h"
+#include "nodes/NodeContainer.h"
+#include <stdlib.h>
+
+struct NodeIndex
+{
+    // capacity is a power of 2
+    NL_Node **slots;
+    size_t capacity;
+    size_t size;
+};
+
+static size_t roundUpToPowerOf2(size_t n)
+{
+    size_t capacity = 16;
+    while (capacity < n)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+NodeIndex *NodeIndex_new(size_t initialCapacity)
+{
+    NodeIndex *index = (NodeIndex *)calloc(1, sizeof(NodeIndex));
+    if (!index)
+    {
+        return NULL;
+    }
+    index->capacity = roundUpToPowerOf2(initialCapacity);
+    index->slots = (NL_Node **)calloc(index->capacity, sizeof(NL_Node *));
+    if (!index->slots)
+    {
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void NodeIndex_delete(NodeIndex *index)
+{
+    if (!index)
+    {
+        return;
+    }
+    free(index->slots);
+    free(index);
+}
+
+static NL_Node **findSlot(NL_Node **slots, size_t capacity,
+                          const UA_NodeId *id)
+{
+    size_t mask = capacity - 1;
+    size_t pos = UA_NodeId_hash(id) & mask;
+    while (slots[pos] && !UA_NodeId_equal(&slots[pos]->id, id))
+    {
+        pos = (pos + 1) & mask;
+    }
+    return &slots[pos];
+}
+
+size_t NodeIndex_memoryUsage(const NodeIndex *index)
+{
+    if (!index)
+    {
+        return 0;
+    }
+    return sizeof(NodeIndex) + index->capacity * sizeof(NL_Node *);
+}
+
+static bool grow(NodeIndex *index)
+{
+    size_t capacity = index->capacity * 2;
+    NL_Node **slots = (NL_Node **)calloc(capacity, sizeof(NL_Node *));
+    if (!slots)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        if (index->slots[i])
+        {
+            *findSlot(slots, capacity, &index->slots[i]->id) = index->slots[i];
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+    return true;
+}
+
+bool NodeIndex_add(NodeIndex *index, NL_Node *node)
+{
+    if (!index)
+    {
+        return false;
+    }
+    // keep the load factor below 0.75
+    if ((index->size + 1) * 4 > index->capacity * 3 && !grow(index))
+    {
+        return false;
+    }
+    NL_Node **slot = findSlot(index->slots, index->capacity, &node->id);
+    if (*slot)
+    {
+        return false;
+    }
+    *slot = node;
+    index->size++;
+    return true;
+}
+
+size_t NodeIndex_size(const NodeIndex *index)
+{
+    return index ? index->size : 0;
+}
+
+void NodeIndex_forEach(const NodeIndex *index, void (*fn)(NL_Node *node))
+{
+    if (!index)
+    {
+        return;
+    }
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        if (index->slots[i])
+        {
+            fn(index->slots[i]);
+        }
+    }
+}
+
+void NodeIndex_forEachWithContext(const NodeIndex *index, void *context,
+                                  void (*fn)(void *context, NL_Node *node))
+{
+    if (!index)
+    {
+        return;
+    }
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        if (index->slots[i])
+        {
+            fn(context, index->slots[i]);
+        }
+    }
+}
+
+NL_Node *NodeIndex_get(const NodeIndex *index, const UA_NodeId *id)
+{
+    if (!index)
+    {
+        return NULL;
+    }
+    return *findSlot(index->slots, index->capacity, id);
+}
+
+// open addressing on the NodeId hash, shared by NodeIdSet and NodeIdMap
+struct IdTable
+{
+    // capacity is a power of 2, free slots hold the null NodeId
+    UA_NodeId *slots;
+    // NULL for a set, otherwise values[i] belongs to slots[i]
+    const void **values;
+    size_t capacity;
+    size_t size;
+    // bytes of the copied string and bytestring identifiers
+    size_t identifierBytes;
+};
+typedef struct IdTable IdTable;
+
+struct NodeIdSet
+{
+    IdTable table;
+};
+
+struct NodeIdMap
+{
+    IdTable table;
+};
+
+static bool IdTable_init(IdTable *table, size_t initialCapacity,
+                         bool withValues)
+{
+    table->capacity = roundUpToPowerOf2(initialCapacity);
+    table->slots = (UA_NodeId *)calloc(table->capacity, sizeof(UA_NodeId));
+    if (!table->slots)
+    {
+        return false;
+    }
+    if (withValues)
+    {
+        table->values =
+            (const void **)calloc(table->capacity, sizeof(const void *));
+        if (!table->values)
+        {
+            free(table->slots);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void IdTable_clear(IdTable *table)
+{
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        UA_NodeId_clear(&table->slots[i]);
+    }
+    free(table->slots);
+    free(table->values);
+}
+
+static size_t findIdPos(const UA_NodeId *slots, size_t capacity,
+                        const UA_NodeId *id)
+{
+    size_t mask = capacity - 1;
+    size_t pos = UA_NodeId_hash(id) & mask;
+    while (!UA_NodeId_isNull(&slots[pos]) && !UA_NodeId_equal(&slots[pos], id))
+    {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+static bool IdTable_grow(IdTable *table)
+{
+    size_t capacity = table->capacity * 2;
+    UA_NodeId *slots = (UA_NodeId *)calloc(capacity, sizeof(UA_NodeId));
+    if (!slots)
+    {
+        return false;
+    }
+    const void **values = NULL;
+    if (table->values)
+    {
+        values = (const void **)calloc(capacity, sizeof(const void *));
+        if (!values)
+        {
+            free(slots);
+            return false;
+        }
+    }
+    // the identifiers are moved, not copied
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        if (!UA_NodeId_isNull(&table->slots[i]))
+        {
+            size_t pos = findIdPos(slots, capacity, &table->slots[i]);
+            slots[pos] = table->slots[i];
+            if (values)
+            {
+                values[pos] = table->values[i];
+            }
+        }
+    }
+    free(table->slots);
+    free(table->values);
+    table->slots = slots;
+    table->values = values;
+    table->capacity = capacity;
+    return true;
+}
+
+static bool IdTable_add(IdTable *table, const UA_NodeId *id, const void *value)
+{
+    if (UA_NodeId_isNull(id))
+    {
+        return false;
+    }
+    if ((table->size + 1) * 4 > table->capacity * 3 && !IdTable_grow(table))
+    {
+        return false;
+    }
+    size_t pos = findIdPos(table->slots, table->capacity, id);
+    if (!UA_NodeId_isNull(&table->slots[pos]) ||
+        UA_NodeId_copy(id, &table->slots[pos]) != UA_STATUSCODE_GOOD)
+    {
+        return false;
+    }
+    if (table->values)
+    {
+        table->values[pos] = value;
+    }
+    if (id->identifierType == UA_NODEIDTYPE_STRING ||
+        id->identifierType == UA_NODEIDTYPE_BYTESTRING)
+    {
+        table->identifierBytes += id->identifier.string.length;
+    }
+    table->size++;
+    return true;
+}
+
+// returns the capacity if the id isn't part of the table
+static size_t IdTable_find(const IdTable *table, const UA_NodeId *id)
+{
+    if (!table->size || UA_NodeId_isNull(id))
+    {
+        return table->capacity;
+    }
+    size_t pos = findIdPos(table->slots, table->capacity, id);
+    return UA_NodeId_isNull(&table->slots[pos]) ? table->capacity : pos;
+}
+
+static size_t IdTable_memoryUsage(const IdTable *table)
+{
+    size_t slotSize =
+        sizeof(UA_NodeId) + (table->values ? sizeof(const void *) : 0);
+    return table->capacity * slotSize + table->identifierBytes;
+}
+
+NodeIdSet *NodeIdSet_new(size_t initialCapacity)
+{
+    NodeIdSet *set = (NodeIdSet *)calloc(1, sizeof(NodeIdSet));
+    if (!set)
+    {
+        return NULL;
+    }
+    if (!IdTable_init(&set->table, initialCapacity, false))
+    {
+        free(set);
+        return NULL;
+    }
+    return set;
+}
+
+void NodeIdSet_delete(NodeIdSet *set)
+{
+    if (!set)
+    {
+        return;
+    }
+    IdTable_clear(&set->table);
+    free(set);
+}
+
+bool NodeIdSet_add(NodeIdSet *set, const UA_NodeId *id)
+{
+    return set && IdTable_add(&set->table, id, NULL);
+}
+
+bool NodeIdSet_contains(const NodeIdSet *set, const UA_NodeId *id)
+{
+    return set && IdTable_find(&set->table, id) != set->table.capacity;
+}
+
+size_t NodeIdSet_size(const NodeIdSet *set) { return set ? set->table.size : 0; }
+
+size_t NodeIdSet_memoryUsage(const NodeIdSet *set)
+{
+    if (!set)
+    {
+        return 0;
+    }
+    return sizeof(NodeIdSet) + IdTable_memoryUsage(&set->table);
+}
+
+NodeIdMap *NodeIdMap_new(size_t initialCapacity)
+{
+    NodeIdMap *map = (NodeIdMap *)calloc(1, sizeof(NodeIdMap));
+    if (!map)
+    {
+        return NULL;
+    }
+    if (!IdTable_init(&map->table, initialCapacity, true))
+    {
+        free(map);
+        return NULL;
+    }
+    return map;
+}
+
+void NodeIdMap_delete(NodeIdMap *map)
+{
+    if (!map)
+    {
+        return;
+    }
+    IdTable_clear(&map->table);
+    free(map);
+}
+
+bool NodeIdMap_add(NodeIdMap *map, const UA_NodeId *id, const void *value)
+{
+    return map && IdTable_add(&map->table, id, value);
+}
+
+bool NodeIdMap_get(const NodeIdMap *map, const UA_NodeId *id,
+                   const void **value)
+{
+    if (!map)
+    {
+        return false;
+    }
+    size_t pos = IdTable_find(&map->table, id);
+    if (pos == map->table.capacity)
+    {
+        return false;
+    }
+    *value = map->table.values[pos];
+    return true;
+}
+
+size_t NodeIdMap_size(const NodeIdMap *map) { return map ? map->table.size : 0; }
+
+struct InverseRefIndex
+{
+    size_t size;
+    // sorted, refs[i] targets targets[i]
+    UA_NodeId *targets;
+    NL_InverseReference *refs;
+};
+
+struct InverseRefEntry
+{
+    UA_NodeId target;
+    NL_InverseReference ref;
+};
+typedef struct InverseRefEntry InverseRefEntry;
+
+struct EntryCollector
+{
+    // NULL if the references are only counted
+    InverseRefEntry *entry;
+    size_t size;
+    NL_Node *source;
+};
+
+// the unknown references are left out
+static void collectEntry(void *context, const NL_ReferenceEntry *ref)
+{
+    struct EntryCollector *c = (struct EntryCollector *)context;
+    if (ref->kind == NL_REFERENCEKIND_UNKNOWN)
+    {
+        return;
+    }
+    if (c->entry)
+    {
+        c->entry->target = ref->target;
+        c->entry->ref.source = c->source;
+        c->entry->ref.refType = ref->refType;
+        c->entry->ref.isForward = ref->isForward;
+        c->entry++;
+    }
+    c->size++;
+}
+
+// counts the references if entries is NULL
+static size_t collect(NodeContainer *const *nodes, NodeBlock *const *blocks,
+                      InverseRefEntry *entries)
+{
+    struct EntryCollector c = {entries, 0, NULL};
+    for (size_t cl = 0; cl < NL_NODECLASS_COUNT; cl++)
+    {
+        for (size_t i = 0; i < nodes[cl]->size; i++)
+        {
+            c.source = nodes[cl]->nodes[i];
+            NodeBlock_forEachReference(blocks ? blocks[cl] : NULL, c.source,
+                                       &c, collectEntry);
+        }
+    }
+    return c.size;
+}
+
+static int compareEntries(const void *a, const void *b)
+{
+    return (int)UA_NodeId_order(&((const InverseRefEntry *)a)->target,
+                                &((const InverseRefEntry *)b)->target);
+}
+
+InverseRefIndex *InverseRefIndex_new(NodeContainer *const *nodes,
+                                     NodeBlock *const *blocks)
+{
+    InverseRefIndex *index =
+        (InverseRefIndex *)calloc(1, sizeof(InverseRefIndex));
+    if (!index)
+    {
+        return NULL;
+    }
+    size_t size = collect(nodes, blocks, NULL);
+    InverseRefEntry *entries =
+        (InverseRefEntry *)calloc(size, sizeof(InverseRefEntry));
+    index->targets = (UA_NodeId *)calloc(size, sizeof(UA_NodeId));
+    index->refs =
+        (NL_InverseReference *)calloc(size, sizeof(NL_InverseReference));
+    if (size && (!entries || !index->targets || !index->refs))
+    {
+        free(entries);
+        InverseRefIndex_delete(index);
+        return NULL;
+    }
+    collect(nodes, blocks, entries);
+    qsort(entries, size, sizeof(InverseRefEntry), compareEntries);
+    for (size_t i = 0; i < size; i++)
+    {
+        index->targets[i] = entries[i].target;
+        index->refs[i] = entries[i].ref;
+    }
+    index->size = size;
+    free(entries);
+    return index;
+}
+
+void InverseRefIndex_delete(InverseRefIndex *index)
+{
+    if (!index)
+    {
+        return;
+    }
+    free(index->targets);
+    free(index->refs);
+    free(index);
+}
+
+size_t InverseRefIndex_memoryUsage(const InverseRefIndex *index)
+{
+    if (!index)
+    {
+        return 0;
+    }
+    return sizeof(InverseRefIndex) +
+           index->size * (sizeof(UA_NodeId) + sizeof(NL_InverseReference));
+}
+
+// first entry which isn't less than target
+static size_t lowerBound(const InverseRefIndex *index, const UA_NodeId *target)
+{
+    size_t begin = 0;
+    size_t end = index->size;
+    while (begin < end)
+    {
+        size_t mid = begin + (end - begin) / 2;
+        if (UA_NodeId_order(&index->targets[mid], target) == UA_ORDER_LESS)
+        {
+            begin = mid + 1;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+const NL_InverseReference *InverseRefIndex_get(const InverseRefIndex *index,
+                                               const UA_NodeId *target,
+                                               size_t *size)
+{
+    size_t begin = lowerBound(index, target);
+    size_t end = begin;
+    while (end < index->size && UA_NodeId_equal(&index->targets[end], target))
+    {
+        end++;
+    }
+    *size = end - begin;
+    return *size ? &index->refs[begin] : NULL;
+}
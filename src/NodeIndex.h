@@ -0,0 +1,67 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NODEINDEX_H
+#define NODEINDEX_H
+
+#include "NodesetLoader/NodesetLoader.h"
+
+struct NodeContainer;
+struct NodeBlock;
+
+// hash index of the nodes, open addressing on the NodeId hash
+struct NodeIndex;
+typedef struct NodeIndex NodeIndex;
+
+NodeIndex *NodeIndex_new(size_t initialCapacity);
+void NodeIndex_delete(NodeIndex *index);
+// returns false if there is already a node with this id
+bool NodeIndex_add(NodeIndex *index, NL_Node *node);
+NL_Node *NodeIndex_get(const NodeIndex *index, const UA_NodeId *id);
+size_t NodeIndex_size(const NodeIndex *index);
+void NodeIndex_forEach(const NodeIndex *index, void (*fn)(NL_Node *node));
+void NodeIndex_forEachWithContext(const NodeIndex *index, void *context,
+                                  void (*fn)(void *context, NL_Node *node));
+size_t NodeIndex_memoryUsage(const NodeIndex *index);
+
+// hash set of NodeIds, the ids are copied. The null NodeId can't be added.
+struct NodeIdSet;
+typedef struct NodeIdSet NodeIdSet;
+
+NodeIdSet *NodeIdSet_new(size_t initialCapacity);
+void NodeIdSet_delete(NodeIdSet *set);
+// returns false if the id is null, already part of the set or on error
+bool NodeIdSet_add(NodeIdSet *set, const UA_NodeId *id);
+bool NodeIdSet_contains(const NodeIdSet *set, const UA_NodeId *id);
+size_t NodeIdSet_size(const NodeIdSet *set);
+size_t NodeIdSet_memoryUsage(const NodeIdSet *set);
+
+// hash map from NodeIds to values, the ids are copied, the values are not
+// owned. The null NodeId can't be added.
+struct NodeIdMap;
+typedef struct NodeIdMap NodeIdMap;
+
+NodeIdMap *NodeIdMap_new(size_t initialCapacity);
+void NodeIdMap_delete(NodeIdMap *map);
+// returns false if the id is null, already part of the map or on error
+bool NodeIdMap_add(NodeIdMap *map, const UA_NodeId *id, const void *value);
+// returns false if the id isn't part of the map, value may be set to NULL
+bool NodeIdMap_get(const NodeIdMap *map, const UA_NodeId *id,
+                   const void **value);
+size_t NodeIdMap_size(const NodeIdMap *map);
+
+// all references of the nodes, grouped by their target, blocks are the blocks
+// of the nodes after the compaction, NULL before
+struct InverseRefIndex;
+typedef struct InverseRefIndex InverseRefIndex;
+
+InverseRefIndex *InverseRefIndex_new(struct NodeContainer *const *nodes,
+                                     struct NodeBlock *const *blocks);
+void InverseRefIndex_delete(InverseRefIndex *index);
+size_t InverseRefIndex_memoryUsage(const InverseRefIndex *index);
+const NL_InverseReference *InverseRefIndex_get(const InverseRefIndex *index,
+                                               const UA_NodeId *target,
+                                               size_t *size);
+
+#endif
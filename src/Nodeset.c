@@ -8,16 +8,29 @@
 #include "Nodeset.h"
 #include "AliasList.h"
 #include "NamespaceList.h"
+#include "NodeIdTable.h"
+#include "NodeIndex.h"
+#include "Progress.h"
+#include "RefTypeResolver.h"
 #include "Sort.h"
+#include "Validation.h"
+#include "Value.h"
 #include "nodes/DataTypeNode.h"
 #include "nodes/Node.h"
+#include "nodes/NodeBlock.h"
+#include "nodes/NodeColumns.h"
+#include "nodes/NodeLevels.h"
 #include "nodes/NodeContainer.h"
+#include "nodes/RefStore.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static UA_NodeId extractNodedId(const NamespaceList *namespaces, char *s);
-static UA_NodeId alias2Id(const Nodeset *nodeset, char *name);
+static UA_NodeId extractNodedId(const Nodeset *nodeset, const NL_Node *node,
+                                char *s);
+static UA_NodeId alias2Id(const Nodeset *nodeset, const NL_Node *node,
+                          char *name);
 static UA_NodeId translateNodeId(const NamespaceList *namespaces, UA_NodeId id);
 static NL_BrowseName translateBrowseName(const NamespaceList *namespaces,
                                          NL_BrowseName id);
@@ -110,17 +123,35 @@ NL_BrowseName translateBrowseName(const NamespaceList *namespaces,
     return bn;
 }
 
-UA_NodeId extractNodedId(const NamespaceList *namespaces, char *s)
+// NodeIds which can't be parsed or use an undefined namespace index are
+// recorded as findings of node, which may be NULL
+UA_NodeId extractNodedId(const Nodeset *nodeset, const NL_Node *node, char *s)
 {
     UA_NodeId id = UA_NODEID_NULL;
     if (s == NULL)
         return id;
 
-    UA_StatusCode res = UA_NodeId_parse(&id, UA_STRING(s));
-    if (res != UA_STATUSCODE_GOOD)
-        return id;
+    // every distinct text is parsed once, numeric ids are copied without
+    // allocation
+    size_t handle = NodeIdTable_intern(nodeset->nodeIds, s);
+    if (handle == NODEIDTABLE_INVALID ||
+        UA_NodeId_copy(NodeIdTable_get(nodeset->nodeIds, handle), &id) !=
+            UA_STATUSCODE_GOOD)
+    {
+        Validation_add(nodeset->validation, NL_CHECK_MALFORMED_NODEID,
+                       node ? &node->id : NULL, "malformed NodeId '%s'", s);
+        return UA_NODEID_NULL;
+    }
+    if (id.namespaceIndex != 0 &&
+        !NamespaceList_getNamespace(nodeset->namespaces, id.namespaceIndex))
+    {
+        Validation_add(nodeset->validation, NL_CHECK_MALFORMED_NODEID,
+                       node ? &node->id : NULL,
+                       "namespace index %u of NodeId '%s' is not defined",
+                       (unsigned)id.namespaceIndex, s);
+    }
 
-    return translateNodeId(namespaces, id);
+    return translateNodeId(nodeset->namespaces, id);
 }
 
 NL_BrowseName extractBrowseName(const NamespaceList *namespaces, char *s)
@@ -143,19 +174,93 @@ NL_BrowseName extractBrowseName(const NamespaceList *namespaces, char *s)
     return translateBrowseName(namespaces, bn);
 }
 
-static UA_NodeId alias2Id(const Nodeset *nodeset, char *name)
+static UA_NodeId alias2Id(const Nodeset *nodeset, const NL_Node *node,
+                          char *name)
 {
     const UA_NodeId *alias = AliasList_getNodeId(nodeset->aliasList, name);
-    if (!alias)
+    if (alias)
     {
-        return extractNodedId(nodeset->namespaces, name);
+        return *alias;
     }
-    return *alias;
+    // every NodeId contains a '=', anything else is meant to be an alias
+    if (name && !strchr(name, '='))
+    {
+        Validation_add(nodeset->validation, NL_CHECK_ALIAS,
+                       node ? &node->id : NULL, "alias '%s' is not defined",
+                       name);
+        return UA_NODEID_NULL;
+    }
+    return extractNodedId(nodeset, node, name);
+}
+
+static void checkBrowseName(const Nodeset *nodeset, const NL_Node *node,
+                            const char *s)
+{
+    if (!s)
+    {
+        Validation_add(nodeset->validation, NL_CHECK_MALFORMED_BROWSENAME,
+                       &node->id, "node without BrowseName");
+        return;
+    }
+    const char *name = strchr(s, ':');
+    if (!name)
+    {
+        name = s;
+    }
+    else
+    {
+        bool validIndex = name != s;
+        for (const char *c = s; c != name; c++)
+        {
+            validIndex = validIndex && *c >= '0' && *c <= '9';
+        }
+        if (!validIndex)
+        {
+            Validation_add(nodeset->validation,
+                           NL_CHECK_MALFORMED_BROWSENAME, &node->id,
+                           "BrowseName '%s' has no valid namespace index", s);
+        }
+        else if (atoi(s) > 0 &&
+                 !NamespaceList_getNamespace(nodeset->namespaces, atoi(s)))
+        {
+            Validation_add(nodeset->validation,
+                           NL_CHECK_MALFORMED_BROWSENAME, &node->id,
+                           "namespace index of BrowseName '%s' is not defined",
+                           s);
+        }
+        name++;
+    }
+    if (!*name)
+    {
+        Validation_add(nodeset->validation, NL_CHECK_MALFORMED_BROWSENAME,
+                       &node->id, "BrowseName '%s' has an empty name", s);
+    }
+}
+
+// the arena regions are allocated with malloc, rounding up all sizes keeps
+// every allocation aligned
+#define EXTENSION_ALIGNMENT 16
+
+static void *allocExtension(void *context, size_t size)
+{
+    Nodeset *nodeset = (Nodeset *)context;
+    if (!nodeset->extensionArena)
+    {
+        nodeset->extensionArena = CharArenaAllocator_new(64 * 1024);
+        if (!nodeset->extensionArena)
+        {
+            return NULL;
+        }
+    }
+    size = (size + EXTENSION_ALIGNMENT - 1) & ~(size_t)(EXTENSION_ALIGNMENT - 1);
+    return CharArenaAllocator_malloc(nodeset->extensionArena,
+                                     size ? size : EXTENSION_ALIGNMENT);
 }
 
 Nodeset *Nodeset_new(NL_addNamespaceCallback nsCallback,
                      NodesetLoader_Logger *logger,
-                     NL_ReferenceService *refService)
+                     NL_ReferenceService *refService,
+                     CharArenaAllocator *charArena)
 {
     Nodeset *nodeset = (Nodeset *)calloc(1, sizeof(Nodeset));
     if (!nodeset)
@@ -164,120 +269,482 @@ Nodeset *Nodeset_new(NL_addNamespaceCallback nsCallback,
     }
     nodeset->aliasList = AliasList_new();
     nodeset->namespaces = NamespaceList_new(nsCallback);
-    nodeset->charArena = CharArenaAllocator_new(1024 * 1024);
-    nodeset->nodes[NODECLASS_OBJECT] = NodeContainer_new(10000, true);
-    nodeset->nodes[NODECLASS_VARIABLE] = NodeContainer_new(10000, true);
-    nodeset->nodes[NODECLASS_METHOD] = NodeContainer_new(1000, true);
-    nodeset->nodes[NODECLASS_OBJECTTYPE] = NodeContainer_new(100, true);
-    nodeset->nodes[NODECLASS_DATATYPE] = NodeContainer_new(100, true);
-    nodeset->nodes[NODECLASS_REFERENCETYPE] = NodeContainer_new(100, true);
-    nodeset->nodes[NODECLASS_VARIABLETYPE] = NodeContainer_new(100, true);
-    nodeset->nodes[NODECLASS_VIEW] = NodeContainer_new(10, true);
+    nodeset->nodeIds = NodeIdTable_new(10000);
+    nodeset->charArena = charArena;
+    if (!nodeset->charArena)
+    {
+        nodeset->charArena = CharArenaAllocator_new(1024 * 1024);
+        nodeset->ownsCharArena = true;
+    }
+    nodeset->extensionAllocator.context = nodeset;
+    nodeset->extensionAllocator.alloc = allocExtension;
+    // the nodes are owned by the index, the containers are filled by the sort,
+    // which doesn't happen if the import is aborted
+    nodeset->nodes[NODECLASS_OBJECT] = NodeContainer_new(10000, false);
+    nodeset->nodes[NODECLASS_VARIABLE] = NodeContainer_new(10000, false);
+    nodeset->nodes[NODECLASS_METHOD] = NodeContainer_new(1000, false);
+    nodeset->nodes[NODECLASS_OBJECTTYPE] = NodeContainer_new(100, false);
+    nodeset->nodes[NODECLASS_DATATYPE] = NodeContainer_new(100, false);
+    nodeset->nodes[NODECLASS_REFERENCETYPE] = NodeContainer_new(100, false);
+    nodeset->nodes[NODECLASS_VARIABLETYPE] = NodeContainer_new(100, false);
+    nodeset->nodes[NODECLASS_VIEW] = NodeContainer_new(10, false);
     nodeset->nodesWithUnknownRefs = NodeContainer_new(100, false);
     nodeset->refTypesWithUnknownRefs = NodeContainer_new(100, false);
     nodeset->refService = refService;
     nodeset->sortCtx = Sort_init();
+    nodeset->index = NodeIndex_new(10000);
+    nodeset->levels = NodeLevels_new();
+    nodeset->validation = Validation_new();
     nodeset->logger = logger;
     return nodeset;
 }
 
-static void Nodeset_addNode(Nodeset *nodeset, NL_Node *node)
-{
-    NodeContainer_add(nodeset->nodes[node->nodeClass], node);
-}
-
-static void insertElementAtFront(NL_Reference **toList, NL_Reference *elem)
+static bool Nodeset_addNode(Nodeset *nodeset, NL_Node *node, size_t level)
 {
-    elem->next = *toList;
-    *toList = elem;
+    NodeContainer *c = nodeset->nodes[node->nodeClass];
+    NodeLevels_add(nodeset->levels, node->nodeClass, c->size, level);
+    NodeContainer_add(c, node);
+    if (!nodeset->progress)
+    {
+        return true;
+    }
+    nodeset->progress->state.nodesSorted++;
+    return Progress_update(nodeset->progress);
 }
 
-static bool lookupUnknownReferences(Nodeset *nodeset, NL_Node *node)
+// the reference types which weren't known when a node was parsed are resolved
+// once, the nodes with references which are left stay unresolved
+static void lookupReferenceTypes(Nodeset *nodeset)
 {
-    while (node->unknownRefs)
+    if (nodeset->refTypesResolved)
     {
-        NL_Reference *nextUnknown = node->unknownRefs->next;
-        if (nodeset->refService->isHierachicalRef(nodeset->refService->context,
-                                                  node->unknownRefs))
+        return;
+    }
+    nodeset->refTypesResolved = true;
+    if (!RefTypeResolver_resolve(nodeset->refService,
+                                 nodeset->refTypesWithUnknownRefs,
+                                 nodeset->nodesWithUnknownRefs))
+    {
+        // out of memory, at least the types which are known by now
+        for (size_t i = 0; i < nodeset->nodesWithUnknownRefs->size; i++)
         {
-            insertElementAtFront(&node->hierachicalRefs, node->unknownRefs);
-            node->unknownRefs = nextUnknown;
-            continue;
+            RefTypeResolver_classify(nodeset->refService,
+                                     nodeset->nodesWithUnknownRefs->nodes[i]);
         }
-        if (nodeset->refService->isNonHierachicalRef(
-                nodeset->refService->context, node->unknownRefs))
+    }
+
+    for (size_t i = 0; i < nodeset->refTypesWithUnknownRefs->size; i++)
+    {
+        if (!Sort_addNode(nodeset->sortCtx,
+                          nodeset->refTypesWithUnknownRefs->nodes[i]))
         {
-            insertElementAtFront(&node->nonHierachicalRefs, node->unknownRefs);
-            node->unknownRefs = nextUnknown;
-            continue;
+            nodeset->sortIncomplete = true;
         }
-        return false;
     }
-    return true;
 }
 
-static void lookupReferenceTypes(Nodeset *nodeset)
+static void removeReferencesTo(NL_Reference **refs, const NodeIdSet *ids)
 {
-    bool allRefTypesKnown = false;
-    while (!allRefTypesKnown)
+    while (*refs)
     {
-        allRefTypesKnown = true;
-        for (size_t i = 0; i < nodeset->refTypesWithUnknownRefs->size; i++)
+        NL_Reference *ref = *refs;
+        if (!NodeIdSet_contains(ids, &ref->target) &&
+            !NodeIdSet_contains(ids, &ref->refType))
         {
-            allRefTypesKnown = lookupUnknownReferences(
-                nodeset, nodeset->refTypesWithUnknownRefs->nodes[i]);
+            refs = &ref->next;
+            continue;
         }
+        *refs = ref->next;
+        UA_NodeId_clear(&ref->target);
+        UA_NodeId_clear(&ref->refType);
+        free(ref);
     }
+}
 
-    for (size_t i = 0; i < nodeset->refTypesWithUnknownRefs->size; i++)
+static void removeTypeDefinitionTo(NL_Reference **ref, const NodeIdSet *ids)
+{
+    if (*ref && NodeIdSet_contains(ids, &(*ref)->target))
+    {
+        UA_NodeId_clear(&(*ref)->target);
+        UA_NodeId_clear(&(*ref)->refType);
+        free(*ref);
+        *ref = NULL;
+    }
+}
+
+static void removeFilteredRefs(void *context, NL_Node *node)
+{
+    const NodeIdSet *filtered = (const NodeIdSet *)context;
+    removeReferencesTo(&node->hierachicalRefs, filtered);
+    removeReferencesTo(&node->nonHierachicalRefs, filtered);
+    removeReferencesTo(&node->unknownRefs, filtered);
+    if (node->nodeClass == NODECLASS_OBJECT)
+    {
+        removeTypeDefinitionTo(&((NL_ObjectNode *)node)->refToTypeDef,
+                               filtered);
+    }
+    if (node->nodeClass == NODECLASS_VARIABLE)
+    {
+        removeTypeDefinitionTo(&((NL_VariableNode *)node)->refToTypeDef,
+                               filtered);
+    }
+    if (NodesetLoader_isInstanceNode(node) &&
+        NodeIdSet_contains(filtered, &((NL_InstanceNode *)node)->parentNodeId))
+    {
+        UA_NodeId_clear(&((NL_InstanceNode *)node)->parentNodeId);
+    }
+}
+
+// the nodes skipped by an import filter are treated as if they had never been
+// referenced, this includes references of a skipped reference type
+static void removeFilteredReferences(Nodeset *nodeset)
+{
+    size_t filtered = NodeIdSet_size(nodeset->filtered);
+    // the references of compacted nodes are owned by their block
+    if (filtered == nodeset->filteredRemoved || nodeset->compacted)
+    {
+        return;
+    }
+    NodeIndex_forEachWithContext(nodeset->index, nodeset->filtered,
+                                 removeFilteredRefs);
+    nodeset->filteredRemoved = filtered;
+}
+
+static void reportUnknownReferences(Nodeset *nodeset, const NL_Node *node)
+{
+    char refType[128];
+    for (const NL_Reference *ref = node->unknownRefs; ref; ref = ref->next)
     {
-        Sort_addNode(nodeset->sortCtx,
-                     nodeset->refTypesWithUnknownRefs->nodes[i]);
+        Validation_printNodeId(&ref->refType, refType, sizeof(refType));
+        Validation_add(nodeset->validation, NL_CHECK_UNKNOWN_REFERENCETYPE,
+                       &node->id,
+                       "reference type %s is neither known as hierarchical "
+                       "nor as non hierarchical",
+                       refType);
     }
 }
 
-bool Nodeset_sort(Nodeset *nodeset)
+static void reportCycle(void *context, NL_Node *node)
 {
+    Validation_add(((Nodeset *)context)->validation,
+                   NL_CHECK_REFERENCE_CYCLE, &node->id,
+                   "node is part of or depends on a cycle of hierarchical "
+                   "references");
+}
+
+// With report set, unresolved references and cycles are recorded as findings
+// and the sort goes on, otherwise it stops at the first unresolved reference.
+static bool sortNodes(Nodeset *nodeset, bool report)
+{
+    // e.g. by Nodeset_validate before
+    if (nodeset->compacted || nodeset->sorted)
+    {
+        return true;
+    }
+    removeFilteredReferences(nodeset);
     // first we have to figure out, if there are reference types, for which we
     // cannot state if they are hierachical or nonhierachical
     lookupReferenceTypes(nodeset);
+    bool resolved = true;
+    if (report)
+    {
+        for (size_t i = 0; i < nodeset->refTypesWithUnknownRefs->size; i++)
+        {
+            reportUnknownReferences(nodeset,
+                                    nodeset->refTypesWithUnknownRefs->nodes[i]);
+        }
+    }
     // all hierachical references of a node should be known at this point
     // if there are nodes with unknown references, the import will be aborted
     for (size_t i = 0; i < nodeset->nodesWithUnknownRefs->size; i++)
     {
-        bool result = lookupUnknownReferences(
-            nodeset, nodeset->nodesWithUnknownRefs->nodes[i]);
-        if (!result)
-        {
-            UA_String nodeIdStr = {0};
-            UA_NodeId_print(&nodeset->nodesWithUnknownRefs->nodes[i]->id,
-                            &nodeIdStr);
-            nodeset->logger->log(
-                nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
-                "node with unresolved reference(s): NodeId(%.*s)",
-                (int)nodeIdStr.length, (char *)nodeIdStr.data);
-            UA_String_clear(&nodeIdStr);
+        NL_Node *node = nodeset->nodesWithUnknownRefs->nodes[i];
+        if (node->unknownRefs)
+        {
+            resolved = false;
+            if (report)
+            {
+                reportUnknownReferences(nodeset, node);
+            }
+            else
+            {
+                UA_String nodeIdStr = {0};
+                UA_NodeId_print(&node->id, &nodeIdStr);
+                nodeset->logger->log(
+                    nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                    "node with unresolved reference(s): NodeId(%.*s)",
+                    (int)nodeIdStr.length, (char *)nodeIdStr.data);
+                UA_String_clear(&nodeIdStr);
+                continue;
+            }
+        }
+        if (!Sort_addNode(nodeset->sortCtx, node))
+        {
+            nodeset->sortIncomplete = true;
+        }
+    }
+    if (!resolved && !report)
+    {
+        return false;
+    }
+    if (nodeset->sortIncomplete)
+    {
+        nodeset->logger->log(nodeset->logger->context,
+                             NODESETLOADER_LOGLEVEL_ERROR,
+                             "NodesetLoader: out of memory, not all nodes "
+                             "were added to the sort");
+        return false;
+    }
+
+    if (nodeset->progress)
+    {
+        Progress_startStage(nodeset->progress, NL_PROGRESS_SORT);
+        nodeset->progress->state.nodesToSort = NodeIndex_size(nodeset->index);
+    }
+    bool sorted = Sort_start(nodeset->sortCtx, nodeset, Nodeset_addNode,
+                             nodeset->logger);
+    if (nodeset->progress)
+    {
+        if (sorted)
+        {
+            Progress_report(nodeset->progress);
+        }
+        if (nodeset->progress->cancelled)
+        {
+            nodeset->logger->log(nodeset->logger->context,
+                                 NODESETLOADER_LOGLEVEL_WARNING,
+                                 "NodesetLoader: import cancelled");
             return false;
         }
-        Sort_addNode(nodeset->sortCtx, nodeset->nodesWithUnknownRefs->nodes[i]);
+    }
+    if (!sorted && report)
+    {
+        Sort_forEachUnsorted(nodeset->sortCtx, nodeset, reportCycle);
+    }
+    nodeset->sorted = sorted && resolved;
+    return nodeset->sorted;
+}
+
+bool Nodeset_sort(Nodeset *nodeset) { return sortNodes(nodeset, false); }
+
+// the lists of compact references are built for the nodes of a node class
+// which are handed out
+static bool buildReferenceLists(const Nodeset *nodeset, NL_NodeClass nodeClass)
+{
+    if (!nodeset->refStore ||
+        NodeBlock_buildReferenceLists(nodeset->blocks[nodeClass]))
+    {
+        return true;
+    }
+    if (nodeset->logger)
+    {
+        nodeset->logger->log(nodeset->logger->context,
+                             NODESETLOADER_LOGLEVEL_ERROR,
+                             "out of memory building the reference lists");
+    }
+    return false;
+}
+
+size_t Nodeset_validate(Nodeset *nodeset, void *context,
+                        NodesetLoader_Finding_Func fn)
+{
+    if (!nodeset->validated)
+    {
+        // the checks read the reference lists
+        for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+        {
+            buildReferenceLists(nodeset, (NL_NodeClass)cnt);
+        }
+        removeFilteredReferences(nodeset);
+        Validation_checkNodes(nodeset->validation, nodeset->index);
+        if (!nodeset->sorted)
+        {
+            sortNodes(nodeset, true);
+        }
+        nodeset->validated = true;
+    }
+    return Validation_forEach(nodeset->validation, context, fn);
+}
+
+bool Nodeset_compact(Nodeset *nodeset, bool compactReferences)
+{
+    if (nodeset->compacted)
+    {
+        return true;
+    }
+    size_t nodesSize = 0;
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        nodesSize += nodeset->nodes[cnt]->size;
+    }
+    // all nodes of the index have to be part of a container, the others
+    // would be lost
+    if (!nodeset->sorted || nodesSize != NodeIndex_size(nodeset->index))
+    {
+        if (nodeset->logger)
+        {
+            nodeset->logger->log(nodeset->logger->context,
+                                 NODESETLOADER_LOGLEVEL_ERROR,
+                                 "nodeset has to be sorted before compaction");
+        }
+        return false;
+    }
+
+    // allocate everything up front, so the nodeset is left untouched if this
+    // fails
+    size_t stringSize = 0;
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        stringSize +=
+            NodeBlock_stringSize(nodeset->nodes[cnt], nodeset->charArena);
+    }
+    CharArenaAllocator *strings = CharArenaAllocator_new(stringSize);
+    NodeIndex *index = NodeIndex_new(nodesSize);
+    NodeBlock *blocks[NL_NODECLASS_COUNT] = {NULL};
+    RefStore *refStore = NULL;
+    bool allocated = strings && index;
+    if (allocated && compactReferences)
+    {
+        // the references to filtered nodes can't be removed from the blocks
+        removeFilteredReferences(nodeset);
+        refStore = RefStore_new(nodesSize);
+        allocated = refStore != NULL;
+    }
+    for (size_t cnt = 0; allocated && cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        blocks[cnt] =
+            NodeBlock_new(nodeset->nodes[cnt], (NL_NodeClass)cnt, refStore);
+        allocated = blocks[cnt] != NULL;
+    }
+    if (!allocated)
+    {
+        for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+        {
+            NodeBlock_delete(blocks[cnt]);
+        }
+        RefStore_delete(refStore);
+        NodeIndex_delete(index);
+        if (strings)
+        {
+            CharArenaAllocator_delete(strings);
+        }
+        return false;
+    }
+
+    // parse and sort only
+    Sort_cleanup(nodeset->sortCtx);
+    nodeset->sortCtx = NULL;
+    NodeContainer_delete(nodeset->nodesWithUnknownRefs);
+    nodeset->nodesWithUnknownRefs = NULL;
+    NodeContainer_delete(nodeset->refTypesWithUnknownRefs);
+    nodeset->refTypesWithUnknownRefs = NULL;
+    AliasList_delete(nodeset->aliasList);
+    nodeset->aliasList = NULL;
+    NamespaceList_delete(nodeset->namespaces);
+    nodeset->namespaces = NULL;
+    NodeIdTable_delete(nodeset->nodeIds);
+    nodeset->nodeIds = NULL;
+    // these point to the old nodes, they are rebuilt on demand
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        NodeColumns_delete(nodeset->columns[cnt]);
+        nodeset->columns[cnt] = NULL;
+    }
+    InverseRefIndex_delete(nodeset->inverseRefs);
+    nodeset->inverseRefs = NULL;
+    NodeLevels_invalidate(nodeset->levels);
+
+    nodeset->allocated[NL_MEMORY_VALUES] = 0;
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        NodeContainer *c = nodeset->nodes[cnt];
+        NodeBlock_move(blocks[cnt], c, nodeset->charArena, strings);
+        nodeset->blocks[cnt] = blocks[cnt];
+        for (size_t i = 0; i < c->size; i++)
+        {
+            NodeIndex_add(index, c->nodes[i]);
+            if (c->nodes[i]->nodeClass == NODECLASS_VARIABLE &&
+                ((NL_VariableNode *)c->nodes[i])->value)
+            {
+                nodeset->allocated[NL_MEMORY_VALUES] += Value_memoryUsage(
+                    ((NL_VariableNode *)c->nodes[i])->value);
+            }
+        }
+    }
+    NodeIndex_delete(nodeset->index);
+    nodeset->index = index;
+    if (refStore)
+    {
+        // the compact references are counted by Nodeset_getMemoryUsage
+        nodeset->refStore = refStore;
+        nodeset->allocated[NL_MEMORY_REFERENCES] = 0;
+        for (const NL_BiDirectionalReference *ref = nodeset->hasEncodingRefs;
+             ref; ref = ref->next)
+        {
+            nodeset->allocated[NL_MEMORY_REFERENCES] +=
+                sizeof(NL_BiDirectionalReference);
+        }
     }
 
-    return Sort_start(nodeset->sortCtx, nodeset, Nodeset_addNode,
-                      nodeset->logger);
+    // a shared arena is handed back to its owner for the next loader
+    if (nodeset->ownsCharArena)
+    {
+        CharArenaAllocator_delete(nodeset->charArena);
+    }
+    else
+    {
+        CharArenaAllocator_reset(nodeset->charArena);
+    }
+    nodeset->charArena = strings;
+    nodeset->ownsCharArena = true;
+    nodeset->compacted = true;
+    return true;
 }
 
 void Nodeset_cleanup(Nodeset *nodeset)
 {
-    CharArenaAllocator_delete(nodeset->charArena);
+    if (nodeset->ownsCharArena)
+    {
+        CharArenaAllocator_delete(nodeset->charArena);
+    }
+    else
+    {
+        CharArenaAllocator_reset(nodeset->charArena);
+    }
+    if (nodeset->extensionArena)
+    {
+        CharArenaAllocator_delete(nodeset->extensionArena);
+    }
     AliasList_delete(nodeset->aliasList);
+    NodeIdTable_delete(nodeset->nodeIds);
     for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
     {
         NodeContainer_delete(nodeset->nodes[cnt]);
+        NodeColumns_delete(nodeset->columns[cnt]);
     }
     NodeContainer_delete(nodeset->nodesWithUnknownRefs);
     NodeContainer_delete(nodeset->refTypesWithUnknownRefs);
     NamespaceList_delete(nodeset->namespaces);
     Sort_cleanup(nodeset->sortCtx);
+    if (nodeset->compacted)
+    {
+        for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+        {
+            NodeBlock_delete(nodeset->blocks[cnt]);
+        }
+        RefStore_delete(nodeset->refStore);
+    }
+    else
+    {
+        NodeIndex_forEach(nodeset->index, Node_delete);
+    }
+    NodeIndex_delete(nodeset->index);
+    InverseRefIndex_delete(nodeset->inverseRefs);
+    NodeLevels_delete(nodeset->levels);
+    Validation_delete(nodeset->validation);
+    NodeIdSet_delete(nodeset->filtered);
+    NodeIdSet_delete(nodeset->subtree);
+    UA_NodeId_clear(&nodeset->subtreeRoot);
     NL_BiDirectionalReference *ref = nodeset->hasEncodingRefs;
     while (ref)
     {
@@ -305,6 +772,7 @@ static char *getAttributeValue(Nodeset *nodeset, const NodeAttribute *attr,
         size_t size = (size_t)(value_end - value_start);
         char *value = CharArenaAllocator_malloc(nodeset->charArena, size + 1);
         memcpy(value, value_start, size);
+        value[size] = '\0';
         return value;
     }
     // we return the defaultValue, if NULL or not, following code has to cope
@@ -312,16 +780,160 @@ static char *getAttributeValue(Nodeset *nodeset, const NodeAttribute *attr,
     return attr->defaultValue;
 }
 
+// the value of an attribute without copying it, NULL if it is missing
+static const char *findAttribute(const NodeAttribute *attr,
+                                 const char **attributes, int nb_attributes,
+                                 size_t *length)
+{
+    const int fields = 5;
+    for (int i = 0; i < nb_attributes; i++)
+    {
+        if (strcmp(attributes[i * fields + 0], attr->name))
+            continue;
+        *length = (size_t)(attributes[i * fields + 4] -
+                           attributes[i * fields + 3]);
+        return attributes[i * fields + 3];
+    }
+    return NULL;
+}
+
+// the NodeId with the namespace index of the file, null if it is missing or
+// malformed
+static UA_NodeId parseAttributeNodeId(const NodeAttribute *attr,
+                                      const char **attributes,
+                                      int nb_attributes)
+{
+    UA_NodeId id = UA_NODEID_NULL;
+    UA_String value = {0, NULL};
+    value.data = (UA_Byte *)(uintptr_t)findAttribute(
+        attr, attributes, nb_attributes, &value.length);
+    if (value.data && UA_NodeId_parse(&id, value) != UA_STATUSCODE_GOOD)
+    {
+        id = UA_NODEID_NULL;
+    }
+    return id;
+}
+
+static bool isInstanceClass(NL_NodeClass nodeClass)
+{
+    return nodeClass == NODECLASS_OBJECT || nodeClass == NODECLASS_VARIABLE ||
+           nodeClass == NODECLASS_METHOD || nodeClass == NODECLASS_VIEW;
+}
+
+static bool passesFilter(const Nodeset *nodeset, const NL_ImportFilter *filter,
+                         void *userContext, NL_NodeClass nodeClass,
+                         const UA_NodeId *localId, const UA_NodeId *id)
+{
+    if (filter->nodeClasses &&
+        !(filter->nodeClasses & NL_NODECLASS_MASK(nodeClass)))
+    {
+        return false;
+    }
+    if (filter->namespaceUris)
+    {
+        const Namespace *ns = NamespaceList_getNamespace(
+            nodeset->namespaces, localId->namespaceIndex);
+        bool found = false;
+        for (size_t i = 0; ns && ns->name && !found &&
+                           i < filter->namespaceUrisSize;
+             i++)
+        {
+            found = !strcmp(filter->namespaceUris[i], ns->name);
+        }
+        if (!found)
+        {
+            return false;
+        }
+    }
+    if (id->identifierType == UA_NODEIDTYPE_NUMERIC &&
+        (id->identifier.numeric < filter->numericMin ||
+         (filter->numericMax && id->identifier.numeric > filter->numericMax)))
+    {
+        return false;
+    }
+    return !filter->accept || filter->accept(userContext, nodeClass, id);
+}
+
+// the instances of the subtree are the root and the instances whose parent was
+// accepted as part of the subtree before
+static bool inSubtree(Nodeset *nodeset, const UA_NodeId *root,
+                      const UA_NodeId *id, const UA_NodeId *parent)
+{
+    if (!nodeset->subtree || !UA_NodeId_equal(&nodeset->subtreeRoot, root))
+    {
+        NodeIdSet_delete(nodeset->subtree);
+        UA_NodeId_clear(&nodeset->subtreeRoot);
+        nodeset->subtree = NodeIdSet_new(1024);
+        if (!nodeset->subtree ||
+            UA_NodeId_copy(root, &nodeset->subtreeRoot) != UA_STATUSCODE_GOOD)
+        {
+            return false;
+        }
+        NodeIdSet_add(nodeset->subtree, root);
+    }
+    return UA_NodeId_equal(id, root) ||
+           NodeIdSet_contains(nodeset->subtree, parent);
+}
+
+bool Nodeset_acceptNode(Nodeset *nodeset, const NL_ImportFilter *filter,
+                        void *userContext, NL_NodeClass nodeClass,
+                        int attributeSize, const char **attributes)
+{
+    if (!filter)
+    {
+        return true;
+    }
+    UA_NodeId localId =
+        parseAttributeNodeId(&attrNodeId, attributes, attributeSize);
+    // shares the identifier with localId
+    UA_NodeId id = translateNodeId(nodeset->namespaces, localId);
+    bool accept =
+        passesFilter(nodeset, filter, userContext, nodeClass, &localId, &id);
+    if (accept && isInstanceClass(nodeClass))
+    {
+        UA_NodeId parent = translateNodeId(
+            nodeset->namespaces,
+            parseAttributeNodeId(&attrParentNodeId, attributes, attributeSize));
+        accept = !NodeIdSet_contains(nodeset->filtered, &parent);
+        if (accept && filter->subtreeRoot)
+        {
+            accept = inSubtree(nodeset, filter->subtreeRoot, &id, &parent);
+            if (accept)
+            {
+                NodeIdSet_add(nodeset->subtree, &id);
+            }
+        }
+        UA_NodeId_clear(&parent);
+    }
+    if (!accept)
+    {
+        if (!nodeset->filtered)
+        {
+            nodeset->filtered = NodeIdSet_new(1024);
+        }
+        NodeIdSet_add(nodeset->filtered, &id);
+    }
+    UA_NodeId_clear(&localId);
+    return accept;
+}
+
 static void extractAttributes(Nodeset *nodeset, const NamespaceList *namespaces,
                               NL_Node *node, int attributeSize,
                               const char **attributes)
 {
-    node->id = extractNodedId(
-        namespaces,
-        getAttributeValue(nodeset, &attrNodeId, attributes, attributeSize));
-    node->browseName = extractBrowseName(
-        namespaces,
-        getAttributeValue(nodeset, &attrBrowseName, attributes, attributeSize));
+    char *nodeId =
+        getAttributeValue(nodeset, &attrNodeId, attributes, attributeSize);
+    if (!nodeId)
+    {
+        Validation_add(nodeset->validation, NL_CHECK_MALFORMED_NODEID, NULL,
+                       "%s node without NodeId",
+                       NL_NODECLASS_NAME[node->nodeClass]);
+    }
+    node->id = extractNodedId(nodeset, NULL, nodeId);
+    char *browseName =
+        getAttributeValue(nodeset, &attrBrowseName, attributes, attributeSize);
+    checkBrowseName(nodeset, node, browseName);
+    node->browseName = extractBrowseName(namespaces, browseName);
     switch (node->nodeClass)
     {
     case NODECLASS_OBJECTTYPE: {
@@ -331,7 +943,7 @@ static void extractAttributes(Nodeset *nodeset, const NamespaceList *namespaces,
     }
     case NODECLASS_OBJECT: {
         ((NL_ObjectNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
+            nodeset, node, getAttributeValue(nodeset, &attrParentNodeId,
                                           attributes, attributeSize));
         ((NL_ObjectNode *)node)->eventNotifier = getAttributeValue(
             nodeset, &attrEventNotifier, attributes, attributeSize);
@@ -340,11 +952,12 @@ static void extractAttributes(Nodeset *nodeset, const NamespaceList *namespaces,
     case NODECLASS_VARIABLE: {
 
         ((NL_VariableNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
+            nodeset, node, getAttributeValue(nodeset, &attrParentNodeId,
                                           attributes, attributeSize));
         char *datatype = getAttributeValue(nodeset, &attrDataType, attributes,
                                            attributeSize);
-        ((NL_VariableNode *)node)->datatype = alias2Id(nodeset, datatype);
+        ((NL_VariableNode *)node)->datatype =
+            alias2Id(nodeset, node, datatype);
         ((NL_VariableNode *)node)->valueRank = getAttributeValue(
             nodeset, &attrValueRank, attributes, attributeSize);
         ((NL_VariableNode *)node)->minimumSamplingInterval = getAttributeValue(
@@ -365,7 +978,8 @@ static void extractAttributes(Nodeset *nodeset, const NamespaceList *namespaces,
             nodeset, &attrValueRank, attributes, attributeSize);
         char *datatype = getAttributeValue(nodeset, &attrDataType, attributes,
                                            attributeSize);
-        ((NL_VariableTypeNode *)node)->datatype = alias2Id(nodeset, datatype);
+        ((NL_VariableTypeNode *)node)->datatype =
+            alias2Id(nodeset, node, datatype);
         ((NL_VariableTypeNode *)node)->arrayDimensions = getAttributeValue(
             nodeset, &attrArrayDimensions, attributes, attributeSize);
         ((NL_VariableTypeNode *)node)->isAbstract = getAttributeValue(
@@ -378,7 +992,7 @@ static void extractAttributes(Nodeset *nodeset, const NamespaceList *namespaces,
         break;
     case NODECLASS_METHOD:
         ((NL_MethodNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
+            nodeset, node, getAttributeValue(nodeset, &attrParentNodeId,
                                           attributes, attributeSize));
         ((NL_MethodNode *)node)->executable = getAttributeValue(
             nodeset, &attrExecutable, attributes, attributeSize);
@@ -391,7 +1005,7 @@ static void extractAttributes(Nodeset *nodeset, const NamespaceList *namespaces,
         break;
     case NODECLASS_VIEW:
         ((NL_ViewNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
+            nodeset, node, getAttributeValue(nodeset, &attrParentNodeId,
                                           attributes, attributeSize));
         ((NL_ViewNode *)node)->containsNoLoops = getAttributeValue(
             nodeset, &attrContainsNoLoops, attributes, attributeSize);
@@ -414,6 +1028,7 @@ NL_Node *Nodeset_newNode(Nodeset *nodeset, NL_NodeClass nodeClass,
                          int nb_attributes, const char **attributes)
 {
     NL_Node *node = Node_new(nodeClass);
+    nodeset->allocated[NL_MEMORY_NODES] += Node_size(nodeClass);
     initNode(nodeset, nodeset->namespaces, nodeClass, node, nb_attributes,
              attributes);
     return node;
@@ -423,6 +1038,7 @@ NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
                                    int attributeSize, const char **attributes)
 {
     NL_Reference *newRef = (NL_Reference *)calloc(1, sizeof(NL_Reference));
+    nodeset->allocated[NL_MEMORY_REFERENCES] += sizeof(NL_Reference);
     if (!strcmp("true", getAttributeValue(nodeset, &attrIsForward, attributes,
                                           attributeSize)))
     {
@@ -435,7 +1051,7 @@ NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
     char *aliasIdString = getAttributeValue(nodeset, &attrReferenceType,
                                             attributes, attributeSize);
 
-    newRef->refType = alias2Id(nodeset, aliasIdString);
+    newRef->refType = alias2Id(nodeset, node, aliasIdString);
 
     if (NODECLASS_VARIABLE == node->nodeClass &&
         nodeset->refService->isHasTypeDefRef(nodeset->refService->context,
@@ -476,14 +1092,40 @@ NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
 Alias *Nodeset_newAlias(Nodeset *nodeset, int attributeSize,
                         const char **attributes)
 {
-    return AliasList_newAlias(
-        nodeset->aliasList,
-        getAttributeValue(nodeset, &attrAlias, attributes, attributeSize));
+    char *name =
+        getAttributeValue(nodeset, &attrAlias, attributes, attributeSize);
+    if (!name)
+    {
+        Validation_add(nodeset->validation, NL_CHECK_ALIAS, NULL,
+                       "alias without name");
+        return NULL;
+    }
+    if (AliasList_isDefinedInFile(nodeset->aliasList, name))
+    {
+        Validation_add(nodeset->validation, NL_CHECK_ALIAS, NULL,
+                       "alias '%s' is defined more than once", name);
+    }
+    Alias *alias = AliasList_newAlias(nodeset->aliasList, name);
+    if (!alias)
+    {
+        Validation_add(nodeset->validation, NL_CHECK_ALIAS, NULL,
+                       "too many aliases, '%s' is ignored", name);
+    }
+    return alias;
 }
 
 void Nodeset_newAliasFinish(Nodeset *nodeset, Alias *alias, char *idString)
 {
-    alias->id = extractNodedId(nodeset->namespaces, idString);
+    if (!alias)
+    {
+        return;
+    }
+    alias->id = extractNodedId(nodeset, NULL, idString);
+}
+
+void Nodeset_startFile(Nodeset *nodeset)
+{
+    AliasList_startFile(nodeset->aliasList);
 }
 
 void Nodeset_newNamespaceFinish(Nodeset *nodeset, void *userContext,
@@ -492,21 +1134,46 @@ void Nodeset_newNamespaceFinish(Nodeset *nodeset, void *userContext,
     NamespaceList_newNamespace(nodeset->namespaces, userContext, namespaceUri);
 }
 
+static void reportDuplicate(Nodeset *nodeset, const NL_Node *node)
+{
+    // a node without id has been reported already
+    if (UA_NodeId_isNull(&node->id))
+    {
+        return;
+    }
+    char id[128];
+    Validation_printNodeId(&node->id, id, sizeof(id));
+    Validation_add(nodeset->validation, NL_CHECK_DUPLICATE_NODEID, &node->id,
+                   "NodeId %s is defined more than once", id);
+}
+
 void Nodeset_newNodeFinish(Nodeset *nodeset, NL_Node *node)
 {
-    if (!node->unknownRefs)
+    if (!node->unknownRefs &&
+        (node->nodeClass != NODECLASS_REFERENCETYPE ||
+         !RefTypeResolver_awaitsSupertype(nodeset->refService, node)))
     {
-        if(!Sort_addNode(nodeset->sortCtx, node))
+        // the index knows all nodes, the sort only those without unknown
+        // references
+        if (NodeIndex_get(nodeset->index, &node->id))
         {
             if (nodeset->logger)
             {
                 nodeset->logger->log(nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
                             "node was not added to sorting algorithm, already exists");
             }
+            reportDuplicate(nodeset, node);
+            Node_delete(node);
+        }
+        else if (!Sort_addNode(nodeset->sortCtx, node))
+        {
+            // out of memory, the sort fails and reports it
+            nodeset->sortIncomplete = true;
             Node_delete(node);
         }
         else
         {
+            NodeIndex_add(nodeset->index, node);
             if (node->nodeClass == NODECLASS_REFERENCETYPE)
             {
                 nodeset->refService->addNewReferenceType(
@@ -516,6 +1183,17 @@ void Nodeset_newNodeFinish(Nodeset *nodeset, NL_Node *node)
     }
     else
     {
+        if (!NodeIndex_add(nodeset->index, node))
+        {
+            if (nodeset->logger)
+            {
+                nodeset->logger->log(nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                            "node was not added, already exists");
+            }
+            reportDuplicate(nodeset, node);
+            Node_delete(node);
+            return;
+        }
         if (node->nodeClass == NODECLASS_REFERENCETYPE)
         {
             NodeContainer_add(nodeset->refTypesWithUnknownRefs, node);
@@ -531,15 +1209,18 @@ void Nodeset_newReferenceFinish(Nodeset *nodeset, NL_Reference *ref,
                                 NL_Node *node, char *targetId)
 {
     UA_NodeId_clear(&ref->target);
-    ref->target = alias2Id(nodeset, targetId);
+    ref->target = alias2Id(nodeset, node, targetId);
 
     // handle hasEncoding in a special way
     UA_NodeId hasEncodingRef = UA_NODEID("i=38");
     if (UA_NodeId_equal(&ref->refType, &hasEncodingRef) &&
+        node->browseName.name &&
         !strcmp(node->browseName.name, "Default Binary") && !ref->isForward)
     {
         NL_BiDirectionalReference *newRef = (NL_BiDirectionalReference *)calloc(
             1, sizeof(NL_BiDirectionalReference));
+        nodeset->allocated[NL_MEMORY_REFERENCES] +=
+            sizeof(NL_BiDirectionalReference);
         UA_NodeId_copy(&ref->target, &newRef->source);
         UA_NodeId_copy(&node->id, &newRef->target);
         UA_NodeId_copy(&ref->refType, &newRef->refType);
@@ -555,6 +1236,7 @@ void Nodeset_addDataTypeDefinition(Nodeset *nodeset, NL_Node *node,
 {
     NL_DataTypeNode *dataTypeNode = (NL_DataTypeNode *)node;
     NL_DataTypeDefinition *def = DataTypeDefinition_new(dataTypeNode);
+    nodeset->allocated[NL_MEMORY_NODES] += sizeof(NL_DataTypeDefinition);
     def->isUnion =
         !strcmp("true", getAttributeValue(nodeset, &dataTypeDefinition_IsUnion,
                                           attributes, attributeSize));
@@ -574,6 +1256,7 @@ void Nodeset_addDataTypeField(Nodeset *nodeset, NL_Node *node,
 
     NL_DataTypeDefinitionField *newField =
         DataTypeNode_addDefinitionField(dataTypeNode->definition);
+    nodeset->allocated[NL_MEMORY_NODES] += sizeof(NL_DataTypeDefinitionField);
     newField->name = getAttributeValue(nodeset, &dataTypeField_Name, attributes,
                                        attributeSize);
 
@@ -588,7 +1271,7 @@ void Nodeset_addDataTypeField(Nodeset *nodeset, NL_Node *node,
     else
     {
         newField->dataType = alias2Id(
-            nodeset, getAttributeValue(nodeset, &dataTypeField_DataType,
+            nodeset, node, getAttributeValue(nodeset, &dataTypeField_DataType,
                                        attributes, attributeSize));
         newField->valueRank = atoi(getAttributeValue(
             nodeset, &attrValueRank, attributes, attributeSize));
@@ -652,6 +1335,10 @@ size_t Nodeset_forEachNode(Nodeset *nodeset, NL_NodeClass nodeClass,
                            void *context,
                            NodesetLoader_forEachNode_Func fn)
 {
+    if (!buildReferenceLists(nodeset, nodeClass))
+    {
+        return 0;
+    }
     NodeContainer *c = nodeset->nodes[nodeClass];
     for (NL_Node **node = c->nodes; node != c->nodes + c->size; node++)
     {
@@ -659,3 +1346,153 @@ size_t Nodeset_forEachNode(Nodeset *nodeset, NL_NodeClass nodeClass,
     }
     return c->size;
 }
+
+size_t Nodeset_forEachSpan(Nodeset *nodeset, NL_NodeClass nodeClass,
+                           size_t batchSize, void *context,
+                           NodesetLoader_forEachSpan_Func fn)
+{
+    if (!nodeset->columns[nodeClass])
+    {
+        nodeset->columns[nodeClass] =
+            NodeColumns_new(nodeset->nodes[nodeClass], nodeClass,
+                            nodeset->blocks[nodeClass]);
+        if (!nodeset->columns[nodeClass])
+        {
+            return 0;
+        }
+    }
+    return NodeColumns_forEachSpan(nodeset->columns[nodeClass], batchSize,
+                                   context, fn);
+}
+
+NL_Node *Nodeset_getNode(const Nodeset *nodeset, const UA_NodeId *id)
+{
+    NL_Node *node = NodeIndex_get(nodeset->index, id);
+    if (node && !buildReferenceLists(nodeset, node->nodeClass))
+    {
+        return NULL;
+    }
+    return node;
+}
+
+size_t Nodeset_forEachReference(const Nodeset *nodeset, const NL_Node *node,
+                                void *context,
+                                NodesetLoader_forEachReference_Func fn)
+{
+    return NodeBlock_forEachReference(nodeset->blocks[node->nodeClass], node,
+                                      context, fn);
+}
+
+const NL_InverseReference *Nodeset_getInverseReferences(Nodeset *nodeset,
+                                                        const UA_NodeId *id,
+                                                        size_t *size)
+{
+    *size = 0;
+    if (!nodeset->inverseRefs)
+    {
+        nodeset->inverseRefs =
+            InverseRefIndex_new(nodeset->nodes, nodeset->blocks);
+        if (!nodeset->inverseRefs)
+        {
+            return NULL;
+        }
+    }
+    return InverseRefIndex_get(nodeset->inverseRefs, id, size);
+}
+
+const NL_NodeLevel *Nodeset_getLevels(Nodeset *nodeset, size_t *size)
+{
+    if (!nodeset->sorted)
+    {
+        *size = 0;
+        return NULL;
+    }
+    return NodeLevels_get(nodeset->levels, nodeset->nodes, size);
+}
+
+void Nodeset_addMemory(Nodeset *nodeset, NL_MemorySubsystem subsystem,
+                       size_t bytes)
+{
+    nodeset->allocated[subsystem] += bytes;
+}
+
+void Nodeset_getMemoryUsage(const Nodeset *nodeset, NL_MemoryUsage *usage)
+{
+    for (size_t i = 0; i < NL_MEMORY_COUNT; i++)
+    {
+        usage->bytes[i] = nodeset->allocated[i];
+    }
+    usage->bytes[NL_MEMORY_NODES] += sizeof(Nodeset);
+    usage->bytes[NL_MEMORY_CHARARENA] +=
+        CharArenaAllocator_memoryUsage(nodeset->charArena);
+    if (nodeset->extensionArena)
+    {
+        usage->bytes[NL_MEMORY_EXTENSIONS] +=
+            CharArenaAllocator_memoryUsage(nodeset->extensionArena);
+    }
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        usage->bytes[NL_MEMORY_NODES] +=
+            NodeContainer_memoryUsage(nodeset->nodes[cnt]);
+        usage->bytes[NL_MEMORY_INDEX] +=
+            NodeColumns_memoryUsage(nodeset->columns[cnt]);
+    }
+    usage->bytes[NL_MEMORY_NODES] +=
+        NodeContainer_memoryUsage(nodeset->nodesWithUnknownRefs) +
+        NodeContainer_memoryUsage(nodeset->refTypesWithUnknownRefs);
+    usage->bytes[NL_MEMORY_REFERENCES] += RefStore_memoryUsage(nodeset->refStore);
+    for (size_t cnt = 0; nodeset->refStore && cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        usage->bytes[NL_MEMORY_REFERENCES] +=
+            NodeBlock_compactRefsMemoryUsage(nodeset->blocks[cnt]);
+    }
+    usage->bytes[NL_MEMORY_SORT] += Sort_memoryUsage(nodeset->sortCtx);
+    usage->bytes[NL_MEMORY_ALIASES] += AliasList_memoryUsage(nodeset->aliasList);
+    usage->bytes[NL_MEMORY_NAMESPACES] +=
+        NamespaceList_memoryUsage(nodeset->namespaces);
+    usage->bytes[NL_MEMORY_INDEX] += NodeIndex_memoryUsage(nodeset->index) +
+                                     InverseRefIndex_memoryUsage(nodeset->inverseRefs) +
+                                     NodeLevels_memoryUsage(nodeset->levels) +
+                                     Validation_memoryUsage(nodeset->validation) +
+                                     NodeIdSet_memoryUsage(nodeset->filtered) +
+                                     NodeIdSet_memoryUsage(nodeset->subtree) +
+                                     NodeIdTable_memoryUsage(nodeset->nodeIds);
+    usage->total = 0;
+    for (size_t i = 0; i < NL_MEMORY_COUNT; i++)
+    {
+        usage->total += usage->bytes[i];
+    }
+    usage->budget = nodeset->memoryBudget;
+}
+
+bool Nodeset_checkMemoryBudget(const Nodeset *nodeset)
+{
+    if (!nodeset->memoryBudget)
+    {
+        return true;
+    }
+    NL_MemoryUsage usage;
+    Nodeset_getMemoryUsage(nodeset, &usage);
+    if (usage.total <= usage.budget)
+    {
+        return true;
+    }
+    size_t largest = 0;
+    for (size_t i = 1; i < NL_MEMORY_COUNT; i++)
+    {
+        if (usage.bytes[i] > usage.bytes[largest])
+        {
+            largest = i;
+        }
+    }
+    if (!nodeset->logger)
+    {
+        return false;
+    }
+    nodeset->logger->log(nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                         "memory budget of %zu bytes exceeded: %zu bytes in "
+                         "use, most of them by %s (%zu bytes)",
+                         usage.budget, usage.total, NL_MEMORY_NAME[largest],
+                         usage.bytes[largest]);
+    return false;
+}
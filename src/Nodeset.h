@@ -23,25 +23,91 @@ typedef struct TParserCtx TParserCtx;
 struct NamespaceList;
 
 struct NodeContainer;
+struct NodeColumns;
+struct NodeBlock;
+struct RefStore;
+struct NodeLevels;
+struct NodeIndex;
+struct NodeIdTable;
+struct InverseRefIndex;
 struct AliasList;
 struct SortContext;
+struct Validation;
 struct Nodeset
 {
     CharArenaAllocator *charArena;
+    // a shared arena is reset instead of deleted
+    bool ownsCharArena;
+    // memory of the extensions, created on first use
+    CharArenaAllocator *extensionArena;
+    NodesetLoader_ExtensionAllocator extensionAllocator;
     struct AliasList *aliasList;
     struct NodeContainer *nodes[NL_NODECLASS_COUNT];
     struct NamespaceList *namespaces;
+    // parsed NodeId strings, freed by the compaction
+    struct NodeIdTable *nodeIds;
     struct SortContext *sortCtx;
     NL_BiDirectionalReference *hasEncodingRefs;
     NodesetLoader_Logger* logger;
     struct NodeContainer *nodesWithUnknownRefs;
+    // reference types with unknown references or an unknown supertype
     struct NodeContainer *refTypesWithUnknownRefs;
+    // set by the first sort, the unknown references are resolved once
+    bool refTypesResolved;
     NL_ReferenceService* refService;
+    // built on demand by Nodeset_forEachSpan
+    struct NodeColumns *columns[NL_NODECLASS_COUNT];
+    struct NodeIndex *index;
+    // built on demand by Nodeset_getInverseReferences
+    struct InverseRefIndex *inverseRefs;
+    // bytes of the allocations which aren't owned by a container, i.e. the
+    // nodes, references and values
+    size_t allocated[NL_MEMORY_COUNT];
+    // 0 if unlimited
+    size_t memoryBudget;
+    bool sorted;
+    // set by Nodeset_compact, the nodes are owned by the blocks then
+    bool compacted;
+    struct NodeBlock *blocks[NL_NODECLASS_COUNT];
+    // NodeIds of the compact references of the blocks, NULL if the references
+    // are kept in the lists
+    struct RefStore *refStore;
+    // filled by the sort
+    struct NodeLevels *levels;
+    // findings of the import and of Nodeset_validate
+    struct Validation *validation;
+    bool validated;
+    // optional, owned by the loader
+    struct Progress *progress;
+    // a node couldn't be added to the sort, the sort fails
+    bool sortIncomplete;
+    // NodeIds skipped by an import filter, created on first use
+    struct NodeIdSet *filtered;
+    // size of filtered when the references were last removed
+    size_t filteredRemoved;
+    // instances accepted by the subtree filter of subtreeRoot, created on
+    // first use
+    struct NodeIdSet *subtree;
+    UA_NodeId subtreeRoot;
 };
 
-Nodeset *Nodeset_new(NL_addNamespaceCallback nsCallback, NodesetLoader_Logger* logger, NL_ReferenceService* refService);
+// charArena is optional, the nodeset creates its own arena if NULL
+Nodeset *Nodeset_new(NL_addNamespaceCallback nsCallback, NodesetLoader_Logger* logger, NL_ReferenceService* refService, CharArenaAllocator *charArena);
 void Nodeset_cleanup(Nodeset *nodeset);
 bool Nodeset_sort(Nodeset *nodeset);
+// runs the checks on the first call and reports all findings
+size_t Nodeset_validate(Nodeset *nodeset, void *context,
+                        NodesetLoader_Finding_Func fn);
+// Frees the structures which are only needed for parsing and sorting and moves
+// the nodes into contiguous blocks in sort order. Has to be called after a
+// successful sort, no files can be imported afterwards. With
+// compactReferences the references are stored as handles of a RefStore.
+bool Nodeset_compact(Nodeset *nodeset, bool compactReferences);
+// evaluates the filter on the attributes of a node element without allocating
+// them, the ids of skipped nodes are remembered
+bool Nodeset_acceptNode(Nodeset *nodeset, const NL_ImportFilter *filter,
+                        void *userContext, NL_NodeClass nodeClass,
+                        int attributeSize, const char **attributes);
 NL_Node *Nodeset_newNode(Nodeset *nodeset, NL_NodeClass nodeClass,
                        int attributeSize, const char **attributes);
 void Nodeset_newNodeFinish(Nodeset *nodeset, NL_Node *node);
@@ -49,6 +115,8 @@ NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
                                 int attributeSize, const char **attributes);
 void Nodeset_newReferenceFinish(Nodeset *nodeset, NL_Reference *ref, NL_Node *node,
                                 char *targetId);
+// the aliases of the next file may redefine those of the files before
+void Nodeset_startFile(Nodeset *nodeset);
 struct Alias *Nodeset_newAlias(Nodeset *nodeset, int attributeSize,
                                const char **attribute);
 void Nodeset_newAliasFinish(Nodeset *nodeset, struct Alias *alias,
@@ -72,4 +140,20 @@ const NL_BiDirectionalReference *
 Nodeset_getBiDirectionalRefs(const Nodeset *nodeset);
 size_t Nodeset_forEachNode(Nodeset *nodeset, NL_NodeClass nodeClass,
                            void *context, NodesetLoader_forEachNode_Func fn);
+NL_Node *Nodeset_getNode(const Nodeset *nodeset, const UA_NodeId *id);
+size_t Nodeset_forEachReference(const Nodeset *nodeset, const NL_Node *node,
+                                void *context,
+                                NodesetLoader_forEachReference_Func fn);
+const NL_NodeLevel *Nodeset_getLevels(Nodeset *nodeset, size_t *size);
+const NL_InverseReference *Nodeset_getInverseReferences(Nodeset *nodeset,
+                                                        const UA_NodeId *id,
+                                                        size_t *size);
+void Nodeset_addMemory(Nodeset *nodeset, NL_MemorySubsystem subsystem,
+                       size_t bytes);
+void Nodeset_getMemoryUsage(const Nodeset *nodeset, NL_MemoryUsage *usage);
+// logs a diagnostic and returns false if the budget is exceeded
+bool Nodeset_checkMemoryBudget(const Nodeset *nodeset);
+size_t Nodeset_forEachSpan(Nodeset *nodeset, NL_NodeClass nodeClass,
+                           size_t batchSize, void *context,
+                           NodesetLoader_forEachSpan_Func fn);
 #endif
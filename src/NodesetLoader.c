@@ -9,6 +9,8 @@
 #include "InternalRefService.h"
 #include "Nodeset.h"
 #include "Parser.h"
+#include "Progress.h"
+#include "TypedValue.h"
 #include "Value.h"
 #include <assert.h>
 #include <stdlib.h>
@@ -38,6 +40,17 @@ const char *NL_NODECLASS_NAME[NL_NODECLASS_COUNT] = {
     "Object", "ObjectType",    "Variable",    "DataType",
     "Method", "ReferenceType", "VariableType", "View"};
 
+const char *NL_MEMORY_NAME[NL_MEMORY_COUNT] = {
+    "char arena", "nodes",      "references", "values",    "sort graph",
+    "aliases",    "namespaces", "indices",    "extensions"};
+
+const char *NL_CHECK_NAME[NL_CHECK_COUNT] = {
+    "dangling-reference",      "unknown-reference-type",
+    "missing-type-definition", "missing-data-type",
+    "alias",                   "malformed-node-id",
+    "malformed-browse-name",   "duplicate-node-id",
+    "reference-cycle",         "value-type-mismatch"};
+
 typedef enum
 {
     PARSER_STATE_INIT,
@@ -70,10 +83,26 @@ struct TParserCtx
     char *onCharacters;
     size_t onCharLength;
     NL_Value *val;
+    bool decodeValues;
+    // the current value is decoded by typed instead of the NL_Data tree
+    bool typedValue;
+    TypedValue *typed;
+    // reused for the text of the elements of typed values
+    char *typedText;
+    size_t typedTextCapacity;
     void *extensionData;
     NodesetLoader_ExtensionInterface *extIf;
+    NodesetLoader_ExtensionInterfaceV2 *extIfV2;
+    const NL_ImportFilter *filter;
+    unsigned int skipAttributes;
+    // reused for the attributes of all extension elements
+    NL_ExtensionAttribute *extAttributes;
+    size_t extAttributesCapacity;
     NL_Reference *ref;
     Nodeset *nodeset;
+    Parser *parser;
+    bool memoryBudgetExceeded;
+    Progress *progress;
 };
 
 struct NodesetLoader
@@ -83,6 +112,13 @@ struct NodesetLoader
     bool internalLogger;
     NL_ReferenceService *refService;
     bool internalRefService;
+    size_t memoryBudget;
+    // optional, see NodesetLoader_useCharArena
+    CharArenaAllocator *charArena;
+    bool autoCompact;
+    bool compactReferences;
+    // the callback of the last imported file
+    Progress progress;
 };
 
 static void enterUnknownState(TParserCtx *ctx)
@@ -92,6 +128,127 @@ static void enterUnknownState(TParserCtx *ctx)
     ctx->unknown_depth = 1;
 }
 
+static bool isSkipped(const TParserCtx *pctx, NL_AttributeMask attribute)
+{
+    return (pctx->skipAttributes & (unsigned int)attribute) != 0;
+}
+
+// the data type of a variable is known when its value starts
+static bool beginTypedValue(TParserCtx *pctx)
+{
+    if (!pctx->decodeValues || pctx->node->nodeClass != NODECLASS_VARIABLE)
+    {
+        return false;
+    }
+    const UA_DataType *type =
+        TypedValue_findType(&((NL_VariableNode *)pctx->node)->datatype);
+    if (!type)
+    {
+        return false;
+    }
+    if (!pctx->typed)
+    {
+        pctx->typed = TypedValue_new(pctx->nodeset->namespaces);
+        if (!pctx->typed)
+        {
+            return false;
+        }
+    }
+    TypedValue_begin(pctx->typed, type);
+    return true;
+}
+
+// returns the memory of the decoded value
+static size_t finishTypedValue(TParserCtx *pctx)
+{
+    size_t memory = TypedValue_memoryUsage(pctx->typed);
+    UA_Variant *variant = (UA_Variant *)calloc(1, sizeof(UA_Variant));
+    if (variant &&
+        TypedValue_finish(pctx->typed, variant, &pctx->val->isArray))
+    {
+        pctx->val->variant = variant;
+        return memory;
+    }
+    free(variant);
+    return 0;
+}
+
+static void appendTypedText(TParserCtx *pctx, const char *ch, size_t len)
+{
+    size_t required = pctx->onCharLength + len + 1;
+    if (required > pctx->typedTextCapacity)
+    {
+        size_t capacity = pctx->typedTextCapacity ? pctx->typedTextCapacity : 64;
+        while (capacity < required)
+        {
+            capacity *= 2;
+        }
+        char *text = (char *)realloc(pctx->typedText, capacity);
+        if (!text)
+        {
+            return;
+        }
+        pctx->typedText = text;
+        pctx->typedTextCapacity = capacity;
+    }
+    memcpy(pctx->typedText + pctx->onCharLength, ch, len);
+    pctx->onCharLength += len;
+    pctx->typedText[pctx->onCharLength] = '\0';
+    pctx->onCharacters = pctx->typedText;
+}
+
+static void startNode(TParserCtx *pctx, NL_NodeClass nodeClass,
+                      int nb_attributes, const char **attributes)
+{
+    if (!Nodeset_acceptNode(pctx->nodeset, pctx->filter, pctx->userContext,
+                            nodeClass, nb_attributes, attributes))
+    {
+        // the element is skipped with all of its children
+        enterUnknownState(pctx);
+        return;
+    }
+    pctx->nodeClass = nodeClass;
+    pctx->node =
+        Nodeset_newNode(pctx->nodeset, nodeClass, nb_attributes, attributes);
+    pctx->state = PARSER_STATE_NODE;
+}
+
+static NL_TextSpan textSpan(const char *text)
+{
+    NL_TextSpan span;
+    span.data = text;
+    span.length = strlen(text);
+    return span;
+}
+
+// libxml2 passes 5 entries per attribute: localname, prefix, URI, value
+// begin and value end
+static size_t decodeExtensionAttributes(TParserCtx *pctx, int nb_attributes,
+                                        const char **attributes)
+{
+    size_t size = nb_attributes > 0 ? (size_t)nb_attributes : 0;
+    if (size > pctx->extAttributesCapacity)
+    {
+        NL_ExtensionAttribute *extAttributes = (NL_ExtensionAttribute *)realloc(
+            pctx->extAttributes, size * sizeof(NL_ExtensionAttribute));
+        if (!extAttributes)
+        {
+            return 0;
+        }
+        pctx->extAttributes = extAttributes;
+        pctx->extAttributesCapacity = size;
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        const char **attribute = &attributes[i * 5];
+        pctx->extAttributes[i].name = textSpan(attribute[0]);
+        pctx->extAttributes[i].value.data = attribute[3];
+        pctx->extAttributes[i].value.length =
+            (size_t)(attribute[4] - attribute[3]);
+    }
+    return size;
+}
+
 static void OnStartElementNs(void *ctx, const char *localname,
                              const char *prefix, const char *URI,
                              int nb_namespaces, const char **namespaces,
@@ -104,59 +261,35 @@ static void OnStartElementNs(void *ctx, const char *localname,
     case PARSER_STATE_INIT:
         if (!strcmp(localname, VARIABLE))
         {
-            pctx->nodeClass = NODECLASS_VARIABLE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_VARIABLE, nb_attributes, attributes);
         }
         else if (!strcmp(localname, OBJECT))
         {
-            pctx->nodeClass = NODECLASS_OBJECT;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_OBJECT, nb_attributes, attributes);
         }
         else if (!strcmp(localname, OBJECTTYPE))
         {
-            pctx->nodeClass = NODECLASS_OBJECTTYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_OBJECTTYPE, nb_attributes, attributes);
         }
         else if (!strcmp(localname, DATATYPE))
         {
-            pctx->nodeClass = NODECLASS_DATATYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_DATATYPE, nb_attributes, attributes);
         }
         else if (!strcmp(localname, METHOD))
         {
-            pctx->nodeClass = NODECLASS_METHOD;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_METHOD, nb_attributes, attributes);
         }
         else if (!strcmp(localname, REFERENCETYPE))
         {
-            pctx->nodeClass = NODECLASS_REFERENCETYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_REFERENCETYPE, nb_attributes, attributes);
         }
         else if (!strcmp(localname, VARIABLETYPE))
         {
-            pctx->nodeClass = NODECLASS_VARIABLETYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_VARIABLETYPE, nb_attributes, attributes);
         }
         else if (!strcmp(localname, VIEW))
         {
-            pctx->nodeClass = NODECLASS_VIEW;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
+            startNode(pctx, NODECLASS_VIEW, nb_attributes, attributes);
         }
         else if (!strcmp(localname, NAMESPACEURIS))
         {
@@ -197,36 +330,45 @@ static void OnStartElementNs(void *ctx, const char *localname,
     case PARSER_STATE_NODE:
         if (!strcmp(localname, DISPLAYNAME))
         {
-            Nodeset_setDisplayName(pctx->nodeset, pctx->node, nb_attributes,
-                                   attributes);
+            if (!isSkipped(pctx, NL_ATTRIBUTE_DISPLAYNAME_LOCALE))
+            {
+                Nodeset_setDisplayName(pctx->nodeset, pctx->node,
+                                       nb_attributes, attributes);
+            }
             pctx->state = PARSER_STATE_DISPLAYNAME;
         }
         else if (!strcmp(localname, REFERENCES))
         {
             pctx->state = PARSER_STATE_REFERENCES;
         }
-        else if (!strcmp(localname, DESCRIPTION))
+        else if (!strcmp(localname, DESCRIPTION) &&
+                 !isSkipped(pctx, NL_ATTRIBUTE_DESCRIPTION))
         {
             pctx->state = PARSER_STATE_DESCRIPTION;
             Nodeset_setDescription(pctx->nodeset, pctx->node, nb_attributes,
                                    attributes);
         }
-        else if (!strcmp(localname, VALUE))
+        else if (!strcmp(localname, VALUE) &&
+                 !isSkipped(pctx, NL_ATTRIBUTE_VALUE))
         {
             pctx->val = Value_new(pctx->node);
+            pctx->typedValue = beginTypedValue(pctx);
             pctx->state = PARSER_STATE_VALUE;
         }
-        else if (!strcmp(localname, EXTENSIONS))
+        else if (!strcmp(localname, EXTENSIONS) &&
+                 !isSkipped(pctx, NL_ATTRIBUTE_EXTENSIONS))
         {
             pctx->state = PARSER_STATE_EXTENSIONS;
         }
-        else if (!strcmp(localname, "Definition"))
+        else if (!strcmp(localname, "Definition") &&
+                 !isSkipped(pctx, NL_ATTRIBUTE_DATATYPE_DEFINITION))
         {
             Nodeset_addDataTypeDefinition(pctx->nodeset, pctx->node, nb_attributes,
                                      attributes);
             pctx->state = PARSER_STATE_DATATYPE_DEFINITION;
         }
-        else if (!strcmp(localname, INVERSENAME))
+        else if (!strcmp(localname, INVERSENAME) &&
+                 !isSkipped(pctx, NL_ATTRIBUTE_INVERSENAME))
         {
             pctx->state = PARSER_STATE_INVERSENAME;
             Nodeset_setInverseName(pctx->nodeset, pctx->node, nb_attributes,
@@ -234,6 +376,7 @@ static void OnStartElementNs(void *ctx, const char *localname,
         }
         else
         {
+            // unknown and skipped elements
             enterUnknownState(pctx);
         }
         break;
@@ -254,12 +397,19 @@ static void OnStartElementNs(void *ctx, const char *localname,
         break;
 
     case PARSER_STATE_VALUE:
+        if (pctx->typedValue)
+        {
+            // the name is only compared, no copy needed
+            TypedValue_start(pctx->typed, localname);
+            pctx->unknown_depth++;
+            break;
+        }
         // copy the name
         {
             size_t len = strlen(localname);
             char *localNameCopy =
                 CharArenaAllocator_malloc(pctx->nodeset->charArena, len + 1);
-            memcpy(localNameCopy, localname, len);
+            memcpy(localNameCopy, localname, len + 1);
             Value_start(pctx->val, localNameCopy);
             pctx->unknown_depth++;
         }
@@ -268,7 +418,13 @@ static void OnStartElementNs(void *ctx, const char *localname,
     case PARSER_STATE_EXTENSIONS:
         if (!strcmp(localname, EXTENSION))
         {
-            if (pctx->extIf)
+            if (pctx->extIfV2)
+            {
+                pctx->extensionData = pctx->extIfV2->newExtension(
+                    pctx->extIfV2->userContext,
+                    &pctx->nodeset->extensionAllocator);
+            }
+            else if (pctx->extIf)
             {
                 pctx->extensionData = pctx->extIf->newExtension();
             }
@@ -280,7 +436,15 @@ static void OnStartElementNs(void *ctx, const char *localname,
         }
         break;
     case PARSER_STATE_EXTENSION:
-        if (pctx->extIf)
+        if (pctx->extIfV2)
+        {
+            size_t attributesSize =
+                decodeExtensionAttributes(pctx, nb_attributes, attributes);
+            pctx->extIfV2->start(pctx->extIfV2->userContext,
+                                 pctx->extensionData, textSpan(localname),
+                                 attributesSize, pctx->extAttributes);
+        }
+        else if (pctx->extIf)
         {
             pctx->extIf->start(pctx->extensionData, localname, nb_attributes, attributes);
         }
@@ -345,6 +509,20 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
         break;
     case PARSER_STATE_NODE:
         Nodeset_newNodeFinish(pctx->nodeset, pctx->node);
+        if (!Nodeset_checkMemoryBudget(pctx->nodeset))
+        {
+            pctx->memoryBudgetExceeded = true;
+            Parser_stop(pctx->parser);
+        }
+        pctx->progress->state.nodesCreated++;
+        if (pctx->progress->callback)
+        {
+            pctx->progress->state.bytesParsed = Parser_bytesRead(pctx->parser);
+            if (!Progress_update(pctx->progress))
+            {
+                Parser_stop(pctx->parser);
+            }
+        }
         pctx->state = PARSER_STATE_INIT;
         break;
     case PARSER_STATE_DISPLAYNAME:
@@ -365,6 +543,14 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
     case PARSER_STATE_VALUE:
         if (!strcmp(localname, VALUE) && pctx->unknown_depth == 0)
         {
+            size_t typedMemory = 0;
+            if (pctx->typedValue)
+            {
+                typedMemory = finishTypedValue(pctx);
+                pctx->typedValue = false;
+            }
+            Nodeset_addMemory(pctx->nodeset, NL_MEMORY_VALUES,
+                              Value_memoryUsage(pctx->val) + typedMemory);
             /* TODO: Enable VariableType to hold a valeu */
             if(pctx->node->nodeClass == NODECLASS_VARIABLE)
                 ((NL_VariableNode *)pctx->node)->value = pctx->val;
@@ -372,14 +558,27 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
         }
         else
         {
-            Value_end(pctx->val, localname, pctx->onCharacters);
+            if (pctx->typedValue)
+            {
+                TypedValue_end(pctx->typed, pctx->onCharacters);
+            }
+            else
+            {
+                Value_end(pctx->val, localname, pctx->onCharacters);
+            }
             pctx->unknown_depth--;
         }
         break;
     case PARSER_STATE_EXTENSION:
         if (!strcmp(localname, EXTENSION))
         {
-            if (pctx->extIf)
+            if (pctx->extIfV2)
+            {
+                pctx->extIfV2->finish(pctx->extIfV2->userContext,
+                                      pctx->extensionData);
+                pctx->node->extension = pctx->extensionData;
+            }
+            else if (pctx->extIf)
             {
                 pctx->extIf->finish(pctx->extensionData);
                 pctx->node->extension = pctx->extensionData;
@@ -388,7 +587,12 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
         }
         else
         {
-            if (pctx->extIf)
+            if (pctx->extIfV2)
+            {
+                pctx->extIfV2->end(pctx->extIfV2->userContext,
+                                   pctx->extensionData, textSpan(localname));
+            }
+            else if (pctx->extIf)
             {
                 pctx->extIf->end(pctx->extensionData, localname,
                                  pctx->onCharacters);
@@ -428,6 +632,27 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
 static void OnCharacters(void *ctx, const char *ch, int len)
 {
     TParserCtx *pctx = (TParserCtx *)ctx;
+    if (pctx->state == PARSER_STATE_EXTENSION && pctx->extIfV2)
+    {
+        // handed over without copying it to the arena
+        NL_TextSpan text;
+        text.data = ch;
+        text.length = (size_t)len;
+        pctx->extIfV2->text(pctx->extIfV2->userContext, pctx->extensionData,
+                            text);
+        return;
+    }
+    // the text of unknown and skipped elements is dropped anyway
+    if (pctx->state == PARSER_STATE_UNKNOWN)
+    {
+        return;
+    }
+    // the text of typed values is converted at the end of the element
+    if (pctx->state == PARSER_STATE_VALUE && pctx->typedValue)
+    {
+        appendTypedText(pctx, ch, (size_t)len);
+        return;
+    }
     if (pctx->onCharacters == NULL)
     {
         char *newValue = CharArenaAllocator_malloc(pctx->nodeset->charArena,
@@ -436,16 +661,31 @@ static void OnCharacters(void *ctx, const char *ch, int len)
     }
     else
     {
+        // the terminator is already reserved
         pctx->onCharacters = CharArenaAllocator_realloc(
-            pctx->nodeset->charArena, (size_t)len + 1);
+            pctx->nodeset->charArena, (size_t)len);
     }
     memcpy(pctx->onCharacters + pctx->onCharLength, ch, (size_t)len);
     pctx->onCharLength += (size_t)len;
+    pctx->onCharacters[pctx->onCharLength] = '\0';
 }
 
 bool NodesetLoader_importFile(NodesetLoader *loader,
                               const NL_FileContext *fileHandler)
 {
+    return NodesetLoader_importFileWithOptions(loader, fileHandler, NULL);
+}
+
+bool NodesetLoader_importFileWithOptions(NodesetLoader *loader,
+                                         const NL_FileContext *fileHandler,
+                                         const NL_ImportOptions *options)
+{
+    NL_ImportOptions defaultOptions;
+    if (!options)
+    {
+        memset(&defaultOptions, 0, sizeof(NL_ImportOptions));
+        options = &defaultOptions;
+    }
     if (fileHandler == NULL)
     {
         loader->logger->log(loader->logger->context,
@@ -460,12 +700,34 @@ bool NodesetLoader_importFile(NodesetLoader *loader,
                             "NodesetLoader: fileHandler->addNamespace missing");
         return false;
     }
+    if (loader->nodeset && loader->nodeset->compacted)
+    {
+        loader->logger->log(loader->logger->context,
+                            NODESETLOADER_LOGLEVEL_ERROR,
+                            "NodesetLoader: nodeset is compacted, no further "
+                            "files can be imported");
+        return false;
+    }
+    if (loader->progress.cancelled)
+    {
+        loader->logger->log(loader->logger->context,
+                            NODESETLOADER_LOGLEVEL_ERROR,
+                            "NodesetLoader: import was cancelled, the loader "
+                            "has to be deleted");
+        return false;
+    }
     bool retStatus = true;
     if (!loader->nodeset)
     {
         loader->nodeset = Nodeset_new(fileHandler->addNamespace, loader->logger,
-                                      loader->refService);
+                                      loader->refService, loader->charArena);
+        loader->nodeset->memoryBudget = loader->memoryBudget;
+        loader->nodeset->progress = &loader->progress;
     }
+    Nodeset_startFile(loader->nodeset);
+    Progress_setCallback(&loader->progress, options->progress,
+                         options->progressContext, options->progressInterval);
+    Progress_startStage(&loader->progress, NL_PROGRESS_PARSE);
 
     TParserCtx *ctx = NULL;
     FILE *f = fopen(fileHandler->file, "r");
@@ -479,6 +741,13 @@ bool NodesetLoader_importFile(NodesetLoader *loader,
         goto cleanup;
     }
 
+    if (loader->progress.callback && !fseek(f, 0, SEEK_END))
+    {
+        long size = ftell(f);
+        loader->progress.state.bytesTotal = size > 0 ? (size_t)size : 0;
+        rewind(f);
+    }
+
     ctx = (TParserCtx *)calloc(1, sizeof(TParserCtx));
     if (!ctx)
     {
@@ -493,17 +762,55 @@ bool NodesetLoader_importFile(NodesetLoader *loader,
     ctx->onCharLength = 0;
     ctx->userContext = fileHandler->userContext;
     ctx->extIf = fileHandler->extensionHandling;
+    ctx->extIfV2 = options->extensionHandlingV2;
+    ctx->filter = options->filter;
+    ctx->skipAttributes = options->skipAttributes;
+    ctx->decodeValues = options->decodeValues;
+    ctx->progress = &loader->progress;
 
     Parser *parser = Parser_new(ctx);
+    ctx->parser = parser;
     if (Parser_run(parser, f, OnStartElementNs, OnEndElementNs, OnCharacters))
     {
-        loader->logger->log(loader->logger->context,
-                            NODESETLOADER_LOGLEVEL_ERROR, "xml parsing error");
+        if (loader->progress.cancelled)
+        {
+            loader->logger->log(loader->logger->context,
+                                NODESETLOADER_LOGLEVEL_WARNING,
+                                "NodesetLoader: import cancelled");
+        }
+        // the budget check has logged the reason already
+        else if (!ctx->memoryBudgetExceeded)
+        {
+            loader->logger->log(loader->logger->context,
+                                NODESETLOADER_LOGLEVEL_ERROR,
+                                "xml parsing error");
+        }
         retStatus = false;
     }
+    else if (!Nodeset_checkMemoryBudget(loader->nodeset))
+    {
+        retStatus = false;
+    }
+    else
+    {
+        loader->progress.state.bytesParsed = Parser_bytesRead(parser);
+        if (!Progress_report(&loader->progress))
+        {
+            loader->logger->log(loader->logger->context,
+                                NODESETLOADER_LOGLEVEL_WARNING,
+                                "NodesetLoader: import cancelled");
+            retStatus = false;
+        }
+    }
     Parser_delete(parser);
 
 cleanup:
+    if (ctx)
+    {
+        free(ctx->extAttributes);
+        TypedValue_delete(ctx->typed);
+        free(ctx->typedText);
+    }
     free(ctx);
     if (f)
     {
@@ -514,11 +821,48 @@ cleanup:
 
 bool NodesetLoader_sort(NodesetLoader *loader)
 {
-    return Nodeset_sort(loader->nodeset);
+    if (!Nodeset_sort(loader->nodeset) ||
+        !Nodeset_checkMemoryBudget(loader->nodeset))
+    {
+        return false;
+    }
+    if (loader->autoCompact)
+    {
+        // a failed compaction leaves the sorted nodeset untouched
+        Nodeset_compact(loader->nodeset, loader->compactReferences);
+    }
+    return true;
+}
+
+bool NodesetLoader_compact(NodesetLoader *loader)
+{
+    if (!loader->nodeset)
+    {
+        return false;
+    }
+    return Nodeset_compact(loader->nodeset, loader->compactReferences);
+}
+
+void NodesetLoader_setAutoCompact(NodesetLoader *loader, bool autoCompact)
+{
+    loader->autoCompact = autoCompact;
+}
+
+void NodesetLoader_setCompactReferences(NodesetLoader *loader,
+                                        bool compactReferences)
+{
+    loader->compactReferences = compactReferences;
 }
 
 NodesetLoader *NodesetLoader_new(NodesetLoader_Logger *logger,
                                  NL_ReferenceService *refService)
+{
+    return NodesetLoader_newWithBudget(logger, refService, 0);
+}
+
+NodesetLoader *NodesetLoader_newWithBudget(NodesetLoader_Logger *logger,
+                                           NL_ReferenceService *refService,
+                                           size_t memoryBudget)
 {
     NodesetLoader *loader = (NodesetLoader *)calloc(1, sizeof(NodesetLoader));
     if(!loader)
@@ -543,6 +887,7 @@ NodesetLoader *NodesetLoader_new(NodesetLoader_Logger *logger,
     {
         loader->refService = refService;
     }
+    loader->memoryBudget = memoryBudget;
     return loader;
 }
 
@@ -572,3 +917,129 @@ size_t NodesetLoader_forEachNode(NodesetLoader *loader, NL_NodeClass nodeClass,
 {
     return Nodeset_forEachNode(loader->nodeset, nodeClass, context, fn);
 }
+
+size_t NodesetLoader_forEachSpan(NodesetLoader *loader, NL_NodeClass nodeClass,
+                                 size_t batchSize, void *context,
+                                 NodesetLoader_forEachSpan_Func fn)
+{
+    return Nodeset_forEachSpan(loader->nodeset, nodeClass, batchSize, context,
+                               fn);
+}
+
+NL_Node *NodesetLoader_getNode(const NodesetLoader *loader, const UA_NodeId *id)
+{
+    if (!loader->nodeset)
+    {
+        return NULL;
+    }
+    return Nodeset_getNode(loader->nodeset, id);
+}
+
+size_t NodesetLoader_forEachReference(NodesetLoader *loader, const NL_Node *node,
+                                      void *context,
+                                      NodesetLoader_forEachReference_Func fn)
+{
+    if (!loader->nodeset)
+    {
+        return 0;
+    }
+    return Nodeset_forEachReference(loader->nodeset, node, context, fn);
+}
+
+const NL_InverseReference *
+NodesetLoader_getInverseReferences(NodesetLoader *loader, const UA_NodeId *id,
+                                   size_t *size)
+{
+    if (!loader->nodeset)
+    {
+        *size = 0;
+        return NULL;
+    }
+    return Nodeset_getInverseReferences(loader->nodeset, id, size);
+}
+
+const NL_NodeLevel *NodesetLoader_getLevels(NodesetLoader *loader,
+                                            size_t *size)
+{
+    if (!loader->nodeset)
+    {
+        *size = 0;
+        return NULL;
+    }
+    return Nodeset_getLevels(loader->nodeset, size);
+}
+
+size_t NodesetLoader_validate(NodesetLoader *loader, void *context,
+                              NodesetLoader_Finding_Func fn)
+{
+    if (!loader->nodeset)
+    {
+        return 0;
+    }
+    return Nodeset_validate(loader->nodeset, context, fn);
+}
+
+void NodesetLoader_getMemoryUsage(const NodesetLoader *loader,
+                                  NL_MemoryUsage *usage)
+{
+    if (!loader->nodeset)
+    {
+        memset(usage, 0, sizeof(NL_MemoryUsage));
+        usage->budget = loader->memoryBudget;
+        return;
+    }
+    Nodeset_getMemoryUsage(loader->nodeset, usage);
+}
+
+NodesetLoader_CharArena *NodesetLoader_CharArena_new(size_t initialSize,
+                                                     bool hugePages)
+{
+    return CharArenaAllocator_newWithOptions(initialSize, hugePages);
+}
+
+void NodesetLoader_CharArena_delete(NodesetLoader_CharArena *arena)
+{
+    if (!arena)
+    {
+        return;
+    }
+    CharArenaAllocator_delete(arena);
+}
+
+void NodesetLoader_CharArena_getStats(const NodesetLoader_CharArena *arena,
+                                      NL_CharArenaStats *stats)
+{
+    CharArenaAllocator_Stats arenaStats;
+    CharArenaAllocator_getStats(arena, &arenaStats);
+    stats->regions = arenaStats.regions;
+    stats->mappedRegions = arenaStats.mappedRegions;
+    stats->capacity = arenaStats.capacity;
+    stats->used = arenaStats.used;
+    stats->resets = arenaStats.resets;
+}
+
+bool NodesetLoader_useCharArena(NodesetLoader *loader,
+                                NodesetLoader_CharArena *arena)
+{
+    if (loader->nodeset)
+    {
+        loader->logger->log(loader->logger->context,
+                            NODESETLOADER_LOGLEVEL_ERROR,
+                            "NodesetLoader: the char arena has to be set "
+                            "before the first import");
+        return false;
+    }
+    loader->charArena = arena;
+    return true;
+}
+
+bool NodesetLoader_getCharArenaStats(const NodesetLoader *loader,
+                                     NL_CharArenaStats *stats)
+{
+    if (!loader->nodeset)
+    {
+        return false;
+    }
+    NodesetLoader_CharArena_getStats(loader->nodeset->charArena, stats);
+    return true;
+}
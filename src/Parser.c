@@ -8,14 +8,56 @@
 #include "Parser.h"
 #include <assert.h>
 #include <libxml/SAX.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef NODESETLOADER_HAS_PTHREAD
+#include <pthread.h>
+#endif
 
 struct Parser
 {
     void *context;
+    xmlParserCtxtPtr ctxt;
+    bool stopped;
+    size_t bytesRead;
 };
 
+// libxml2 is initialized by the first running parser and cleaned up by the
+// last one, cleaning up while another thread parses isn't safe
+#ifdef NODESETLOADER_HAS_PTHREAD
+static pthread_mutex_t usersLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static size_t users;
+
+static void acquireLibXml(void)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_lock(&usersLock);
+#endif
+    if (users++ == 0)
+    {
+        xmlInitParser(); // Fix memory leak: https://gitlab.gnome.org/GNOME/libxml2/-/issues/9
+    }
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_unlock(&usersLock);
+#endif
+}
+
+static void releaseLibXml(void)
+{
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_lock(&usersLock);
+#endif
+    if (--users == 0)
+    {
+        xmlCleanupParser();
+    }
+#ifdef NODESETLOADER_HAS_PTHREAD
+    pthread_mutex_unlock(&usersLock);
+#endif
+}
+
 Parser *Parser_new(void *context)
 {
     Parser *parser = (Parser *)calloc(1, sizeof(Parser));
@@ -33,6 +75,7 @@ int Parser_run(Parser *parser, FILE *file, Parser_callbackStart start,
     {
         return 1;
     }
+    parser->bytesRead = (size_t)res;
 
     xmlSAXHandler hdl;
     memset(&hdl, 0, sizeof(xmlSAXHandler));
@@ -43,20 +86,45 @@ int Parser_run(Parser *parser, FILE *file, Parser_callbackStart start,
     hdl.startElementNs = (startElementNsSAX2Func)start;
     hdl.endElementNs = (endElementNsSAX2Func)end;
     hdl.characters = (charactersSAXFunc)onChars;
-    xmlInitParser(); // Fix memory leak: https://gitlab.gnome.org/GNOME/libxml2/-/issues/9
+    acquireLibXml();
     xmlParserCtxtPtr ctxt =
         xmlCreatePushParserCtxt(&hdl, parser->context, chars, res, NULL);
+    parser->ctxt = ctxt;
     while ((res = (int)fread(chars, 1, sizeof(chars), file)) > 0)
     {
+        parser->bytesRead += (size_t)res;
         if (xmlParseChunk(ctxt, chars, res, 0))
         {
-            xmlParserError(ctxt, "xmlParseChunk");
-            return 1;
+            if (!parser->stopped)
+            {
+                xmlParserError(ctxt, "xmlParseChunk");
+                parser->ctxt = NULL;
+                xmlFreeParserCtxt(ctxt);
+                releaseLibXml();
+                return 1;
+            }
+            break;
         }
     }
-    xmlParseChunk(ctxt, chars, 0, 1);
+    if (!parser->stopped)
+    {
+        xmlParseChunk(ctxt, chars, 0, 1);
+    }
+    parser->ctxt = NULL;
     xmlFreeParserCtxt(ctxt);
-    xmlCleanupParser();
-    return 0;
+    releaseLibXml();
+    return parser->stopped ? 1 : 0;
+}
+
+void Parser_stop(Parser *parser)
+{
+    if (parser->ctxt)
+    {
+        parser->stopped = true;
+        xmlStopParser(parser->ctxt);
+    }
 }
+
+size_t Parser_bytesRead(const Parser *parser) { return parser->bytesRead; }
+
 void Parser_delete(Parser *parser) { free(parser); }
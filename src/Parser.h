@@ -26,5 +26,9 @@ typedef void (*Parser_callbackChar)(void *ctx, const char *ch, int len);
 Parser *Parser_new(void *context);
 int Parser_run(Parser *parser, FILE *file, Parser_callbackStart start,
                Parser_callbackEnd end, Parser_callbackChar onChars);
+// aborts Parser_run from within a callback, Parser_run returns 1 then
+void Parser_stop(Parser *parser);
+// bytes of the file passed to libxml2 so far
+size_t Parser_bytesRead(const Parser *parser);
 void Parser_delete(Parser *parser);
 #endif
@@ -17,8 +17,10 @@ static void logStdOut(void *context, enum NodesetLoader_LogLevel level,
 {
     va_list vl;
     va_start(vl, message);
+    printf("NODESETLOADER: %s : ", logLevel[level]);
+    vprintf(message, vl);
+    printf("\n");
     va_end(vl);
-    printf("NODESETLOADER: %s : %s\n", logLevel[level], message);
 }
 
 NodesetLoader_Logger *InternalLogger_new(void)
@@ -0,0 +1,52 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Progress.h"
+
+void Progress_setCallback(Progress *progress, NL_ProgressCallback callback,
+                          void *context, unsigned int intervalMs)
+{
+    progress->callback = callback;
+    progress->context = context;
+    progress->interval = (UA_DateTime)intervalMs * UA_DATETIME_MSEC;
+}
+
+void Progress_startStage(Progress *progress, NL_ProgressStage stage)
+{
+    NL_Progress *state = &progress->state;
+    state->stage = stage;
+    // the first update of a stage is reported
+    progress->next = 0;
+    switch (stage)
+    {
+    case NL_PROGRESS_PARSE:
+        state->bytesParsed = 0;
+        state->bytesTotal = 0;
+        // fall through
+    case NL_PROGRESS_SORT:
+        state->nodesSorted = 0;
+        state->nodesToSort = 0;
+        // fall through
+    case NL_PROGRESS_INSERT:
+        state->nodeClass = NODECLASS_OBJECT;
+        state->nodesInserted = 0;
+        state->nodesOfClass = 0;
+        break;
+    }
+}
+
+bool Progress_report(Progress *progress)
+{
+    if (!progress->callback || progress->cancelled)
+    {
+        return !progress->cancelled;
+    }
+    if (!progress->callback(progress->context, &progress->state))
+    {
+        progress->cancelled = true;
+        return false;
+    }
+    progress->next = UA_DateTime_nowMonotonic() + progress->interval;
+    return true;
+}
@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include "NodesetLoader/NodesetLoader.h"
+
+// Throttles the calls of an NL_ProgressCallback and remembers a cancellation.
+// The counters in state are updated by the caller. A zeroed Progress has no
+// callback, Progress_update is a single branch then.
+struct Progress
+{
+    NL_ProgressCallback callback;
+    void *context;
+    UA_DateTime interval;
+    UA_DateTime next;
+    bool cancelled;
+    NL_Progress state;
+};
+typedef struct Progress Progress;
+
+// keeps the counters and a cancellation
+void Progress_setCallback(Progress *progress, NL_ProgressCallback callback,
+                          void *context, unsigned int intervalMs);
+// enters the next stage, the fields of the following stages are reset
+void Progress_startStage(Progress *progress, NL_ProgressStage stage);
+// calls the callback regardless of the interval, e.g. at the end of a stage
+bool Progress_report(Progress *progress);
+
+// returns false once the import is cancelled
+static inline bool Progress_update(Progress *progress)
+{
+    if (!progress->callback)
+    {
+        return true;
+    }
+    if (progress->cancelled)
+    {
+        return false;
+    }
+    if (UA_DateTime_nowMonotonic() < progress->next)
+    {
+        return true;
+    }
+    return Progress_report(progress);
+}
+
+#endif
@@ -0,0 +1,282 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "RefTypeResolver.h"
+#include "nodes/NodeContainer.h"
+
+#include <stdlib.h>
+
+static const UA_UInt32 NL_HASSUBTYPE_ID = 45;
+
+// a node with references whose reference type isn't known yet, or a reference
+// type whose supertype isn't registered yet
+struct Waiter
+{
+    NL_Node *node;
+    // unknown references and the supertype which are waited for
+    size_t pending;
+    bool registered;
+};
+typedef struct Waiter Waiter;
+
+struct WaitEntry
+{
+    // points into the node of the waiter
+    const UA_NodeId *refType;
+    Waiter *waiter;
+};
+typedef struct WaitEntry WaitEntry;
+
+struct Resolution
+{
+    NL_ReferenceService *refService;
+    Waiter *waiters;
+    size_t waitersSize;
+    // sorted by the reference type
+    WaitEntry *entries;
+    size_t entriesSize;
+    // registered reference types whose waiters aren't released yet
+    const UA_NodeId **released;
+    size_t releasedSize;
+};
+typedef struct Resolution Resolution;
+
+static bool isKnown(NL_ReferenceService *refService, const UA_NodeId *refType)
+{
+    NL_Reference ref;
+    ref.isForward = true;
+    ref.refType = *refType;
+    ref.target = UA_NODEID_NULL;
+    ref.next = NULL;
+    return refService->isHierachicalRef(refService->context, &ref) ||
+           refService->isNonHierachicalRef(refService->context, &ref);
+}
+
+static const UA_NodeId *getSupertype(const NL_Node *refType)
+{
+    const UA_NodeId hasSubtype = UA_NODEID_NUMERIC(0, NL_HASSUBTYPE_ID);
+    for (const NL_Reference *ref = refType->hierachicalRefs; ref;
+         ref = ref->next)
+    {
+        if (!ref->isForward && UA_NodeId_equal(&ref->refType, &hasSubtype))
+        {
+            return &ref->target;
+        }
+    }
+    return NULL;
+}
+
+bool RefTypeResolver_classify(NL_ReferenceService *refService, NL_Node *node)
+{
+    NL_Reference **unknown = &node->unknownRefs;
+    while (*unknown)
+    {
+        NL_Reference *ref = *unknown;
+        NL_Reference **list = NULL;
+        if (refService->isHierachicalRef(refService->context, ref))
+        {
+            list = &node->hierachicalRefs;
+        }
+        else if (refService->isNonHierachicalRef(refService->context, ref))
+        {
+            list = &node->nonHierachicalRefs;
+        }
+        if (!list)
+        {
+            unknown = &ref->next;
+            continue;
+        }
+        *unknown = ref->next;
+        ref->next = *list;
+        *list = ref;
+    }
+    return node->unknownRefs == NULL;
+}
+
+bool RefTypeResolver_awaitsSupertype(NL_ReferenceService *refService,
+                                     const NL_Node *refType)
+{
+    const UA_NodeId *supertype = getSupertype(refType);
+    return supertype && !isKnown(refService, supertype);
+}
+
+static int compareEntries(const void *a, const void *b)
+{
+    return (int)UA_NodeId_order(((const WaitEntry *)a)->refType,
+                                ((const WaitEntry *)b)->refType);
+}
+
+// counts the entries if res->entries is NULL
+static size_t addEntries(Resolution *res, Waiter *waiter)
+{
+    size_t cnt = 0;
+    for (const NL_Reference *ref = waiter->node->unknownRefs; ref;
+         ref = ref->next)
+    {
+        if (res->entries)
+        {
+            res->entries[res->entriesSize].refType = &ref->refType;
+            res->entries[res->entriesSize].waiter = waiter;
+            res->entriesSize++;
+        }
+        cnt++;
+    }
+    if (waiter->node->nodeClass == NODECLASS_REFERENCETYPE &&
+        RefTypeResolver_awaitsSupertype(res->refService, waiter->node))
+    {
+        if (res->entries)
+        {
+            res->entries[res->entriesSize].refType =
+                getSupertype(waiter->node);
+            res->entries[res->entriesSize].waiter = waiter;
+            res->entriesSize++;
+        }
+        cnt++;
+    }
+    return cnt;
+}
+
+static void registerRefType(Resolution *res, Waiter *waiter)
+{
+    waiter->registered = true;
+    res->refService->addNewReferenceType(res->refService->context,
+                                         (NL_ReferenceTypeNode *)waiter->node);
+    res->released[res->releasedSize++] = &waiter->node->id;
+}
+
+static void resolveWaiter(Resolution *res, Waiter *waiter)
+{
+    RefTypeResolver_classify(res->refService, waiter->node);
+    if (waiter->node->nodeClass == NODECLASS_REFERENCETYPE &&
+        !waiter->registered)
+    {
+        registerRefType(res, waiter);
+    }
+}
+
+// first entry which isn't less than refType
+static size_t lowerBound(const Resolution *res, const UA_NodeId *refType)
+{
+    size_t first = 0;
+    size_t last = res->entriesSize;
+    while (first < last)
+    {
+        size_t mid = first + (last - first) / 2;
+        if (UA_NodeId_order(res->entries[mid].refType, refType) ==
+            UA_ORDER_LESS)
+        {
+            first = mid + 1;
+        }
+        else
+        {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+static void releaseWaiters(Resolution *res)
+{
+    while (res->releasedSize)
+    {
+        const UA_NodeId *refType = res->released[--res->releasedSize];
+        for (size_t i = lowerBound(res, refType);
+             i < res->entriesSize &&
+             UA_NodeId_equal(res->entries[i].refType, refType);
+             i++)
+        {
+            Waiter *waiter = res->entries[i].waiter;
+            if (--waiter->pending == 0)
+            {
+                resolveWaiter(res, waiter);
+            }
+        }
+    }
+}
+
+// Registers the first reference type which only waits for a supertype that
+// isn't part of the nodeset, returns false if there is none.
+static bool registerWithoutSupertype(Resolution *res)
+{
+    for (size_t i = 0; i < res->waitersSize; i++)
+    {
+        Waiter *waiter = &res->waiters[i];
+        if (waiter->node->nodeClass == NODECLASS_REFERENCETYPE &&
+            !waiter->registered &&
+            RefTypeResolver_classify(res->refService, waiter->node))
+        {
+            registerRefType(res, waiter);
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t addWaiters(Resolution *res, NodeContainer *nodes)
+{
+    size_t cnt = 0;
+    for (size_t i = 0; i < nodes->size; i++)
+    {
+        Waiter *waiter = &res->waiters[res->waitersSize++];
+        waiter->node = nodes->nodes[i];
+        waiter->registered = false;
+        // the reference types which were registered after the node was parsed
+        RefTypeResolver_classify(res->refService, waiter->node);
+        waiter->pending = addEntries(res, waiter);
+        cnt += waiter->pending;
+    }
+    return cnt;
+}
+
+bool RefTypeResolver_resolve(NL_ReferenceService *refService,
+                             NodeContainer *refTypes, NodeContainer *nodes)
+{
+    Resolution res = {refService, NULL, 0, NULL, 0, NULL, 0};
+    size_t waitersSize = refTypes->size + nodes->size;
+    if (!waitersSize)
+    {
+        return true;
+    }
+    res.waiters = (Waiter *)calloc(waitersSize, sizeof(Waiter));
+    // every reference type is released once
+    res.released =
+        (const UA_NodeId **)calloc(refTypes->size + 1, sizeof(UA_NodeId *));
+    if (!res.waiters || !res.released)
+    {
+        free(res.waiters);
+        free(res.released);
+        return false;
+    }
+    size_t entriesSize = addWaiters(&res, refTypes) + addWaiters(&res, nodes);
+    res.entries = (WaitEntry *)calloc(entriesSize + 1, sizeof(WaitEntry));
+    if (!res.entries)
+    {
+        free(res.waiters);
+        free(res.released);
+        return false;
+    }
+    for (size_t i = 0; i < res.waitersSize; i++)
+    {
+        addEntries(&res, &res.waiters[i]);
+    }
+    qsort(res.entries, res.entriesSize, sizeof(WaitEntry), compareEntries);
+
+    for (size_t i = 0; i < res.waitersSize; i++)
+    {
+        if (res.waiters[i].pending == 0)
+        {
+            resolveWaiter(&res, &res.waiters[i]);
+        }
+    }
+    releaseWaiters(&res);
+    while (registerWithoutSupertype(&res))
+    {
+        releaseWaiters(&res);
+    }
+
+    free(res.waiters);
+    free(res.entries);
+    free(res.released);
+    return true;
+}
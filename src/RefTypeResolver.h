@@ -0,0 +1,35 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef REFTYPERESOLVER_H
+#define REFTYPERESOLVER_H
+
+#include "NodesetLoader/NodesetLoader.h"
+#include "NodesetLoader/ReferenceService.h"
+
+struct NodeContainer;
+
+// Moves the unknown references of the node whose reference type is known to
+// the service by now into the hierachical and non hierachical references.
+// Returns false if unknown references are left.
+bool RefTypeResolver_classify(NL_ReferenceService *refService, NL_Node *node);
+
+// A reference type is registered at the service once its supertype is known,
+// otherwise it would be classified as non hierachical.
+bool RefTypeResolver_awaitsSupertype(NL_ReferenceService *refService,
+                                     const NL_Node *refType);
+
+// Resolves the reference types and nodes which wait for reference types of
+// the nodeset. They are indexed by the reference types they wait for,
+// registering a reference type releases exactly the waiting references, so
+// every reference is looked up a bounded number of times. A reference type is
+// registered as soon as its references and its supertype are known, those
+// whose supertype isn't part of the nodeset are registered at the end. The
+// references which are left can't be resolved, they stay unknown. Returns
+// false if out of memory.
+bool RefTypeResolver_resolve(NL_ReferenceService *refService,
+                             struct NodeContainer *refTypes,
+                             struct NodeContainer *nodes);
+
+#endif
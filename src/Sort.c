@@ -29,10 +29,18 @@ struct S_Node
     const UA_NodeId *id;
     struct S_Node *left, *right;
     int balance;
+    // the node has no hierarchical reference, the one to its ParentNodeId is
+    // added by resolveParents
+    bool awaitsParent;
+    // the references of the node to its waiting children have been looked up
+    bool childrenScanned;
     struct S_Node *qlink;
     struct S_Edge *edges;
     size_t edgeCount;
+    size_t level;
     NL_Node *data;
+    // reference of the parent to a waiting node
+    const NL_Reference *parentRef;
 };
 
 typedef struct S_Node S_Node;
@@ -43,13 +51,22 @@ struct SortContext
     S_Node *zeros;
     S_Node *root1;
     size_t keyCnt;
+    // nodes waiting for the reference to their ParentNodeId
+    S_Node **awaiting;
+    size_t awaitingSize;
+    size_t awaitingCapacity;
+    // graph nodes, edges and the references to the ParentNodeIds
+    size_t allocated;
+    // the graph is consumed by the sort, it can't be run twice
+    bool started;
 };
 
-static S_Node *new_node(const UA_NodeId *id)
+static S_Node *new_node(SortContext *ctx, const UA_NodeId *id)
 {
     S_Node *k = (S_Node *)calloc(1, sizeof(S_Node));
     if(!k)
         return NULL;
+    ctx->allocated += sizeof(S_Node);
 
     k->id = id;
     k->left = k->right = NULL;
@@ -63,14 +80,15 @@ static S_Node *new_node(const UA_NodeId *id)
 }
 
 static S_Node *
-search_node(S_Node *rootNode, const UA_NodeId *nodeId) {
+search_node(SortContext *ctx, const UA_NodeId *nodeId) {
+    S_Node *rootNode = ctx->root1;
     if(!rootNode)
         return NULL;
 
     S_Node *p, *q, *r, *s, *t;
 
     if(rootNode->right == NULL)
-        return (rootNode->right = new_node(nodeId));
+        return (rootNode->right = new_node(ctx, nodeId));
 
     t = rootNode;
     s = p = rootNode->right;
@@ -86,7 +104,7 @@ search_node(S_Node *rootNode, const UA_NodeId *nodeId) {
             q = p->right;
 
         if (q == NULL) {
-            q = new_node(nodeId);
+            q = new_node(ctx, nodeId);
             if (a == UA_ORDER_LESS)
                 p->left = q;
             else
@@ -177,14 +195,31 @@ search_node(S_Node *rootNode, const UA_NodeId *nodeId) {
     }
 }
 
+// lookup without adding the node
+static S_Node *find_node(SortContext *ctx, const UA_NodeId *nodeId)
+{
+    S_Node *p = ctx->root1->right;
+    while (p)
+    {
+        UA_Order a = UA_NodeId_order(nodeId, p->id);
+        if (a == UA_ORDER_EQ)
+        {
+            return p;
+        }
+        p = a == UA_ORDER_LESS ? p->left : p->right;
+    }
+    return NULL;
+}
+
 static void
-record_relation(S_Node *from, S_Node *to) {
+record_relation(SortContext *ctx, S_Node *from, S_Node *to) {
     if(UA_NodeId_equal(from->id, to->id))
         return;
 
     struct S_Edge *e = (S_Edge *)calloc(1, sizeof(S_Edge));
     if(!e)
         return;
+    ctx->allocated += sizeof(S_Edge);
 
     to->edgeCount++;
     e->dest = to;
@@ -243,7 +278,7 @@ static void walk_tree(SortContext *ctx, S_Node *rootNode,
 SortContext *Sort_init(void)
 {
     SortContext *ctx = (SortContext *)calloc(1, sizeof(SortContext));
-    ctx->root1 = new_node(NULL);
+    ctx->root1 = new_node(ctx, NULL);
     return ctx;
 }
 
@@ -272,84 +307,164 @@ static void cleanupSubtree(S_Node *n)
 
 void Sort_cleanup(SortContext *ctx)
 {
+    if (!ctx)
+    {
+        return;
+    }
     if (ctx->root1)
     {
         cleanupSubtree(ctx->root1);
     }
+    free(ctx->awaiting);
     free(ctx);
 }
 
+size_t Sort_memoryUsage(const SortContext *ctx)
+{
+    if (!ctx)
+    {
+        return 0;
+    }
+    return sizeof(SortContext) + ctx->allocated;
+}
+
+// reserves the slot for a node which waits for its ParentNodeId reference
+static bool reserveAwaiting(SortContext *ctx)
+{
+    if (ctx->awaitingSize < ctx->awaitingCapacity)
+    {
+        return true;
+    }
+    size_t capacity = ctx->awaitingCapacity ? ctx->awaitingCapacity * 2 : 1024;
+    S_Node **awaiting =
+        (S_Node **)realloc(ctx->awaiting, capacity * sizeof(S_Node *));
+    if (!awaiting)
+    {
+        return false;
+    }
+    ctx->allocated += (capacity - ctx->awaitingCapacity) * sizeof(S_Node *);
+    ctx->awaiting = awaiting;
+    ctx->awaitingCapacity = capacity;
+    return true;
+}
+
 bool Sort_addNode(SortContext *ctx, NL_Node *data) {
     S_Node *j = NULL;
     // add node, no matter if there are references on it
-    j = search_node(ctx->root1, &data->id);
+    j = search_node(ctx, &data->id);
     // entry already exists
     if(j->data!=NULL)
     {
         return false;
     }
+    // the reference to the ParentNodeId is added by resolveParents, if the
+    // node doesn't have a hierachical ref already
+    bool awaitsParent = !data->hierachicalRefs &&
+                        NodesetLoader_isInstanceNode(data) &&
+                        !UA_NodeId_isNull(&((NL_InstanceNode *)data)->parentNodeId);
+    // the node would lose its ParentNodeId reference otherwise, nothing is
+    // recorded then
+    if (awaitsParent && !reserveAwaiting(ctx))
+    {
+        return false;
+    }
     j->data = data;
     NL_Reference *hierachicalRef = data->hierachicalRefs;
-    bool hierachicalRefRecorded = false;
-    if (hierachicalRef) {
-        while (hierachicalRef) {
-            S_Node *k = search_node(ctx->root1, &hierachicalRef->target);
-            if (!hierachicalRef->isForward) {
-                record_relation(k, j);
-            } else {
-                record_relation(j, k);
-            }
-            hierachicalRef = hierachicalRef->next;
-            hierachicalRefRecorded = true;
+    while (hierachicalRef) {
+        S_Node *k = search_node(ctx, &hierachicalRef->target);
+        if (!hierachicalRef->isForward) {
+            record_relation(ctx, k, j);
+        } else {
+            record_relation(ctx, j, k);
         }
+        hierachicalRef = hierachicalRef->next;
     }
-    // add reference generated by ParentNodeId, if dont have already a hierachical ref
-    if (!hierachicalRefRecorded && NodesetLoader_isInstanceNode(data)) {
-        NL_InstanceNode *instanceNode = (NL_InstanceNode *)data;
-        if(UA_NodeId_equal(&instanceNode->parentNodeId, &UA_NODEID_NULL))
-        {
-            return true;
-        }
+    if (awaitsParent)
+    {
+        j->awaitsParent = true;
+        ctx->awaiting[ctx->awaitingSize++] = j;
+    }
+    return true;
+}
 
-        S_Node *k = search_node(ctx->root1, &instanceNode->parentNodeId);
-        
-        //to we already have a reference for the node parentNode?
-        //parent references
-        bool refTypeFound = false;
-        if (k->data) {
-            NL_Reference *r = k->data->hierachicalRefs;
-            while (r) {
-                if (UA_NodeId_equal(&r->target, &data->id)) 
-                {
-                    NL_Reference *newRef = (NL_Reference *)calloc(1, sizeof(NL_Reference));
-                    newRef->isForward = !r->isForward;
-                    UA_NodeId_copy(&k->data->id, &newRef->target);
-                    UA_NodeId_copy(&r->refType, &newRef->refType);
-                    newRef->next = data->hierachicalRefs;
-                    data->hierachicalRefs = newRef;
-                    refTypeFound = true;
-                    break;
-                }
-                r = r->next;
-            }
+static void addParentRef(SortContext *ctx, S_Node *k)
+{
+    NL_InstanceNode *node = (NL_InstanceNode *)k->data;
+    // removed by an import filter in the meantime
+    if (UA_NodeId_isNull(&node->parentNodeId))
+    {
+        return;
+    }
+    NL_Reference *newRef = (NL_Reference *)calloc(1, sizeof(NL_Reference));
+    if (!newRef)
+    {
+        return;
+    }
+    ctx->allocated += sizeof(NL_Reference);
+    UA_NodeId_copy(&node->parentNodeId, &newRef->target);
+    if (k->parentRef)
+    {
+        newRef->isForward = !k->parentRef->isForward;
+        UA_NodeId_copy(&k->parentRef->refType, &newRef->refType);
+    }
+    else
+    {
+        newRef->isForward = false;
+        newRef->refType = UA_NODEID_NUMERIC(0, NL_HASCOMPONENT_ID);
+    }
+    newRef->next = node->hierachicalRefs;
+    node->hierachicalRefs = newRef;
+}
+
+// Adds the references to the ParentNodeIds of the waiting nodes. If the parent
+// has a hierachical reference to the node, its reference type is used,
+// otherwise HasComponent. The references of every parent are walked once, no
+// matter how many children it has.
+static void resolveParents(SortContext *ctx)
+{
+    for (size_t i = 0; i < ctx->awaitingSize; i++)
+    {
+        const NL_InstanceNode *node =
+            (const NL_InstanceNode *)ctx->awaiting[i]->data;
+        S_Node *parent = find_node(ctx, &node->parentNodeId);
+        if (!parent || !parent->data || parent->childrenScanned)
+        {
+            continue;
         }
-        if(!refTypeFound)
+        parent->childrenScanned = true;
+        for (const NL_Reference *r = parent->data->hierachicalRefs; r;
+             r = r->next)
         {
-            NL_Reference *newRef =
-            (NL_Reference *)calloc(1, sizeof(NL_Reference));
-            newRef->isForward = false;
-            UA_NodeId_copy(&instanceNode->parentNodeId, &newRef->target);
-            newRef->refType = UA_NODEID_NUMERIC(0, NL_HASCOMPONENT_ID);
-            newRef->next = data->hierachicalRefs;
-            data->hierachicalRefs = newRef;
+            S_Node *k = find_node(ctx, &r->target);
+            if (k && k->awaitsParent && !k->parentRef &&
+                UA_NodeId_equal(
+                    &((const NL_InstanceNode *)k->data)->parentNodeId,
+                    parent->id))
+            {
+                k->parentRef = r;
+            }
         }
     }
-    return true;
+    for (size_t i = 0; i < ctx->awaitingSize; i++)
+    {
+        addParentRef(ctx, ctx->awaiting[i]);
+    }
+    free(ctx->awaiting);
+    ctx->allocated -= ctx->awaitingCapacity * sizeof(S_Node *);
+    ctx->awaiting = NULL;
+    ctx->awaitingSize = 0;
+    ctx->awaitingCapacity = 0;
 }
 
 bool Sort_start(SortContext *ctx, struct Nodeset *nodeset,
                 Sort_SortedNodeCallback callback, NodesetLoader_Logger *logger)
 {
+    if (ctx->started)
+    {
+        return false;
+    }
+    ctx->started = true;
+    resolveParents(ctx);
     walk_tree(ctx, ctx->root1, count_items);
 
     while (ctx->keyCnt > 0)
@@ -360,16 +475,25 @@ bool Sort_start(SortContext *ctx, struct Nodeset *nodeset,
         {
             S_Edge *e = ctx->head->edges;
 
-            if (ctx->head->data != NULL)
+            if (ctx->head->data != NULL &&
+                !callback(nodeset, ctx->head->data, ctx->head->level))
             {
-                callback(nodeset, ctx->head->data);
+                return false;
             }
+            // referenced nodes which are not part of the nodeset don't
+            // count as level
+            size_t nextLevel =
+                ctx->head->level + (ctx->head->data != NULL ? 1 : 0);
 
             ctx->head->id = NULL;
             ctx->keyCnt--;
 
             while (e)
             {
+                if (e->dest->level < nextLevel)
+                {
+                    e->dest->level = nextLevel;
+                }
                 e->dest->edgeCount--;
                 if (e->dest->edgeCount == 0)
                 {
@@ -392,3 +516,25 @@ bool Sort_start(SortContext *ctx, struct Nodeset *nodeset,
     }
     return true;
 }
+
+static void visitUnsorted(S_Node *k, void *context,
+                          Sort_UnsortedNodeCallback callback)
+{
+    if (!k)
+    {
+        return;
+    }
+    visitUnsorted(k->left, context, callback);
+    // sorted nodes have their id removed
+    if (k->id && k->data)
+    {
+        callback(context, k->data);
+    }
+    visitUnsorted(k->right, context, callback);
+}
+
+void Sort_forEachUnsorted(SortContext *ctx, void *context,
+                          Sort_UnsortedNodeCallback callback)
+{
+    visitUnsorted(ctx->root1->right, context, callback);
+}
@@ -22,9 +22,18 @@ struct NodesetLoader_Logger;
 typedef struct SortContext SortContext;
 SortContext* Sort_init(void);
 void Sort_cleanup(SortContext * ctx);
+// returns false if the node was added before or on out of memory, the node
+// isn't part of the sort then
 bool Sort_addNode(SortContext* ctx, struct NL_Node *node);
-typedef void (*Sort_SortedNodeCallback)(struct Nodeset *nodeset, struct NL_Node *node);
+size_t Sort_memoryUsage(const SortContext *ctx);
+// level is the length of the longest dependency chain which leads to the node,
+// nodes of the same level don't depend on each other, returning false aborts
+// the sort
+typedef bool (*Sort_SortedNodeCallback)(struct Nodeset *nodeset, struct NL_Node *node, size_t level);
 bool Sort_start(SortContext* ctx, struct Nodeset *nodeset, Sort_SortedNodeCallback callback, struct NodesetLoader_Logger* logger);
+// after a failed sort, the nodes which are part of a cycle or depend on one
+typedef void (*Sort_UnsortedNodeCallback)(void *context, struct NL_Node *node);
+void Sort_forEachUnsorted(SortContext *ctx, void *context, Sort_UnsortedNodeCallback callback);
 
 #ifdef __cplusplus
 }
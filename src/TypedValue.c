@@ -0,0 +1,538 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "TypedValue.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// deeper values are skipped, nodesets don't come close to it
+#define TYPEDVALUE_MAX_DEPTH 32
+#define TYPEDVALUE_MAX_TYPE_DEPTH 8
+
+typedef enum
+{
+    FRAME_ROOT,
+    FRAME_ARRAY,
+    FRAME_EXTENSIONOBJECT,
+    FRAME_BODY,
+    // an element with the encoding of type, e.g. <LocalizedText>
+    FRAME_VALUE,
+    // an element whose text is the encoding of type, e.g. <Identifier>
+    FRAME_TEXT
+} FrameKind;
+
+typedef struct
+{
+    FrameKind kind;
+    const UA_DataType *type;
+    void *mem;
+    // arrays only
+    size_t *length;
+    void **data;
+} Frame;
+
+struct TypedValue
+{
+    const NamespaceList *namespaces;
+    const UA_DataType *type;
+    Frame frames[TYPEDVALUE_MAX_DEPTH];
+    size_t depth;
+    // depth below an element which is not part of the type
+    size_t skipDepth;
+    bool hasValue;
+    bool isArray;
+    void *scalar;
+    void *array;
+    size_t length;
+    size_t memory;
+};
+
+static bool isSupported(const UA_DataType *type, size_t depth)
+{
+    if (!type || depth > TYPEDVALUE_MAX_TYPE_DEPTH)
+    {
+        return false;
+    }
+    switch (type->typeKind)
+    {
+    case UA_DATATYPEKIND_BOOLEAN:
+    case UA_DATATYPEKIND_SBYTE:
+    case UA_DATATYPEKIND_BYTE:
+    case UA_DATATYPEKIND_INT16:
+    case UA_DATATYPEKIND_UINT16:
+    case UA_DATATYPEKIND_INT32:
+    case UA_DATATYPEKIND_UINT32:
+    case UA_DATATYPEKIND_INT64:
+    case UA_DATATYPEKIND_UINT64:
+    case UA_DATATYPEKIND_FLOAT:
+    case UA_DATATYPEKIND_DOUBLE:
+    case UA_DATATYPEKIND_STRING:
+    case UA_DATATYPEKIND_DATETIME:
+    case UA_DATATYPEKIND_GUID:
+    case UA_DATATYPEKIND_BYTESTRING:
+    case UA_DATATYPEKIND_NODEID:
+    case UA_DATATYPEKIND_STATUSCODE:
+    case UA_DATATYPEKIND_QUALIFIEDNAME:
+    case UA_DATATYPEKIND_LOCALIZEDTEXT:
+    case UA_DATATYPEKIND_ENUM:
+        return true;
+    case UA_DATATYPEKIND_STRUCTURE:
+        for (size_t i = 0; i < type->membersSize; i++)
+        {
+            const UA_DataTypeMember *m = &type->members[i];
+            if (m->isOptional || !isSupported(m->memberType, depth + 1))
+            {
+                return false;
+            }
+        }
+        return true;
+    default:
+        // variants, unions, ... are left to the NL_Data tree
+        return false;
+    }
+}
+
+const UA_DataType *TypedValue_findType(const UA_NodeId *dataTypeId)
+{
+    // the custom types are only known after the import of the datatypes
+    if (dataTypeId->namespaceIndex != 0)
+    {
+        return NULL;
+    }
+    const UA_DataType *type = UA_findDataType(dataTypeId);
+    return isSupported(type, 0) ? type : NULL;
+}
+
+TypedValue *TypedValue_new(const NamespaceList *namespaces)
+{
+    TypedValue *tv = (TypedValue *)calloc(1, sizeof(TypedValue));
+    if (!tv)
+    {
+        return NULL;
+    }
+    tv->namespaces = namespaces;
+    return tv;
+}
+
+static void clearValue(TypedValue *tv)
+{
+    if (tv->scalar)
+    {
+        UA_delete(tv->scalar, tv->type);
+    }
+    if (tv->array)
+    {
+        UA_Array_delete(tv->array, tv->length, tv->type);
+    }
+    tv->scalar = NULL;
+    tv->array = NULL;
+    tv->length = 0;
+    tv->hasValue = false;
+    tv->isArray = false;
+    tv->memory = 0;
+}
+
+void TypedValue_begin(TypedValue *tv, const UA_DataType *type)
+{
+    clearValue(tv);
+    tv->type = type;
+    tv->skipDepth = 0;
+    tv->depth = 1;
+    memset(&tv->frames[0], 0, sizeof(Frame));
+    tv->frames[0].kind = FRAME_ROOT;
+    tv->frames[0].type = type;
+}
+
+static void *allocate(TypedValue *tv, size_t size)
+{
+    void *mem = calloc(1, size);
+    if (mem)
+    {
+        tv->memory += size;
+    }
+    return mem;
+}
+
+static void *appendElement(TypedValue *tv, const Frame *array)
+{
+    size_t size = array->type->memSize;
+    void *data = realloc(*array->data, (*array->length + 1) * size);
+    if (!data)
+    {
+        return NULL;
+    }
+    void *element = (char *)data + *array->length * size;
+    memset(element, 0, size);
+    *array->data = data;
+    (*array->length)++;
+    tv->memory += size;
+    return element;
+}
+
+static Frame newFrame(FrameKind kind, const UA_DataType *type, void *mem)
+{
+    Frame frame;
+    memset(&frame, 0, sizeof(Frame));
+    frame.kind = kind;
+    frame.type = type;
+    frame.mem = mem;
+    return frame;
+}
+
+static Frame newArrayFrame(const UA_DataType *type, size_t *length,
+                           void **data)
+{
+    Frame frame = newFrame(FRAME_ARRAY, type, NULL);
+    frame.length = length;
+    frame.data = data;
+    return frame;
+}
+
+// element of a scalar or an array element
+static Frame newElementFrame(const UA_DataType *type, void *mem,
+                             const char *name)
+{
+    if (!strcmp(name, "ExtensionObject"))
+    {
+        return newFrame(FRAME_EXTENSIONOBJECT, type, mem);
+    }
+    return newFrame(FRAME_VALUE, type, mem);
+}
+
+static bool newMemberFrame(const Frame *parent, const char *name, Frame *out)
+{
+    switch (parent->type->typeKind)
+    {
+    case UA_DATATYPEKIND_LOCALIZEDTEXT:
+    {
+        UA_LocalizedText *lt = (UA_LocalizedText *)parent->mem;
+        if (!strcmp(name, "Locale"))
+        {
+            *out = newFrame(FRAME_TEXT, &UA_TYPES[UA_TYPES_STRING], &lt->locale);
+            return true;
+        }
+        if (!strcmp(name, "Text"))
+        {
+            *out = newFrame(FRAME_TEXT, &UA_TYPES[UA_TYPES_STRING], &lt->text);
+            return true;
+        }
+        return false;
+    }
+    case UA_DATATYPEKIND_QUALIFIEDNAME:
+    {
+        UA_QualifiedName *qn = (UA_QualifiedName *)parent->mem;
+        if (!strcmp(name, "NamespaceIndex"))
+        {
+            *out = newFrame(FRAME_TEXT, &UA_TYPES[UA_TYPES_UINT16],
+                            &qn->namespaceIndex);
+            return true;
+        }
+        if (!strcmp(name, "Name"))
+        {
+            *out = newFrame(FRAME_TEXT, &UA_TYPES[UA_TYPES_STRING], &qn->name);
+            return true;
+        }
+        return false;
+    }
+    case UA_DATATYPEKIND_NODEID:
+        *out = newFrame(FRAME_TEXT, parent->type, parent->mem);
+        return !strcmp(name, "Identifier");
+    case UA_DATATYPEKIND_GUID:
+        *out = newFrame(FRAME_TEXT, parent->type, parent->mem);
+        return !strcmp(name, "String");
+    case UA_DATATYPEKIND_STATUSCODE:
+        *out = newFrame(FRAME_TEXT, parent->type, parent->mem);
+        return !strcmp(name, "Code");
+    case UA_DATATYPEKIND_STRUCTURE:
+    {
+        // same layout as the open62541 types, an array member is stored as
+        // its length followed by the pointer to the elements
+        uintptr_t adr = (uintptr_t)parent->mem;
+        for (size_t i = 0; i < parent->type->membersSize; i++)
+        {
+            const UA_DataTypeMember *m = &parent->type->members[i];
+            adr += m->padding;
+            if (!strcmp(m->memberName, name))
+            {
+                if (m->isArray)
+                {
+                    *out = newArrayFrame(m->memberType, (size_t *)adr,
+                                         (void **)(adr + sizeof(size_t)));
+                }
+                else
+                {
+                    *out = newFrame(FRAME_VALUE, m->memberType, (void *)adr);
+                }
+                return true;
+            }
+            adr += m->isArray ? sizeof(size_t) + sizeof(void *)
+                              : m->memberType->memSize;
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+void TypedValue_start(TypedValue *tv, const char *name)
+{
+    if (tv->skipDepth > 0 || tv->depth == TYPEDVALUE_MAX_DEPTH)
+    {
+        tv->skipDepth++;
+        return;
+    }
+    const Frame *parent = &tv->frames[tv->depth - 1];
+    Frame frame = newFrame(FRAME_TEXT, NULL, NULL);
+    bool known = true;
+    switch (parent->kind)
+    {
+    case FRAME_ROOT:
+        if (tv->hasValue)
+        {
+            known = false;
+            break;
+        }
+        tv->hasValue = true;
+        if (!strncmp(name, "ListOf", strlen("ListOf")))
+        {
+            tv->isArray = true;
+            frame = newArrayFrame(tv->type, &tv->length, &tv->array);
+            break;
+        }
+        tv->scalar = allocate(tv, tv->type->memSize);
+        known = tv->scalar != NULL;
+        frame = newElementFrame(tv->type, tv->scalar, name);
+        break;
+    case FRAME_ARRAY:
+    {
+        void *element = appendElement(tv, parent);
+        known = element != NULL;
+        frame = newElementFrame(parent->type, element, name);
+        break;
+    }
+    case FRAME_EXTENSIONOBJECT:
+        // the TypeId is given by the data type of the variable
+        known = !strcmp(name, "Body");
+        frame = newFrame(FRAME_BODY, parent->type, parent->mem);
+        break;
+    case FRAME_BODY:
+        frame = newFrame(FRAME_VALUE, parent->type, parent->mem);
+        break;
+    case FRAME_VALUE:
+        known = newMemberFrame(parent, name, &frame);
+        break;
+    case FRAME_TEXT:
+    default:
+        known = false;
+        break;
+    }
+    if (!known)
+    {
+        tv->skipDepth++;
+        return;
+    }
+    tv->frames[tv->depth++] = frame;
+}
+
+static bool isOnlyWhitespace(const char *text)
+{
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (!isspace((unsigned char)*c))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static UA_UInt16 translateIndex(const TypedValue *tv, UA_UInt16 idx)
+{
+    if (idx == 0 || !tv->namespaces)
+    {
+        return idx;
+    }
+    const Namespace *ns = NamespaceList_getNamespace(tv->namespaces, idx);
+    return ns ? ns->idx : idx;
+}
+
+static void setString(TypedValue *tv, UA_String *s, const char *text)
+{
+    size_t length = strlen(text);
+    s->data = (UA_Byte *)allocate(tv, length);
+    if (s->data)
+    {
+        memcpy(s->data, text, length);
+        s->length = length;
+    }
+}
+
+static UA_DateTime parseDateTime(const char *text)
+{
+    UA_DateTimeStruct dt;
+    memset(&dt, 0, sizeof(UA_DateTimeStruct));
+    sscanf(text, "%hi-%hu-%huT%hu:%hu:%huZ", &dt.year, &dt.month, &dt.day,
+           &dt.hour, &dt.min, &dt.sec);
+    return UA_DateTime_fromStruct(dt);
+}
+
+static void setText(TypedValue *tv, const UA_DataType *type, void *mem,
+                    const char *text)
+{
+    if (!text || isOnlyWhitespace(text))
+    {
+        return;
+    }
+    UA_String str = UA_STRING((char *)(uintptr_t)text);
+    switch (type->typeKind)
+    {
+    case UA_DATATYPEKIND_BOOLEAN:
+        *(UA_Boolean *)mem = !strcmp(text, "true");
+        break;
+    case UA_DATATYPEKIND_SBYTE:
+        *(UA_SByte *)mem = (UA_SByte)strtol(text, NULL, 10);
+        break;
+    case UA_DATATYPEKIND_BYTE:
+        *(UA_Byte *)mem = (UA_Byte)strtoul(text, NULL, 10);
+        break;
+    case UA_DATATYPEKIND_INT16:
+        *(UA_Int16 *)mem = (UA_Int16)strtol(text, NULL, 10);
+        break;
+    case UA_DATATYPEKIND_UINT16:
+        *(UA_UInt16 *)mem = (UA_UInt16)strtoul(text, NULL, 10);
+        break;
+    case UA_DATATYPEKIND_INT32:
+        *(UA_Int32 *)mem = (UA_Int32)strtol(text, NULL, 10);
+        break;
+    case UA_DATATYPEKIND_UINT32:
+    case UA_DATATYPEKIND_STATUSCODE:
+        *(UA_UInt32 *)mem = (UA_UInt32)strtoul(text, NULL, 0);
+        break;
+    case UA_DATATYPEKIND_INT64:
+        *(UA_Int64 *)mem = (UA_Int64)strtoll(text, NULL, 10);
+        break;
+    case UA_DATATYPEKIND_UINT64:
+        *(UA_UInt64 *)mem = (UA_UInt64)strtoull(text, NULL, 10);
+        break;
+    case UA_DATATYPEKIND_FLOAT:
+        *(UA_Float *)mem = strtof(text, NULL);
+        break;
+    case UA_DATATYPEKIND_DOUBLE:
+        *(UA_Double *)mem = strtod(text, NULL);
+        break;
+    case UA_DATATYPEKIND_ENUM:
+    {
+        // enum values are either given as <symbol>_<value> or <value>
+        const char *sep = strchr(text, '_');
+        *(UA_Int32 *)mem = (UA_Int32)strtol(sep ? sep + 1 : text, NULL, 10);
+        break;
+    }
+    case UA_DATATYPEKIND_STRING:
+        setString(tv, (UA_String *)mem, text);
+        break;
+    case UA_DATATYPEKIND_BYTESTRING:
+    {
+        UA_ByteString *bs = (UA_ByteString *)mem;
+        if (UA_ByteString_fromBase64(bs, &str) == UA_STATUSCODE_GOOD)
+        {
+            tv->memory += bs->length;
+        }
+        break;
+    }
+    case UA_DATATYPEKIND_DATETIME:
+        *(UA_DateTime *)mem = parseDateTime(text);
+        break;
+    case UA_DATATYPEKIND_GUID:
+        *(UA_Guid *)mem = UA_GUID(text);
+        break;
+    case UA_DATATYPEKIND_NODEID:
+    {
+        UA_NodeId *id = (UA_NodeId *)mem;
+        if (UA_NodeId_parse(id, str) == UA_STATUSCODE_GOOD)
+        {
+            id->namespaceIndex = translateIndex(tv, id->namespaceIndex);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void TypedValue_end(TypedValue *tv, const char *text)
+{
+    if (tv->skipDepth > 0)
+    {
+        tv->skipDepth--;
+        return;
+    }
+    if (tv->depth <= 1)
+    {
+        return;
+    }
+    const Frame *frame = &tv->frames[--tv->depth];
+    if (frame->kind == FRAME_TEXT)
+    {
+        setText(tv, frame->type, frame->mem, text);
+    }
+    else if (frame->kind == FRAME_VALUE)
+    {
+        if (frame->type->typeKind == UA_DATATYPEKIND_QUALIFIEDNAME)
+        {
+            UA_QualifiedName *qn = (UA_QualifiedName *)frame->mem;
+            qn->namespaceIndex = translateIndex(tv, qn->namespaceIndex);
+        }
+        else if (frame->type->typeKind != UA_DATATYPEKIND_LOCALIZEDTEXT &&
+                 frame->type->typeKind != UA_DATATYPEKIND_NODEID &&
+                 frame->type->typeKind != UA_DATATYPEKIND_GUID &&
+                 frame->type->typeKind != UA_DATATYPEKIND_STATUSCODE &&
+                 frame->type->typeKind != UA_DATATYPEKIND_STRUCTURE)
+        {
+            setText(tv, frame->type, frame->mem, text);
+        }
+    }
+}
+
+bool TypedValue_finish(TypedValue *tv, UA_Variant *out, bool *isArray)
+{
+    UA_Variant_init(out);
+    if (!tv->hasValue)
+    {
+        clearValue(tv);
+        return false;
+    }
+    if (tv->isArray)
+    {
+        UA_Variant_setArray(out, tv->array, tv->length, tv->type);
+    }
+    else
+    {
+        UA_Variant_setScalar(out, tv->scalar, tv->type);
+    }
+    *isArray = tv->isArray;
+    // the memory is owned by the variant now
+    tv->scalar = NULL;
+    tv->array = NULL;
+    clearValue(tv);
+    return true;
+}
+
+size_t TypedValue_memoryUsage(const TypedValue *tv)
+{
+    return tv->memory;
+}
+
+void TypedValue_delete(TypedValue *tv)
+{
+    if (!tv)
+    {
+        return;
+    }
+    clearValue(tv);
+    free(tv);
+}
@@ -0,0 +1,34 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef TYPEDVALUE_H
+#define TYPEDVALUE_H
+#include "NamespaceList.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Decodes the elements of a <Value> straight into the memory layout of a data
+// type of namespace 0, without building the NL_Data tree. One decoder is
+// reused for all values of a file.
+struct TypedValue;
+typedef struct TypedValue TypedValue;
+
+// returns NULL if the values of the data type can't be decoded directly
+const UA_DataType *TypedValue_findType(const UA_NodeId *dataTypeId);
+
+// namespaces translates the namespace indices of NodeIds and QualifiedNames,
+// may be NULL
+TypedValue *TypedValue_new(const NamespaceList *namespaces);
+// starts a new value of the given type, an unfinished value is discarded
+void TypedValue_begin(TypedValue *tv, const UA_DataType *type);
+void TypedValue_start(TypedValue *tv, const char *name);
+// text is the content of the element, NULL if there is none
+void TypedValue_end(TypedValue *tv, const char *text);
+// moves the decoded value into out, returns false if there was no value
+bool TypedValue_finish(TypedValue *tv, UA_Variant *out, bool *isArray);
+// heap memory of the current value
+size_t TypedValue_memoryUsage(const TypedValue *tv);
+void TypedValue_delete(TypedValue *tv);
+
+#endif
@@ -0,0 +1,532 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Validation.h"
+#include "NodeIndex.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Entry
+{
+    NL_Finding finding;
+    char *message;
+};
+
+struct Validation
+{
+    struct Entry *entries;
+    size_t size;
+    size_t capacity;
+    size_t messageBytes;
+};
+
+Validation *Validation_new(void)
+{
+    return (Validation *)calloc(1, sizeof(Validation));
+}
+
+void Validation_delete(Validation *validation)
+{
+    if (!validation)
+    {
+        return;
+    }
+    for (size_t i = 0; i < validation->size; i++)
+    {
+        UA_NodeId_clear(&validation->entries[i].finding.nodeId);
+        free(validation->entries[i].message);
+    }
+    free(validation->entries);
+    free(validation);
+}
+
+void Validation_add(Validation *validation, NL_Check check,
+                    const UA_NodeId *nodeId, const char *format, ...)
+{
+    if (!validation)
+    {
+        return;
+    }
+    if (validation->size == validation->capacity)
+    {
+        size_t capacity = validation->capacity ? validation->capacity * 2 : 16;
+        struct Entry *entries = (struct Entry *)realloc(
+            validation->entries, capacity * sizeof(struct Entry));
+        if (!entries)
+        {
+            return;
+        }
+        validation->entries = entries;
+        validation->capacity = capacity;
+    }
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (len < 0)
+    {
+        return;
+    }
+    char *message = (char *)malloc((size_t)len + 1);
+    if (!message)
+    {
+        return;
+    }
+    va_start(args, format);
+    vsnprintf(message, (size_t)len + 1, format, args);
+    va_end(args);
+
+    struct Entry *entry = &validation->entries[validation->size++];
+    entry->finding.check = check;
+    if (nodeId)
+    {
+        UA_NodeId_copy(nodeId, &entry->finding.nodeId);
+    }
+    else
+    {
+        UA_NodeId_init(&entry->finding.nodeId);
+    }
+    entry->message = message;
+    entry->finding.message = message;
+    validation->messageBytes += (size_t)len + 1;
+}
+
+void Validation_printNodeId(const UA_NodeId *id, char *buf, size_t size)
+{
+    UA_String s = {0, NULL};
+    if (UA_NodeId_print(id, &s) != UA_STATUSCODE_GOOD)
+    {
+        snprintf(buf, size, "?");
+        return;
+    }
+    snprintf(buf, size, "%.*s", (int)s.length, (char *)s.data);
+    UA_String_clear(&s);
+}
+
+size_t Validation_forEach(const Validation *validation, void *context,
+                          NodesetLoader_Finding_Func fn)
+{
+    if (!validation)
+    {
+        return 0;
+    }
+    for (size_t i = 0; fn && i < validation->size; i++)
+    {
+        fn(context, &validation->entries[i].finding);
+    }
+    return validation->size;
+}
+
+size_t Validation_memoryUsage(const Validation *validation)
+{
+    if (!validation)
+    {
+        return 0;
+    }
+    return sizeof(Validation) + validation->capacity * sizeof(struct Entry) +
+           validation->messageBytes;
+}
+
+#define ID_LENGTH 128
+
+struct NodeCheck
+{
+    Validation *validation;
+    const NodeIndex *index;
+    // a bit per namespace index with at least one imported node
+    unsigned char *namespaces;
+};
+
+static void markNamespace(void *context, NL_Node *node)
+{
+    struct NodeCheck *c = (struct NodeCheck *)context;
+    if (UA_NodeId_isNull(&node->id))
+    {
+        return;
+    }
+    c->namespaces[node->id.namespaceIndex / 8] |=
+        (unsigned char)(1u << (node->id.namespaceIndex % 8));
+}
+
+// the node should be part of the nodesets but isn't
+static bool isMissing(const struct NodeCheck *c, const UA_NodeId *id)
+{
+    if (UA_NodeId_isNull(id))
+    {
+        return false;
+    }
+    if (!(c->namespaces[id->namespaceIndex / 8] &
+          (1u << (id->namespaceIndex % 8))))
+    {
+        return false;
+    }
+    return !NodeIndex_get(c->index, id);
+}
+
+static void checkReferences(struct NodeCheck *c, const NL_Node *node,
+                            const NL_Reference *ref, bool classified)
+{
+    char target[ID_LENGTH];
+    char refType[ID_LENGTH];
+    for (; ref; ref = ref->next)
+    {
+        if (isMissing(c, &ref->target))
+        {
+            Validation_printNodeId(&ref->target, target, sizeof(target));
+            Validation_printNodeId(&ref->refType, refType, sizeof(refType));
+            Validation_add(c->validation, NL_CHECK_DANGLING_REFERENCE,
+                           &node->id,
+                           "reference of type %s to %s which doesn't exist",
+                           refType, target);
+        }
+        // the unclassified references are reported by the sort
+        if (!classified || UA_NodeId_isNull(&ref->refType))
+        {
+            continue;
+        }
+        const NL_Node *type = NodeIndex_get(c->index, &ref->refType);
+        if (type && type->nodeClass != NODECLASS_REFERENCETYPE)
+        {
+            Validation_printNodeId(&ref->refType, refType, sizeof(refType));
+            Validation_add(c->validation, NL_CHECK_UNKNOWN_REFERENCETYPE,
+                           &node->id, "reference type %s is a %s", refType,
+                           NL_NODECLASS_NAME[type->nodeClass]);
+        }
+        else if (isMissing(c, &ref->refType))
+        {
+            Validation_printNodeId(&ref->refType, refType, sizeof(refType));
+            Validation_add(c->validation, NL_CHECK_UNKNOWN_REFERENCETYPE,
+                           &node->id, "reference type %s doesn't exist",
+                           refType);
+        }
+    }
+}
+
+static void checkTypeDefinition(struct NodeCheck *c, const NL_Node *node,
+                                const NL_Reference *ref,
+                                NL_NodeClass typeClass)
+{
+    if (!ref)
+    {
+        Validation_add(c->validation, NL_CHECK_MISSING_TYPEDEFINITION,
+                       &node->id, "%s without type definition",
+                       NL_NODECLASS_NAME[node->nodeClass]);
+        return;
+    }
+    char id[ID_LENGTH];
+    const NL_Node *type = NodeIndex_get(c->index, &ref->target);
+    if (type && type->nodeClass != typeClass)
+    {
+        Validation_printNodeId(&ref->target, id, sizeof(id));
+        Validation_add(c->validation, NL_CHECK_MISSING_TYPEDEFINITION,
+                       &node->id, "type definition %s is a %s", id,
+                       NL_NODECLASS_NAME[type->nodeClass]);
+    }
+    else if (isMissing(c, &ref->target))
+    {
+        Validation_printNodeId(&ref->target, id, sizeof(id));
+        Validation_add(c->validation, NL_CHECK_MISSING_TYPEDEFINITION,
+                       &node->id, "type definition %s doesn't exist", id);
+    }
+}
+
+static void checkDataType(struct NodeCheck *c, const NL_Node *node,
+                          const UA_NodeId *dataType)
+{
+    char id[ID_LENGTH];
+    const NL_Node *type = NodeIndex_get(c->index, dataType);
+    if (type && type->nodeClass != NODECLASS_DATATYPE)
+    {
+        Validation_printNodeId(dataType, id, sizeof(id));
+        Validation_add(c->validation, NL_CHECK_MISSING_DATATYPE, &node->id,
+                       "data type %s is a %s", id,
+                       NL_NODECLASS_NAME[type->nodeClass]);
+    }
+    else if (isMissing(c, dataType))
+    {
+        Validation_printNodeId(dataType, id, sizeof(id));
+        Validation_add(c->validation, NL_CHECK_MISSING_DATATYPE, &node->id,
+                       "data type %s doesn't exist", id);
+    }
+}
+
+// names of the builtin types, indexed by the id of their data type node
+#define BUILTIN_COUNT 26
+static const char *builtinNames[BUILTIN_COUNT] = {
+    NULL,         "Boolean",        "SByte",      "Byte",
+    "Int16",      "UInt16",         "Int32",      "UInt32",
+    "Int64",      "UInt64",         "Float",      "Double",
+    "String",     "DateTime",       "Guid",       "ByteString",
+    "XmlElement", "NodeId",         "ExpandedNodeId", "StatusCode",
+    "QualifiedName", "LocalizedText", "ExtensionObject", "DataValue",
+    "Variant",    "DiagnosticInfo"};
+
+#define DATATYPE_STRUCTURE 22
+#define DATATYPE_BASEDATATYPE 24
+#define DATATYPE_NUMBER 26
+#define DATATYPE_INTEGER 27
+#define DATATYPE_UINTEGER 28
+#define DATATYPE_ENUMERATION 29
+
+static UA_UInt32 builtinId(const char *name)
+{
+    for (UA_UInt32 i = 1; name && i < BUILTIN_COUNT; i++)
+    {
+        if (!strcmp(builtinNames[i], name))
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// only the data types of namespace 0 with a known encoding are checked
+static bool isCompatible(const UA_NodeId *dataType, UA_UInt32 valueType)
+{
+    // an unknown data type has been reported while parsing
+    if (!valueType || UA_NodeId_isNull(dataType) ||
+        dataType->namespaceIndex != 0 ||
+        dataType->identifierType != UA_NODEIDTYPE_NUMERIC)
+    {
+        return true;
+    }
+    UA_UInt32 id = dataType->identifier.numeric;
+    if (id < DATATYPE_STRUCTURE)
+    {
+        return id == valueType;
+    }
+    switch (id)
+    {
+    case DATATYPE_STRUCTURE:
+        return valueType == DATATYPE_STRUCTURE;
+    case DATATYPE_NUMBER:
+        return valueType >= 2 && valueType <= 11;
+    case DATATYPE_INTEGER:
+        return valueType == 2 || valueType == 4 || valueType == 6 ||
+               valueType == 8;
+    case DATATYPE_UINTEGER:
+        return valueType == 3 || valueType == 5 || valueType == 7 ||
+               valueType == 9;
+    case DATATYPE_ENUMERATION:
+        return valueType == 6;
+    default:
+        return true;
+    }
+}
+
+static bool isEnd(const char *end)
+{
+    while (isspace((unsigned char)*end))
+    {
+        end++;
+    }
+    return *end == '\0';
+}
+
+static bool isSigned(const char *s, long long min, long long max)
+{
+    char *end = NULL;
+    errno = 0;
+    long long v = strtoll(s, &end, 10);
+    return end != s && !errno && isEnd(end) && v >= min && v <= max;
+}
+
+static bool isUnsigned(const char *s, unsigned long long max)
+{
+    while (isspace((unsigned char)*s))
+    {
+        s++;
+    }
+    if (*s == '-')
+    {
+        return false;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    return end != s && !errno && isEnd(end) && v <= max;
+}
+
+static bool isValidPrimitive(UA_UInt32 type, const char *s)
+{
+    if (!s)
+    {
+        // empty elements decode to the default value
+        return true;
+    }
+    char *end = NULL;
+    switch (type)
+    {
+    case 1:
+        while (isspace((unsigned char)*s))
+        {
+            s++;
+        }
+        return (!strncmp(s, "true", 4) && isEnd(s + 4)) ||
+               (!strncmp(s, "false", 5) && isEnd(s + 5)) ||
+               ((*s == '0' || *s == '1') && isEnd(s + 1));
+    case 2:
+        return isSigned(s, -128, 127);
+    case 3:
+        return isUnsigned(s, 255);
+    case 4:
+        return isSigned(s, -32768, 32767);
+    case 5:
+        return isUnsigned(s, 65535);
+    case 6:
+        return isSigned(s, -2147483647LL - 1, 2147483647LL);
+    case 7:
+        return isUnsigned(s, 4294967295ULL);
+    case 8:
+        return isSigned(s, -9223372036854775807LL - 1, 9223372036854775807LL);
+    case 9:
+        return isUnsigned(s, 18446744073709551615ULL);
+    case 10:
+    case 11:
+        strtod(s, &end);
+        return end != s && isEnd(end);
+    default:
+        return true;
+    }
+}
+
+static void checkPrimitive(struct NodeCheck *c, const NL_Node *node,
+                           UA_UInt32 type, const NL_Data *data)
+{
+    if (data->type != DATATYPE_PRIMITIVE ||
+        isValidPrimitive(type, data->val.primitiveData.value))
+    {
+        return;
+    }
+    Validation_add(c->validation, NL_CHECK_VALUE_TYPE, &node->id,
+                   "'%.64s' is no valid %s", data->val.primitiveData.value,
+                   builtinNames[type]);
+}
+
+static void checkValue(struct NodeCheck *c, const NL_VariableNode *node)
+{
+    const NL_Value *value = node->value;
+    const char *typeName = value->type;
+    if (value->isExtensionObject)
+    {
+        typeName = builtinNames[DATATYPE_STRUCTURE];
+    }
+    else if (value->isArray)
+    {
+        // the name of an empty list is the only hint of its type
+        typeName = value->data && !strncmp(value->data->name, "ListOf", 6)
+                       ? value->data->name + 6
+                       : NULL;
+    }
+    if (node->valueRank)
+    {
+        int valueRank = atoi(node->valueRank);
+        if (valueRank == -1 && value->isArray)
+        {
+            Validation_add(c->validation, NL_CHECK_VALUE_TYPE, &node->id,
+                           "array value for ValueRank -1");
+        }
+        else if (valueRank >= 0 && !value->isArray)
+        {
+            Validation_add(c->validation, NL_CHECK_VALUE_TYPE, &node->id,
+                           "scalar value for ValueRank %d", valueRank);
+        }
+    }
+    UA_UInt32 type = builtinId(typeName);
+    if (!isCompatible(&node->datatype, type))
+    {
+        char id[ID_LENGTH];
+        Validation_printNodeId(&node->datatype, id, sizeof(id));
+        Validation_add(c->validation, NL_CHECK_VALUE_TYPE, &node->id,
+                       "%s value for data type %s", typeName, id);
+    }
+    if (!type || value->isExtensionObject || !value->data)
+    {
+        return;
+    }
+    if (!value->isArray)
+    {
+        checkPrimitive(c, (const NL_Node *)node, type, value->data);
+        return;
+    }
+    if (value->data->type != DATATYPE_COMPLEX)
+    {
+        return;
+    }
+    for (size_t i = 0; i < value->data->val.complexData.membersSize; i++)
+    {
+        checkPrimitive(c, (const NL_Node *)node, type,
+                       value->data->val.complexData.members[i]);
+    }
+}
+
+static void checkNode(void *context, NL_Node *node)
+{
+    struct NodeCheck *c = (struct NodeCheck *)context;
+    checkReferences(c, node, node->hierachicalRefs, true);
+    checkReferences(c, node, node->nonHierachicalRefs, true);
+    checkReferences(c, node, node->unknownRefs, false);
+    if (NodesetLoader_isInstanceNode(node) &&
+        isMissing(c, &((NL_InstanceNode *)node)->parentNodeId))
+    {
+        char id[ID_LENGTH];
+        Validation_printNodeId(&((NL_InstanceNode *)node)->parentNodeId, id,
+                               sizeof(id));
+        Validation_add(c->validation, NL_CHECK_DANGLING_REFERENCE, &node->id,
+                       "parent %s doesn't exist", id);
+    }
+    switch (node->nodeClass)
+    {
+    case NODECLASS_OBJECT:
+        checkTypeDefinition(c, node, ((NL_ObjectNode *)node)->refToTypeDef,
+                            NODECLASS_OBJECTTYPE);
+        break;
+    case NODECLASS_VARIABLE:
+    {
+        NL_VariableNode *var = (NL_VariableNode *)node;
+        checkTypeDefinition(c, node, var->refToTypeDef,
+                            NODECLASS_VARIABLETYPE);
+        checkDataType(c, node, &var->datatype);
+        if (var->value)
+        {
+            checkValue(c, var);
+        }
+        break;
+    }
+    case NODECLASS_VARIABLETYPE:
+        checkDataType(c, node, &((NL_VariableTypeNode *)node)->datatype);
+        break;
+    case NODECLASS_DATATYPE:
+    {
+        const NL_DataTypeDefinition *def = ((NL_DataTypeNode *)node)->definition;
+        for (size_t i = 0; def && !def->isEnum && i < def->fieldCnt; i++)
+        {
+            checkDataType(c, node, &def->fields[i].dataType);
+        }
+        break;
+    }
+    case NODECLASS_OBJECTTYPE:
+    case NODECLASS_METHOD:
+    case NODECLASS_REFERENCETYPE:
+    case NODECLASS_VIEW:
+        break;
+    }
+}
+
+void Validation_checkNodes(Validation *validation, const NodeIndex *index)
+{
+    struct NodeCheck c = {validation, index, NULL};
+    c.namespaces = (unsigned char *)calloc(UINT16_MAX / 8 + 1, 1);
+    if (!c.namespaces)
+    {
+        return;
+    }
+    NodeIndex_forEachWithContext(index, &c, markNamespace);
+    NodeIndex_forEachWithContext(index, &c, checkNode);
+    free(c.namespaces);
+}
@@ -0,0 +1,32 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+#include "NodesetLoader/NodesetLoader.h"
+
+struct NodeIndex;
+
+// findings of the import and of the checks of the imported nodes
+struct Validation;
+typedef struct Validation Validation;
+
+Validation *Validation_new(void);
+void Validation_delete(Validation *validation);
+// nodeId is copied and may be NULL, the message is formatted with printf
+// semantics
+void Validation_add(Validation *validation, NL_Check check,
+                    const UA_NodeId *nodeId, const char *format, ...);
+// NodeId as string for the messages, truncated to size
+void Validation_printNodeId(const UA_NodeId *id, char *buf, size_t size);
+// checks the references, type definitions, data types and values of the
+// indexed nodes
+void Validation_checkNodes(Validation *validation,
+                           const struct NodeIndex *index);
+size_t Validation_forEach(const Validation *validation, void *context,
+                          NodesetLoader_Finding_Func fn);
+size_t Validation_memoryUsage(const Validation *validation);
+
+#endif
@@ -244,9 +244,45 @@ static void Data_clear(NL_Data *data)
     free(data);
 }
 
+static size_t Data_memoryUsage(const NL_Data *data)
+{
+    if (!data)
+    {
+        return 0;
+    }
+    size_t size = sizeof(NL_Data);
+    if (data->type == DATATYPE_COMPLEX)
+    {
+        size += data->val.complexData.membersSize * sizeof(NL_Data *);
+        for (size_t cnt = 0; cnt < data->val.complexData.membersSize; cnt++)
+        {
+            size += Data_memoryUsage(data->val.complexData.members[cnt]);
+        }
+    }
+    return size;
+}
+
+size_t Value_memoryUsage(const NL_Value *val)
+{
+    return sizeof(NL_Value) + (val->ctx ? sizeof(NL_ParserCtx) : 0) +
+           (val->variant ? sizeof(UA_Variant) : 0) +
+           Data_memoryUsage(val->data);
+}
+
+void Value_finishParsing(NL_Value *val)
+{
+    free(val->ctx);
+    val->ctx = NULL;
+}
+
 void Value_delete(NL_Value *val)
 {
     Data_clear(val->data);
+    if (val->variant)
+    {
+        UA_Variant_clear(val->variant);
+        free(val->variant);
+    }
     free(val->ctx);
     free(val);
 }
@@ -31,4 +31,9 @@ typedef struct NL_ParserCtx NL_ParserCtx;
 NL_Value *Value_new(const NL_Node *node);
 void Value_start(NL_Value *val, const char *name);
 void Value_end(NL_Value *val, const char *name, const char *value);
+// memory of the value, the strings are part of the char arena, the memory of
+// a decoded variant is accounted by the parser
+size_t Value_memoryUsage(const NL_Value *val);
+// frees the state which is only needed while the value is parsed
+void Value_finishParsing(NL_Value *val);
 void Value_delete(NL_Value *val);
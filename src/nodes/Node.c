@@ -10,41 +10,38 @@
 #include <stdlib.h>
 #include "Value.h"
 
-NL_Node *Node_new(NL_NodeClass nodeClass)
+size_t Node_size(NL_NodeClass nodeClass)
 {
-    void *node = NULL;
     switch (nodeClass)
     {
     case NODECLASS_VARIABLE:
-        node = calloc(1, sizeof(NL_VariableNode));
-        break;
+        return sizeof(NL_VariableNode);
     case NODECLASS_OBJECT:
-        node = calloc(1, sizeof(NL_ObjectNode));
-        break;
+        return sizeof(NL_ObjectNode);
     case NODECLASS_OBJECTTYPE:
-        node = calloc(1, sizeof(NL_ObjectTypeNode));
-        break;
+        return sizeof(NL_ObjectTypeNode);
     case NODECLASS_REFERENCETYPE:
-        node = calloc(1, sizeof(NL_ReferenceTypeNode));
-        break;
+        return sizeof(NL_ReferenceTypeNode);
     case NODECLASS_VARIABLETYPE:
-        node = calloc(1, sizeof(NL_VariableTypeNode));
-        break;
+        return sizeof(NL_VariableTypeNode);
     case NODECLASS_DATATYPE:
-        node = calloc(1, sizeof(NL_DataTypeNode));
-        break;
+        return sizeof(NL_DataTypeNode);
     case NODECLASS_METHOD:
-        node = calloc(1, sizeof(NL_MethodNode));
-        break;
+        return sizeof(NL_MethodNode);
     case NODECLASS_VIEW:
-        node = calloc(1, sizeof(NL_ViewNode));
-        break;
+        return sizeof(NL_ViewNode);
     }
-    if(!node)
+    return 0;
+}
+
+NL_Node *Node_new(NL_NodeClass nodeClass)
+{
+    size_t size = Node_size(nodeClass);
+    if (!size)
     {
         return NULL;
     }
-    return (NL_Node*)node;
+    return (NL_Node *)calloc(1, size);
 }
 
 static void deleteRef(NL_Reference *ref)
@@ -59,11 +56,9 @@ static void deleteRef(NL_Reference *ref)
     }
 }
 
-void Node_delete(NL_Node *node)
+void Node_clear(NL_Node *node)
 {
     UA_NodeId_clear(&node->id);
-    deleteRef(node->hierachicalRefs);
-    deleteRef(node->nonHierachicalRefs);
     if (node->nodeClass == NODECLASS_DATATYPE)
     {
         DataTypeNode_clear((NL_DataTypeNode *)node);
@@ -71,7 +66,6 @@ void Node_delete(NL_Node *node)
     if(node->nodeClass == NODECLASS_VARIABLE)
     {
         NL_VariableNode* varNode = (NL_VariableNode*)node;
-        free(varNode->refToTypeDef);
         UA_NodeId_clear(&varNode->parentNodeId);
         if(varNode->value)
         {
@@ -82,7 +76,67 @@ void Node_delete(NL_Node *node)
     {
         NL_ObjectNode *objNode = (NL_ObjectNode *)node;
         UA_NodeId_clear(&objNode->parentNodeId);
-        free(objNode->refToTypeDef);
     }
+}
+
+void Node_delete(NL_Node *node)
+{
+    deleteRef(node->hierachicalRefs);
+    deleteRef(node->nonHierachicalRefs);
+    // left if they couldn't be resolved
+    deleteRef(node->unknownRefs);
+    if(node->nodeClass == NODECLASS_VARIABLE)
+    {
+        free(((NL_VariableNode *)node)->refToTypeDef);
+    }
+    if(node->nodeClass==NODECLASS_OBJECT)
+    {
+        free(((NL_ObjectNode *)node)->refToTypeDef);
+    }
+    Node_clear(node);
     free(node);
 }
+
+static const NL_Reference *getTypeDefinition(const NL_Node *node)
+{
+    if (node->nodeClass == NODECLASS_OBJECT)
+    {
+        return ((const NL_ObjectNode *)node)->refToTypeDef;
+    }
+    if (node->nodeClass == NODECLASS_VARIABLE)
+    {
+        return ((const NL_VariableNode *)node)->refToTypeDef;
+    }
+    return NULL;
+}
+
+static size_t forEachRef(const NL_Reference *ref, NL_ReferenceKind kind,
+                         void *context, NodesetLoader_forEachReference_Func fn)
+{
+    size_t cnt = 0;
+    for (; ref; ref = ref->next)
+    {
+        NL_ReferenceEntry entry;
+        entry.refType = ref->refType;
+        entry.target = ref->target;
+        entry.isForward = ref->isForward;
+        entry.kind = kind;
+        fn(context, &entry);
+        cnt++;
+    }
+    return cnt;
+}
+
+size_t Node_forEachReference(const NL_Node *node, void *context,
+                             NodesetLoader_forEachReference_Func fn)
+{
+    // the order of the calls matters, so no single expression
+    size_t cnt = forEachRef(getTypeDefinition(node),
+                            NL_REFERENCEKIND_TYPEDEFINITION, context, fn);
+    cnt += forEachRef(node->hierachicalRefs, NL_REFERENCEKIND_HIERACHICAL,
+                      context, fn);
+    cnt += forEachRef(node->nonHierachicalRefs,
+                      NL_REFERENCEKIND_NONHIERACHICAL, context, fn);
+    cnt += forEachRef(node->unknownRefs, NL_REFERENCEKIND_UNKNOWN, context, fn);
+    return cnt;
+}
@@ -10,6 +10,15 @@
 #include "NodesetLoader/NodesetLoader.h"
 
 NL_Node *Node_new(NL_NodeClass nodeClass);
+// size of the node struct of the node class
+size_t Node_size(NL_NodeClass nodeClass);
 void Node_delete(NL_Node *node);
+// frees the members of the node, but neither the node itself nor its
+// references, used for nodes which live in a NodeBlock
+void Node_clear(NL_Node *node);
+// calls fn for the references in the lists of the node, the type definition
+// first, returns their number
+size_t Node_forEachReference(const NL_Node *node, void *context,
+                             NodesetLoader_forEachReference_Func fn);
 
 #endif
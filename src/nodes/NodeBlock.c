@@ -0,0 +1,496 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NodeBlock.h"
+#include "Node.h"
+#include "NodeContainer.h"
+#include "Value.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct NodeBlock
+{
+    NL_NodeClass nodeClass;
+    size_t nodeSize;
+    size_t nodesSize;
+    // nodes, followed by the references
+    char *mem;
+    NL_Reference *refs;
+    size_t refsSize;
+    // compact references, NULL if the references are kept in the lists
+    RefStore *store;
+    // nodesSize + 1 entries, part of mem
+    UA_UInt32 *compactRefsBegin;
+    CompactRef *compactRefs;
+    // the lists built from the compact references, created on demand
+    NL_Reference *lists;
+};
+
+struct StringMove
+{
+    const CharArenaAllocator *from;
+    // NULL if the strings are only measured
+    CharArenaAllocator *to;
+    size_t size;
+};
+
+static NL_Reference **getTypeDefinition(NL_Node *node)
+{
+    switch (node->nodeClass)
+    {
+    case NODECLASS_OBJECT:
+        return &((NL_ObjectNode *)node)->refToTypeDef;
+    case NODECLASS_VARIABLE:
+        return &((NL_VariableNode *)node)->refToTypeDef;
+    case NODECLASS_OBJECTTYPE:
+    case NODECLASS_DATATYPE:
+    case NODECLASS_METHOD:
+    case NODECLASS_REFERENCETYPE:
+    case NODECLASS_VARIABLETYPE:
+    case NODECLASS_VIEW:
+        break;
+    }
+    return NULL;
+}
+
+static size_t countRefs(const NL_Reference *ref)
+{
+    size_t cnt = 0;
+    for (; ref; ref = ref->next)
+    {
+        cnt++;
+    }
+    return cnt;
+}
+
+// returns the copy, or NULL if the string stays where it is
+static char *copyString(struct StringMove *m, const char *s)
+{
+    if (!s || !CharArenaAllocator_contains(m->from, s))
+    {
+        return NULL;
+    }
+    size_t size = strlen(s) + 1;
+    if (!m->to)
+    {
+        m->size += size;
+        return NULL;
+    }
+    char *copy = CharArenaAllocator_malloc(m->to, size);
+    memcpy(copy, s, size);
+    return copy;
+}
+
+static void moveString(struct StringMove *m, char **s)
+{
+    char *copy = copyString(m, *s);
+    if (copy)
+    {
+        *s = copy;
+    }
+}
+
+static void moveConstString(struct StringMove *m, const char **s)
+{
+    char *copy = copyString(m, *s);
+    if (copy)
+    {
+        *s = copy;
+    }
+}
+
+static void moveLocalizedText(struct StringMove *m, NL_LocalizedText *text)
+{
+    moveString(m, &text->locale);
+    moveString(m, &text->text);
+}
+
+static void moveData(struct StringMove *m, NL_Data *data)
+{
+    if (!data)
+    {
+        return;
+    }
+    moveConstString(m, &data->name);
+    if (data->type == DATATYPE_PRIMITIVE)
+    {
+        moveConstString(m, &data->val.primitiveData.value);
+        return;
+    }
+    for (size_t i = 0; i < data->val.complexData.membersSize; i++)
+    {
+        moveData(m, data->val.complexData.members[i]);
+    }
+}
+
+static void moveStrings(struct StringMove *m, NL_Node *node)
+{
+    moveString(m, &node->browseName.name);
+    moveLocalizedText(m, &node->displayName);
+    moveLocalizedText(m, &node->description);
+    moveString(m, &node->writeMask);
+    switch (node->nodeClass)
+    {
+    case NODECLASS_OBJECT:
+        moveString(m, &((NL_ObjectNode *)node)->eventNotifier);
+        break;
+    case NODECLASS_OBJECTTYPE:
+        moveString(m, &((NL_ObjectTypeNode *)node)->isAbstract);
+        break;
+    case NODECLASS_VARIABLETYPE:
+    {
+        NL_VariableTypeNode *varType = (NL_VariableTypeNode *)node;
+        moveString(m, &varType->isAbstract);
+        moveString(m, &varType->arrayDimensions);
+        moveString(m, &varType->valueRank);
+        break;
+    }
+    case NODECLASS_VARIABLE:
+    {
+        NL_VariableNode *var = (NL_VariableNode *)node;
+        moveString(m, &var->arrayDimensions);
+        moveString(m, &var->valueRank);
+        moveString(m, &var->accessLevel);
+        moveString(m, &var->userAccessLevel);
+        moveString(m, &var->historizing);
+        moveString(m, &var->minimumSamplingInterval);
+        if (var->value)
+        {
+            moveConstString(m, &var->value->type);
+            moveData(m, var->value->data);
+        }
+        break;
+    }
+    case NODECLASS_DATATYPE:
+    {
+        NL_DataTypeNode *dataType = (NL_DataTypeNode *)node;
+        moveString(m, &dataType->isAbstract);
+        if (dataType->definition)
+        {
+            for (size_t i = 0; i < dataType->definition->fieldCnt; i++)
+            {
+                moveString(m, &dataType->definition->fields[i].name);
+            }
+        }
+        break;
+    }
+    case NODECLASS_METHOD:
+        moveString(m, &((NL_MethodNode *)node)->executable);
+        moveString(m, &((NL_MethodNode *)node)->userExecutable);
+        break;
+    case NODECLASS_REFERENCETYPE:
+        moveLocalizedText(m, &((NL_ReferenceTypeNode *)node)->inverseName);
+        moveString(m, &((NL_ReferenceTypeNode *)node)->symmetric);
+        break;
+    case NODECLASS_VIEW:
+        moveString(m, &((NL_ViewNode *)node)->containsNoLoops);
+        moveString(m, &((NL_ViewNode *)node)->eventNotifier);
+        break;
+    }
+}
+
+size_t NodeBlock_stringSize(const NodeContainer *container,
+                            const CharArenaAllocator *arena)
+{
+    struct StringMove m = {arena, NULL, 0};
+    for (size_t i = 0; i < container->size; i++)
+    {
+        moveStrings(&m, container->nodes[i]);
+    }
+    return m.size;
+}
+
+// adds the NodeIds of the references to the store, returns false if out of
+// memory
+static bool internRefs(RefStore *store, const NL_Reference *ref)
+{
+    for (; ref; ref = ref->next)
+    {
+        if (RefStore_intern(store, &ref->refType) == REFSTORE_INVALID_HANDLE ||
+            RefStore_intern(store, &ref->target) == REFSTORE_INVALID_HANDLE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool internNodeRefs(RefStore *store, NL_Node *node)
+{
+    NL_Reference **typeDef = getTypeDefinition(node);
+    return (!typeDef || internRefs(store, *typeDef)) &&
+           internRefs(store, node->hierachicalRefs) &&
+           internRefs(store, node->nonHierachicalRefs) &&
+           internRefs(store, node->unknownRefs);
+}
+
+NodeBlock *NodeBlock_new(const NodeContainer *container, NL_NodeClass nodeClass,
+                         RefStore *store)
+{
+    NodeBlock *block = (NodeBlock *)calloc(1, sizeof(NodeBlock));
+    if (!block)
+    {
+        return NULL;
+    }
+    block->nodeClass = nodeClass;
+    block->nodeSize = Node_size(nodeClass);
+    block->store = store;
+    size_t refsSize = 0;
+    for (size_t i = 0; i < container->size; i++)
+    {
+        NL_Node *node = container->nodes[i];
+        NL_Reference **typeDef = getTypeDefinition(node);
+        refsSize += countRefs(node->hierachicalRefs) +
+                    countRefs(node->nonHierachicalRefs) +
+                    countRefs(node->unknownRefs) +
+                    (typeDef ? countRefs(*typeDef) : 0);
+        if (store && !internNodeRefs(store, node))
+        {
+            free(block);
+            return NULL;
+        }
+    }
+    // the node structs are a multiple of the alignment of the references
+    size_t nodesBytes = container->size * block->nodeSize;
+    size_t bytes = nodesBytes + refsSize * sizeof(NL_Reference);
+    if (store)
+    {
+        // the offsets of the nodes are 32 bit
+        if (refsSize >= (size_t)REFSTORE_INVALID_HANDLE)
+        {
+            free(block);
+            return NULL;
+        }
+        bytes = nodesBytes + (container->size + 1) * sizeof(UA_UInt32) +
+                refsSize * sizeof(CompactRef);
+    }
+    if (!bytes)
+    {
+        return block;
+    }
+    block->mem = (char *)malloc(bytes);
+    if (!block->mem)
+    {
+        free(block);
+        return NULL;
+    }
+    if (store)
+    {
+        block->compactRefsBegin = (UA_UInt32 *)(block->mem + nodesBytes);
+        block->compactRefs =
+            (CompactRef *)(block->compactRefsBegin + container->size + 1);
+        block->compactRefsBegin[0] = 0;
+        return block;
+    }
+    block->refs = (NL_Reference *)(block->mem + nodesBytes);
+    return block;
+}
+
+// moves the list into the block, the order of the list is kept
+static NL_Reference *moveRefs(NodeBlock *block, NL_Reference *ref)
+{
+    NL_Reference *head = NULL;
+    NL_Reference **tail = &head;
+    while (ref)
+    {
+        NL_Reference *next = ref->next;
+        NL_Reference *moved = &block->refs[block->refsSize++];
+        *moved = *ref;
+        free(ref);
+        *tail = moved;
+        tail = &moved->next;
+        ref = next;
+    }
+    *tail = NULL;
+    return head;
+}
+
+// appends the list to the compact references and frees it, the NodeIds are
+// already part of the store
+static void compactRefs(NodeBlock *block, NL_Reference *ref,
+                        NL_ReferenceKind kind)
+{
+    RefStore *store = block->store;
+    while (ref)
+    {
+        NL_Reference *next = ref->next;
+        CompactRef *compact = &block->compactRefs[block->refsSize++];
+        compact->refType = RefStore_intern(store, &ref->refType);
+        compact->target = RefStore_intern(store, &ref->target);
+        compact->flags =
+            (UA_Byte)((ref->isForward ? 1u : 0u) | ((unsigned)kind << 1));
+        UA_NodeId_clear(&ref->refType);
+        UA_NodeId_clear(&ref->target);
+        free(ref);
+        ref = next;
+    }
+}
+
+static void moveNodeRefs(NodeBlock *block, NL_Node *node, size_t index)
+{
+    NL_Reference **typeDef = getTypeDefinition(node);
+    if (!block->store)
+    {
+        node->hierachicalRefs = moveRefs(block, node->hierachicalRefs);
+        node->nonHierachicalRefs = moveRefs(block, node->nonHierachicalRefs);
+        node->unknownRefs = moveRefs(block, node->unknownRefs);
+        if (typeDef)
+        {
+            *typeDef = moveRefs(block, *typeDef);
+        }
+        return;
+    }
+    if (typeDef)
+    {
+        compactRefs(block, *typeDef, NL_REFERENCEKIND_TYPEDEFINITION);
+        *typeDef = NULL;
+    }
+    compactRefs(block, node->hierachicalRefs, NL_REFERENCEKIND_HIERACHICAL);
+    compactRefs(block, node->nonHierachicalRefs,
+                NL_REFERENCEKIND_NONHIERACHICAL);
+    compactRefs(block, node->unknownRefs, NL_REFERENCEKIND_UNKNOWN);
+    node->hierachicalRefs = NULL;
+    node->nonHierachicalRefs = NULL;
+    node->unknownRefs = NULL;
+    block->compactRefsBegin[index + 1] = (UA_UInt32)block->refsSize;
+}
+
+void NodeBlock_move(NodeBlock *block, NodeContainer *container,
+                    const CharArenaAllocator *from, CharArenaAllocator *to)
+{
+    struct StringMove m = {from, to, 0};
+    for (size_t i = 0; i < container->size; i++)
+    {
+        NL_Node *old = container->nodes[i];
+        NL_Node *node = (NL_Node *)(block->mem + i * block->nodeSize);
+        memcpy(node, old, block->nodeSize);
+        free(old);
+        moveNodeRefs(block, node, i);
+        moveStrings(&m, node);
+        if (node->nodeClass == NODECLASS_VARIABLE &&
+            ((NL_VariableNode *)node)->value)
+        {
+            Value_finishParsing(((NL_VariableNode *)node)->value);
+        }
+        container->nodes[i] = node;
+    }
+    block->nodesSize = container->size;
+}
+
+size_t NodeBlock_forEachReference(const NodeBlock *block, const NL_Node *node,
+                                  void *context,
+                                  NodesetLoader_forEachReference_Func fn)
+{
+    if (!block || !block->store)
+    {
+        return Node_forEachReference(node, context, fn);
+    }
+    size_t index = (size_t)((const char *)node - block->mem) / block->nodeSize;
+    const CompactRef *ref = block->compactRefs + block->compactRefsBegin[index];
+    const CompactRef *end =
+        block->compactRefs + block->compactRefsBegin[index + 1];
+    for (; ref != end; ref++)
+    {
+        NL_ReferenceEntry entry;
+        entry.refType = *RefStore_get(block->store, ref->refType);
+        entry.target = *RefStore_get(block->store, ref->target);
+        entry.isForward = (ref->flags & 1u) != 0;
+        entry.kind = (NL_ReferenceKind)(ref->flags >> 1);
+        fn(context, &entry);
+    }
+    return (size_t)(end - (block->compactRefs + block->compactRefsBegin[index]));
+}
+
+static NL_Reference **getList(NL_Node *node, NL_ReferenceKind kind)
+{
+    switch (kind)
+    {
+    case NL_REFERENCEKIND_HIERACHICAL:
+        return &node->hierachicalRefs;
+    case NL_REFERENCEKIND_NONHIERACHICAL:
+        return &node->nonHierachicalRefs;
+    case NL_REFERENCEKIND_TYPEDEFINITION:
+        return getTypeDefinition(node);
+    case NL_REFERENCEKIND_UNKNOWN:
+        break;
+    }
+    return &node->unknownRefs;
+}
+
+bool NodeBlock_buildReferenceLists(NodeBlock *block)
+{
+    if (!block->store || block->lists || !block->refsSize)
+    {
+        return true;
+    }
+    block->lists =
+        (NL_Reference *)malloc(block->refsSize * sizeof(NL_Reference));
+    if (!block->lists)
+    {
+        return false;
+    }
+    NL_Reference *list = block->lists;
+    for (size_t i = 0; i < block->nodesSize; i++)
+    {
+        NL_Node *node = (NL_Node *)(block->mem + i * block->nodeSize);
+        // the compact references are grouped by their kind, the order of
+        // each list is kept
+        NL_Reference **tail = NULL;
+        NL_ReferenceKind kind = NL_REFERENCEKIND_UNKNOWN;
+        for (size_t r = block->compactRefsBegin[i];
+             r < block->compactRefsBegin[i + 1]; r++, list++)
+        {
+            const CompactRef *ref = &block->compactRefs[r];
+            NL_ReferenceKind refKind = (NL_ReferenceKind)(ref->flags >> 1);
+            if (!tail || refKind != kind)
+            {
+                kind = refKind;
+                tail = getList(node, kind);
+            }
+            list->isForward = (ref->flags & 1u) != 0;
+            list->refType = *RefStore_get(block->store, ref->refType);
+            list->target = *RefStore_get(block->store, ref->target);
+            list->next = NULL;
+            *tail = list;
+            tail = &list->next;
+        }
+    }
+    return true;
+}
+
+size_t NodeBlock_compactRefsMemoryUsage(const NodeBlock *block)
+{
+    if (!block || !block->store)
+    {
+        return 0;
+    }
+    size_t bytes = (block->nodesSize + 1) * sizeof(UA_UInt32) +
+                   block->refsSize * sizeof(CompactRef);
+    if (block->lists)
+    {
+        bytes += block->refsSize * sizeof(NL_Reference);
+    }
+    return bytes;
+}
+
+void NodeBlock_delete(NodeBlock *block)
+{
+    if (!block)
+    {
+        return;
+    }
+    for (size_t i = 0; i < block->nodesSize; i++)
+    {
+        Node_clear((NL_Node *)(block->mem + i * block->nodeSize));
+    }
+    // the NodeIds of compact references are owned by the store
+    for (size_t i = 0; block->refs && i < block->refsSize; i++)
+    {
+        UA_NodeId_clear(&block->refs[i].refType);
+        UA_NodeId_clear(&block->refs[i].target);
+    }
+    free(block->lists);
+    free(block->mem);
+    free(block);
+}
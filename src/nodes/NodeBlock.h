@@ -0,0 +1,49 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NODEBLOCK_H
+#define NODEBLOCK_H
+#include "CharAllocator.h"
+#include "NodesetLoader/NodesetLoader.h"
+#include "RefStore.h"
+
+struct NodeContainer;
+
+// The nodes of one node class and their references in one allocation, the
+// nodes are stored in the order of the container they were moved from. The
+// references are either kept in the lists of the nodes or stored as compact
+// references, an array of handles per node.
+struct NodeBlock;
+typedef struct NodeBlock NodeBlock;
+
+// bytes needed for the strings of the nodes which are part of the arena
+size_t NodeBlock_stringSize(const struct NodeContainer *container,
+                            const CharArenaAllocator *arena);
+// Allocates the block for the nodes of the container, nothing is moved yet.
+// With a store the references are compact, the NodeIds of the references are
+// added to the store here.
+NodeBlock *NodeBlock_new(const struct NodeContainer *container,
+                         NL_NodeClass nodeClass, RefStore *store);
+// Moves the nodes and their references into the block and frees the old
+// allocations, the container is updated with the new addresses. Compact
+// references leave the lists of the nodes empty. Strings which are part of the
+// arena from are copied to the arena to, which needs room for
+// NodeBlock_stringSize bytes.
+void NodeBlock_move(NodeBlock *block, struct NodeContainer *container,
+                    const CharArenaAllocator *from, CharArenaAllocator *to);
+// Calls fn for the references of a node of the block, or for those in the
+// lists of the node if the block is NULL or the references aren't compact. The
+// type definition comes first.
+size_t NodeBlock_forEachReference(const NodeBlock *block, const NL_Node *node,
+                                  void *context,
+                                  NodesetLoader_forEachReference_Func fn);
+// Builds the lists of the nodes from the compact references on the first
+// call, the NodeIds point into the store. Returns false if out of memory.
+bool NodeBlock_buildReferenceLists(NodeBlock *block);
+// bytes of the compact references and of the lists built from them
+size_t NodeBlock_compactRefsMemoryUsage(const NodeBlock *block);
+// clears the nodes and frees the block
+void NodeBlock_delete(NodeBlock *block);
+
+#endif
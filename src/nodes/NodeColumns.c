@@ -0,0 +1,192 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NodeColumns.h"
+#include "NodeBlock.h"
+#include "NodeContainer.h"
+#include <stdlib.h>
+
+struct RefCollector
+{
+    // NULL if the references are only counted
+    NL_ReferenceEntry *entry;
+    size_t size;
+    const UA_NodeId *typeDefinition;
+};
+
+// the unknown references are left out
+static void collectRef(void *context, const NL_ReferenceEntry *ref)
+{
+    struct RefCollector *c = (struct RefCollector *)context;
+    if (ref->kind == NL_REFERENCEKIND_UNKNOWN)
+    {
+        return;
+    }
+    if (c->entry)
+    {
+        *c->entry = *ref;
+        if (ref->kind == NL_REFERENCEKIND_TYPEDEFINITION)
+        {
+            c->typeDefinition = &c->entry->target;
+        }
+        c->entry++;
+    }
+    c->size++;
+}
+
+static bool allocColumns(NodeColumns *columns, size_t refsSize)
+{
+    size_t size = columns->size;
+    columns->nodes = (NL_Node **)calloc(size, sizeof(NL_Node *));
+    columns->ids = (UA_NodeId *)calloc(size, sizeof(UA_NodeId));
+    columns->browseNames = (NL_BrowseName *)calloc(size, sizeof(NL_BrowseName));
+    columns->refsBegin = (size_t *)calloc(size + 1, sizeof(size_t));
+    columns->refs =
+        (NL_ReferenceEntry *)calloc(refsSize, sizeof(NL_ReferenceEntry));
+    bool ok = columns->nodes && columns->ids && columns->browseNames &&
+              columns->refsBegin && (columns->refs || !refsSize);
+    if (columns->nodeClass == NODECLASS_OBJECT ||
+        columns->nodeClass == NODECLASS_VARIABLE ||
+        columns->nodeClass == NODECLASS_METHOD ||
+        columns->nodeClass == NODECLASS_VIEW)
+    {
+        columns->parentNodeIds = (UA_NodeId *)calloc(size, sizeof(UA_NodeId));
+        ok = ok && columns->parentNodeIds;
+    }
+    if (columns->nodeClass == NODECLASS_OBJECT ||
+        columns->nodeClass == NODECLASS_VARIABLE)
+    {
+        columns->typeDefinitions = (UA_NodeId *)calloc(size, sizeof(UA_NodeId));
+        ok = ok && columns->typeDefinitions;
+    }
+    if (columns->nodeClass == NODECLASS_VARIABLE ||
+        columns->nodeClass == NODECLASS_VARIABLETYPE)
+    {
+        columns->dataTypes = (UA_NodeId *)calloc(size, sizeof(UA_NodeId));
+        ok = ok && columns->dataTypes;
+    }
+    return ok;
+}
+
+NodeColumns *NodeColumns_new(const NodeContainer *container,
+                             NL_NodeClass nodeClass, const NodeBlock *block)
+{
+    NodeColumns *columns = (NodeColumns *)calloc(1, sizeof(NodeColumns));
+    if (!columns)
+    {
+        return NULL;
+    }
+    columns->nodeClass = nodeClass;
+    columns->size = container->size;
+
+    struct RefCollector c = {NULL, 0, NULL};
+    for (size_t i = 0; i < container->size; i++)
+    {
+        NodeBlock_forEachReference(block, container->nodes[i], &c, collectRef);
+    }
+    size_t refsSize = c.size;
+    if (!allocColumns(columns, refsSize))
+    {
+        NodeColumns_delete(columns);
+        return NULL;
+    }
+
+    c.entry = columns->refs;
+    for (size_t i = 0; i < container->size; i++)
+    {
+        NL_Node *node = container->nodes[i];
+        columns->nodes[i] = node;
+        columns->ids[i] = node->id;
+        columns->browseNames[i] = node->browseName;
+        if (columns->parentNodeIds)
+        {
+            columns->parentNodeIds[i] = ((NL_InstanceNode *)node)->parentNodeId;
+        }
+        if (nodeClass == NODECLASS_VARIABLE)
+        {
+            columns->dataTypes[i] = ((NL_VariableNode *)node)->datatype;
+        }
+        else if (nodeClass == NODECLASS_VARIABLETYPE)
+        {
+            columns->dataTypes[i] = ((NL_VariableTypeNode *)node)->datatype;
+        }
+
+        columns->refsBegin[i] = (size_t)(c.entry - columns->refs);
+        c.typeDefinition = NULL;
+        NodeBlock_forEachReference(block, node, &c, collectRef);
+        if (columns->typeDefinitions && c.typeDefinition)
+        {
+            columns->typeDefinitions[i] = *c.typeDefinition;
+        }
+    }
+    columns->refsBegin[container->size] = refsSize;
+    return columns;
+}
+
+size_t NodeColumns_memoryUsage(const NodeColumns *columns)
+{
+    if (!columns)
+    {
+        return 0;
+    }
+    size_t size = columns->size;
+    size_t idColumns = 1;
+    idColumns += columns->parentNodeIds ? 1 : 0;
+    idColumns += columns->typeDefinitions ? 1 : 0;
+    idColumns += columns->dataTypes ? 1 : 0;
+    return sizeof(NodeColumns) + size * sizeof(NL_Node *) +
+           idColumns * size * sizeof(UA_NodeId) +
+           size * sizeof(NL_BrowseName) + (size + 1) * sizeof(size_t) +
+           columns->refsBegin[size] * sizeof(NL_ReferenceEntry);
+}
+
+void NodeColumns_delete(NodeColumns *columns)
+{
+    if (!columns)
+    {
+        return;
+    }
+    free(columns->nodes);
+    free(columns->ids);
+    free(columns->browseNames);
+    free(columns->parentNodeIds);
+    free(columns->typeDefinitions);
+    free(columns->dataTypes);
+    free(columns->refsBegin);
+    free(columns->refs);
+    free(columns);
+}
+
+size_t NodeColumns_forEachSpan(const NodeColumns *columns, size_t batchSize,
+                               void *context,
+                               NodesetLoader_forEachSpan_Func fn)
+{
+    if (batchSize == 0)
+    {
+        batchSize = columns->size;
+    }
+    for (size_t begin = 0; begin < columns->size; begin += batchSize)
+    {
+        size_t size = columns->size - begin;
+        if (size > batchSize)
+        {
+            size = batchSize;
+        }
+        NL_NodeSpan span;
+        span.nodeClass = columns->nodeClass;
+        span.size = size;
+        span.nodes = columns->nodes + begin;
+        span.ids = columns->ids + begin;
+        span.browseNames = columns->browseNames + begin;
+        span.parentNodeIds =
+            columns->parentNodeIds ? columns->parentNodeIds + begin : NULL;
+        span.typeDefinitions =
+            columns->typeDefinitions ? columns->typeDefinitions + begin : NULL;
+        span.dataTypes = columns->dataTypes ? columns->dataTypes + begin : NULL;
+        span.refsBegin = columns->refsBegin + begin;
+        span.refs = columns->refs;
+        fn(context, &span);
+    }
+    return columns->size;
+}
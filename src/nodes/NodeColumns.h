@@ -0,0 +1,39 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NODECOLUMNS_H
+#define NODECOLUMNS_H
+#include "NodesetLoader/NodesetLoader.h"
+
+struct NodeContainer;
+struct NodeBlock;
+
+// struct of arrays copy of the nodes of one node class
+struct NodeColumns
+{
+    NL_NodeClass nodeClass;
+    size_t size;
+    NL_Node **nodes;
+    UA_NodeId *ids;
+    NL_BrowseName *browseNames;
+    UA_NodeId *parentNodeIds;
+    UA_NodeId *typeDefinitions;
+    UA_NodeId *dataTypes;
+    // size + 1 entries
+    size_t *refsBegin;
+    NL_ReferenceEntry *refs;
+};
+typedef struct NodeColumns NodeColumns;
+
+// block is the block of the nodes after the compaction, NULL before
+NodeColumns *NodeColumns_new(const struct NodeContainer *container,
+                             NL_NodeClass nodeClass,
+                             const struct NodeBlock *block);
+void NodeColumns_delete(NodeColumns *columns);
+size_t NodeColumns_memoryUsage(const NodeColumns *columns);
+size_t NodeColumns_forEachSpan(const NodeColumns *columns, size_t batchSize,
+                               void *context,
+                               NodesetLoader_forEachSpan_Func fn);
+
+#endif
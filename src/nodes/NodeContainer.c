@@ -48,8 +48,21 @@ void NodeContainer_add(NodeContainer *container, NL_Node *node)
     container->size++;
 }
 
+size_t NodeContainer_memoryUsage(const NodeContainer *container)
+{
+    if (!container)
+    {
+        return 0;
+    }
+    return sizeof(NodeContainer) + container->capacity * sizeof(NL_Node *);
+}
+
 void NodeContainer_delete(NodeContainer *container)
 {
+    if (!container)
+    {
+        return;
+    }
     if (container->owner)
     {
         for (size_t i = 0; i < container->size; i++)
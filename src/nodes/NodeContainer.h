@@ -22,5 +22,7 @@ typedef struct NodeContainer NodeContainer;
 NodeContainer *NodeContainer_new(size_t initialSize, bool owner);
 void NodeContainer_delete(NodeContainer *container);
 void NodeContainer_add(NodeContainer *container, NL_Node *node);
+// memory of the container itself, without the nodes
+size_t NodeContainer_memoryUsage(const NodeContainer *container);
 
 #endif
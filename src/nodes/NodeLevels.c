@@ -0,0 +1,162 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NodeLevels.h"
+#include "NodeContainer.h"
+#include <stdlib.h>
+
+struct LevelEntry
+{
+    NL_NodeClass nodeClass;
+    size_t index;
+    size_t level;
+};
+
+struct NodeLevels
+{
+    struct LevelEntry *entries;
+    size_t entriesSize;
+    size_t entriesCapacity;
+    size_t levelsSize;
+    // an entry couldn't be added, the levels are incomplete
+    bool failed;
+    // grouped on demand
+    NL_NodeLevel *levels;
+    NL_Node **nodes;
+};
+
+NodeLevels *NodeLevels_new(void)
+{
+    return (NodeLevels *)calloc(1, sizeof(NodeLevels));
+}
+
+void NodeLevels_delete(NodeLevels *levels)
+{
+    if (!levels)
+    {
+        return;
+    }
+    NodeLevels_invalidate(levels);
+    free(levels->entries);
+    free(levels);
+}
+
+bool NodeLevels_add(NodeLevels *levels, NL_NodeClass nodeClass, size_t index,
+                    size_t level)
+{
+    if (!levels)
+    {
+        return false;
+    }
+    if (levels->entriesSize == levels->entriesCapacity)
+    {
+        size_t capacity =
+            levels->entriesCapacity ? levels->entriesCapacity * 2 : 1024;
+        struct LevelEntry *entries = (struct LevelEntry *)realloc(
+            levels->entries, capacity * sizeof(struct LevelEntry));
+        if (!entries)
+        {
+            levels->failed = true;
+            return false;
+        }
+        levels->entries = entries;
+        levels->entriesCapacity = capacity;
+    }
+    struct LevelEntry *entry = &levels->entries[levels->entriesSize++];
+    entry->nodeClass = nodeClass;
+    entry->index = index;
+    entry->level = level;
+    if (level >= levels->levelsSize)
+    {
+        levels->levelsSize = level + 1;
+    }
+    return true;
+}
+
+// counting sort of the entries by level, which keeps the sort order within a
+// level
+static bool group(NodeLevels *levels, NodeContainer *const *containers)
+{
+    levels->levels =
+        (NL_NodeLevel *)calloc(levels->levelsSize, sizeof(NL_NodeLevel));
+    levels->nodes =
+        (NL_Node **)malloc(levels->entriesSize * sizeof(NL_Node *));
+    if (!levels->levels || !levels->nodes)
+    {
+        NodeLevels_invalidate(levels);
+        return false;
+    }
+    size_t *fill = (size_t *)calloc(levels->levelsSize, sizeof(size_t));
+    if (!fill)
+    {
+        NodeLevels_invalidate(levels);
+        return false;
+    }
+    for (size_t i = 0; i < levels->entriesSize; i++)
+    {
+        fill[levels->entries[i].level]++;
+    }
+    // fill becomes the position of the next node of the level
+    size_t begin = 0;
+    for (size_t l = 0; l < levels->levelsSize; l++)
+    {
+        levels->levels[l].nodes = levels->nodes + begin;
+        levels->levels[l].size = fill[l];
+        begin += fill[l];
+        fill[l] = begin - levels->levels[l].size;
+    }
+    for (size_t i = 0; i < levels->entriesSize; i++)
+    {
+        const struct LevelEntry *entry = &levels->entries[i];
+        levels->nodes[fill[entry->level]++] =
+            containers[entry->nodeClass]->nodes[entry->index];
+    }
+    free(fill);
+    return true;
+}
+
+const NL_NodeLevel *NodeLevels_get(NodeLevels *levels,
+                                   NodeContainer *const *containers,
+                                   size_t *size)
+{
+    *size = 0;
+    if (!levels || levels->failed || !levels->levelsSize)
+    {
+        return NULL;
+    }
+    if (!levels->levels && !group(levels, containers))
+    {
+        return NULL;
+    }
+    *size = levels->levelsSize;
+    return levels->levels;
+}
+
+void NodeLevels_invalidate(NodeLevels *levels)
+{
+    if (!levels)
+    {
+        return;
+    }
+    free(levels->levels);
+    levels->levels = NULL;
+    free(levels->nodes);
+    levels->nodes = NULL;
+}
+
+size_t NodeLevels_memoryUsage(const NodeLevels *levels)
+{
+    if (!levels)
+    {
+        return 0;
+    }
+    size_t size = sizeof(NodeLevels) +
+                  levels->entriesCapacity * sizeof(struct LevelEntry);
+    if (levels->levels)
+    {
+        size += levels->levelsSize * sizeof(NL_NodeLevel) +
+                levels->entriesSize * sizeof(NL_Node *);
+    }
+    return size;
+}
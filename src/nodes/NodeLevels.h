@@ -0,0 +1,31 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NODELEVELS_H
+#define NODELEVELS_H
+#include "NodesetLoader/NodesetLoader.h"
+
+struct NodeContainer;
+
+// Dependency depth of the sorted nodes. The nodes are recorded by their
+// position in the node containers, so the levels stay valid if the nodes are
+// moved.
+struct NodeLevels;
+typedef struct NodeLevels NodeLevels;
+
+NodeLevels *NodeLevels_new(void);
+void NodeLevels_delete(NodeLevels *levels);
+// has to be called in sort order
+bool NodeLevels_add(NodeLevels *levels, NL_NodeClass nodeClass, size_t index,
+                    size_t level);
+// Groups the nodes by level on the first call, within a level the nodes are
+// in sort order.
+const NL_NodeLevel *NodeLevels_get(NodeLevels *levels,
+                                   struct NodeContainer *const *containers,
+                                   size_t *size);
+// drops the grouped nodes, they are grouped again on the next get
+void NodeLevels_invalidate(NodeLevels *levels);
+size_t NodeLevels_memoryUsage(const NodeLevels *levels);
+
+#endif
@@ -0,0 +1,163 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "RefStore.h"
+#include <stdlib.h>
+
+struct RefStore
+{
+    UA_NodeId *ids;
+    size_t size;
+    size_t idsCapacity;
+    // handle + 1, 0 if empty, capacity is a power of 2
+    UA_UInt32 *slots;
+    size_t capacity;
+    // bytes of the copied string identifiers
+    size_t stringBytes;
+};
+
+static size_t roundUpToPowerOf2(size_t n)
+{
+    size_t capacity = 16;
+    while (capacity < n)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+RefStore *RefStore_new(size_t initialCapacity)
+{
+    RefStore *store = (RefStore *)calloc(1, sizeof(RefStore));
+    if (!store)
+    {
+        return NULL;
+    }
+    store->idsCapacity = initialCapacity < 8 ? 8 : initialCapacity;
+    store->capacity = roundUpToPowerOf2(store->idsCapacity * 2);
+    store->slots = (UA_UInt32 *)calloc(store->capacity, sizeof(UA_UInt32));
+    store->ids = (UA_NodeId *)calloc(store->idsCapacity, sizeof(UA_NodeId));
+    if (!store->slots || !store->ids)
+    {
+        RefStore_delete(store);
+        return NULL;
+    }
+    return store;
+}
+
+void RefStore_delete(RefStore *store)
+{
+    if (!store)
+    {
+        return;
+    }
+    for (size_t i = 0; i < store->size; i++)
+    {
+        UA_NodeId_clear(&store->ids[i]);
+    }
+    free(store->ids);
+    free(store->slots);
+    free(store);
+}
+
+static UA_UInt32 *findSlot(const RefStore *store, UA_UInt32 *slots,
+                           size_t capacity, const UA_NodeId *id)
+{
+    size_t mask = capacity - 1;
+    size_t pos = UA_NodeId_hash(id) & mask;
+    while (slots[pos] && !UA_NodeId_equal(&store->ids[slots[pos] - 1], id))
+    {
+        pos = (pos + 1) & mask;
+    }
+    return &slots[pos];
+}
+
+static bool growSlots(RefStore *store)
+{
+    size_t capacity = store->capacity * 2;
+    UA_UInt32 *slots = (UA_UInt32 *)calloc(capacity, sizeof(UA_UInt32));
+    if (!slots)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < store->size; i++)
+    {
+        *findSlot(store, slots, capacity, &store->ids[i]) = (UA_UInt32)(i + 1);
+    }
+    free(store->slots);
+    store->slots = slots;
+    store->capacity = capacity;
+    return true;
+}
+
+static bool growIds(RefStore *store)
+{
+    size_t capacity = store->idsCapacity * 2;
+    UA_NodeId *ids =
+        (UA_NodeId *)realloc(store->ids, capacity * sizeof(UA_NodeId));
+    if (!ids)
+    {
+        return false;
+    }
+    store->ids = ids;
+    store->idsCapacity = capacity;
+    return true;
+}
+
+UA_UInt32 RefStore_intern(RefStore *store, const UA_NodeId *id)
+{
+    UA_UInt32 *slot = findSlot(store, store->slots, store->capacity, id);
+    if (*slot)
+    {
+        return *slot - 1;
+    }
+    if (store->size >= (size_t)REFSTORE_INVALID_HANDLE)
+    {
+        return REFSTORE_INVALID_HANDLE;
+    }
+    if (store->size == store->idsCapacity && !growIds(store))
+    {
+        return REFSTORE_INVALID_HANDLE;
+    }
+    // keep the load factor at most 0.5
+    if ((store->size + 1) * 2 > store->capacity)
+    {
+        if (!growSlots(store))
+        {
+            return REFSTORE_INVALID_HANDLE;
+        }
+        slot = findSlot(store, store->slots, store->capacity, id);
+    }
+    if (UA_NodeId_copy(id, &store->ids[store->size]) != UA_STATUSCODE_GOOD)
+    {
+        return REFSTORE_INVALID_HANDLE;
+    }
+    if (id->identifierType == UA_NODEIDTYPE_STRING ||
+        id->identifierType == UA_NODEIDTYPE_BYTESTRING)
+    {
+        store->stringBytes += id->identifier.string.length;
+    }
+    *slot = (UA_UInt32)(store->size + 1);
+    return (UA_UInt32)store->size++;
+}
+
+const UA_NodeId *RefStore_get(const RefStore *store, UA_UInt32 handle)
+{
+    return &store->ids[handle];
+}
+
+size_t RefStore_size(const RefStore *store)
+{
+    return store ? store->size : 0;
+}
+
+size_t RefStore_memoryUsage(const RefStore *store)
+{
+    if (!store)
+    {
+        return 0;
+    }
+    return sizeof(RefStore) + store->capacity * sizeof(UA_UInt32) +
+           store->idsCapacity * sizeof(UA_NodeId) + store->stringBytes;
+}
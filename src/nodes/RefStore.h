@@ -0,0 +1,37 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef REFSTORE_H
+#define REFSTORE_H
+#include "NodesetLoader/NodesetLoader.h"
+
+#define REFSTORE_INVALID_HANDLE ((UA_UInt32)-1)
+
+// a reference whose reference type and target are handles of a RefStore
+struct CompactRef
+{
+    UA_UInt32 refType;
+    UA_UInt32 target;
+    // bit 0: isForward, bits 1 to 2: the NL_ReferenceKind
+    UA_Byte flags;
+};
+typedef struct CompactRef CompactRef;
+
+// Table of the distinct NodeIds of the references of a nodeset, a NodeId is
+// stored once and identified by its handle, the index in insertion order.
+// Open addressing on the NodeId hash.
+struct RefStore;
+typedef struct RefStore RefStore;
+
+RefStore *RefStore_new(size_t initialCapacity);
+void RefStore_delete(RefStore *store);
+// returns the handle of the id, the id is copied on first use,
+// REFSTORE_INVALID_HANDLE if out of memory
+UA_UInt32 RefStore_intern(RefStore *store, const UA_NodeId *id);
+// valid until the store is deleted
+const UA_NodeId *RefStore_get(const RefStore *store, UA_UInt32 handle);
+size_t RefStore_size(const RefStore *store);
+size_t RefStore_memoryUsage(const RefStore *store);
+
+#endif
@@ -0,0 +1,82 @@
+#include "NodeIdTable.h"
+#include "check.h"
+
+START_TEST(fastPath)
+{
+    NodeIdTable *table = NodeIdTable_new(4);
+    size_t numeric = NodeIdTable_intern(table, "i=47");
+    size_t withNs = NodeIdTable_intern(table, "ns=2;i=5001");
+    size_t string = NodeIdTable_intern(table, "ns=1;s=Machine.Axis");
+    ck_assert_uint_ne(numeric, NODEIDTABLE_INVALID);
+    ck_assert_uint_ne(withNs, NODEIDTABLE_INVALID);
+    ck_assert_uint_ne(string, NODEIDTABLE_INVALID);
+
+    const UA_NodeId *id = NodeIdTable_get(table, numeric);
+    ck_assert_uint_eq(id->namespaceIndex, 0);
+    ck_assert_uint_eq(id->identifier.numeric, 47);
+    id = NodeIdTable_get(table, withNs);
+    ck_assert_uint_eq(id->namespaceIndex, 2);
+    ck_assert_uint_eq(id->identifier.numeric, 5001);
+    id = NodeIdTable_get(table, string);
+    ck_assert_uint_eq(id->namespaceIndex, 1);
+    ck_assert(id->identifierType == UA_NODEIDTYPE_STRING);
+    ck_assert_uint_eq(id->identifier.string.length, strlen("Machine.Axis"));
+
+    // the same text is interned once
+    ck_assert_uint_eq(NodeIdTable_intern(table, "i=47"), numeric);
+    ck_assert_uint_eq(NodeIdTable_size(table), 3);
+    NodeIdTable_delete(table);
+}
+END_TEST
+
+START_TEST(fallback)
+{
+    NodeIdTable *table = NodeIdTable_new(4);
+    // not covered by the fast path, left to UA_NodeId_parse
+    size_t guid = NodeIdTable_intern(table, "g=09087e75-8e5e-499b-954f-f2a9603db28a");
+    ck_assert_uint_ne(guid, NODEIDTABLE_INVALID);
+    ck_assert(NodeIdTable_get(table, guid)->identifierType == UA_NODEIDTYPE_GUID);
+    ck_assert_uint_eq(NodeIdTable_intern(table, "no NodeId"), NODEIDTABLE_INVALID);
+    ck_assert_uint_eq(NodeIdTable_size(table), 1);
+    NodeIdTable_delete(table);
+}
+END_TEST
+
+START_TEST(grow)
+{
+    NodeIdTable *table = NodeIdTable_new(4);
+    char text[32];
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        snprintf(text, sizeof(text), "ns=1;i=%u", i);
+        ck_assert_uint_eq(NodeIdTable_intern(table, text), i);
+    }
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        snprintf(text, sizeof(text), "ns=1;i=%u", i);
+        size_t handle = NodeIdTable_intern(table, text);
+        ck_assert_uint_eq(handle, i);
+        ck_assert_uint_eq(NodeIdTable_get(table, handle)->identifier.numeric, i);
+    }
+    ck_assert_uint_eq(NodeIdTable_size(table), 1000);
+    NodeIdTable_delete(table);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("NodeIdTable tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, fastPath);
+    tcase_add_test(tc, fallback);
+    tcase_add_test(tc, grow);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? 0 : -1;
+}
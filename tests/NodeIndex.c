@@ -0,0 +1,71 @@
+#include "NodeIndex.h"
+#include "check.h"
+
+START_TEST(idSet)
+{
+    NodeIdSet *set = NodeIdSet_new(4);
+    UA_NodeId numeric = UA_NODEID_NUMERIC(1, 5001);
+    UA_NodeId string = UA_NODEID_STRING(2, "Machine.Axis");
+    UA_NodeId null = UA_NODEID_NULL;
+    ck_assert(NodeIdSet_add(set, &numeric));
+    ck_assert(NodeIdSet_add(set, &string));
+    ck_assert(!NodeIdSet_add(set, &numeric));
+    ck_assert(!NodeIdSet_add(set, &null));
+    ck_assert(NodeIdSet_contains(set, &numeric));
+    ck_assert(NodeIdSet_contains(set, &string));
+    ck_assert(!NodeIdSet_contains(set, &null));
+    ck_assert_uint_eq(NodeIdSet_size(set), 2);
+    NodeIdSet_delete(set);
+}
+END_TEST
+
+START_TEST(idMap)
+{
+    NodeIdMap *map = NodeIdMap_new(4);
+    int values[1000];
+    for (UA_UInt32 i = 0; i < 1000; i++)
+    {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        ck_assert(NodeIdMap_add(map, &id, &values[i]));
+    }
+    UA_NodeId known = UA_NODEID_NUMERIC(1, 999);
+    ck_assert(!NodeIdMap_add(map, &known, NULL));
+    ck_assert_uint_eq(NodeIdMap_size(map), 1000);
+
+    // values survive the growth of the map
+    for (UA_UInt32 i = 0; i < 1000; i++)
+    {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        const void *value = NULL;
+        ck_assert(NodeIdMap_get(map, &id, &value));
+        ck_assert_ptr_eq(value, &values[i]);
+    }
+
+    // a NULL value is distinguished from a missing id
+    UA_NodeId withoutValue = UA_NODEID_STRING(2, "noType");
+    ck_assert(NodeIdMap_add(map, &withoutValue, NULL));
+    const void *value = &values[0];
+    ck_assert(NodeIdMap_get(map, &withoutValue, &value));
+    ck_assert_ptr_eq(value, NULL);
+    UA_NodeId unknown = UA_NODEID_NUMERIC(3, 1);
+    ck_assert(!NodeIdMap_get(map, &unknown, &value));
+    NodeIdMap_delete(map);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("NodeIndex tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, idSet);
+    tcase_add_test(tc, idMap);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? 0 : -1;
+}
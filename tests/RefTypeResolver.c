@@ -0,0 +1,176 @@
+#include "RefTypeResolver.h"
+#include "InternalRefService.h"
+#include "nodes/NodeContainer.h"
+#include "NodesetLoader/NodesetLoader.h"
+#include "check.h"
+#include <stdio.h>
+
+static NL_ReferenceService *refService;
+static NodeContainer *refTypes;
+static NodeContainer *nodes;
+
+static void setup(void)
+{
+    refService = InternalRefService_new();
+    refTypes = NodeContainer_new(10, false);
+    nodes = NodeContainer_new(10, false);
+}
+
+static void teardown(void)
+{
+    NodeContainer_delete(refTypes);
+    NodeContainer_delete(nodes);
+    InternalRefService_delete(refService);
+}
+
+static void initRefType(NL_ReferenceTypeNode *n, UA_UInt32 id)
+{
+    memset(n, 0, sizeof(NL_ReferenceTypeNode));
+    n->nodeClass = NODECLASS_REFERENCETYPE;
+    n->id = UA_NODEID_NUMERIC(1, id);
+}
+
+static void initObject(NL_ObjectNode *n, UA_UInt32 id)
+{
+    memset(n, 0, sizeof(NL_ObjectNode));
+    n->nodeClass = NODECLASS_OBJECT;
+    n->id = UA_NODEID_NUMERIC(1, id);
+}
+
+static void initRef(NL_Reference *ref, UA_NodeId refType, UA_NodeId target,
+                    bool isForward, NL_Reference **list)
+{
+    ref->refType = refType;
+    ref->target = target;
+    ref->isForward = isForward;
+    ref->next = *list;
+    *list = ref;
+}
+
+static bool isHierachical(const UA_NodeId *refType)
+{
+    NL_Reference ref;
+    memset(&ref, 0, sizeof(ref));
+    ref.refType = *refType;
+    return refService->isHierachicalRef(refService->context, &ref);
+}
+
+// nodeA has a reference of type typeB, which is a subtype of typeA, which has
+// a reference of type typeC
+// expect: the types are registered in the order typeC, typeA, typeB and the
+// reference of nodeA is hierachical
+START_TEST(waitingChain)
+{
+    NL_ReferenceTypeNode typeA, typeB, typeC;
+    initRefType(&typeA, 1);
+    initRefType(&typeB, 2);
+    initRefType(&typeC, 3);
+    NL_Reference refs[5];
+    // typeA is a subtype of HierarchicalReferences
+    initRef(&refs[0], UA_NODEID_NUMERIC(0, 45), UA_NODEID_NUMERIC(0, 33),
+            false, &typeA.hierachicalRefs);
+    initRef(&refs[1], typeC.id, UA_NODEID_NUMERIC(1, 100), true,
+            &typeA.unknownRefs);
+    initRef(&refs[2], UA_NODEID_NUMERIC(0, 45), typeA.id, false,
+            &typeB.hierachicalRefs);
+    // typeC is a subtype of NonHierarchicalReferences
+    initRef(&refs[3], UA_NODEID_NUMERIC(0, 45), UA_NODEID_NUMERIC(0, 32),
+            false, &typeC.hierachicalRefs);
+
+    NL_ObjectNode nodeA;
+    initObject(&nodeA, 10);
+    initRef(&refs[4], typeB.id, UA_NODEID_NUMERIC(1, 11), true,
+            &nodeA.unknownRefs);
+
+    ck_assert(RefTypeResolver_awaitsSupertype(refService, (NL_Node *)&typeB));
+    NodeContainer_add(refTypes, (NL_Node *)&typeB);
+    NodeContainer_add(refTypes, (NL_Node *)&typeA);
+    NodeContainer_add(refTypes, (NL_Node *)&typeC);
+    NodeContainer_add(nodes, (NL_Node *)&nodeA);
+    ck_assert(RefTypeResolver_resolve(refService, refTypes, nodes));
+
+    ck_assert(!typeA.unknownRefs);
+    ck_assert(typeA.nonHierachicalRefs == &refs[1]);
+    ck_assert(isHierachical(&typeA.id));
+    ck_assert(isHierachical(&typeB.id));
+    ck_assert(!isHierachical(&typeC.id));
+    ck_assert(!nodeA.unknownRefs);
+    ck_assert(nodeA.hierachicalRefs == &refs[4]);
+}
+END_TEST
+
+// nodeA has a reference of a type which isn't defined, typeA is a subtype of
+// a type which isn't defined and nodeB has a reference of type typeA
+// expect: the reference of nodeA stays unknown, typeA is registered as non
+// hierachical
+START_TEST(unresolved)
+{
+    NL_ReferenceTypeNode typeA;
+    initRefType(&typeA, 1);
+    NL_Reference refs[3];
+    initRef(&refs[0], UA_NODEID_NUMERIC(0, 45), UA_NODEID_NUMERIC(1, 99),
+            false, &typeA.hierachicalRefs);
+
+    NL_ObjectNode nodeA, nodeB;
+    initObject(&nodeA, 10);
+    initObject(&nodeB, 11);
+    initRef(&refs[1], UA_NODEID_NUMERIC(1, 98), nodeB.id, true,
+            &nodeA.unknownRefs);
+    initRef(&refs[2], typeA.id, nodeA.id, true, &nodeB.unknownRefs);
+
+    NodeContainer_add(refTypes, (NL_Node *)&typeA);
+    NodeContainer_add(nodes, (NL_Node *)&nodeA);
+    NodeContainer_add(nodes, (NL_Node *)&nodeB);
+    ck_assert(RefTypeResolver_resolve(refService, refTypes, nodes));
+
+    ck_assert(nodeA.unknownRefs == &refs[1]);
+    ck_assert(!nodeB.unknownRefs);
+    ck_assert(nodeB.nonHierachicalRefs == &refs[2]);
+    ck_assert(!isHierachical(&typeA.id));
+}
+END_TEST
+
+// two reference types with references of each other's type
+// expect: termination, the references stay unknown
+START_TEST(cycle)
+{
+    NL_ReferenceTypeNode typeA, typeB;
+    initRefType(&typeA, 1);
+    initRefType(&typeB, 2);
+    NL_Reference refs[2];
+    initRef(&refs[0], typeB.id, typeB.id, true, &typeA.unknownRefs);
+    initRef(&refs[1], typeA.id, typeA.id, true, &typeB.unknownRefs);
+
+    NodeContainer_add(refTypes, (NL_Node *)&typeA);
+    NodeContainer_add(refTypes, (NL_Node *)&typeB);
+    ck_assert(RefTypeResolver_resolve(refService, refTypes, nodes));
+    ck_assert(typeA.unknownRefs == &refs[0]);
+    ck_assert(typeB.unknownRefs == &refs[1]);
+}
+END_TEST
+
+START_TEST(empty)
+{
+    ck_assert(RefTypeResolver_resolve(refService, refTypes, nodes));
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("RefTypeResolver tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, waitingChain);
+    tcase_add_test(tc, unresolved);
+    tcase_add_test(tc, cycle);
+    tcase_add_test(tc, empty);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? 0 : -1;
+}
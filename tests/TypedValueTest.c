@@ -0,0 +1,200 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "../src/TypedValue.h"
+#include "check.h"
+
+static const UA_DataType *findType(UA_UInt32 id)
+{
+    UA_NodeId typeId = UA_NODEID_NUMERIC(0, id);
+    return TypedValue_findType(&typeId);
+}
+
+START_TEST(simpleVal)
+{
+    //<Value><Double>3.1415</Double></Value>
+    TypedValue *tv = TypedValue_new(NULL);
+    TypedValue_begin(tv, findType(UA_NS0ID_DOUBLE));
+    TypedValue_start(tv, "Double");
+    TypedValue_end(tv, "3.1415");
+
+    UA_Variant var;
+    bool isArray = true;
+    ck_assert(TypedValue_finish(tv, &var, &isArray));
+    ck_assert(!isArray);
+    ck_assert_ptr_eq(var.type, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert(*(UA_Double *)var.data == 3.1415);
+    UA_Variant_clear(&var);
+    TypedValue_delete(tv);
+}
+END_TEST
+
+START_TEST(ListOfInt32)
+{
+    TypedValue *tv = TypedValue_new(NULL);
+    TypedValue_begin(tv, findType(UA_NS0ID_INT32));
+    TypedValue_start(tv, "ListOfInt32");
+    for (int i = 0; i < 3; i++)
+    {
+        TypedValue_start(tv, "Int32");
+        TypedValue_end(tv, i == 1 ? "-7" : "12");
+    }
+    TypedValue_end(tv, NULL);
+
+    UA_Variant var;
+    bool isArray = false;
+    ck_assert(TypedValue_finish(tv, &var, &isArray));
+    ck_assert(isArray);
+    ck_assert_uint_eq(var.arrayLength, 3);
+    ck_assert_int_eq(((UA_Int32 *)var.data)[0], 12);
+    ck_assert_int_eq(((UA_Int32 *)var.data)[1], -7);
+    UA_Variant_clear(&var);
+    TypedValue_delete(tv);
+}
+END_TEST
+
+START_TEST(LocalizedText)
+{
+    TypedValue *tv = TypedValue_new(NULL);
+    TypedValue_begin(tv, findType(UA_NS0ID_LOCALIZEDTEXT));
+    TypedValue_start(tv, "LocalizedText");
+    TypedValue_start(tv, "Locale");
+    TypedValue_end(tv, "en");
+    TypedValue_start(tv, "Text");
+    TypedValue_end(tv, "hello");
+    // unknown elements are skipped with their children
+    TypedValue_start(tv, "Unknown");
+    TypedValue_start(tv, "Text");
+    TypedValue_end(tv, "skipped");
+    TypedValue_end(tv, NULL);
+    TypedValue_end(tv, "  \n ");
+
+    UA_Variant var;
+    bool isArray = false;
+    ck_assert(TypedValue_finish(tv, &var, &isArray));
+    UA_LocalizedText *lt = (UA_LocalizedText *)var.data;
+    ck_assert_uint_eq(lt->locale.length, 2);
+    ck_assert(!strncmp((const char *)lt->text.data, "hello", lt->text.length));
+    ck_assert_uint_eq(lt->text.length, 5);
+    UA_Variant_clear(&var);
+    TypedValue_delete(tv);
+}
+END_TEST
+
+START_TEST(ExtensionObject)
+{
+    TypedValue *tv = TypedValue_new(NULL);
+    TypedValue_begin(tv, findType(UA_NS0ID_RANGE));
+    TypedValue_start(tv, "ExtensionObject");
+    TypedValue_start(tv, "TypeId");
+    TypedValue_start(tv, "Identifier");
+    TypedValue_end(tv, "i=886");
+    TypedValue_end(tv, NULL);
+    TypedValue_start(tv, "Body");
+    TypedValue_start(tv, "Range");
+    TypedValue_start(tv, "Low");
+    TypedValue_end(tv, "-1.5");
+    TypedValue_start(tv, "High");
+    TypedValue_end(tv, "100");
+    TypedValue_end(tv, NULL);
+    TypedValue_end(tv, NULL);
+    TypedValue_end(tv, NULL);
+
+    UA_Variant var;
+    bool isArray = false;
+    ck_assert(TypedValue_finish(tv, &var, &isArray));
+    ck_assert(!isArray);
+    UA_Range *range = (UA_Range *)var.data;
+    ck_assert(range->low == -1.5);
+    ck_assert(range->high == 100.0);
+    UA_Variant_clear(&var);
+    TypedValue_delete(tv);
+}
+END_TEST
+
+START_TEST(ListOfExtensionObject)
+{
+    TypedValue *tv = TypedValue_new(NULL);
+    TypedValue_begin(tv, findType(UA_NS0ID_ARGUMENT));
+    TypedValue_start(tv, "ListOfExtensionObject");
+    for (int i = 0; i < 2; i++)
+    {
+        TypedValue_start(tv, "ExtensionObject");
+        TypedValue_start(tv, "Body");
+        TypedValue_start(tv, "Argument");
+        TypedValue_start(tv, "Name");
+        TypedValue_end(tv, i ? "Second" : "First");
+        TypedValue_start(tv, "DataType");
+        TypedValue_start(tv, "Identifier");
+        TypedValue_end(tv, "i=12");
+        TypedValue_end(tv, NULL);
+        TypedValue_start(tv, "ValueRank");
+        TypedValue_end(tv, "1");
+        TypedValue_start(tv, "ArrayDimensions");
+        TypedValue_start(tv, "UInt32");
+        TypedValue_end(tv, "4");
+        TypedValue_end(tv, NULL);
+        TypedValue_end(tv, NULL);
+        TypedValue_end(tv, NULL);
+        TypedValue_end(tv, NULL);
+    }
+    TypedValue_end(tv, NULL);
+
+    UA_Variant var;
+    bool isArray = false;
+    ck_assert(TypedValue_finish(tv, &var, &isArray));
+    ck_assert(isArray);
+    ck_assert_uint_eq(var.arrayLength, 2);
+    UA_Argument *arg = &((UA_Argument *)var.data)[1];
+    ck_assert_uint_eq(arg->name.length, strlen("Second"));
+    ck_assert_uint_eq(arg->dataType.identifier.numeric, 12);
+    ck_assert_int_eq(arg->valueRank, 1);
+    ck_assert_uint_eq(arg->arrayDimensionsSize, 1);
+    ck_assert_uint_eq(arg->arrayDimensions[0], 4);
+    UA_Variant_clear(&var);
+    TypedValue_delete(tv);
+}
+END_TEST
+
+START_TEST(UnsupportedTypes)
+{
+    // variants and custom types are left to the NL_Data tree
+    ck_assert_ptr_eq(findType(UA_NS0ID_BASEDATATYPE), NULL);
+    UA_NodeId custom = UA_NODEID_NUMERIC(1, 3002);
+    ck_assert_ptr_eq(TypedValue_findType(&custom), NULL);
+
+    // an empty value and an unfinished value are discarded
+    TypedValue *tv = TypedValue_new(NULL);
+    TypedValue_begin(tv, findType(UA_NS0ID_INT32));
+    UA_Variant var;
+    bool isArray = false;
+    ck_assert(!TypedValue_finish(tv, &var, &isArray));
+    TypedValue_begin(tv, findType(UA_NS0ID_LOCALIZEDTEXT));
+    TypedValue_start(tv, "LocalizedText");
+    TypedValue_start(tv, "Text");
+    TypedValue_end(tv, "lost");
+    TypedValue_delete(tv);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("TypedValue tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, simpleVal);
+    tcase_add_test(tc, ListOfInt32);
+    tcase_add_test(tc, LocalizedText);
+    tcase_add_test(tc, ExtensionObject);
+    tcase_add_test(tc, ListOfExtensionObject);
+    tcase_add_test(tc, UnsupportedTypes);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? 0 : -1;
+}
@@ -24,7 +24,8 @@ START_TEST(simpleRealloc)
 {
     CharArenaAllocator *a = (CharArenaAllocator *)CharArenaAllocator_new(100);
     char *val = CharArenaAllocator_malloc(a, 50);
-    memcpy(val, "alsökdjfaösldfj", strlen("alsökdjfaösldfj"));
+    // regions are not zero filled, the terminator is copied as well
+    memcpy(val, "alsökdjfaösldfj", strlen("alsökdjfaösldfj") + 1);
     char *val2 = CharArenaAllocator_realloc(a, 50);
     ck_assert(val == val2);
     ck_assert(!strcmp(val, "alsökdjfaösldfj"));
@@ -53,6 +54,79 @@ START_TEST(overcommit)
 }
 END_TEST
 
+START_TEST(reallocAcrossRegions)
+{
+    CharArenaAllocator *a = CharArenaAllocator_new(16);
+    char *val = CharArenaAllocator_malloc(a, 11);
+    memcpy(val, "0123456789", 11);
+    val = CharArenaAllocator_realloc(a, 10);
+    memcpy(val + 10, "abcdefghi", 10);
+    ck_assert_str_eq(val, "0123456789abcdefghi");
+    CharArenaAllocator_Stats stats;
+    CharArenaAllocator_getStats(a, &stats);
+    ck_assert_uint_eq(stats.regions, 2);
+    ck_assert_uint_eq(stats.used, 21);
+    CharArenaAllocator_delete(a);
+}
+END_TEST
+
+START_TEST(geometricGrowth)
+{
+    CharArenaAllocator *a = CharArenaAllocator_new(64);
+    for (size_t i = 0; i < 64 * 1024; i++)
+    {
+        ck_assert_ptr_ne(CharArenaAllocator_malloc(a, 16), NULL);
+    }
+    CharArenaAllocator_Stats stats;
+    CharArenaAllocator_getStats(a, &stats);
+    // 1 MiB in regions of 64 bytes doubling
+    ck_assert_uint_le(stats.regions, 16);
+    ck_assert_uint_ge(stats.capacity, stats.used);
+    CharArenaAllocator_delete(a);
+}
+END_TEST
+
+START_TEST(resetKeepsRegions)
+{
+    CharArenaAllocator *a = CharArenaAllocator_new(64);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        CharArenaAllocator_malloc(a, 10);
+    }
+    CharArenaAllocator_Stats before;
+    CharArenaAllocator_getStats(a, &before);
+    CharArenaAllocator_reset(a);
+    CharArenaAllocator_Stats stats;
+    CharArenaAllocator_getStats(a, &stats);
+    ck_assert_uint_eq(stats.used, 0);
+    ck_assert_uint_eq(stats.resets, 1);
+    ck_assert_uint_eq(stats.capacity, before.capacity);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        char *val = CharArenaAllocator_malloc(a, 10);
+        memcpy(val, "123456789", 10);
+    }
+    CharArenaAllocator_getStats(a, &stats);
+    ck_assert_uint_eq(stats.regions, before.regions);
+    ck_assert_uint_eq(stats.capacity, before.capacity);
+    ck_assert_uint_eq(stats.used, before.used);
+    CharArenaAllocator_delete(a);
+}
+END_TEST
+
+START_TEST(hugePages)
+{
+    CharArenaAllocator *a = CharArenaAllocator_newWithOptions(100, true);
+    char *val = CharArenaAllocator_malloc(a, 3 * 1024 * 1024);
+    memset(val, 1, 3 * 1024 * 1024);
+    CharArenaAllocator_Stats stats;
+    CharArenaAllocator_getStats(a, &stats);
+    // rounded up to the huge page size
+    ck_assert_uint_eq(stats.capacity % (2 * 1024 * 1024), 0);
+    CharArenaAllocator_delete(a);
+}
+END_TEST
+
 int main(void)
 {
     Suite *s = suite_create("Sort tests");
@@ -62,6 +136,10 @@ int main(void)
     tcase_add_test(tc, simpleRealloc);
     tcase_add_test(tc, simpleRealloc2);
     tcase_add_test(tc, overcommit);
+    tcase_add_test(tc, reallocAcrossRegions);
+    tcase_add_test(tc, geometricGrowth);
+    tcase_add_test(tc, resetKeepsRegions);
+    tcase_add_test(tc, hugePages);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -0,0 +1,161 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "check.h"
+#include "NodesetLoader/NodesetLoader.h"
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned short addNamespace(void *userContext, const char *uri)
+{
+    return 1;
+}
+
+char *nodesetPath = NULL;
+
+struct MyExtension
+{
+    char address[32];
+    size_t addressLength;
+    char port[8];
+    size_t attributesSize;
+    bool inAddress;
+    bool finished;
+};
+
+static size_t extensionCnt = 0;
+
+static bool spanEquals(NL_TextSpan span, const char *text)
+{
+    return span.length == strlen(text) &&
+           !strncmp(span.data, text, span.length);
+}
+
+static void *newExtension(void *userContext,
+                          const NodesetLoader_ExtensionAllocator *allocator)
+{
+    ck_assert_ptr_eq(userContext, &extensionCnt);
+    extensionCnt++;
+    struct MyExtension *ext = (struct MyExtension *)allocator->alloc(
+        allocator->context, sizeof(struct MyExtension));
+    ck_assert_ptr_ne(ext, NULL);
+    memset(ext, 0, sizeof(struct MyExtension));
+    return ext;
+}
+
+static void startExtension(void *userContext, void *extensionData,
+                           NL_TextSpan name, size_t attributesSize,
+                           const NL_ExtensionAttribute *attributes)
+{
+    struct MyExtension *ext = (struct MyExtension *)extensionData;
+    if (!spanEquals(name, "Address"))
+    {
+        return;
+    }
+    ext->inAddress = true;
+    ext->attributesSize = attributesSize;
+    for (size_t i = 0; i < attributesSize; i++)
+    {
+        if (spanEquals(attributes[i].name, "Port"))
+        {
+            ck_assert_uint_lt(attributes[i].value.length, sizeof(ext->port));
+            memcpy(ext->port, attributes[i].value.data,
+                   attributes[i].value.length);
+        }
+    }
+}
+
+static void extensionText(void *userContext, void *extensionData,
+                          NL_TextSpan text)
+{
+    struct MyExtension *ext = (struct MyExtension *)extensionData;
+    if (!ext->inAddress)
+    {
+        return;
+    }
+    ck_assert_uint_lt(ext->addressLength + text.length, sizeof(ext->address));
+    memcpy(ext->address + ext->addressLength, text.data, text.length);
+    ext->addressLength += text.length;
+}
+
+static void endExtension(void *userContext, void *extensionData,
+                         NL_TextSpan name)
+{
+    struct MyExtension *ext = (struct MyExtension *)extensionData;
+    if (spanEquals(name, "Address"))
+    {
+        ext->inAddress = false;
+    }
+}
+
+static void finishExtension(void *userContext, void *extensionData)
+{
+    ((struct MyExtension *)extensionData)->finished = true;
+}
+
+START_TEST(ExtensionV2)
+{
+    NodesetLoader_ExtensionInterfaceV2 extIf;
+    extIf.userContext = &extensionCnt;
+    extIf.newExtension = newExtension;
+    extIf.start = startExtension;
+    extIf.text = extensionText;
+    extIf.end = endExtension;
+    extIf.finish = finishExtension;
+
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(NL_ImportOptions));
+    options.extensionHandlingV2 = &extIf;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    ck_assert(NodesetLoader_sort(loader));
+    ck_assert_uint_eq(extensionCnt, 1);
+
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 6002);
+    NL_Node *node = NodesetLoader_getNode(loader, &id);
+    ck_assert_ptr_ne(node, NULL);
+    const struct MyExtension *ext = (const struct MyExtension *)node->extension;
+    ck_assert_ptr_ne(ext, NULL);
+    ck_assert(ext->finished);
+    ck_assert_uint_eq(ext->addressLength, strlen("demo.test"));
+    ck_assert(!strncmp(ext->address, "demo.test", ext->addressLength));
+    ck_assert_uint_eq(ext->attributesSize, 2);
+    ck_assert_str_eq(ext->port, "4840");
+
+    id = UA_NODEID_NUMERIC(1, 6003);
+    node = NodesetLoader_getNode(loader, &id);
+    ck_assert_ptr_ne(node, NULL);
+    ck_assert_ptr_eq(node->extension, NULL);
+
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static Suite *testSuite_Client(void)
+{
+    Suite *s = suite_create("extension");
+    TCase *tc_server = tcase_create("extension v2");
+    tcase_add_test(tc_server, ExtensionV2);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    if (!(argc > 1))
+        return 1;
+    nodesetPath = argv[1];
+    Suite *s = testSuite_Client();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -5,6 +5,7 @@
 #include "check.h"
 #include "NodesetLoader/NodesetLoader.h"
 #include <stdlib.h>
+#include <string.h>
 
 unsigned short addNamespace(void *userContext, const char *uri) { return 1; }
 
@@ -14,6 +15,7 @@ void addNode(void *userContext, const NL_Node *node)
 }
 
 char *nodesetPath = NULL;
+char *subtreePath = NULL;
 
 static void setup(void)
 {
@@ -49,12 +51,869 @@ START_TEST(Server_ImportBasicNodeClassTest)
 }
 END_TEST
 
+struct SpanCtx
+{
+    NL_Node **nodes;
+    size_t size;
+    size_t spans;
+    bool equal;
+};
+
+static void collectNode(void *context, NL_Node *node)
+{
+    struct SpanCtx *ctx = (struct SpanCtx *)context;
+    ctx->nodes[ctx->size++] = node;
+}
+
+static size_t countRefs(const NL_Reference *ref)
+{
+    size_t cnt = 0;
+    for (; ref; ref = ref->next)
+    {
+        cnt++;
+    }
+    return cnt;
+}
+
+static void compareSpan(void *context, const NL_NodeSpan *span)
+{
+    struct SpanCtx *ctx = (struct SpanCtx *)context;
+    ctx->spans++;
+    for (size_t i = 0; i < span->size; i++)
+    {
+        const NL_Node *node = ctx->nodes[ctx->size++];
+        size_t refs = countRefs(node->hierachicalRefs) +
+                      countRefs(node->nonHierachicalRefs);
+        if (span->typeDefinitions &&
+            !UA_NodeId_equal(&span->typeDefinitions[i], &UA_NODEID_NULL))
+        {
+            refs++;
+        }
+        if (span->nodes[i] != node || !UA_NodeId_equal(&span->ids[i], &node->id) ||
+            span->browseNames[i].name != node->browseName.name ||
+            span->refsBegin[i + 1] - span->refsBegin[i] != refs)
+        {
+            ctx->equal = false;
+        }
+    }
+}
+
+START_TEST(Server_ForEachSpan)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    handler.file = nodesetPath;
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    ck_assert(NodesetLoader_sort(loader));
+
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        struct SpanCtx ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        int nodeCount = 0;
+        size_t cnt = NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &nodeCount,
+                                               (NodesetLoader_forEachNode_Func)addNode);
+        ctx.nodes = (NL_Node **)calloc(cnt + 1, sizeof(NL_Node *));
+        NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &ctx, collectNode);
+        ctx.size = 0;
+        ctx.equal = true;
+        ck_assert_uint_eq(NodesetLoader_forEachSpan(loader, (NL_NodeClass)i, 2,
+                                                    &ctx, compareSpan),
+                          cnt);
+        ck_assert(ctx.equal);
+        ck_assert_uint_eq(ctx.size, cnt);
+        ck_assert_uint_eq(ctx.spans, (cnt + 1) / 2);
+        free(ctx.nodes);
+    }
+
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static void checkIndex(void *context, NL_Node *node)
+{
+    NodesetLoader *loader = (NodesetLoader *)context;
+    ck_assert(NodesetLoader_getNode(loader, &node->id) == node);
+    for (const NL_Reference *ref = node->hierachicalRefs; ref; ref = ref->next)
+    {
+        size_t size = 0;
+        const NL_InverseReference *inverse =
+            NodesetLoader_getInverseReferences(loader, &ref->target, &size);
+        bool found = false;
+        for (size_t i = 0; i < size; i++)
+        {
+            found = found || (inverse[i].source == node &&
+                              UA_NodeId_equal(&inverse[i].refType, &ref->refType));
+        }
+        ck_assert(found);
+    }
+}
+
+START_TEST(Server_GetNode)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    handler.file = nodesetPath;
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    ck_assert(NodesetLoader_sort(loader));
+
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        NodesetLoader_forEachNode(loader, (NL_NodeClass)i, loader, checkIndex);
+    }
+    UA_NodeId unknown = UA_NODEID_NUMERIC(77, 4711);
+    ck_assert(NodesetLoader_getNode(loader, &unknown) == NULL);
+    size_t size = 1;
+    ck_assert(NodesetLoader_getInverseReferences(loader, &unknown, &size) == NULL);
+    ck_assert_uint_eq(size, 0);
+
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static bool importWithBudget(size_t budget, bool sort, NL_MemoryUsage *usage)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+
+    NodesetLoader *loader = NodesetLoader_newWithBudget(NULL, NULL, budget);
+    bool status = NodesetLoader_importFile(loader, &handler);
+    if (status && sort)
+    {
+        status = NodesetLoader_sort(loader);
+    }
+    NodesetLoader_getMemoryUsage(loader, usage);
+    NodesetLoader_delete(loader);
+    return status;
+}
+
+START_TEST(Server_MemoryBudget)
+{
+    NL_MemoryUsage imported;
+    ck_assert(importWithBudget(0, false, &imported));
+    ck_assert_uint_eq(imported.budget, 0);
+    ck_assert_uint_gt(imported.bytes[NL_MEMORY_CHARARENA], 0);
+    ck_assert_uint_gt(imported.bytes[NL_MEMORY_NODES], 0);
+    ck_assert_uint_gt(imported.bytes[NL_MEMORY_SORT], 0);
+    size_t total = 0;
+    for (size_t i = 0; i < NL_MEMORY_COUNT; i++)
+    {
+        total += imported.bytes[i];
+    }
+    ck_assert_uint_eq(total, imported.total);
+
+    NL_MemoryUsage sorted;
+    ck_assert(importWithBudget(0, true, &sorted));
+    ck_assert_uint_ge(sorted.total, imported.total);
+
+    // the usage is deterministic, the exact budget is sufficient
+    NL_MemoryUsage usage;
+    ck_assert(importWithBudget(sorted.total, true, &usage));
+    ck_assert_uint_eq(usage.total, sorted.total);
+    ck_assert_uint_eq(usage.budget, sorted.total);
+
+    // the import is aborted, not the process
+    ck_assert(!importWithBudget(imported.total - 1, false, &usage));
+    ck_assert_uint_le(usage.total, imported.total);
+    ck_assert(!importWithBudget(1, false, &usage));
+}
+END_TEST
+
+START_TEST(Server_ReuseCharArena)
+{
+    NodesetLoader_CharArena *arena = NodesetLoader_CharArena_new(256, false);
+    ck_assert_ptr_ne(arena, NULL);
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+
+    NL_CharArenaStats first;
+    for (int i = 0; i < 2; i++)
+    {
+        NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+        ck_assert(NodesetLoader_useCharArena(loader, arena));
+        ck_assert(NodesetLoader_importFile(loader, &handler));
+        ck_assert(!NodesetLoader_useCharArena(loader, arena));
+        NL_CharArenaStats stats;
+        ck_assert(NodesetLoader_getCharArenaStats(loader, &stats));
+        ck_assert_uint_gt(stats.used, 0);
+        if (i == 0)
+        {
+            first = stats;
+        }
+        else
+        {
+            // the warmed regions are reused
+            ck_assert_uint_eq(stats.regions, first.regions);
+            ck_assert_uint_eq(stats.capacity, first.capacity);
+            ck_assert_uint_eq(stats.used, first.used);
+        }
+        NodesetLoader_delete(loader);
+    }
+    NL_CharArenaStats stats;
+    NodesetLoader_CharArena_getStats(arena, &stats);
+    ck_assert_uint_eq(stats.resets, 2);
+    ck_assert_uint_eq(stats.used, 0);
+    NodesetLoader_CharArena_delete(arena);
+}
+END_TEST
+
+START_TEST(Server_Compact)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(!NodesetLoader_compact(loader));
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    // has to be sorted first
+    ck_assert(!NodesetLoader_compact(loader));
+    ck_assert(NodesetLoader_sort(loader));
+
+    size_t counts[NL_NODECLASS_COUNT];
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        int nodeCount = 0;
+        counts[i] = NodesetLoader_forEachNode(
+            loader, (NL_NodeClass)i, &nodeCount,
+            (NodesetLoader_forEachNode_Func)addNode);
+    }
+    NL_MemoryUsage before;
+    NodesetLoader_getMemoryUsage(loader, &before);
+
+    ck_assert(NodesetLoader_compact(loader));
+    ck_assert(NodesetLoader_compact(loader));
+
+    NL_MemoryUsage after;
+    NodesetLoader_getMemoryUsage(loader, &after);
+    ck_assert_uint_eq(after.bytes[NL_MEMORY_SORT], 0);
+    ck_assert_uint_eq(after.bytes[NL_MEMORY_ALIASES], 0);
+    ck_assert_uint_le(after.total, before.total);
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        ck_assert_uint_eq(NodesetLoader_forEachNode(loader, (NL_NodeClass)i,
+                                                    loader, checkIndex),
+                          counts[i]);
+        struct SpanCtx ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.nodes = (NL_Node **)calloc(counts[i] + 1, sizeof(NL_Node *));
+        NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &ctx, collectNode);
+        // the nodes are laid out in iteration order
+        for (size_t n = 1; n < ctx.size; n++)
+        {
+            ck_assert((const char *)ctx.nodes[n - 1] <
+                      (const char *)ctx.nodes[n]);
+        }
+        free(ctx.nodes);
+    }
+    ck_assert(!NodesetLoader_importFile(loader, &handler));
+    NodesetLoader_delete(loader);
+
+    loader = NodesetLoader_new(NULL, NULL);
+    NodesetLoader_setAutoCompact(loader, true);
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    ck_assert(NodesetLoader_sort(loader));
+    NL_MemoryUsage usage;
+    NodesetLoader_getMemoryUsage(loader, &usage);
+    ck_assert_uint_eq(usage.bytes[NL_MEMORY_SORT], 0);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+struct RefsCtx
+{
+    NL_ReferenceEntry *refs;
+    size_t size;
+};
+
+// counts the references if refs is NULL
+static void collectRef(void *context, const NL_ReferenceEntry *ref)
+{
+    struct RefsCtx *ctx = (struct RefsCtx *)context;
+    if (ctx->refs)
+    {
+        ctx->refs[ctx->size] = *ref;
+    }
+    ctx->size++;
+}
+
+struct CompareRefsCtx
+{
+    NodesetLoader *compact;
+    NodesetLoader *lists;
+};
+
+// the node of the compact loader has the references of the node with the same
+// id of the loader which keeps the lists, in the same order
+static void compareRefs(void *context, NL_Node *node)
+{
+    const struct CompareRefsCtx *ctx = (const struct CompareRefsCtx *)context;
+    const NL_Node *other = NodesetLoader_getNode(ctx->lists, &node->id);
+    ck_assert_ptr_ne(other, NULL);
+    struct RefsCtx a = {NULL, 0};
+    size_t size =
+        NodesetLoader_forEachReference(ctx->lists, other, &a, collectRef);
+    ck_assert_uint_eq(a.size, size);
+    struct RefsCtx b = {NULL, 0};
+    a.refs = (NL_ReferenceEntry *)calloc(size + 1, sizeof(NL_ReferenceEntry));
+    b.refs = (NL_ReferenceEntry *)calloc(size + 1, sizeof(NL_ReferenceEntry));
+    a.size = 0;
+    NodesetLoader_forEachReference(ctx->compact, node, &a, collectRef);
+    NodesetLoader_forEachReference(ctx->lists, other, &b, collectRef);
+    ck_assert_uint_eq(a.size, size);
+    ck_assert_uint_eq(b.size, size);
+    for (size_t i = 0; i < a.size; i++)
+    {
+        ck_assert(UA_NodeId_equal(&a.refs[i].refType, &b.refs[i].refType));
+        ck_assert(UA_NodeId_equal(&a.refs[i].target, &b.refs[i].target));
+        ck_assert(a.refs[i].isForward == b.refs[i].isForward);
+        ck_assert_int_eq(a.refs[i].kind, b.refs[i].kind);
+    }
+    free(a.refs);
+    free(b.refs);
+    // the lists built from the compact references
+    ck_assert_uint_eq(countRefs(node->hierachicalRefs),
+                      countRefs(other->hierachicalRefs));
+    ck_assert_uint_eq(countRefs(node->nonHierachicalRefs),
+                      countRefs(other->nonHierachicalRefs));
+    ck_assert_uint_eq(countRefs(node->unknownRefs),
+                      countRefs(other->unknownRefs));
+    for (const NL_Reference *ref = node->hierachicalRefs,
+                            *otherRef = other->hierachicalRefs;
+         ref; ref = ref->next, otherRef = otherRef->next)
+    {
+        ck_assert(UA_NodeId_equal(&ref->target, &otherRef->target));
+        ck_assert(ref->isForward == otherRef->isForward);
+    }
+}
+
+static void countSpanRefs(void *context, const NL_NodeSpan *span)
+{
+    *(size_t *)context += span->refsBegin[span->size] - span->refsBegin[0];
+}
+
+START_TEST(Server_CompactReferences)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+
+    NodesetLoader *lists = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFile(lists, &handler));
+    ck_assert(NodesetLoader_sort(lists));
+    ck_assert(NodesetLoader_compact(lists));
+
+    NodesetLoader *compact = NodesetLoader_new(NULL, NULL);
+    NodesetLoader_setCompactReferences(compact, true);
+    ck_assert(NodesetLoader_importFile(compact, &handler));
+    ck_assert(NodesetLoader_sort(compact));
+    ck_assert(NodesetLoader_compact(compact));
+
+    // the spans and the inverse references don't need the lists
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        size_t compactRefs = 0;
+        size_t listRefs = 0;
+        NodesetLoader_forEachSpan(compact, (NL_NodeClass)i, 0, &compactRefs,
+                                  countSpanRefs);
+        NodesetLoader_forEachSpan(lists, (NL_NodeClass)i, 0, &listRefs,
+                                  countSpanRefs);
+        ck_assert_uint_eq(compactRefs, listRefs);
+    }
+    UA_NodeId objectsFolder = UA_NODEID_NUMERIC(0, 85);
+    size_t compactSize = 0;
+    size_t listsSize = 0;
+    NodesetLoader_getInverseReferences(compact, &objectsFolder, &compactSize);
+    NodesetLoader_getInverseReferences(lists, &objectsFolder, &listsSize);
+    ck_assert_uint_eq(compactSize, listsSize);
+    NL_MemoryUsage before;
+    NodesetLoader_getMemoryUsage(compact, &before);
+
+    struct CompareRefsCtx ctx = {compact, lists};
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        NodesetLoader_forEachNode(compact, (NL_NodeClass)i, &ctx, compareRefs);
+    }
+    // the lists are accounted for once they are built
+    NL_MemoryUsage after;
+    NodesetLoader_getMemoryUsage(compact, &after);
+    ck_assert_uint_ge(after.bytes[NL_MEMORY_REFERENCES],
+                      before.bytes[NL_MEMORY_REFERENCES]);
+
+    NodesetLoader_delete(compact);
+    NodesetLoader_delete(lists);
+}
+END_TEST
+
+static size_t findLevel(const NL_NodeLevel *levels, size_t levelsSize,
+                        const UA_NodeId *id)
+{
+    for (size_t l = 0; l < levelsSize; l++)
+    {
+        for (size_t i = 0; i < levels[l].size; i++)
+        {
+            if (UA_NodeId_equal(&levels[l].nodes[i]->id, id))
+            {
+                return l;
+            }
+        }
+    }
+    return levelsSize;
+}
+
+START_TEST(Server_Levels)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    size_t levelsSize = 1;
+    ck_assert(NodesetLoader_getLevels(loader, &levelsSize) == NULL);
+    ck_assert_uint_eq(levelsSize, 0);
+    ck_assert(NodesetLoader_sort(loader));
+
+    size_t nodesSize = 0;
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        int nodeCount = 0;
+        nodesSize += NodesetLoader_forEachNode(
+            loader, (NL_NodeClass)i, &nodeCount,
+            (NodesetLoader_forEachNode_Func)addNode);
+    }
+    const NL_NodeLevel *levels = NodesetLoader_getLevels(loader, &levelsSize);
+    ck_assert_ptr_ne(levels, NULL);
+    size_t levelNodes = 0;
+    for (size_t l = 0; l < levelsSize; l++)
+    {
+        ck_assert_uint_gt(levels[l].size, 0);
+        levelNodes += levels[l].size;
+        for (size_t i = 0; i < levels[l].size; i++)
+        {
+            const NL_Node *node = levels[l].nodes[i];
+            for (const NL_Reference *ref = node->hierachicalRefs; ref;
+                 ref = ref->next)
+            {
+                size_t target = findLevel(levels, levelsSize, &ref->target);
+                if (target == levelsSize)
+                {
+                    // not part of the nodeset
+                    continue;
+                }
+                if (ref->isForward)
+                {
+                    ck_assert_uint_gt(target, l);
+                }
+                else
+                {
+                    ck_assert_uint_lt(target, l);
+                }
+            }
+        }
+    }
+    ck_assert_uint_eq(levelNodes, nodesSize);
+
+    // the levels survive the compaction
+    size_t *sizes = (size_t *)calloc(levelsSize, sizeof(size_t));
+    for (size_t l = 0; l < levelsSize; l++)
+    {
+        sizes[l] = levels[l].size;
+    }
+    ck_assert(NodesetLoader_compact(loader));
+    size_t compactedSize = 0;
+    const NL_NodeLevel *compacted =
+        NodesetLoader_getLevels(loader, &compactedSize);
+    ck_assert_uint_eq(compactedSize, levelsSize);
+    for (size_t l = 0; l < compactedSize; l++)
+    {
+        ck_assert_uint_eq(compacted[l].size, sizes[l]);
+        for (size_t i = 0; i < compacted[l].size; i++)
+        {
+            const NL_Node *node = compacted[l].nodes[i];
+            ck_assert(NodesetLoader_getNode(loader, &node->id) == node);
+        }
+    }
+    free(sizes);
+
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+struct FilterCtx
+{
+    UA_NodeId *instances;
+    size_t instancesSize;
+    size_t calls;
+};
+
+static void collectInstance(void *context, NL_Node *node)
+{
+    struct FilterCtx *ctx = (struct FilterCtx *)context;
+    if (NodesetLoader_isInstanceNode(node))
+    {
+        UA_NodeId_copy(&node->id, &ctx->instances[ctx->instancesSize++]);
+    }
+}
+
+static void checkNoReferenceToInstance(void *context, NL_Node *node)
+{
+    const struct FilterCtx *ctx = (const struct FilterCtx *)context;
+    const NL_Reference *lists[2] = {node->hierachicalRefs,
+                                    node->nonHierachicalRefs};
+    for (size_t l = 0; l < 2; l++)
+    {
+        for (const NL_Reference *ref = lists[l]; ref; ref = ref->next)
+        {
+            for (size_t i = 0; i < ctx->instancesSize; i++)
+            {
+                ck_assert(!UA_NodeId_equal(&ref->target, &ctx->instances[i]));
+            }
+        }
+    }
+}
+
+static bool rejectAll(void *userContext, NL_NodeClass nodeClass,
+                      const UA_NodeId *id)
+{
+    ((struct FilterCtx *)userContext)->calls++;
+    return false;
+}
+
+static void importFiltered(const NL_ImportFilter *filter,
+                           struct FilterCtx *ctx, size_t *counts)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+    handler.userContext = ctx;
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(NL_ImportOptions));
+    options.filter = filter;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    ck_assert(NodesetLoader_sort(loader));
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        counts[i] = NodesetLoader_forEachNode(loader, (NL_NodeClass)i, ctx,
+                                              checkNoReferenceToInstance);
+    }
+    NodesetLoader_delete(loader);
+}
+
+START_TEST(Server_ImportFilter)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    ck_assert(NodesetLoader_sort(loader));
+    size_t all[NL_NODECLASS_COUNT];
+    size_t allSize = 0;
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        int nodeCount = 0;
+        all[i] = NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &nodeCount,
+                                           (NodesetLoader_forEachNode_Func)addNode);
+        allSize += all[i];
+    }
+    struct FilterCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.instances = (UA_NodeId *)calloc(allSize + 1, sizeof(UA_NodeId));
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &ctx,
+                                  collectInstance);
+    }
+    NodesetLoader_delete(loader);
+
+    // the types without the instances, either by node class or because no
+    // instance is part of the subtree
+    NL_ImportFilter types;
+    memset(&types, 0, sizeof(types));
+    types.nodeClasses = NL_NODECLASS_MASK(NODECLASS_OBJECTTYPE) |
+                        NL_NODECLASS_MASK(NODECLASS_VARIABLETYPE) |
+                        NL_NODECLASS_MASK(NODECLASS_DATATYPE) |
+                        NL_NODECLASS_MASK(NODECLASS_REFERENCETYPE);
+    UA_NodeId unknownRoot = UA_NODEID_NUMERIC(77, 4711);
+    NL_ImportFilter subtree;
+    memset(&subtree, 0, sizeof(subtree));
+    subtree.subtreeRoot = &unknownRoot;
+    const NL_ImportFilter *filters[2] = {&types, &subtree};
+    for (size_t f = 0; f < 2; f++)
+    {
+        size_t counts[NL_NODECLASS_COUNT];
+        importFiltered(filters[f], &ctx, counts);
+        for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+        {
+            NL_Node node;
+            node.nodeClass = (NL_NodeClass)i;
+            ck_assert_uint_eq(counts[i], NodesetLoader_isInstanceNode(&node)
+                                             ? 0
+                                             : all[i]);
+        }
+    }
+
+    // every node element is offered to the predicate
+    NL_ImportFilter none;
+    memset(&none, 0, sizeof(none));
+    none.accept = rejectAll;
+    size_t counts[NL_NODECLASS_COUNT];
+    importFiltered(&none, &ctx, counts);
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        ck_assert_uint_eq(counts[i], 0);
+    }
+    ck_assert_uint_ge(ctx.calls, allSize);
+
+    for (size_t i = 0; i < ctx.instancesSize; i++)
+    {
+        UA_NodeId_clear(&ctx.instances[i]);
+    }
+    free(ctx.instances);
+}
+END_TEST
+
+START_TEST(Server_SubtreeFilter)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+
+    // the nodes of the first file are not part of the subtree
+    UA_NodeId root = UA_NODEID_NUMERIC(1, 7010);
+    NL_ImportFilter filter;
+    memset(&filter, 0, sizeof(filter));
+    filter.subtreeRoot = &root;
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(NL_ImportOptions));
+    options.filter = &filter;
+    handler.file = subtreePath;
+    ck_assert(NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    ck_assert(NodesetLoader_sort(loader));
+
+    const UA_UInt32 imported[] = {7000, 7010, 7011, 7012};
+    for (size_t i = 0; i < sizeof(imported) / sizeof(imported[0]); i++)
+    {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, imported[i]);
+        ck_assert_ptr_ne(NodesetLoader_getNode(loader, &id), NULL);
+    }
+    const UA_UInt32 skipped[] = {7001, 7020};
+    for (size_t i = 0; i < sizeof(skipped) / sizeof(skipped[0]); i++)
+    {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, skipped[i]);
+        ck_assert_ptr_eq(NodesetLoader_getNode(loader, &id), NULL);
+    }
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static void checkSkipped(void *context, NL_Node *node)
+{
+    ck_assert_ptr_eq(node->description.text, NULL);
+    ck_assert_ptr_eq(node->displayName.locale, NULL);
+    ck_assert_ptr_eq(node->extension, NULL);
+    switch (node->nodeClass)
+    {
+    case NODECLASS_VARIABLE:
+        ck_assert_ptr_eq(((NL_VariableNode *)node)->value, NULL);
+        break;
+    case NODECLASS_DATATYPE:
+        ck_assert_ptr_eq(((NL_DataTypeNode *)node)->definition, NULL);
+        break;
+    case NODECLASS_REFERENCETYPE:
+        ck_assert_ptr_eq(((NL_ReferenceTypeNode *)node)->inverseName.text,
+                         NULL);
+        break;
+    default:
+        break;
+    }
+    (*(size_t *)context)++;
+}
+
+START_TEST(Server_SkipAttributes)
+{
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    NL_MemoryUsage all;
+    NodesetLoader_getMemoryUsage(loader, &all);
+    ck_assert(NodesetLoader_sort(loader));
+    size_t allSize = 0;
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        int nodeCount = 0;
+        allSize += NodesetLoader_forEachNode(
+            loader, (NL_NodeClass)i, &nodeCount,
+            (NodesetLoader_forEachNode_Func)addNode);
+    }
+    NodesetLoader_delete(loader);
+
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(NL_ImportOptions));
+    options.skipAttributes =
+        NL_ATTRIBUTE_VALUE | NL_ATTRIBUTE_DESCRIPTION |
+        NL_ATTRIBUTE_DISPLAYNAME_LOCALE | NL_ATTRIBUTE_INVERSENAME |
+        NL_ATTRIBUTE_EXTENSIONS | NL_ATTRIBUTE_DATATYPE_DEFINITION;
+    loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    NL_MemoryUsage projected;
+    NodesetLoader_getMemoryUsage(loader, &projected);
+    ck_assert_uint_le(projected.total, all.total);
+    ck_assert_uint_le(projected.bytes[NL_MEMORY_VALUES],
+                      all.bytes[NL_MEMORY_VALUES]);
+    ck_assert(NodesetLoader_sort(loader));
+    size_t size = 0;
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &size,
+                                  checkSkipped);
+    }
+    // only parts of the nodes are skipped
+    ck_assert_uint_eq(size, allSize);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+struct ProgressLog
+{
+    size_t calls[3];
+    NL_Progress last[3];
+    // cancels at this call, 0 never cancels
+    size_t cancelAt;
+    size_t callsTotal;
+};
+
+static bool onProgress(void *context, const NL_Progress *progress)
+{
+    struct ProgressLog *log = (struct ProgressLog *)context;
+    log->calls[progress->stage]++;
+    log->last[progress->stage] = *progress;
+    log->callsTotal++;
+    return log->callsTotal != log->cancelAt;
+}
+
+START_TEST(Server_Progress)
+{
+    struct ProgressLog log;
+    memset(&log, 0, sizeof(log));
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(NL_ImportOptions));
+    options.progress = onProgress;
+    options.progressContext = &log;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    ck_assert(NodesetLoader_sort(loader));
+    NodesetLoader_delete(loader);
+
+    // with an interval of 0 every node is reported, plus the end of the stage
+    ck_assert_uint_gt(log.calls[NL_PROGRESS_PARSE], 1);
+    ck_assert_uint_eq(log.last[NL_PROGRESS_PARSE].bytesParsed,
+                      log.last[NL_PROGRESS_PARSE].bytesTotal);
+    ck_assert_uint_gt(log.last[NL_PROGRESS_PARSE].bytesTotal, 0);
+    ck_assert_uint_eq(log.calls[NL_PROGRESS_SORT],
+                      log.last[NL_PROGRESS_SORT].nodesToSort + 1);
+    ck_assert_uint_eq(log.last[NL_PROGRESS_SORT].nodesSorted,
+                      log.last[NL_PROGRESS_SORT].nodesToSort);
+    ck_assert_uint_eq(log.last[NL_PROGRESS_SORT].nodesCreated,
+                      log.last[NL_PROGRESS_PARSE].nodesCreated);
+    ck_assert_uint_eq(log.calls[NL_PROGRESS_INSERT], 0);
+
+    // a long interval only reports the first update and the end of a stage
+    memset(&log, 0, sizeof(log));
+    options.progressInterval = 3600 * 1000;
+    loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    ck_assert(NodesetLoader_sort(loader));
+    NodesetLoader_delete(loader);
+    ck_assert_uint_eq(log.calls[NL_PROGRESS_PARSE], 2);
+    ck_assert_uint_eq(log.calls[NL_PROGRESS_SORT], 2);
+}
+END_TEST
+
+START_TEST(Server_CancelImport)
+{
+    struct ProgressLog log;
+    memset(&log, 0, sizeof(log));
+    log.cancelAt = 2;
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(NL_FileContext));
+    handler.addNamespace = addNamespace;
+    handler.file = nodesetPath;
+    NL_ImportOptions options;
+    memset(&options, 0, sizeof(NL_ImportOptions));
+    options.progress = onProgress;
+    options.progressContext = &log;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(!NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    ck_assert_uint_eq(log.callsTotal, 2);
+    // nothing is reported after the cancellation
+    ck_assert(!NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    ck_assert_uint_eq(log.callsTotal, 2);
+    NodesetLoader_delete(loader);
+
+    // cancelled by the first call of the sort
+    memset(&log, 0, sizeof(log));
+    loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFileWithOptions(loader, &handler, &options));
+    log.cancelAt = log.callsTotal + 1;
+    ck_assert(!NodesetLoader_sort(loader));
+    ck_assert_uint_eq(log.calls[NL_PROGRESS_SORT], 1);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
 static Suite *testSuite_Client(void)
 {
     Suite *s = suite_create("server nodeset import");
     TCase *tc_server = tcase_create("server nodeset import");
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, Server_ImportBasicNodeClassTest);
+    tcase_add_test(tc_server, Server_ForEachSpan);
+    tcase_add_test(tc_server, Server_GetNode);
+    tcase_add_test(tc_server, Server_MemoryBudget);
+    tcase_add_test(tc_server, Server_ReuseCharArena);
+    tcase_add_test(tc_server, Server_Compact);
+    tcase_add_test(tc_server, Server_CompactReferences);
+    tcase_add_test(tc_server, Server_Levels);
+    tcase_add_test(tc_server, Server_ImportFilter);
+    if (subtreePath)
+    {
+        tcase_add_test(tc_server, Server_SubtreeFilter);
+    }
+    tcase_add_test(tc_server, Server_SkipAttributes);
+    tcase_add_test(tc_server, Server_Progress);
+    tcase_add_test(tc_server, Server_CancelImport);
     suite_add_tcase(s, tc_server);
     return s;
 }
@@ -64,6 +923,10 @@ int main(int argc, char *argv[])
     if (!(argc > 1))
         return 1;
     nodesetPath = argv[1];
+    if (argc > 2)
+    {
+        subtreePath = argv[2];
+    }
     Suite *s = testSuite_Client();
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
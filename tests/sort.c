@@ -4,18 +4,21 @@
 #include <stdio.h>
 
 static const NL_Node* sortedNodes[100];
+static size_t sortedLevels[100];
 static int sortedNodesCnt = 0;
 
 struct Nodeset;
 
-static void sortCallback(struct Nodeset* nodeset, NL_Node *node) 
+static bool sortCallback(struct Nodeset* nodeset, NL_Node *node, size_t level)
 { 
     UA_String idStr = {0};
     UA_NodeId_print(&node->id, &idStr);
     printf("%.*s\n", (int)idStr.length, (char*)idStr.data);
     UA_String_clear(&idStr);
     sortedNodes[sortedNodesCnt] = node;
+    sortedLevels[sortedNodesCnt] = level;
     sortedNodesCnt++;
+    return true;
 }
 
 static void initNode(NL_VariableNode* n)
@@ -165,6 +168,119 @@ START_TEST(cycleDetect) {
 }
 END_TEST
 
+static size_t levelOf(const NL_VariableNode *node)
+{
+    for (int i = 0; i < sortedNodesCnt; i++)
+    {
+        if (sortedNodes[i] == (const NL_Node *)node)
+        {
+            return sortedLevels[i];
+        }
+    }
+    ck_abort();
+    return 0;
+}
+
+// nodeB -> nodeA, nodeC -> nodeA, nodeD -> nodeB, nodeE -> unknown node
+// expect: level 0: nodeA, nodeE, level 1: nodeB, nodeC, level 2: nodeD
+START_TEST(levels) {
+    sortedNodesCnt = 0;
+    SortContext *ctx = Sort_init();
+
+    NL_VariableNode nodes[5];
+    NL_Reference refs[4];
+    char *names[5] = {"nodeA", "nodeB", "nodeC", "nodeD", "nodeE"};
+    for (int i = 0; i < 5; i++)
+    {
+        initNode(&nodes[i]);
+        nodes[i].id = UA_NODEID_STRING(1, names[i]);
+    }
+    const int parents[4] = {0, 0, 1, -1};
+    for (int i = 0; i < 4; i++)
+    {
+        refs[i].isForward = false;
+        refs[i].target = parents[i] < 0 ? UA_NODEID_STRING(1, "unknown")
+                                         : nodes[parents[i]].id;
+        refs[i].next = NULL;
+        nodes[i + 1].hierachicalRefs = &refs[i];
+    }
+    for (int i = 4; i >= 0; i--)
+    {
+        Sort_addNode(ctx, (NL_Node *)&nodes[i]);
+    }
+    ck_assert(Sort_start(ctx, NULL, sortCallback, NULL));
+    ck_assert_int_eq(sortedNodesCnt, 5);
+    ck_assert_uint_eq(levelOf(&nodes[0]), 0);
+    ck_assert_uint_eq(levelOf(&nodes[1]), 1);
+    ck_assert_uint_eq(levelOf(&nodes[2]), 1);
+    ck_assert_uint_eq(levelOf(&nodes[3]), 2);
+    ck_assert_uint_eq(levelOf(&nodes[4]), 0);
+    Sort_cleanup(ctx);
+}
+END_TEST
+
+static void deleteRefs(NL_Reference *ref)
+{
+    while (ref)
+    {
+        NL_Reference *next = ref->next;
+        UA_NodeId_clear(&ref->target);
+        UA_NodeId_clear(&ref->refType);
+        free(ref);
+        ref = next;
+    }
+}
+
+// nodeA organizes nodeB, nodeB and nodeC only have nodeA as ParentNodeId
+// expect: reference of nodeB is an inverse Organizes, the one of nodeC an
+// inverse HasComponent, no matter if nodeA is added before or after them
+START_TEST(parentNodeId) {
+    sortedNodesCnt = 0;
+    SortContext *ctx = Sort_init();
+
+    NL_VariableNode nodes[3];
+    char *names[3] = {"nodeA", "nodeB", "nodeC"};
+    for (int i = 0; i < 3; i++)
+    {
+        initNode(&nodes[i]);
+        nodes[i].id = UA_NODEID_STRING(1, names[i]);
+        nodes[i].nodeClass = NODECLASS_VARIABLE;
+    }
+    nodes[1].parentNodeId = nodes[0].id;
+    nodes[2].parentNodeId = nodes[0].id;
+
+    NL_Reference organizes;
+    organizes.isForward = true;
+    organizes.refType = UA_NODEID_NUMERIC(0, 35);
+    organizes.target = nodes[1].id;
+    organizes.next = NULL;
+    nodes[0].hierachicalRefs = &organizes;
+
+    Sort_addNode(ctx, (NL_Node *)&nodes[1]);
+    Sort_addNode(ctx, (NL_Node *)&nodes[0]);
+    Sort_addNode(ctx, (NL_Node *)&nodes[2]);
+    ck_assert(Sort_start(ctx, NULL, sortCallback, NULL));
+    ck_assert_int_eq(sortedNodesCnt, 3);
+
+    const NL_Reference *ref = nodes[1].hierachicalRefs;
+    ck_assert(ref && !ref->next);
+    ck_assert(!ref->isForward);
+    ck_assert(UA_NodeId_equal(&ref->target, &nodes[0].id));
+    ck_assert(UA_NodeId_equal(&ref->refType, &organizes.refType));
+
+    ref = nodes[2].hierachicalRefs;
+    ck_assert(ref && !ref->next);
+    ck_assert(!ref->isForward);
+    ck_assert(UA_NodeId_equal(&ref->target, &nodes[0].id));
+    const UA_NodeId hasComponent = UA_NODEID_NUMERIC(0, 47);
+    ck_assert(UA_NodeId_equal(&ref->refType, &hasComponent));
+
+    deleteRefs(nodes[1].hierachicalRefs);
+    deleteRefs(nodes[2].hierachicalRefs);
+    Sort_cleanup(ctx);
+}
+END_TEST
+
 START_TEST(empty)
 {
     SortContext *ctx = Sort_init();
@@ -181,6 +297,8 @@ int main(void) {
     tcase_add_test(tc, nodeWithRefs_1);
     tcase_add_test(tc, nodeWithRefs_2);
     tcase_add_test(tc, cycleDetect);
+    tcase_add_test(tc, levels);
+    tcase_add_test(tc, parentNodeId);
     tcase_add_test(tc, empty);
     suite_add_tcase(s, tc);
 
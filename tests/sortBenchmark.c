@@ -0,0 +1,109 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Sorts a folder with a huge number of children which only have the folder as
+// ParentNodeId, every second of them is organized by the folder.
+// usage: sortBenchmark [children], 1000000 children by default
+
+#include "Sort.h"
+#include "NodesetLoader/NodesetLoader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static size_t sortedCnt = 0;
+
+struct Nodeset;
+
+static bool countSorted(struct Nodeset *nodeset, NL_Node *node, size_t level)
+{
+    sortedCnt++;
+    return true;
+}
+
+static double secondsSince(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t children = 1000000;
+    if (argc > 1)
+    {
+        children = strtoul(argv[1], NULL, 10);
+    }
+
+    NL_ObjectNode folder;
+    memset(&folder, 0, sizeof(folder));
+    folder.nodeClass = NODECLASS_OBJECT;
+    folder.id = UA_NODEID_NUMERIC(1, 1);
+
+    NL_VariableNode *nodes =
+        (NL_VariableNode *)calloc(children, sizeof(NL_VariableNode));
+    NL_Reference *refs = (NL_Reference *)calloc(children / 2 + 1,
+                                                sizeof(NL_Reference));
+    if (!nodes || !refs)
+    {
+        printf("out of memory\n");
+        return EXIT_FAILURE;
+    }
+    size_t refsSize = 0;
+    for (size_t i = 0; i < children; i++)
+    {
+        nodes[i].nodeClass = NODECLASS_VARIABLE;
+        nodes[i].id = UA_NODEID_NUMERIC(1, (UA_UInt32)(i + 2));
+        nodes[i].parentNodeId = folder.id;
+        if (i % 2 == 0)
+        {
+            NL_Reference *ref = &refs[refsSize++];
+            ref->isForward = true;
+            ref->refType = UA_NODEID_NUMERIC(0, 35);
+            ref->target = nodes[i].id;
+            ref->next = folder.hierachicalRefs;
+            folder.hierachicalRefs = ref;
+        }
+    }
+
+    SortContext *ctx = Sort_init();
+    clock_t start = clock();
+    // the parent before its children, like in most nodesets
+    Sort_addNode(ctx, (NL_Node *)&folder);
+    for (size_t i = 0; i < children; i++)
+    {
+        Sort_addNode(ctx, (NL_Node *)&nodes[i]);
+    }
+    double addTime = secondsSince(start);
+    start = clock();
+    bool sorted = Sort_start(ctx, NULL, countSorted, NULL);
+    double sortTime = secondsSince(start);
+    printf("children: %zu\nadd: %.3f s\nsort: %.3f s\nmemory: %zu bytes\n",
+           children, addTime, sortTime, Sort_memoryUsage(ctx));
+    Sort_cleanup(ctx);
+
+    bool valid = sorted && sortedCnt == children + 1;
+    for (size_t i = 0; i < children; i++)
+    {
+        NL_Reference *ref = nodes[i].hierachicalRefs;
+        valid = valid && ref && !ref->isForward &&
+                UA_NodeId_equal(&ref->target, &folder.id) &&
+                ref->refType.identifier.numeric == (i % 2 == 0 ? 35u : 47u);
+        if (ref)
+        {
+            UA_NodeId_clear(&ref->target);
+            UA_NodeId_clear(&ref->refType);
+            free(ref);
+        }
+    }
+    free(nodes);
+    free(refs);
+    if (!valid)
+    {
+        printf("references to the parent are wrong\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "check.h"
+#include "NodesetLoader/NodesetLoader.h"
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned short addNamespace(void *userContext, const char *uri)
+{
+    return 1;
+}
+
+// nodeset with findings of every check
+char *invalidPath = NULL;
+// nodeset without findings
+char *validPath = NULL;
+
+static void countFinding(void *context, const NL_Finding *finding)
+{
+    ck_assert_int_lt(finding->check, NL_CHECK_COUNT);
+    ck_assert_ptr_ne(finding->message, NULL);
+    ((size_t *)context)[finding->check]++;
+}
+
+static void countNode(void *context, NL_Node *node) { (*(size_t *)context)++; }
+
+static void silent(void *context, enum NodesetLoader_LogLevel level,
+                   const char *message, ...)
+{
+}
+
+START_TEST(AllFindings)
+{
+    NodesetLoader_Logger logger = {NULL, silent};
+    NodesetLoader *loader = NodesetLoader_new(&logger, NULL);
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.addNamespace = addNamespace;
+    handler.file = invalidPath;
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+
+    size_t checks[NL_CHECK_COUNT] = {0};
+    size_t findings = NodesetLoader_validate(loader, checks, countFinding);
+    ck_assert_uint_eq(checks[NL_CHECK_DANGLING_REFERENCE], 1);
+    ck_assert_uint_eq(checks[NL_CHECK_UNKNOWN_REFERENCETYPE], 1);
+    ck_assert_uint_eq(checks[NL_CHECK_MISSING_TYPEDEFINITION], 2);
+    ck_assert_uint_eq(checks[NL_CHECK_MISSING_DATATYPE], 1);
+    ck_assert_uint_eq(checks[NL_CHECK_ALIAS], 2);
+    ck_assert_uint_eq(checks[NL_CHECK_MALFORMED_NODEID], 1);
+    ck_assert_uint_eq(checks[NL_CHECK_MALFORMED_BROWSENAME], 1);
+    ck_assert_uint_eq(checks[NL_CHECK_DUPLICATE_NODEID], 1);
+    ck_assert_uint_eq(checks[NL_CHECK_REFERENCE_CYCLE], 2);
+    ck_assert_uint_eq(checks[NL_CHECK_VALUE_TYPE], 3);
+    ck_assert_uint_eq(findings, 15);
+
+    // the checks run once, the findings are kept
+    ck_assert_uint_eq(NodesetLoader_validate(loader, NULL, NULL), findings);
+    ck_assert(!NodesetLoader_sort(loader));
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+START_TEST(NoFindings)
+{
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.addNamespace = addNamespace;
+    handler.file = validPath;
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+
+    size_t checks[NL_CHECK_COUNT] = {0};
+    ck_assert_uint_eq(NodesetLoader_validate(loader, checks, countFinding), 0);
+    ck_assert(NodesetLoader_sort(loader));
+
+    // a clean nodeset is sorted by the validation
+    size_t nodes = 0;
+    NodesetLoader_forEachNode(loader, NODECLASS_VARIABLE, &nodes, countNode);
+    ck_assert_uint_eq(nodes, 2);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static Suite *testSuite_Validation(void)
+{
+    Suite *s = suite_create("validation");
+    TCase *tc = tcase_create("validation");
+    tcase_add_test(tc, AllFindings);
+    tcase_add_test(tc, NoFindings);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    if (!(argc > 2))
+        return 1;
+    invalidPath = argv[1];
+    validPath = argv[2];
+    Suite *s = testSuite_Validation();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}